@@ -212,12 +212,12 @@ int Serial_::read(void)
 
 int Serial_::availableForWrite(void)
 {
-	return USB_SendSpace(CDC_TX);
+	return CDC_TxSpace();
 }
 
 void Serial_::flush(void)
 {
-	USB_Flush(CDC_TX);
+	CDC_TxFlush();
 }
 
 size_t Serial_::write(uint8_t c)
@@ -237,13 +237,26 @@ size_t Serial_::write(const uint8_t *buffer, size_t size)
 	// open connection isn't broken cleanly (cable is yanked out, host dies
 	// or locks up, or host virtual serial port hangs)
 	if (_usbLineInfo.lineState > 0)	{
-		int r = USB_Send(CDC_TX,buffer,size);
-		if (r > 0) {
-			return r;
-		} else {
+		// returns as soon as everything is queued, only waits while the
+		// queue is full and gives up after 250ms without progress
+		size_t sent = 0;
+		unsigned long start = millis();
+		while (sent < size) {
+			int r = CDC_TxQueue(buffer + sent, size - sent);
+			if (r < 0) {
+				break;
+			}
+			if (r > 0) {
+				sent += r;
+				start = millis();
+			} else if (millis() - start > 250) {
+				break;
+			}
+		}
+		if (sent < size) {
 			setWriteError();
-			return 0;
 		}
+		return sent;
 	}
 	setWriteError();
 	return 0;
@@ -264,7 +277,7 @@ Serial_::operator bool() {
 	return result;
 }
 
-unsigned long Serial_::baud() {
+uint32_t Serial_::baud() {
 	// Disable interrupts while reading a multi-byte value
 	uint32_t baudrate;
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -90,8 +90,8 @@ void HardwareSerial::_tx_udr_empty_irq(void)
 {
   // If interrupts are enabled, there must be more data in the output
   // buffer. Send the next byte
-  unsigned char c = _tx_buffer[_tx_buffer_tail];
-  _tx_buffer_tail = (_tx_buffer_tail + 1) % SERIAL_TX_BUFFER_SIZE;
+  unsigned char c = _tx_buf[_tx_buffer_tail];
+  _tx_buffer_tail = (_tx_buffer_tail + 1) & _tx_mask;
 
   *_udr = c;
 
@@ -149,6 +149,42 @@ void HardwareSerial::begin(unsigned long baud, byte config)
   cbi(*_ucsrb, UDRIE0);
 }
 
+// A caller supplied buffer must be a power of 2 that the index type can
+// address, anything else keeps the built-in buffer.
+static bool validBufferSize(uint16_t size, uint16_t maxMask)
+{
+  return size >= 2 && (uint16_t)(size - 1) <= maxMask && (size & (size - 1)) == 0;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t config,
+                           unsigned char *rxBuffer, uint16_t rxSize,
+                           unsigned char *txBuffer, uint16_t txSize)
+{
+  // Let the old buffers drain and stop the interrupts before they are
+  // swapped out from under the handlers
+  end();
+
+  if (rxBuffer && validBufferSize(rxSize, (rx_buffer_index_t)~0)) {
+    _rx_buf = rxBuffer;
+    _rx_mask = rxSize - 1;
+  } else {
+    _rx_buf = _rx_buffer;
+    _rx_mask = SERIAL_RX_BUFFER_SIZE - 1;
+  }
+  if (txBuffer && validBufferSize(txSize, (tx_buffer_index_t)~0)) {
+    _tx_buf = txBuffer;
+    _tx_mask = txSize - 1;
+  } else {
+    _tx_buf = _tx_buffer;
+    _tx_mask = SERIAL_TX_BUFFER_SIZE - 1;
+  }
+  _rx_buffer_head = _rx_buffer_tail = 0;
+  _tx_buffer_head = _tx_buffer_tail = 0;
+  resetRxStats();
+
+  begin(baud, config);
+}
+
 void HardwareSerial::end()
 {
   // wait for transmission of outgoing data
@@ -165,7 +201,7 @@ void HardwareSerial::end()
 
 int HardwareSerial::available(void)
 {
-  return ((unsigned int)(SERIAL_RX_BUFFER_SIZE + _rx_buffer_head - _rx_buffer_tail)) % SERIAL_RX_BUFFER_SIZE;
+  return (rx_buffer_index_t)(_rx_buffer_head - _rx_buffer_tail) & _rx_mask;
 }
 
 int HardwareSerial::peek(void)
@@ -173,7 +209,7 @@ int HardwareSerial::peek(void)
   if (_rx_buffer_head == _rx_buffer_tail) {
     return -1;
   } else {
-    return _rx_buffer[_rx_buffer_tail];
+    return _rx_buf[_rx_buffer_tail];
   }
 }
 
@@ -183,8 +219,8 @@ int HardwareSerial::read(void)
   if (_rx_buffer_head == _rx_buffer_tail) {
     return -1;
   } else {
-    unsigned char c = _rx_buffer[_rx_buffer_tail];
-    _rx_buffer_tail = (rx_buffer_index_t)(_rx_buffer_tail + 1) % SERIAL_RX_BUFFER_SIZE;
+    unsigned char c = _rx_buf[_rx_buffer_tail];
+    _rx_buffer_tail = (_rx_buffer_tail + 1) & _rx_mask;
     return c;
   }
 }
@@ -198,8 +234,24 @@ int HardwareSerial::availableForWrite(void)
     head = _tx_buffer_head;
     tail = _tx_buffer_tail;
   }
-  if (head >= tail) return SERIAL_TX_BUFFER_SIZE - 1 - head + tail;
-  return tail - head - 1;
+  return (tx_buffer_index_t)(tail - head - 1) & _tx_mask;
+}
+
+uint16_t HardwareSerial::rxOverruns(void)
+{
+  uint16_t n;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    n = _rx_overruns;
+  }
+  return n;
+}
+
+void HardwareSerial::resetRxStats(void)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    _rx_overruns = 0;
+    _rx_high_water = 0;
+  }
 }
 
 void HardwareSerial::flush()
@@ -248,7 +300,7 @@ size_t HardwareSerial::write(uint8_t c)
     }
     return 1;
   }
-  tx_buffer_index_t i = (_tx_buffer_head + 1) % SERIAL_TX_BUFFER_SIZE;
+  tx_buffer_index_t i = (_tx_buffer_head + 1) & _tx_mask;
 	
   // If the output buffer is full, there's nothing for it other than to 
   // wait for the interrupt handler to empty it a bit
@@ -265,7 +317,7 @@ size_t HardwareSerial::write(uint8_t c)
     }
   }
 
-  _tx_buffer[_tx_buffer_head] = c;
+  _tx_buf[_tx_buffer_head] = c;
 
   // make atomic to prevent execution of ISR between setting the
   // head pointer and setting the interrupt flag resulting in buffer
@@ -278,4 +330,52 @@ size_t HardwareSerial::write(uint8_t c)
   return 1;
 }
 
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  // A lone byte may still take the direct UDR shortcut
+  if (size == 1)
+    return write(*buffer);
+
+  size_t n = size;
+  _written = true;
+  while (size) {
+    // Only we move the head, so it can be read without locking
+    tx_buffer_index_t head = _tx_buffer_head;
+    tx_buffer_index_t tail;
+    TX_BUFFER_ATOMIC {
+      tail = _tx_buffer_tail;
+    }
+    tx_buffer_index_t room = (tx_buffer_index_t)(tail - head - 1) & _tx_mask;
+
+    // When the buffer is full, let a quarter of it drain (or room for
+    // all that is left) before copying more, so the spans stay long.
+    // The interrupt keeps the UART busy meanwhile.
+    size_t want = ((size_t)_tx_mask + 1) / 4;
+    if (want > size) want = size;
+    if (room == 0 || room < want) {
+      // Same as write(uint8_t): poll the data register empty flag
+      // ourselves if interrupts are disabled
+      if (bit_is_clear(SREG, SREG_I) && bit_is_set(*_ucsra, UDRE0))
+        _tx_udr_empty_irq();
+      continue;
+    }
+
+    // Copy the free span up to the end of the ring, a wrapped remainder
+    // goes in on the next round
+    size_t span = (size_t)_tx_mask + 1 - head;
+    if (span > room) span = room;
+    if (span > size) span = size;
+    memcpy(_tx_buf + head, buffer, span);
+
+    // Publish the whole span and kick the interrupt in one go
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      _tx_buffer_head = (head + span) & _tx_mask;
+      sbi(*_ucsrb, UDRIE0);
+    }
+    buffer += span;
+    size -= span;
+  }
+  return n;
+}
+
 #endif // whole file
@@ -32,8 +32,8 @@
 // using a ring buffer (I think), in which head is the index of the location
 // to which to write the next incoming character and tail is the index of the
 // location from which to read.
-// NOTE: a "power of 2" buffer size is recommended to dramatically
-//       optimize all the modulo operations for ring buffers.
+// NOTE: buffer sizes must be a power of 2, indexes wrap with a mask.
+//       begin() can also switch an instance to caller supplied buffers.
 // WARNING: When buffer sizes are increased to > 256, the buffer index
 // variables are automatically increased in size, but the extra
 // atomicity guards needed for that are not implemented. This will
@@ -53,6 +53,9 @@
 #define SERIAL_RX_BUFFER_SIZE 64
 #endif
 #endif
+#if (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1)) || (SERIAL_RX_BUFFER_SIZE & (SERIAL_RX_BUFFER_SIZE - 1))
+#error "SERIAL_TX_BUFFER_SIZE and SERIAL_RX_BUFFER_SIZE must be powers of 2"
+#endif
 #if (SERIAL_TX_BUFFER_SIZE>256)
 typedef uint16_t tx_buffer_index_t;
 #else
@@ -107,6 +110,19 @@ class HardwareSerial : public Stream
     volatile tx_buffer_index_t _tx_buffer_head;
     volatile tx_buffer_index_t _tx_buffer_tail;
 
+    // Active buffers, either the ones below or caller supplied ones
+    // passed to begin(). Sizes are powers of 2, the masks are size - 1.
+    unsigned char *_rx_buf;
+    unsigned char *_tx_buf;
+    rx_buffer_index_t _rx_mask;
+    tx_buffer_index_t _tx_mask;
+
+    // Bytes lost because the RX buffer was full, plus one per UART data
+    // overrun (the hardware can't tell how many went missing), and the
+    // highest RX buffer fill level seen
+    volatile uint16_t _rx_overruns;
+    volatile rx_buffer_index_t _rx_high_water;
+
     // Don't put any members after these buffers, since only the first
     // 32 bytes of this struct can be accessed quickly using the ldd
     // instruction.
@@ -120,6 +136,12 @@ class HardwareSerial : public Stream
       volatile uint8_t *ucsrc, volatile uint8_t *udr);
     void begin(unsigned long baud) { begin(baud, SERIAL_8N1); }
     void begin(unsigned long, uint8_t);
+    // Use caller supplied ring buffers. Sizes must be powers of 2 and fit
+    // the index type (256 unless SERIAL_*_BUFFER_SIZE is larger); an
+    // invalid or NULL buffer keeps the built-in one for that direction.
+    void begin(unsigned long baud, uint8_t config,
+               unsigned char *rxBuffer, uint16_t rxSize,
+               unsigned char *txBuffer, uint16_t txSize);
     void end();
     virtual int available(void);
     virtual int peek(void);
@@ -127,6 +149,7 @@ class HardwareSerial : public Stream
     virtual int availableForWrite(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
@@ -134,6 +157,12 @@ class HardwareSerial : public Stream
     using Print::write; // pull in write(str) and write(buf, size) from Print
     operator bool() { return true; }
 
+    // Receive diagnostics: bytes dropped since the last reset and the
+    // fullest the RX buffer has been
+    uint16_t rxOverruns(void);
+    int rxHighWater(void) { return _rx_high_water; }
+    void resetRxStats(void);
+
     // Interrupt handlers - Not intended to be called externally
     inline void _rx_complete_irq(void);
     void _tx_udr_empty_irq(void);
@@ -48,6 +48,7 @@
 #define U2X0 U2X
 #define UPE0 UPE
 #define UDRE0 UDRE
+#define DOR0 DOR
 #elif defined(TXC1)
 // Some devices have uart1 but no uart0
 #define TXC0 TXC1
@@ -58,6 +59,7 @@
 #define U2X0 U2X1
 #define UPE0 UPE1
 #define UDRE0 UDRE1
+#define DOR0 DOR1
 #else
 #error No UART found in HardwareSerial.cpp
 #endif
@@ -92,7 +94,10 @@ HardwareSerial::HardwareSerial(
     _ucsra(ucsra), _ucsrb(ucsrb), _ucsrc(ucsrc),
     _udr(udr),
     _rx_buffer_head(0), _rx_buffer_tail(0),
-    _tx_buffer_head(0), _tx_buffer_tail(0)
+    _tx_buffer_head(0), _tx_buffer_tail(0),
+    _rx_buf(_rx_buffer), _tx_buf(_tx_buffer),
+    _rx_mask(SERIAL_RX_BUFFER_SIZE - 1), _tx_mask(SERIAL_TX_BUFFER_SIZE - 1),
+    _rx_overruns(0), _rx_high_water(0)
 {
 }
 
@@ -100,19 +105,30 @@ HardwareSerial::HardwareSerial(
 
 void HardwareSerial::_rx_complete_irq(void)
 {
-  if (bit_is_clear(*_ucsra, UPE0)) {
+  uint8_t status = *_ucsra;
+  if (bit_is_set(status, DOR0)) {
+    // at least one byte was lost in the UART before we got here
+    _rx_overruns++;
+  }
+  if (bit_is_clear(status, UPE0)) {
     // No Parity error, read byte and store it in the buffer if there is
     // room
     unsigned char c = *_udr;
-    rx_buffer_index_t i = (unsigned int)(_rx_buffer_head + 1) % SERIAL_RX_BUFFER_SIZE;
+    rx_buffer_index_t i = (_rx_buffer_head + 1) & _rx_mask;
 
     // if we should be storing the received character into the location
     // just before the tail (meaning that the head would advance to the
     // current location of the tail), we're about to overflow the buffer
     // and so we don't write the character or advance the head.
     if (i != _rx_buffer_tail) {
-      _rx_buffer[_rx_buffer_head] = c;
+      _rx_buf[_rx_buffer_head] = c;
       _rx_buffer_head = i;
+      rx_buffer_index_t used = (i - _rx_buffer_tail) & _rx_mask;
+      if (used > _rx_high_water) {
+        _rx_high_water = used;
+      }
+    } else {
+      _rx_overruns++;
     }
   } else {
     // Parity error, read byte but discard it
@@ -186,6 +186,19 @@ int		CDC_GetInterface(uint8_t* interfaceNum);
 int		CDC_GetDescriptor(int i);
 bool	CDC_Setup(USBSetup& setup);
 
+// Serial_ output is queued here and moved into the CDC IN endpoint banks
+// from the endpoint interrupt. Must be a power of two, at most 128.
+#ifndef CDC_TX_BUFFER_SIZE
+#define CDC_TX_BUFFER_SIZE 64
+#endif
+#if (CDC_TX_BUFFER_SIZE & (CDC_TX_BUFFER_SIZE - 1)) || CDC_TX_BUFFER_SIZE > 128
+#error "CDC_TX_BUFFER_SIZE must be a power of two, at most 128"
+#endif
+
+int		CDC_TxQueue(const void* data, int len);	// non-blocking, returns bytes queued
+int		CDC_TxSpace(void);
+bool	CDC_TxFlush(void);						// waits until the host took everything
+
 //================================================================================
 //================================================================================
 
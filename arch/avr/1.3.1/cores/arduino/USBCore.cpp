@@ -195,6 +195,11 @@ static inline u8 FrameNumber()
 	return UDFNUML;
 }
 
+static inline u8 BusyBanks()
+{
+	return UESTA0X & ((1<<NBUSYBK1) | (1<<NBUSYBK0));
+}
+
 //==================================================================
 //==================================================================
 
@@ -335,6 +340,102 @@ int USB_Send(u8 ep, const void* d, int len)
 	return r;
 }
 
+#ifdef CDC_ENABLED
+//	CDC TX queue. Serial_::write() only copies into the ring, TxPump() moves
+//	it into the endpoint banks: right away if a bank is free, otherwise from
+//	the TXINI interrupt once the host has taken a packet. A partly filled
+//	bank goes out on the next SOF, so small writes still share a packet.
+static u8 _txBuffer[CDC_TX_BUFFER_SIZE];
+static volatile u8 _txHead;	// free running, written by CDC_TxQueue()
+static volatile u8 _txTail;	// free running, written by TxPump()
+static volatile bool _txZlp;	// last packet was full, the transfer still needs a short one
+
+//	Called with interrupts off
+static void TxPump()
+{
+	SetEP(CDC_TX);
+	while (_txTail != _txHead && ReadWriteAllowed())
+	{
+		Send8(_txBuffer[_txTail & (CDC_TX_BUFFER_SIZE - 1)]);
+		_txTail++;
+		_txZlp = false;
+		if (!ReadWriteAllowed())	// bank full, send it and go on with the other one
+		{
+			ReleaseTX();
+			_txZlp = true;
+		}
+	}
+	if (_txTail != _txHead)
+		UEIENX |= (1<<TXINE);
+	else
+		UEIENX &= ~(1<<TXINE);
+}
+
+//	Called with interrupts off, once per frame
+static void TxFrame()
+{
+	TxPump();
+	if (_txTail == _txHead && ReadWriteAllowed())
+	{
+		if (FifoByteCount() || _txZlp)
+		{
+			ReleaseTX();
+			_txZlp = false;
+		}
+	}
+}
+
+int CDC_TxQueue(const void* d, int len)
+{
+	if (!_usbConfiguration || len < 0)
+		return -1;
+
+	if (_usbSuspendState & (1<<SUSPI)) {
+		//send a remote wakeup
+		UDCON |= (1 << RMWKUP);
+	}
+
+	const u8* data = (const u8*)d;
+	LockEP lock(CDC_TX);
+	u8 n = CDC_TX_BUFFER_SIZE - (u8)(_txHead - _txTail);
+	if (len < n)
+		n = len;
+	for (u8 i = 0; i < n; i++)
+		_txBuffer[(u8)(_txHead + i) & (CDC_TX_BUFFER_SIZE - 1)] = data[i];
+	_txHead += n;
+	TxPump();
+
+	if (n) {
+		TXLED1;					// light the TX LED
+		TxLEDPulse = TX_RX_LED_PULSE_MS;
+	}
+	return n;
+}
+
+int CDC_TxSpace(void)
+{
+	return CDC_TX_BUFFER_SIZE - (u8)(_txHead - _txTail);
+}
+
+bool CDC_TxFlush(void)
+{
+	u8 timeout = 250;
+	while (_usbConfiguration)
+	{
+		{
+			LockEP lock(CDC_TX);
+			TxFrame();
+			if (_txTail == _txHead && !_txZlp && !BusyBanks())
+				return true;
+		}
+		if (!(--timeout))
+			break;
+		delay(1);
+	}
+	return false;
+}
+#endif
+
 u8 _initEndpoints[USB_ENDPOINTS] =
 {
 	0,                      // Control Endpoint
@@ -379,6 +480,10 @@ void InitEndpoints()
 	}
 	UERST = 0x7E;	// And reset them
 	UERST = 0;
+#ifdef CDC_ENABLED
+	_txTail = _txHead;
+	_txZlp = false;
+#endif
 }
 
 //	Handle CLASS_INTERFACE requests
@@ -562,6 +667,12 @@ bool SendDescriptor(USBSetup& setup)
 //	Endpoint 0 interrupt
 ISR(USB_COM_vect)
 {
+#ifdef CDC_ENABLED
+	//	A CDC TX bank became free while data is queued
+	if (UEINT & (1<<CDC_TX))
+		TxPump();
+#endif
+
     SetEP(0);
 	if (!ReceivedSetupInt())
 		return;
@@ -770,7 +881,9 @@ ISR(USB_GEN_vect)
 	//	Start of Frame - happens every millisecond so we use it for TX and RX LED one-shot timing, too
 	if (udint & (1<<SOFI))
 	{
-		USB_Flush(CDC_TX);				// Send a tx frame if found
+#ifdef CDC_ENABLED
+		TxFrame();					// Send a tx frame if found
+#endif
 		
 		// check whether the one-shot period has elapsed.  if so, turn off the LED
 		if (TxLEDPulse && !(--TxLEDPulse))
@@ -79,8 +79,10 @@ void loop()
 	}
 	
 	/* Get X, Y values: */
-	float X_Value = LIS_Accel.getAccelerationX() * Range;
-	float Y_Value = -1 * LIS_Accel.getAccelerationY() * Range;
+	int16_t X_mg, Y_mg, Z_mg;
+	LIS_Accel.getAccelerationMilliG(&X_mg, &Y_mg, &Z_mg);   //All axes in one read, in milli-g
+	int X_Value = (long)X_mg * Range / 1000;
+	int Y_Value = -1 * (long)Y_mg * Range / 1000;
 	
 	Mouse.move(X_Value, Y_Value, 0);
 	
@@ -42,6 +42,7 @@ void setup()
 	  
 	/* Init keyboard control */
 	Keyboard.begin();
+	Keyboard.setPacking(6);   //Send up to 6 different letters per USB report - types the text much faster
 
   /* Get text from user */
   Serial.println("Enter the text you want to attach to Button 1:");
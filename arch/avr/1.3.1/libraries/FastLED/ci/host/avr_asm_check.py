@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# Runs the AVR inline assembly of the nscale8, nscale8_video, nblend and power
+# sum kernels on a small interpreter of the instructions they use, and checks
+# the results against the C formulas they replace. Operands are bound to the
+# registers a compiler could pick; cycle counts use the ATmega timings.
+#
+# usage:
+#   ./avr_asm_check.py
+#
+import os, re, random, sys
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src') + os.sep
+
+def asm_block(path, func_sig):
+    s = open(SRC + path).read()
+    i = s.index(func_sig)
+    j = s.index('asm volatile(', i)
+    k = s.index('\n', j)
+    lines = []
+    for line in s[k:].split('\n'):
+        t = line.strip()
+        if t.startswith(':'):
+            break
+        m = re.match(r'"(.*)"', t)
+        if m:
+            lines.append(m.group(1).replace('\\n', '').replace('\\t', '').strip())
+    return lines
+
+PTR = {26: 'X', 28: 'Y', 30: 'Z'}
+class AVR:
+    def __init__(self, ops):
+        self.r = [0] * 32; self.C = 0; self.Z = 0; self.mem = {}; self.cycles = 0; self.ops = ops
+    def operand(self, tok):
+        tok = tok.strip()
+        m = re.fullmatch(r'%([ABCDa]?)\[(\w+)\](\+?)', tok)
+        if m:
+            mod, name, inc = m.groups()
+            base = self.ops[name]
+            if mod == 'a': return ('ptr', base, inc == '+')
+            return ('reg', base + ' ABCD'.index(mod or ' ') - (1 if mod else 0) if mod else base)
+        if tok == '__tmp_reg__': return ('reg', 0)
+        if tok == '__zero_reg__': return ('reg', 1)
+        m = re.fullmatch(r'r(\d+)', tok)
+        if m: return ('reg', int(m.group(1)))
+        return ('imm', int(tok, 0))
+    def ptr(self, base): return self.r[base] | self.r[base + 1] << 8
+    def setptr(self, base, v): self.r[base] = v & 255; self.r[base + 1] = (v >> 8) & 255
+    def run(self, lines, limit=10**8):
+        prog, labels = [], {}
+        for l in lines:
+            if l.endswith(':'):
+                labels[l[:-1].replace('%=', '0')] = len(prog); continue
+            if not l: continue
+            op, _, args = l.partition(' ')
+            prog.append((op, [a for a in args.split(',')] if args.strip() else []))
+        pc = 0
+        while pc < len(prog):
+            limit -= 1
+            assert limit > 0
+            op, args = prog[pc]; pc += 1
+            A = [self.operand(a) if not a.strip().startswith(('L_', 'R_', 'G_', 'B_')) else ('lab', a.strip().replace('%=', '0')) for a in args]
+            r = self.r
+            if op == 'ld':
+                _, base, inc = A[1]; addr = self.ptr(base); r[A[0][1]] = self.mem.get(addr, 0)
+                if inc: self.setptr(base, addr + 1)
+                self.cycles += 2
+            elif op == 'st':
+                _, base, inc = A[0]; addr = self.ptr(base); self.mem[addr] = r[A[1][1]]
+                if inc: self.setptr(base, addr + 1)
+                self.cycles += 2
+            elif op in ('add', 'adc'):
+                d = A[0][1]; v = r[d] + r[A[1][1]] + (self.C if op == 'adc' else 0)
+                self.C = v >> 8; r[d] = v & 255; self.Z = int(r[d] == 0); self.cycles += 1
+            elif op in ('sub', 'sbc', 'subi', 'sbci'):
+                d = A[0][1]; src = A[1][1] if A[1][0] == 'imm' else r[A[1][1]]
+                v = r[d] - src - (self.C if op in ('sbc', 'sbci') else 0)
+                self.C = int(v < 0); r[d] = v & 255
+                self.Z = int(r[d] == 0) & (self.Z if op in ('sbc', 'sbci') else 1); self.cycles += 1
+            elif op == 'sbiw':
+                d = A[0][1]; v = self.ptr(d) - A[1][1]; self.C = int(v < 0); self.setptr(d, v); self.Z = int(v & 0xffff == 0); self.cycles += 2
+            elif op == 'mul':
+                v = r[A[0][1]] * r[A[1][1]]; r[0] = v & 255; r[1] = v >> 8; self.C = v >> 15; self.Z = int(v == 0); self.cycles += 2
+            elif op == 'mov':
+                r[A[0][1]] = r[A[1][1]]; self.cycles += 1
+            elif op == 'inc':
+                d = A[0][1]; r[d] = (r[d] + 1) & 255; self.Z = int(r[d] == 0); self.cycles += 1
+            elif op == 'tst':
+                self.Z = int(r[A[0][1]] == 0); self.cycles += 1
+            elif op == 'clr':
+                r[A[0][1]] = 0; self.Z = 1; self.cycles += 1
+            elif op in ('brne', 'breq'):
+                take = (self.Z == 0) if op == 'brne' else (self.Z == 1)
+                if take: pc = labels[A[0][1]]; self.cycles += 2
+                else: self.cycles += 1
+            else:
+                raise Exception('unhandled ' + op)
+
+def load(cpu, addr, data):
+    for i, b in enumerate(data): cpu.mem[addr + i] = b
+def dump(cpu, addr, n): return [cpu.mem.get(addr + i, 0) for i in range(n)]
+
+ok = True
+def check(name, cond):
+    global ok
+    if not cond: ok = False; print('MISMATCH', name)
+
+rnd = random.Random(1)
+# --- nscale8 (FASTLED_SCALE8_FIXED == 1 wrapper: 255 returns, else scale+1)
+code = asm_block('colorutils.cpp', 'void nscale8( CRGB* leds, uint16_t num_leds, uint8_t scale)\n{')
+cyc = {}
+for scale in list(range(256)):
+    n = rnd.randint(1, 40); px = [rnd.randrange(256) for _ in range(3 * n)]
+    ref = [(v * (scale + 1)) >> 8 for v in px]
+    if scale == 255: got = px
+    else:
+        cpu = AVR({'p': 30, 'n': 24, 't': 18, 'scale': 20}); load(cpu, 0x100, px)
+        cpu.setptr(30, 0x100); cpu.setptr(24, n); cpu.r[20] = scale + 1; cpu.run(code); got = dump(cpu, 0x100, 3 * n)
+        check('nscale8 r1', cpu.r[1] == 0); cyc['nscale8'] = cpu.cycles / n
+    check('nscale8 %d' % scale, got == ref)
+# --- nscale8_video
+code = asm_block('colorutils.cpp', 'void nscale8_video( CRGB* leds, uint16_t num_leds, uint8_t scale)\n{')
+for scale in range(1, 256):
+    n = 64; px = [rnd.choice([0, rnd.randrange(256)]) for _ in range(3 * n)]
+    ref = [0 if v == 0 else ((v * scale) >> 8) + 1 for v in px]
+    cpu = AVR({'p': 30, 'n': 24, 't': 18, 'scale': 20}); load(cpu, 0x100, px)
+    cpu.setptr(30, 0x100); cpu.setptr(24, n); cpu.r[20] = scale; cpu.run(code)
+    check('video %d' % scale, dump(cpu, 0x100, 3 * n) == ref); check('video r1', cpu.r[1] == 0)
+cpu = AVR({'p': 30, 'n': 24, 't': 18, 'scale': 20}); load(cpu, 0x100, [200] * 300); cpu.setptr(30, 0x100); cpu.setptr(24, 100); cpu.r[20] = 100; cpu.run(code); cyc['nscale8_video lit'] = cpu.cycles / 100
+cpu = AVR({'p': 30, 'n': 24, 't': 18, 'scale': 20}); load(cpu, 0x100, [0] * 300); cpu.setptr(30, 0x100); cpu.setptr(24, 100); cpu.r[20] = 100; cpu.run(code); cyc['nscale8_video black'] = cpu.cycles / 100
+# --- nblend
+code = asm_block('colorutils.cpp', 'void nblend( CRGB* existing, CRGB* overlay, uint16_t count, fract8 amountOfOverlay)\n{')
+def blend8(a, b, amt):
+    partial = ((a << 8) | b) & 0xffff; partial = (partial + b * amt) & 0xffff; partial = (partial - a * amt) & 0xffff
+    return partial >> 8
+for amt in range(1, 255):
+    n = rnd.randint(1, 30); ex = [rnd.randrange(256) for _ in range(3 * n)]; ov = [rnd.randrange(256) for _ in range(3 * n)]
+    ref = [blend8(a, b, amt) for a, b in zip(ex, ov)]
+    cpu = AVR({'dst': 26, 'src': 30, 'n': 24, 'a': 18, 'b': 19, 'partial': 20, 'amount': 22})
+    load(cpu, 0x100, ex); load(cpu, 0x400, ov); cpu.setptr(26, 0x100); cpu.setptr(30, 0x400); cpu.setptr(24, n); cpu.r[22] = amt
+    cpu.run(code); check('nblend %d' % amt, dump(cpu, 0x100, 3 * n) == ref); check('nblend src', dump(cpu, 0x400, 3 * n) == ov)
+    check('nblend r1', cpu.r[1] == 0); cyc['nblend'] = cpu.cycles / n
+# --- power sum
+code = asm_block('power_mgt.cpp', 'static void sum_channels')
+for n in [1, 2, 3, 100, 1000, 21000]:
+    px = [255] * (3 * n) if n > 1000 else [rnd.randrange(256) for _ in range(3 * n)]
+    cpu = AVR({'red': 8, 'green': 12, 'blue': 2, 'p': 30, 'count': 24}); load(cpu, 0x100, px)
+    cpu.setptr(30, 0x100); cpu.setptr(24, n); cpu.run(code, limit=10**9)
+    got = [cpu.r[b] | cpu.r[b + 1] << 8 | cpu.r[b + 2] << 16 | cpu.r[b + 3] << 24 for b in (8, 12, 2)]
+    check('power %d' % n, got == [sum(px[0::3]), sum(px[1::3]), sum(px[2::3])]); cyc['power sum'] = cpu.cycles / n
+for k, v in cyc.items(): print('%-22s %.1f cycles/pixel' % (k, v))
+print('all kernels match the C formulas' if ok else 'FAILED')
+sys.exit(0 if ok else 1)
@@ -0,0 +1,261 @@
+/// @file bench.cpp
+/// Golden output checks and per pixel timings of the color, noise, blur and
+/// scaling code, built natively on the stub platform (see PORTING.md).
+///
+///   bench golden.txt          compare against the recorded hashes, then time
+///   bench --check golden.txt  only compare
+///   bench --write golden.txt  record the hashes of this build
+///
+/// Each golden entry is an FNV-1a hash over the outputs of one function
+/// family on fixed inputs, so any change in the produced colors shows up
+/// as a failed entry while pure speedups keep passing.
+
+#include "FastLED.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#define WIDTH  16
+#define HEIGHT 16
+#define NUM_LEDS (WIDTH * HEIGHT)
+
+static CRGB leds[NUM_LEDS];
+static CRGB other[NUM_LEDS];
+
+// serpentine layout
+uint16_t XY(uint8_t x, uint8_t y) {
+    return (y & 1) ? y * WIDTH + (WIDTH - 1 - x) : y * WIDTH + x;
+}
+
+static const uint32_t FNV_BASIS = 2166136261u;
+
+static uint32_t fnv(const void *data, size_t n, uint32_t h) {
+    const uint8_t *p = (const uint8_t *)data;
+    while(n--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void seed() {
+    for(int i = 0; i < NUM_LEDS; i++) {
+        leds[i] = CRGB(i * 7, i * 13 + 5, 255 - i * 3);
+        other[i] = CRGB(i * 11, 200 - i, i * 5);
+    }
+}
+
+static std::map<std::string, uint32_t> golden;
+
+static void record(const char *name, uint32_t h) {
+    golden[name] = h;
+}
+
+static void color_goldens() {
+    uint32_t h = FNV_BASIS;
+    for(int hue = 0; hue < 256; hue++) {
+        for(int sat = 0; sat < 256; sat += 15) {
+            for(int val = 0; val < 256; val += 17) {
+                CRGB c;
+                hsv2rgb_rainbow(CHSV(hue, sat, val), c);
+                h = fnv(&c, 3, h);
+            }
+        }
+    }
+    record("hsv2rgb_rainbow", h);
+
+    h = FNV_BASIS;
+    for(int i = 0; i < 256; i++) {
+        for(int bri : {255, 128, 7}) {
+            CRGB c = ColorFromPalette(RainbowColors_p, i, bri, LINEARBLEND);
+            h = fnv(&c, 3, h);
+            c = ColorFromPalette(LavaColors_p, i * 3, bri, NOBLEND);
+            h = fnv(&c, 3, h);
+        }
+    }
+    record("ColorFromPalette", h);
+}
+
+static void noise_goldens() {
+    uint32_t h = FNV_BASIS;
+    for(int x = 0; x < 65536; x += 97) {
+        for(int y = 0; y < 65536; y += 4099) {
+            uint16_t n = inoise16(x * 17, y * 13, x ^ y);
+            h = fnv(&n, 2, h);
+            n = inoise16(x * 5, y * 3);
+            h = fnv(&n, 2, h);
+        }
+    }
+    record("inoise16", h);
+
+    h = FNV_BASIS;
+    for(uint32_t i = 0; i < 20000; i++) {
+        uint32_t x = i * 2654435761u, y = i * 40503u + 7, z = i * 977u;
+        int16_t r = inoise16_raw(x, y, z);
+        h = fnv(&r, 2, h);
+        r = inoise16_raw(x >> 3, y);
+        h = fnv(&r, 2, h);
+        uint8_t n = inoise8(x, y, z);
+        h = fnv(&n, 1, h);
+        int8_t r8 = inoise8_raw(x, y);
+        h = fnv(&r8, 1, h);
+    }
+    record("inoise16_raw/inoise8", h);
+
+    h = FNV_BASIS;
+    for(int t = 0; t < 8; t++) {
+        fill_noise16(leds, NUM_LEDS, 1, t * 1000, 300, 1, 0, 200, t * 3000, 5);
+        h = fnv(leds, sizeof(leds), h);
+        fill_2dnoise16(leds, WIDTH, HEIGHT, true, 2, t * 777, 1200, 9000, 900, t * 50000, 1, 4321, 800, 2, 60, t * 50, false);
+        h = fnv(leds, sizeof(leds), h);
+    }
+    record("fill_noise16/fill_2dnoise16", h);
+
+    // the raw fill helpers add into their output, so start from fixed data
+    h = FNV_BASIS;
+    static uint8_t bytes[NUM_LEDS];
+    static uint16_t words[NUM_LEDS];
+    for(int t = 0; t < 24; t++) {
+        uint8_t octaves = 1 + t % 4;
+        int w = 1 + (t * 5) % WIDTH, hgt = 1 + (t * 3) % HEIGHT;
+        int scale = (t & 1) ? -(t * 97) : t * 211 + 1;
+        uint32_t time = t * 123457u;
+        memset(bytes, t, sizeof(bytes));
+        fill_raw_noise16into8(bytes, 200, octaves, t * 99991u, scale, time);
+        h = fnv(bytes, sizeof(bytes), h);
+        memset(bytes, t, sizeof(bytes));
+        fill_raw_2dnoise16into8(bytes, w, hgt, octaves, t * 7919u, scale, t * 104729u, 1200 - scale, time);
+        h = fnv(bytes, sizeof(bytes), h);
+        for(int i = 0; i < NUM_LEDS; i++) {
+            words[i] = i * 77;
+        }
+        fill_raw_2dnoise16(words, w, hgt, octaves, q88(2, 0), 40000, 1 + t % 3, t * 7919u, scale, t * 104729u, 1200 - scale, time);
+        h = fnv(words, sizeof(words), h);
+        memset(bytes, t, sizeof(bytes));
+        fill_raw_2dnoise8(bytes, w, hgt, octaves, t * 31, scale, t * 57, 300, time);
+        h = fnv(bytes, sizeof(bytes), h);
+        memset(bytes, t, sizeof(bytes));
+        fill_raw_noise8(bytes, 200, octaves, t * 31, scale, time);
+        h = fnv(bytes, sizeof(bytes), h);
+    }
+    record("fill_raw_noise", h);
+}
+
+static void blend_goldens() {
+    seed();
+    uint32_t h = FNV_BASIS;
+    for(fract8 amount : {0, 1, 64, 128, 200, 255}) {
+        blur2d(leds, WIDTH, HEIGHT, amount);
+        h = fnv(leds, sizeof(leds), h);
+        blur1d(leds, NUM_LEDS, amount);
+        h = fnv(leds, sizeof(leds), h);
+    }
+    record("blur2d/blur1d", h);
+
+    seed();
+    h = FNV_BASIS;
+    for(int amount : {0, 1, 77, 128, 254, 255}) {
+        nblend(leds, other, NUM_LEDS, amount);
+        h = fnv(leds, sizeof(leds), h);
+    }
+    for(int amount : {0, 1, 20, 128, 255}) {
+        fadeToBlackBy(leds, NUM_LEDS, amount);
+        h = fnv(leds, sizeof(leds), h);
+        seed();
+        fade_video(leds, NUM_LEDS, amount);
+        h = fnv(leds, sizeof(leds), h);
+    }
+    record("nblend/fadeToBlackBy/fade_video", h);
+
+    h = FNV_BASIS;
+    for(int scale : {0, 1, 2, 100, 254, 255}) {
+        seed();
+        nscale8(leds, NUM_LEDS, scale);
+        h = fnv(leds, sizeof(leds), h);
+        seed();
+        nscale8_video(leds, NUM_LEDS, scale);
+        h = fnv(leds, sizeof(leds), h);
+    }
+    seed();
+    for(int n = 0; n <= NUM_LEDS; n += 37) {
+        uint32_t mW = calculate_unscaled_power_mW(leds, n);
+        h = fnv(&mW, sizeof(mW), h);
+        uint8_t bri = calculate_max_brightness_for_power_mW(leds, n, 255, 400);
+        h = fnv(&bri, 1, h);
+    }
+    record("nscale8/power", h);
+}
+
+template <class F> static double time_ns(F f, int iters) {
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i = 0; i < iters; i++) {
+        f(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / iters;
+}
+
+static void report(const char *name, double ns_per_frame) {
+    printf("%-28s %8.2f ns/px\n", name, ns_per_frame / NUM_LEDS);
+}
+
+int main(int argc, char **argv) {
+    color_goldens();
+    noise_goldens();
+    blend_goldens();
+
+    int bad = 0;
+    bool timings = true;
+    if(argc > 2 && !strcmp(argv[1], "--check")) {
+        timings = false;
+        argv++;
+        argc--;
+    }
+    if(argc > 2 && !strcmp(argv[1], "--write")) {
+        FILE *f = fopen(argv[2], "w");
+        if(!f) {
+            return 1;
+        }
+        for(auto &g : golden) {
+            fprintf(f, "%08x %s\n", g.second, g.first.c_str());
+        }
+        fclose(f);
+        printf("wrote %zu golden hashes\n", golden.size());
+    } else if(argc > 1) {
+        FILE *f = fopen(argv[1], "r");
+        if(!f) {
+            return 1;
+        }
+        char name[128];
+        unsigned value;
+        size_t n = 0;
+        while(fscanf(f, "%x %127s", &value, name) == 2) {
+            bool ok = golden.count(name) && golden[name] == value;
+            bad += !ok;
+            n++;
+            printf("%s %s\n", ok ? "OK  " : "FAIL", name);
+        }
+        fclose(f);
+        if(n != golden.size()) {
+            printf("FAIL golden file has %zu of %zu entries\n", n, golden.size());
+            bad++;
+        }
+    }
+
+    if(!timings) {
+        printf("%s\n", bad ? "FAILED" : "ok");
+        return bad != 0;
+    }
+
+    seed();
+    report("hsv2rgb_rainbow", time_ns([](int i) { for(int p = 0; p < NUM_LEDS; p++) { hsv2rgb_rainbow(CHSV(p + i, 240, 255), leds[p]); } }, 20000));
+    report("fill_noise16", time_ns([](int i) { fill_noise16(leds, NUM_LEDS, 1, i * 100, 300, 1, 0, 200, i * 300, 5); }, 2000));
+    report("fill_2dnoise16", time_ns([](int i) { fill_2dnoise16(leds, WIDTH, HEIGHT, true, 2, 0, 1200, 9000, 900, i * 500, 1, 4321, 800, 2, 60, i * 50, false); }, 2000));
+    report("blur2d", time_ns([](int) { blur2d(leds, WIDTH, HEIGHT, 64); }, 20000));
+    report("ColorFromPalette", time_ns([](int i) { for(int p = 0; p < NUM_LEDS; p++) { leds[p] = ColorFromPalette(RainbowColors_p, p + i, 255, LINEARBLEND); } }, 20000));
+    report("nblend", time_ns([](int i) { nblend(leds, other, NUM_LEDS, 1 + (i & 127)); }, 50000));
+    report("fadeToBlackBy", time_ns([](int i) { fadeToBlackBy(leds, NUM_LEDS, i & 15); }, 50000));
+    printf("%s\n", bad ? "FAILED" : "ok");
+    return bad != 0;
+}
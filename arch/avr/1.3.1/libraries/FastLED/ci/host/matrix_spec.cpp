@@ -0,0 +1,178 @@
+/// @file matrix_spec.cpp
+/// CLEDMatrix against the XY() based code it replaces: index tables for every
+/// layout flag combination and a shuffled custom layout, blur2d(),
+/// blurRows() and blurColumns() byte for byte against the free functions,
+/// shift() and scroll() against naive per pixel copies. Then timings on 16x16.
+
+#include "FastLED.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static std::mt19937 rng(99);
+static int W, H, L;                 // current size and layout, L < 0 for the custom one
+static std::vector<uint16_t> perm;  // custom layout
+
+static uint16_t ref_index(int x, int y) {
+    if(L < 0) {
+        return perm[y * W + x];
+    }
+    int u = (L & MATRIX_FLIP_X) ? W - 1 - x : x;
+    int v = (L & MATRIX_FLIP_Y) ? H - 1 - y : y;
+    bool cols = L & MATRIX_COLUMNS;
+    int line = cols ? u : v, pos = cols ? v : u, len = cols ? H : W;
+    if((L & MATRIX_SERPENTINE) && (line & 1)) {
+        pos = len - 1 - pos;
+    }
+    return line * len + pos;
+}
+
+// what the free blur functions use
+uint16_t XY(uint8_t x, uint8_t y) {
+    return ref_index(x, y);
+}
+
+static long fails;
+
+#define CHECK(cond) do { if(!(cond)) { if(++fails < 10) { printf("FAIL line %d: %dx%d layout %d\n", __LINE__, W, H, L); } } } while(0)
+
+static void randomize(CRGB *a, int n) {
+    for(int i = 0; i < n; i++) {
+        a[i] = CRGB(rng(), rng(), rng());
+    }
+    // saturated channels and near black exercise the carry paths of the blur
+    if(rng() & 1) {
+        for(int i = 0; i < n; i++) {
+            if(rng() % 3) {
+                a[i] = CRGB(rng() & 0xe0, 255, rng() & 7);
+            }
+        }
+    }
+}
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main() {
+    static CRGB a[1024], b[1024], c[1024];
+    static uint16_t map[1024];
+    const int sizes[][2] = {{16, 16}, {7, 5}, {5, 7}, {1, 9}, {9, 1}, {1, 1}, {2, 2}, {32, 8}, {8, 32}, {13, 3}};
+    for(auto &size : sizes) {
+        for(int layout = -1; layout < 16; layout++) {
+            for(int rep = 0; rep < 30; rep++) {
+                W = size[0];
+                H = size[1];
+                L = layout;
+                int N = W * H;
+                size_t bytes = sizeof(CRGB) * N;
+                if(L < 0) {
+                    perm.resize(N);
+                    for(int i = 0; i < N; i++) {
+                        perm[i] = i;
+                    }
+                    std::shuffle(perm.begin(), perm.end(), rng);
+                }
+                CLEDMatrix m(b, W, H, map, L < 0 ? 0 : L);
+                if(L < 0) {
+                    m.setLayout(XY);
+                }
+                for(int y = 0; y < H; y++) {
+                    for(int x = 0; x < W; x++) {
+                        CHECK(m.XY(x, y) == ref_index(x, y));
+                    }
+                }
+
+                uint8_t amount = rng();
+                randomize(a, N);
+                memcpy(b, a, bytes);
+                blur2d(a, W, H, amount);
+                m.blur2d(amount);
+                CHECK(!memcmp(a, b, bytes));
+                randomize(a, N);
+                memcpy(b, a, bytes);
+                blurRows(a, W, H, amount);
+                m.blurRows(amount);
+                CHECK(!memcmp(a, b, bytes));
+                randomize(a, N);
+                memcpy(b, a, bytes);
+                blurColumns(a, W, H, amount);
+                m.blurColumns(amount);
+                CHECK(!memcmp(a, b, bytes));
+
+                int dx = (int)(rng() % 41) - 20, dy = (int)(rng() % 41) - 20;
+                if(rep & 1) {
+                    dx = (int)(rng() % 3) - 1;
+                    dy = (int)(rng() % 3) - 1;
+                }
+                if(rep == 2) {
+                    dx = -128;
+                    dy = 127;
+                }
+                randomize(a, N);
+                memcpy(b, a, bytes);
+                CRGB fill(1, 2, 3);
+                m.shift(dx, dy, fill);
+                for(int y = 0; y < H; y++) {
+                    for(int x = 0; x < W; x++) {
+                        int sx = x - dx, sy = y - dy;
+                        CRGB want = (sx >= 0 && sx < W && sy >= 0 && sy < H) ? a[ref_index(sx, sy)] : fill;
+                        CHECK(b[ref_index(x, y)] == want);
+                    }
+                }
+                randomize(a, N);
+                memcpy(b, a, bytes);
+                m.scroll(dx, dy);
+                for(int y = 0; y < H; y++) {
+                    for(int x = 0; x < W; x++) {
+                        int sx = ((x - dx) % W + W) % W, sy = ((y - dy) % H + H) % H;
+                        CHECK(b[ref_index(x, y)] == a[ref_index(sx, sy)]);
+                    }
+                }
+
+                if(W == 16 && H == 16 && L >= 0) {
+                    CLEDMatrixArray<16, 16> inline_table(c, L);
+                    for(int y = 0; y < H; y++) {
+                        for(int x = 0; x < W; x++) {
+                            CHECK(inline_table.XY(x, y) == m.XY(x, y));
+                        }
+                    }
+                    CHECK(&inline_table(3, 4) == c + inline_table.XY(3, 4));
+                }
+            }
+        }
+    }
+    printf("%ld mismatches\n", fails);
+
+    // 16x16, best of 10
+    W = H = 16;
+    const int F = 20000;
+    volatile uint8_t sink = 0;
+    for(int layout : {(int)MATRIX_SERPENTINE, (int)MATRIX_ROWS, MATRIX_ROTATE_90 | MATRIX_SERPENTINE}) {
+        L = layout;
+        CLEDMatrixArray<16, 16> m(b, L);
+        double best[4] = {1e9, 1e9, 1e9, 1e9};
+        for(int r = 0; r < 10; r++) {
+            double t0 = now();
+            for(int f = 0; f < F; f++) { blur2d(a, 16, 16, 64); sink += a[f & 255].r; }
+            double t1 = now();
+            for(int f = 0; f < F; f++) { m.blur2d(64); sink += b[f & 255].r; }
+            double t2 = now();
+            for(int f = 0; f < F; f++) { m.scroll(1, 0); sink += b[f & 255].r; }
+            double t3 = now();
+            for(int f = 0; f < F; f++) { m.scroll(0, -1); sink += b[f & 255].r; }
+            double t4 = now();
+            double d[4] = {t1 - t0, t2 - t1, t3 - t2, t4 - t3};
+            for(int i = 0; i < 4; i++) {
+                best[i] = std::min(best[i], d[i]);
+            }
+        }
+        printf("layout %2d: blur2d(XY) %.1f, CLEDMatrix::blur2d %.1f, scroll x %.1f, scroll y %.1f ns/px\n", layout,
+               best[0] / F / 256 * 1e9, best[1] / F / 256 * 1e9, best[2] / F / 256 * 1e9, best[3] / F / 256 * 1e9);
+    }
+    printf("%s\n", fails ? "FAILED" : "ok");
+    return fails != 0;
+}
@@ -0,0 +1,105 @@
+/// @file noise_spec.cpp
+/// CNoiseField16 against inoise16() point by point for random grids, steep
+/// and shallow, 2D and 3D, the 2D fills on rows wider than the columns they
+/// cache, then the cost of a 16x16 frame both ways. That the fill_raw_*
+/// helpers built on it still produce the same bytes as before is covered by
+/// the "fill_raw_noise" entry of golden.txt.
+
+#include "FastLED.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+uint16_t XY(uint8_t x, uint8_t y) {
+    return y * 16 + x;
+}
+
+static std::mt19937 rng(1234);
+static long fails;
+
+#define CHECK(cond) do { if(!(cond)) { if(++fails < 10) { printf("FAIL line %d\n", __LINE__); } } } while(0)
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main() {
+    static uint16_t field[256];
+    for(int t = 0; t < 300; t++) {
+        CNoiseFieldArray16<16, 16> f;
+        uint32_t x = rng(), y = rng();
+        int32_t sx = (int32_t)(rng() % 200001) - 100000, sy = (int32_t)(rng() % 200001) - 100000;
+        if(t & 1) {
+            sx /= 50;
+            sy /= 50;
+        }
+        f.setGrid(x, sx, y, sy);
+        for(int k = 0; k < 4; k++) {
+            uint32_t z = rng();
+            f.fill(field, z);
+            for(int i = 0; i < 16; i++) {
+                for(int j = 0; j < 16; j++) {
+                    CHECK(field[i * 16 + j] == inoise16(x + j * sx, y + i * sy, z));
+                }
+            }
+            f.fill(field);
+            for(int i = 0; i < 16; i++) {
+                for(int j = 0; j < 16; j++) {
+                    CHECK(field[i * 16 + j] == inoise16(x + j * sx, y + i * sy));
+                }
+            }
+        }
+    }
+    printf("%ld mismatches\n", fails);
+
+    // one octave at full amplitude is the folded inoise16() of the top left
+    // point of each skip x skip block
+    static uint16_t words[64 * 8];
+    static uint8_t bytes[64 * 8];
+    for(int t = 0; t < 200; t++) {
+        int width = 1 + t % 64, height = 1 + t % 8, skip = 1 + t % 3;
+        uint32_t x = rng() >> 1, y = rng() >> 1, time = rng();
+        int sx = (int)(rng() % 20001) - 10000, sy = (int)(rng() % 20001) - 10000;
+        fill_raw_2dnoise16(words, width, height, 1, q88(2, 0), 0, skip, x, sx, y, sy, time);
+        fill_raw_2dnoise16into8(bytes, width, height, 1, x, sx, y, sy, time);
+        for(int i = 0; i < height; i++) {
+            for(int j = 0; j < width; j++) {
+                uint16_t n = inoise16(x + j / skip * skip * sx, y + i / skip * skip * sy, time);
+                n = (0x8000 & n) ? n - 32767 : 32767 - n;
+                CHECK(words[i * width + j] == (uint16_t)(n << 1));
+                n = inoise16(x + j * sx, y + i * sy, time);
+                n = (0x8000 & n) ? n - 32767 : 32767 - n;
+                CHECK(bytes[i * width + j] == n >> 7);
+            }
+        }
+    }
+    printf("2D fills up to 64 wide: %ld mismatches\n", fails);
+
+    // 3D 16x16 frame per z step, best of 15
+    static CNoiseFieldArray16<16, 16> f;
+    f.setGrid(0, 1200, 0, 1200);
+    volatile uint32_t sink = 0;
+    const int F = 4000;
+    double best_loop = 1e9, best_field = 1e9;
+    for(int rep = 0; rep < 15; rep++) {
+        double t0 = now();
+        for(int fr = 0; fr < F; fr++) {
+            for(int i = 0; i < 16; i++) {
+                for(int j = 0; j < 16; j++) {
+                    sink += inoise16(j * 1200u, i * 1200u, fr * 300u);
+                }
+            }
+        }
+        double t1 = now();
+        for(int fr = 0; fr < F; fr++) {
+            f.fill(field, fr * 300u);
+            sink += field[fr & 255];
+        }
+        double t2 = now();
+        best_loop = std::min(best_loop, t1 - t0);
+        best_field = std::min(best_field, t2 - t1);
+    }
+    printf("16x16 3D noise: inoise16 loop %.1f ns/px, CNoiseField16 %.1f ns/px\n", best_loop / F / 256 * 1e9, best_field / F / 256 * 1e9);
+    printf("%s\n", fails ? "FAILED" : "ok");
+    return fails != 0;
+}
@@ -0,0 +1,107 @@
+/// @file power_spec.cpp
+/// CPowerTracker against a full calculate_unscaled_power_mW() pass after
+/// random tracked writes, range updates and invalidations, and the power
+/// limited brightness with and without a tracker on the controller.
+
+#include "FastLED.h"
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+
+#define NUM_LEDS 600
+
+static CRGB leds[NUM_LEDS];
+static CRGB leds2[150];
+
+uint16_t XY(uint8_t x, uint8_t y) {
+    return y * 16 + x;
+}
+
+static uint32_t rng = 7;
+
+static uint8_t r8() {
+    rng = rng * 1103515245 + 12345;
+    return rng >> 16;
+}
+
+static uint16_t r16() {
+    return r8() << 8 | r8();
+}
+
+int main() {
+    for(CRGB &c : leds) {
+        c = CRGB(r8(), r8(), r8());
+    }
+    CLEDController &strip = FastLED.addLeds<WS2812B, 2, GRB>(leds, NUM_LEDS);
+    FastLED.addLeds<WS2812B, 3, GRB>(leds2, 150);
+    CPowerTracker tracker(leds, NUM_LEDS);
+    strip.setPowerTracker(&tracker);
+
+    long bad = 0;
+    const int frames = 20000;
+    for(int frame = 0; frame < frames; frame++) {
+        int op = r8() % 4;
+        if(op == 0) {
+            tracker[r16() % NUM_LEDS] = CRGB(r8(), r8(), r8());
+        } else if(op == 1) {
+            tracker.set(r16() % NUM_LEDS, CRGB(r8(), 0, r8()));
+        } else if(op == 2) {
+            int first = r16() % NUM_LEDS, count = 1 + r8() % 20;
+            if(first + count > NUM_LEDS) {
+                count = NUM_LEDS - first;
+            }
+            tracker.beginUpdate(first, count);
+            for(int i = first; i < first + count; i++) {
+                leds[i].r >>= 1;
+                leds[i].g = r8();
+            }
+            tracker.endUpdate(first, count);
+        } else if(r8() < 8) {
+            fill_solid(leds, NUM_LEDS, CRGB::White);  // untracked bulk write
+            tracker.invalidate();
+        }
+        if(tracker.unscaled_power_mW() != calculate_unscaled_power_mW(leds, NUM_LEDS)) {
+            bad++;
+        }
+        // the controller walk must give the same brightness as a full pass
+        for(int bri : {255, 128}) {
+            for(uint32_t limit : {2000u, 20000u, 200000u}) {
+                uint8_t tracked = calculate_max_brightness_for_power_mW(bri, limit);
+                strip.setPowerTracker(NULL);
+                uint8_t full = calculate_max_brightness_for_power_mW(bri, limit);
+                strip.setPowerTracker(&tracker);
+                if(tracked != full) {
+                    bad++;
+                }
+            }
+        }
+    }
+    printf("%d frames, %ld mismatches\n", frames, bad);
+
+    // cost per frame with a few changed pixels
+    volatile uint32_t sink = 0;
+    const int F = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int f = 0; f < F; f++) {
+        for(int k = 0; k < 4; k++) {
+            leds[(f * 7 + k) % NUM_LEDS].r++;
+        }
+        sink += calculate_unscaled_power_mW(leds, NUM_LEDS);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for(int f = 0; f < F; f++) {
+        for(int k = 0; k < 4; k++) {
+            int i = (f * 7 + k) % NUM_LEDS;
+            CRGB c = leds[i];
+            c.r++;
+            tracker.set(i, c);
+        }
+        sink += tracker.unscaled_power_mW();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    printf("%d LEDs, 4 changed per frame: full pass %.0f ns/frame, tracked %.0f ns/frame\n", NUM_LEDS,
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / F,
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / F);
+    printf("%s\n", bad ? "FAILED" : "ok");
+    return bad != 0;
+}
@@ -215,9 +215,58 @@ void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB
 
 void nscale8_video( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
+#if SCALE8_AVRASM == 1
+    if( num_leds == 0) {
+        return;
+    }
+    // with scale 0 every channel goes to black, otherwise non-zero
+    // channels become (i * scale >> 8) + 1
+    if( scale == 0) {
+        fill_solid( leds, num_leds, CRGB::Black);
+        return;
+    }
+    uint8_t* p = (uint8_t*)leds;
+    uint8_t t;
+
+    // 34 cycles per pixel, 25 for a black one
+    asm volatile(
+        "L_%=:                   \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  tst %[t]              \n\t"
+        "  breq R_%=             \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  mov %[t], r1          \n\t"
+        "  inc %[t]              \n\t"
+        "R_%=:                   \n\t"
+        "  st %a[p]+, %[t]       \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  tst %[t]              \n\t"
+        "  breq G_%=             \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  mov %[t], r1          \n\t"
+        "  inc %[t]              \n\t"
+        "G_%=:                   \n\t"
+        "  st %a[p]+, %[t]       \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  tst %[t]              \n\t"
+        "  breq B_%=             \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  mov %[t], r1          \n\t"
+        "  inc %[t]              \n\t"
+        "B_%=:                   \n\t"
+        "  st %a[p]+, %[t]       \n\t"
+        "  sbiw %[n], 1          \n\t"
+        "  brne L_%=             \n\t"
+        "  clr __zero_reg__      \n\t"
+        : [p] "+e" (p), [n] "+w" (num_leds), [t] "=&r" (t)
+        : [scale] "r" (scale)
+        : "r0", "r1", "memory"
+    );
+#else
     for( uint16_t i = 0; i < num_leds; ++i) {
         leds[i].nscale8_video( scale);
     }
+#endif
 }
 
 void fade_video(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
@@ -250,9 +299,45 @@ void nscale8_raw( CRGB* leds, uint16_t num_leds, uint8_t scale)
 
 void nscale8( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
+#if SCALE8_AVRASM == 1
+#if (FASTLED_SCALE8_FIXED == 1)
+    // the fixed scale8 is i * (scale + 1) >> 8, so 255 is a no-op and
+    // anything else needs just one mul per channel
+    if( scale == 255) {
+        return;
+    }
+    ++scale;
+#endif
+    if( num_leds == 0) {
+        return;
+    }
+    uint8_t* p = (uint8_t*)leds;
+    uint8_t t;
+
+    // 22 cycles per pixel
+    asm volatile(
+        "L_%=:                   \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  st %a[p]+, r1         \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  st %a[p]+, r1         \n\t"
+        "  ld %[t], %a[p]        \n\t"
+        "  mul %[t], %[scale]    \n\t"
+        "  st %a[p]+, r1         \n\t"
+        "  sbiw %[n], 1          \n\t"
+        "  brne L_%=             \n\t"
+        "  clr __zero_reg__      \n\t"
+        : [p] "+e" (p), [n] "+w" (num_leds), [t] "=&r" (t)
+        : [scale] "r" (scale)
+        : "r0", "r1", "memory"
+    );
+#else
     for( uint16_t i = 0; i < num_leds; ++i) {
         leds[i].nscale8( scale);
     }
+#endif
 }
 
 void fadeUsingColor( CRGB* leds, uint16_t numLeds, const CRGB& colormask)
@@ -307,11 +392,74 @@ CRGB& nblend( CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay )
 
 void nblend( CRGB* existing, CRGB* overlay, uint16_t count, fract8 amountOfOverlay)
 {
+#if BLEND8_AVRASM == 1 && (FASTLED_BLEND_FIXED == 1) && (FASTLED_SCALE8_FIXED == 1)
+    // same special cases as the single pixel nblend()
+    if( amountOfOverlay == 0 || count == 0) {
+        return;
+    }
+    if( amountOfOverlay == 255) {
+        for( uint16_t i = count; i; --i) {
+            *existing++ = *overlay++;
+        }
+        return;
+    }
+    uint8_t* dst = (uint8_t*)existing;
+    const uint8_t* src = (const uint8_t*)overlay;
+    uint8_t a, b;
+    uint16_t partial;
+
+    // blend8() per channel, (A*256 + B + B*amountOfB - A*amountOfB) / 256,
+    // in 52 cycles per pixel
+    asm volatile(
+        "L_%=:                            \n\t"
+        "  ld %[a], %a[dst]               \n\t"
+        "  ld %[b], %a[src]+              \n\t"
+        "  mov %A[partial], %[b]          \n\t"
+        "  mov %B[partial], %[a]          \n\t"
+        "  mul %[a], %[amount]            \n\t"
+        "  sub %A[partial], r0            \n\t"
+        "  sbc %B[partial], r1            \n\t"
+        "  mul %[b], %[amount]            \n\t"
+        "  add %A[partial], r0            \n\t"
+        "  adc %B[partial], r1            \n\t"
+        "  st %a[dst]+, %B[partial]       \n\t"
+        "  ld %[a], %a[dst]               \n\t"
+        "  ld %[b], %a[src]+              \n\t"
+        "  mov %A[partial], %[b]          \n\t"
+        "  mov %B[partial], %[a]          \n\t"
+        "  mul %[a], %[amount]            \n\t"
+        "  sub %A[partial], r0            \n\t"
+        "  sbc %B[partial], r1            \n\t"
+        "  mul %[b], %[amount]            \n\t"
+        "  add %A[partial], r0            \n\t"
+        "  adc %B[partial], r1            \n\t"
+        "  st %a[dst]+, %B[partial]       \n\t"
+        "  ld %[a], %a[dst]               \n\t"
+        "  ld %[b], %a[src]+              \n\t"
+        "  mov %A[partial], %[b]          \n\t"
+        "  mov %B[partial], %[a]          \n\t"
+        "  mul %[a], %[amount]            \n\t"
+        "  sub %A[partial], r0            \n\t"
+        "  sbc %B[partial], r1            \n\t"
+        "  mul %[b], %[amount]            \n\t"
+        "  add %A[partial], r0            \n\t"
+        "  adc %B[partial], r1            \n\t"
+        "  st %a[dst]+, %B[partial]       \n\t"
+        "  sbiw %[n], 1                   \n\t"
+        "  brne L_%=                      \n\t"
+        "  clr __zero_reg__               \n\t"
+        : [dst] "+e" (dst), [src] "+e" (src), [n] "+w" (count),
+          [a] "=&r" (a), [b] "=&r" (b), [partial] "=&r" (partial)
+        : [amount] "r" (amountOfOverlay)
+        : "r0", "r1", "memory"
+    );
+#else
     for( uint16_t i = count; i; --i) {
         nblend( *existing, *overlay, amountOfOverlay);
         ++existing;
         ++overlay;
     }
+#endif
 }
 
 CRGB blend( const CRGB& p1, const CRGB& p2, fract8 amountOfP2 )
@@ -497,6 +645,207 @@ void blurColumns(CRGB* leds, uint8_t width, uint8_t height, fract8 blur_amount)
 
 
 
+// CLEDMatrix walks a row or a column through one of these two, the first
+// one when the line is evenly spaced in the LED array and the second one
+// through the lookup table otherwise.
+struct MatrixStepLine {
+    MatrixStepLine(CRGB *leds, const uint16_t *map, uint8_t mapStep, uint8_t count)
+        : first(leds + map[0]), step(count > 1 ? (int16_t)(map[mapStep] - map[0]) : 0) {}
+    CRGB &operator[](uint8_t i) const { return first[(int16_t)i * step]; }
+    CRGB *first;
+    int16_t step;
+};
+
+struct MatrixMapLine {
+    MatrixMapLine(CRGB *leds, const uint16_t *map, uint8_t mapStep, uint8_t)
+        : leds(leds), map(map), step(mapStep) {}
+    CRGB &operator[](uint8_t i) const { return leds[map[(uint16_t)i * step]]; }
+    CRGB *leds;
+    const uint16_t *map;
+    uint8_t step;
+};
+
+// Runs op(line, count) on every row (mapStep 1, lineStep width) or column
+// (mapStep width, lineStep 1) of the lookup table
+template<class OP>
+static void matrix_each_line(OP &op, CRGB *leds, const uint16_t *map, bool stepped,
+                             uint8_t lines, uint8_t lineStep, uint8_t count, uint8_t mapStep)
+{
+    for( uint8_t l = 0; l < lines; ++l, map += lineStep) {
+        if( stepped) {
+            op( MatrixStepLine( leds, map, mapStep, count), count);
+        } else {
+            op( MatrixMapLine( leds, map, mapStep, count), count);
+        }
+    }
+}
+
+// Same steps as blur1d()
+struct MatrixBlur {
+    MatrixBlur(fract8 blur_amount) : keep(255 - blur_amount), seep(blur_amount >> 1) {}
+    template<class LINE> void operator()(const LINE &line, uint8_t count) const {
+        CRGB carryover = CRGB::Black;
+        CRGB *prev = NULL;
+        for( uint8_t i = 0; i < count; ++i) {
+            CRGB &px = line[i];
+            CRGB cur = px;
+            CRGB part = cur;
+            part.nscale8( seep);
+            cur.nscale8( keep);
+            cur += carryover;
+            if( prev) *prev += part;
+            px = cur;
+            carryover = part;
+            prev = &px;
+        }
+    }
+    uint8_t keep;
+    uint8_t seep;
+};
+
+struct MatrixShift {
+    MatrixShift(int8_t n, const CRGB &fill) : n(n), fill(fill) {}
+    template<class LINE> void operator()(const LINE &line, uint8_t count) const {
+        if( n > 0) {
+            uint8_t i = count;
+            for( ; i > n; --i) line[i - 1] = line[i - 1 - n];
+            for( ; i > 0; --i) line[i - 1] = fill;
+        } else {
+            uint8_t m = -n;
+            uint8_t i = 0;
+            for( ; i + m < count; ++i) line[i] = line[i + m];
+            for( ; i < count; ++i) line[i] = fill;
+        }
+    }
+    int8_t n;
+    const CRGB &fill;
+};
+
+// Rotates each line by n towards the higher end, following the gcd(count, n)
+// cycles of the permutation so every pixel is moved exactly once
+struct MatrixScroll {
+    MatrixScroll(uint8_t n, uint8_t count) : n(n) {
+        uint8_t a = count, b = n;
+        while( b) { uint8_t t = a % b; a = b; b = t; }
+        cycles = a;
+    }
+    template<class LINE> void operator()(const LINE &line, uint8_t count) const {
+        for( uint8_t s = 0; s < cycles; ++s) {
+            CRGB tmp = line[s];
+            uint8_t j = s;
+            for( ;;) {
+                uint8_t k = (j >= n) ? (j - n) : (j + count - n);
+                if( k == s) break;
+                line[j] = line[k];
+                j = k;
+            }
+            line[j] = tmp;
+        }
+    }
+    uint8_t n;
+    uint8_t cycles;
+};
+
+// n mod count, in 0..count-1
+static uint8_t matrix_wrap(int8_t n, uint8_t count)
+{
+    int16_t m = n % (int16_t)count;
+    return (m < 0) ? m + count : m;
+}
+
+void CLEDMatrix::setLayout(uint8_t layout)
+{
+    bool columns = layout & MATRIX_COLUMNS;
+    uint8_t lineLength = columns ? m_nHeight : m_nWidth;
+    uint16_t *map = m_Map;
+    for( uint8_t y = 0; y < m_nHeight; ++y) {
+        uint8_t v = (layout & MATRIX_FLIP_Y) ? (m_nHeight - 1 - y) : y;
+        for( uint8_t x = 0; x < m_nWidth; ++x) {
+            uint8_t u = (layout & MATRIX_FLIP_X) ? (m_nWidth - 1 - x) : x;
+            uint8_t line = columns ? u : v;
+            uint8_t pos = columns ? v : u;
+            if( (layout & MATRIX_SERPENTINE) && (line & 0x01)) {
+                pos = lineLength - 1 - pos;
+            }
+            *map++ = (uint16_t)line * lineLength + pos;
+        }
+    }
+    checkSteps();
+}
+
+void CLEDMatrix::setLayout(uint16_t (*xy)(uint8_t x, uint8_t y))
+{
+    uint16_t *map = m_Map;
+    for( uint8_t y = 0; y < m_nHeight; ++y) {
+        for( uint8_t x = 0; x < m_nWidth; ++x) {
+            *map++ = xy(x, y);
+        }
+    }
+    checkSteps();
+}
+
+void CLEDMatrix::checkSteps()
+{
+    m_bRowsStep = true;
+    m_bColsStep = true;
+    for( uint8_t y = 0; y < m_nHeight && m_bRowsStep; ++y) {
+        const uint16_t *row = m_Map + (uint16_t)y * m_nWidth;
+        for( uint8_t x = 2; x < m_nWidth; ++x) {
+            if( (uint16_t)(row[x] - row[x-1]) != (uint16_t)(row[1] - row[0])) {
+                m_bRowsStep = false;
+                break;
+            }
+        }
+    }
+    for( uint8_t x = 0; x < m_nWidth && m_bColsStep; ++x) {
+        const uint16_t *col = m_Map + x;
+        for( uint8_t y = 2; y < m_nHeight; ++y) {
+            if( (uint16_t)(col[(uint16_t)y * m_nWidth] - col[(uint16_t)(y-1) * m_nWidth]) != (uint16_t)(col[m_nWidth] - col[0])) {
+                m_bColsStep = false;
+                break;
+            }
+        }
+    }
+}
+
+void CLEDMatrix::blurRows(fract8 blur_amount)
+{
+    MatrixBlur op(blur_amount);
+    matrix_each_line(op, m_Leds, m_Map, m_bRowsStep, m_nHeight, m_nWidth, m_nWidth, 1);
+}
+
+void CLEDMatrix::blurColumns(fract8 blur_amount)
+{
+    MatrixBlur op(blur_amount);
+    matrix_each_line(op, m_Leds, m_Map, m_bColsStep, m_nWidth, 1, m_nHeight, m_nWidth);
+}
+
+void CLEDMatrix::shift(int8_t dx, int8_t dy, const CRGB &fill)
+{
+    if( dx) {
+        MatrixShift op(dx, fill);
+        matrix_each_line(op, m_Leds, m_Map, m_bRowsStep, m_nHeight, m_nWidth, m_nWidth, 1);
+    }
+    if( dy) {
+        MatrixShift op(dy, fill);
+        matrix_each_line(op, m_Leds, m_Map, m_bColsStep, m_nWidth, 1, m_nHeight, m_nWidth);
+    }
+}
+
+void CLEDMatrix::scroll(int8_t dx, int8_t dy)
+{
+    uint8_t nx = m_nWidth ? matrix_wrap(dx, m_nWidth) : 0;
+    uint8_t ny = m_nHeight ? matrix_wrap(dy, m_nHeight) : 0;
+    if( nx) {
+        MatrixScroll op(nx, m_nWidth);
+        matrix_each_line(op, m_Leds, m_Map, m_bRowsStep, m_nHeight, m_nWidth, m_nWidth, 1);
+    }
+    if( ny) {
+        MatrixScroll op(ny, m_nHeight);
+        matrix_each_line(op, m_Leds, m_Map, m_bColsStep, m_nWidth, 1, m_nHeight, m_nWidth);
+    }
+}
+
 // CRGB HeatColor( uint8_t temperature)
 //
 // Approximates a 'black body radiation' spectrum for
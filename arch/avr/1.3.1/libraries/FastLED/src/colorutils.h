@@ -455,6 +455,114 @@ void blurColumns(CRGB* leds, uint8_t width, uint8_t height, fract8 blur_amount);
 /// @} ColorBlurs
 
 
+/// @defgroup ColorMatrix LED Matrix
+/// Two-dimensional effects on an LED matrix through a precomputed XY table
+/// @{
+
+/// How the strip is wired through the matrix, for CLEDMatrix::setLayout().
+/// Combine one of MATRIX_ROWS / MATRIX_COLUMNS with any of the other flags.
+/// The flips are applied first, then MATRIX_SERPENTINE counts lines from
+/// the first LED on.
+typedef enum {
+    MATRIX_ROWS       = 0x00,  ///< the strip runs along the rows, first LED at (0,0)
+    MATRIX_COLUMNS    = 0x01,  ///< the strip runs along the columns
+    MATRIX_SERPENTINE = 0x02,  ///< every other row (column) runs backwards
+    MATRIX_FLIP_X     = 0x04,  ///< mirrored left to right
+    MATRIX_FLIP_Y     = 0x08,  ///< mirrored top to bottom
+
+    MATRIX_ROTATE_90  = MATRIX_COLUMNS | MATRIX_FLIP_X,  ///< row layout panel turned a quarter clockwise
+    MATRIX_ROTATE_180 = MATRIX_FLIP_X | MATRIX_FLIP_Y,   ///< row layout panel turned upside down
+    MATRIX_ROTATE_270 = MATRIX_COLUMNS | MATRIX_FLIP_Y   ///< row layout panel turned a quarter counter-clockwise
+} EMatrixLayout;
+
+/// An LED array seen as a width x height matrix.
+/// The LED index of every (x, y) is looked up once in setLayout() and kept
+/// in a table of width * height entries, so the blur and shift functions
+/// never call XY(). Rows or columns that are evenly spaced in the LED array
+/// (all of them along the wiring direction, and both ways for non
+/// serpentine layouts) are walked with a plain pointer step.
+///
+/// blur2d(), blurRows() and blurColumns() give the same result as the free
+/// functions of the same name with the same mapping as XY().
+class CLEDMatrix {
+public:
+    /// @param leds the LED array
+    /// @param width the width of the matrix
+    /// @param height the height of the matrix
+    /// @param map storage for width * height LED indices
+    /// @param layout wiring of the matrix, a combination of EMatrixLayout flags
+    CLEDMatrix(CRGB *leds, uint8_t width, uint8_t height, uint16_t *map, uint8_t layout = MATRIX_ROWS)
+        : m_Leds(leds), m_Map(map), m_nWidth(width), m_nHeight(height) { setLayout(layout); }
+
+    /// Map the matrix with one of the built-in wirings
+    /// @param layout a combination of EMatrixLayout flags
+    void setLayout(uint8_t layout);
+
+    /// Map the matrix with an XY() function, for irregular wirings
+    /// @param xy returns the LED index of a given column and row
+    void setLayout(uint16_t (*xy)(uint8_t x, uint8_t y));
+
+    /// LED index of a pixel
+    uint16_t XY(uint8_t x, uint8_t y) const { return m_Map[(uint16_t)y * m_nWidth + x]; }
+
+    /// Access a pixel
+    CRGB &operator()(uint8_t x, uint8_t y) { return m_Leds[XY(x, y)]; }
+
+    /// @copydoc ::blur2d()
+    void blur2d(fract8 blur_amount) { blurRows(blur_amount); blurColumns(blur_amount); }
+
+    /// @copydoc ::blurRows()
+    void blurRows(fract8 blur_amount);
+
+    /// @copydoc ::blurColumns()
+    void blurColumns(fract8 blur_amount);
+
+    /// Move the picture, the pixels moved out are dropped
+    /// @param dx columns to move by, positive moves towards higher x
+    /// @param dy rows to move by, positive moves towards higher y
+    /// @param fill color of the pixels moved in
+    void shift(int8_t dx, int8_t dy, const CRGB &fill = CRGB::Black);
+
+    /// Move the picture, the pixels moved out come back in on the other side
+    /// @param dx columns to move by, positive moves towards higher x
+    /// @param dy rows to move by, positive moves towards higher y
+    void scroll(int8_t dx, int8_t dy);
+
+    /// The LED array
+    CRGB *leds() const { return m_Leds; }
+    /// The width of the matrix
+    uint8_t width() const { return m_nWidth; }
+    /// The height of the matrix
+    uint8_t height() const { return m_nHeight; }
+
+private:
+    void checkSteps();
+
+    CRGB *m_Leds;
+    uint16_t *m_Map;
+    uint8_t m_nWidth;
+    uint8_t m_nHeight;
+    bool m_bRowsStep;  ///< every row is evenly spaced in the LED array
+    bool m_bColsStep;  ///< every column is evenly spaced in the LED array
+};
+
+/// CLEDMatrix with its own WIDTH x HEIGHT lookup table
+/// @tparam WIDTH the width of the matrix
+/// @tparam HEIGHT the height of the matrix
+template<uint8_t WIDTH, uint8_t HEIGHT>
+class CLEDMatrixArray : public CLEDMatrix {
+    uint16_t m_Table[WIDTH * HEIGHT];  ///< the LED index of every pixel
+
+public:
+    /// @param leds the LED array
+    /// @param layout wiring of the matrix, a combination of EMatrixLayout flags
+    CLEDMatrixArray(CRGB *leds, uint8_t layout = MATRIX_ROWS)
+        : CLEDMatrix(leds, WIDTH, HEIGHT, m_Table, layout) {}
+};
+
+/// @} ColorMatrix
+
+
 /// @addtogroup ColorFills
 /// @{
 
@@ -47,6 +47,8 @@ FASTLED_NAMESPACE_BEGIN
 /// The dither setting, either DISABLE_DITHER or BINARY_DITHER
 typedef uint8_t EDitherMode;
 
+class CPowerTracker;
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // LED Controller interface definition
@@ -67,6 +69,7 @@ protected:
     CRGB m_ColorTemperature;   ///< CRGB object representing the color temperature to apply to the strip on show() @see setTemperature
     EDitherMode m_DitherMode;  ///< the current dither mode of the controller
     int m_nLeds;               ///< the number of LEDs in the LED data array
+    CPowerTracker *m_pPowerTracker;  ///< running power sums for m_Data, or NULL for a full pass per show()  @see setPowerTracker
     static CLEDController *m_pHead;  ///< pointer to the first LED controller in the linked list
     static CLEDController *m_pTail;  ///< pointer to the last LED controller in the linked list
 
@@ -84,7 +87,7 @@ protected:
 
 public:
     /// Create an led controller object, add it to the chain of controllers
-    CLEDController() : m_Data(NULL), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_nLeds(0) {
+    CLEDController() : m_Data(NULL), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_nLeds(0), m_pPowerTracker(NULL) {
         m_pNext = NULL;
         if(m_pHead==NULL) { m_pHead = this; }
         if(m_pTail != NULL) { m_pTail->m_pNext = this; }
@@ -194,6 +197,16 @@ public:
     /// @copydoc setCorrection()
     CLEDController & setCorrection(LEDColorCorrection correction) { m_ColorCorrection = correction; return *this; }
 
+    /// Use a CPowerTracker's running sums for this controller's LEDs when
+    /// limiting power, instead of adding up the whole array on every show()
+    /// @param tracker the tracker watching this controller's LED data, or NULL
+    /// @returns a reference to the controller
+    CLEDController & setPowerTracker(CPowerTracker *tracker) { m_pPowerTracker = tracker; return *this; }
+
+    /// Get the power tracker used by this controller
+    /// @returns the tracker (CLEDController::m_pPowerTracker), or NULL if there is none
+    CPowerTracker *getPowerTracker() { return m_pPowerTracker; }
+
     /// Get the correction value used by this controller
     /// @returns the current color correction (CLEDController::m_ColorCorrection)
     CRGB getCorrection() { return m_ColorCorrection; }
@@ -109,6 +109,9 @@ template<int LOOP, int PAD> inline void _delaycycles_AVR() {
 template<int CYCLES> __attribute__((always_inline)) inline void delaycycles() {
 	_delaycycles_AVR<CYCLES / 3, CYCLES % 3>();
 }
+#elif defined(FASTLED_STUB)
+// native host builds don't drive anything, so there is nothing to time
+template<int CYCLES> __attribute__((always_inline)) inline void delaycycles() { }
 #else
 // template<int LOOP, int PAD> inline void _delaycycles_ARM() {
 // 	delaycycles<PAD>();
@@ -299,14 +299,28 @@ static int8_t inline __attribute__((always_inline)) lerp7by8( int8_t a, int8_t b
     return result;
 }
 
-int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z)
+// The 16-bit 2D and 3D noise is split into the per-coordinate terms, the
+// lattice hashing and the interpolation, so that CNoiseField16 and the fill
+// functions can keep the first two around while the last one stays shared
+// with inoise16() and bit-exact with it.
+
+static void inline __attribute__((always_inline)) noise16_axis_set(noise16_axis &a, uint32_t v)
 {
     // Find the unit cube containing the point
-    uint8_t X = (x>>16)&0xFF;
-    uint8_t Y = (y>>16)&0xFF;
-    uint8_t Z = (z>>16)&0xFF;
+    a.cell = (v>>16)&0xFF;
 
-    // Hash cube corner coordinates
+    // Get the relative position of the point in the cube
+    uint16_t u = v & 0xFFFF;
+
+    // Get a signed version of the above for the grad function
+    a.offset = (u >> 1) & 0x7FFF;
+    a.fade = EASE16(u);
+}
+
+// Hash cube corner coordinates, h[] gets the gradient selectors of the
+// eight corners
+static void inline __attribute__((always_inline)) noise16_hash(uint8_t *h, uint8_t X, uint8_t Y, uint8_t Z)
+{
     uint8_t A = P(X)+Y;
     uint8_t AA = P(A)+Z;
     uint8_t AB = P(A+1)+Z;
@@ -314,36 +328,59 @@ int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z)
     uint8_t BA = P(B) + Z;
     uint8_t BB = P(B+1)+Z;
 
-    // Get the relative position of the point in the cube
-    uint16_t u = x & 0xFFFF;
-    uint16_t v = y & 0xFFFF;
-    uint16_t w = z & 0xFFFF;
+    h[0] = P(AA);   h[1] = P(BA);   h[2] = P(AB);   h[3] = P(BB);
+    h[4] = P(AA+1); h[5] = P(BA+1); h[6] = P(AB+1); h[7] = P(BB+1);
+}
 
-    // Get a signed version of the above for the grad function
-    int16_t xx = (u >> 1) & 0x7FFF;
-    int16_t yy = (v >> 1) & 0x7FFF;
-    int16_t zz = (w >> 1) & 0x7FFF;
-    uint16_t N = 0x8000L;
+// Hash square corner coordinates, h[] gets the gradient selectors of the
+// four corners
+static void inline __attribute__((always_inline)) noise16_hash(uint8_t *h, uint8_t X, uint8_t Y)
+{
+    uint8_t A = P(X)+Y;
+    uint8_t B = P(X+1)+Y;
 
-    u = EASE16(u); v = EASE16(v); w = EASE16(w);
+    h[0] = P(P(A)); h[1] = P(P(B)); h[2] = P(P(A+1)); h[3] = P(P(B+1));
+}
+
+static int16_t inline __attribute__((always_inline)) noise16_lerp(const uint8_t *h, const noise16_axis &x, const noise16_axis &y, const noise16_axis &z)
+{
+    int16_t xx = x.offset;
+    int16_t yy = y.offset;
+    int16_t zz = z.offset;
+    uint16_t N = 0x8000L;
 
     // skip the log fade adjustment for the moment, otherwise here we would
     // adjust fade values for u,v,w
-    int16_t X1 = LERP(grad16(P(AA), xx, yy, zz), grad16(P(BA), xx - N, yy, zz), u);
-    int16_t X2 = LERP(grad16(P(AB), xx, yy-N, zz), grad16(P(BB), xx - N, yy - N, zz), u);
-    int16_t X3 = LERP(grad16(P(AA+1), xx, yy, zz-N), grad16(P(BA+1), xx - N, yy, zz-N), u);
-    int16_t X4 = LERP(grad16(P(AB+1), xx, yy-N, zz-N), grad16(P(BB+1), xx - N, yy - N, zz - N), u);
+    int16_t X1 = LERP(grad16(h[0], xx, yy, zz), grad16(h[1], xx - N, yy, zz), x.fade);
+    int16_t X2 = LERP(grad16(h[2], xx, yy-N, zz), grad16(h[3], xx - N, yy - N, zz), x.fade);
+    int16_t X3 = LERP(grad16(h[4], xx, yy, zz-N), grad16(h[5], xx - N, yy, zz-N), x.fade);
+    int16_t X4 = LERP(grad16(h[6], xx, yy-N, zz-N), grad16(h[7], xx - N, yy - N, zz - N), x.fade);
 
-    int16_t Y1 = LERP(X1,X2,v);
-    int16_t Y2 = LERP(X3,X4,v);
+    int16_t Y1 = LERP(X1,X2,y.fade);
+    int16_t Y2 = LERP(X3,X4,y.fade);
 
-    int16_t ans = LERP(Y1,Y2,w);
+    int16_t ans = LERP(Y1,Y2,z.fade);
 
     return ans;
 }
 
-uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
-    int32_t ans = inoise16_raw(x,y,z);
+static int16_t inline __attribute__((always_inline)) noise16_lerp(const uint8_t *h, const noise16_axis &x, const noise16_axis &y)
+{
+    int16_t xx = x.offset;
+    int16_t yy = y.offset;
+    uint16_t N = 0x8000L;
+
+    int16_t X1 = LERP(grad16(h[0], xx, yy), grad16(h[1], xx - N, yy), x.fade);
+    int16_t X2 = LERP(grad16(h[2], xx, yy-N), grad16(h[3], xx - N, yy - N), x.fade);
+
+    int16_t ans = LERP(X1,X2,y.fade);
+
+    return ans;
+}
+
+static uint16_t inline __attribute__((always_inline)) noise16_scale3d(int16_t raw3d)
+{
+    int32_t ans = raw3d;
     ans = ans + 19052L;
     uint32_t pan = ans;
     // pan = (ans * 220L) >> 7.  That's the same as:
@@ -358,41 +395,9 @@ uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
     // return scale16by8(inoise16_raw(x,y,z)+19052,220)<<1;
 }
 
-int16_t inoise16_raw(uint32_t x, uint32_t y)
+static uint16_t inline __attribute__((always_inline)) noise16_scale2d(int16_t raw2d)
 {
-    // Find the unit cube containing the point
-    uint8_t X = x>>16;
-    uint8_t Y = y>>16;
-
-    // Hash cube corner coordinates
-    uint8_t A = P(X)+Y;
-    uint8_t AA = P(A);
-    uint8_t AB = P(A+1);
-    uint8_t B = P(X+1)+Y;
-    uint8_t BA = P(B);
-    uint8_t BB = P(B+1);
-
-    // Get the relative position of the point in the cube
-    uint16_t u = x & 0xFFFF;
-    uint16_t v = y & 0xFFFF;
-
-    // Get a signed version of the above for the grad function
-    int16_t xx = (u >> 1) & 0x7FFF;
-    int16_t yy = (v >> 1) & 0x7FFF;
-    uint16_t N = 0x8000L;
-
-    u = EASE16(u); v = EASE16(v);
-
-    int16_t X1 = LERP(grad16(P(AA), xx, yy), grad16(P(BA), xx - N, yy), u);
-    int16_t X2 = LERP(grad16(P(AB), xx, yy-N), grad16(P(BB), xx - N, yy - N), u);
-
-    int16_t ans = LERP(X1,X2,v);
-
-    return ans;
-}
-
-uint16_t inoise16(uint32_t x, uint32_t y) {
-    int32_t ans = inoise16_raw(x,y);
+    int32_t ans = raw2d;
     ans = ans + 17308L;
     uint32_t pan = ans;
     // pan = (ans * 242L) >> 7.  That's the same as:
@@ -406,6 +411,39 @@ uint16_t inoise16(uint32_t x, uint32_t y) {
     // return scale16by8(inoise16_raw(x,y)+17308,242)<<1;
 }
 
+int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z)
+{
+    noise16_axis ax, ay, az;
+    noise16_axis_set(ax, x);
+    noise16_axis_set(ay, y);
+    noise16_axis_set(az, z);
+
+    uint8_t h[8];
+    noise16_hash(h, ax.cell, ay.cell, az.cell);
+
+    return noise16_lerp(h, ax, ay, az);
+}
+
+uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
+    return noise16_scale3d(inoise16_raw(x,y,z));
+}
+
+int16_t inoise16_raw(uint32_t x, uint32_t y)
+{
+    noise16_axis ax, ay;
+    noise16_axis_set(ax, x);
+    noise16_axis_set(ay, y);
+
+    uint8_t h[4];
+    noise16_hash(h, ax.cell, ay.cell);
+
+    return noise16_lerp(h, ax, ay);
+}
+
+uint16_t inoise16(uint32_t x, uint32_t y) {
+    return noise16_scale2d(inoise16_raw(x,y));
+}
+
 int16_t inoise16_raw(uint32_t x)
 {
     // Find the unit cube containing the point
@@ -591,9 +629,21 @@ void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16
 void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint32_t x, int scale, uint32_t time) {
   uint32_t _xx = x;
   uint32_t scx = scale;
+  // inoise16(xx,time), with the time terms worked out once and the corner
+  // hashes reused while xx stays in the same cell
+  noise16_axis at;
+  noise16_axis_set(at, time);
   for(int o = 0; o < octaves; ++o) {
+    uint8_t h[4] = { 0 };  // filled in by the first point
+    int16_t hashed = -1;
     for(int i = 0,xx=_xx; i < num_points; ++i, xx+=scx) {
-      uint32_t accum = (inoise16(xx,time))>>o;
+      noise16_axis ax;
+      noise16_axis_set(ax, xx);
+      if(ax.cell != hashed) {
+        noise16_hash(h, ax.cell, at.cell);
+        hashed = ax.cell;
+      }
+      uint32_t accum = noise16_scale2d(noise16_lerp(h, ax, at))>>o;
       accum += (pData[i]<<8);
       if(accum > 65535) { accum = 65535; }
       pData[i] = accum>>8;
@@ -656,6 +706,12 @@ void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, u
   fill_raw_2dnoise8(pData, width, height, octaves, q44(2,0), 128, 1, x, scalex, y, scaley, time);
 }
 
+// Columns of the 2D fills whose terms are kept on the stack, 5 bytes each.
+// Columns past these go through inoise16() as before.
+#ifndef FASTLED_NOISE16_FILL_COLUMNS
+#define FASTLED_NOISE16_FILL_COLUMNS 16
+#endif
+
 void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves, q88 freq88, fract16 amplitude, int skip, uint32_t x, int scalex, uint32_t y, int scaley, uint32_t time) {
   if(octaves > 1) {
     fill_raw_2dnoise16(pData, width, height, octaves-1, freq88, amplitude, skip, x *freq88 , scalex *freq88, y * freq88, scaley * freq88, time);
@@ -664,13 +720,41 @@ void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves,
     amplitude=65535;
   }
 
+  if(width <= 0 || height <= 0) { return; }
+
   scalex *= skip;
   scaley *= skip;
   fract16 invamp = 65535-amplitude;
+
+  // inoise16(xx,y,time), with the time and leading column terms worked out
+  // once and the corner hashes reused while xx stays in the same cell
+  noise16_axis cols[FASTLED_NOISE16_FILL_COLUMNS];
+  int cached = 0;
+  noise16_axis az;
+  noise16_axis_set(az, time);
+  for(int j = 0,xx=x; j < width && cached < FASTLED_NOISE16_FILL_COLUMNS; j+=skip, xx+=scalex) {
+    noise16_axis_set(cols[cached++], xx);
+  }
+
   for(int i = 0; i < height; i+=skip, y+=scaley) {
     uint16_t *pRow = pData + (i*width);
-    for(int j = 0,xx=x; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
+    noise16_axis ay;
+    noise16_axis_set(ay, y);
+    uint8_t h[8];
+    uint8_t hashed = cols[0].cell;
+    noise16_hash(h, hashed, ay.cell, az.cell);
+    for(int j = 0,c = 0,xx=x; j < width; j+=skip, ++c, xx+=scalex) {
+      uint16_t noise_base;
+      if(c < cached) {
+        const noise16_axis &ax = cols[c];
+        if(ax.cell != hashed) {
+          noise16_hash(h, ax.cell, ay.cell, az.cell);
+          hashed = ax.cell;
+        }
+        noise_base = noise16_scale3d(noise16_lerp(h, ax, ay, az));
+      } else {
+        noise_base = inoise16(xx,y,time);
+      }
       noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
       noise_base = scale16(noise_base<<1, amplitude);
       if(skip==1) {
@@ -702,15 +786,44 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
     amplitude=255;
   }
 
+  if(width <= 0 || height <= 0) { return; }
+
   scalex *= skip;
   scaley *= skip;
   uint32_t xx;
   fract8 invamp = 255-amplitude;
+
+  // inoise16(xx,y,time), with the time and leading column terms worked out
+  // once and the corner hashes reused while xx stays in the same cell
+  noise16_axis cols[FASTLED_NOISE16_FILL_COLUMNS];
+  int cached = 0;
+  noise16_axis az;
+  noise16_axis_set(az, time);
+  xx = x;
+  for(int j = 0; j < width && cached < FASTLED_NOISE16_FILL_COLUMNS; j+=skip, xx+=scalex) {
+    noise16_axis_set(cols[cached++], xx);
+  }
+
   for(int i = 0; i < height; i+=skip, y+=scaley) {
     uint8_t *pRow = pData + (i*width);
+    noise16_axis ay;
+    noise16_axis_set(ay, y);
+    uint8_t h[8];
+    uint8_t hashed = cols[0].cell;
+    noise16_hash(h, hashed, ay.cell, az.cell);
     xx = x;
-    for(int j = 0; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
+    for(int j = 0,c = 0; j < width; j+=skip, ++c, xx+=scalex) {
+      uint16_t noise_base;
+      if(c < cached) {
+        const noise16_axis &ax = cols[c];
+        if(ax.cell != hashed) {
+          noise16_hash(h, ax.cell, ay.cell, az.cell);
+          hashed = ax.cell;
+        }
+        noise_base = noise16_scale3d(noise16_lerp(h, ax, ay, az));
+      } else {
+        noise_base = inoise16(xx,y,time);
+      }
       noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
       noise_base = scale8(noise_base>>7,amplitude);
       if(skip==1) {
@@ -731,6 +844,51 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
   fill_raw_2dnoise16into8(pData, width, height, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
 }
 
+void CNoiseField16::setGrid(uint32_t x, int32_t scalex, uint32_t y, int32_t scaley) {
+  for(uint8_t j = 0; j < m_nWidth; ++j, x+=scalex) {
+    noise16_axis_set(m_Cols[j], x);
+  }
+  for(uint8_t i = 0; i < m_nHeight; ++i, y+=scaley) {
+    noise16_axis_set(m_Rows[i], y);
+  }
+}
+
+void CNoiseField16::fill(uint16_t *pData, uint32_t z) const {
+  noise16_axis az;
+  noise16_axis_set(az, z);
+  for(uint8_t i = 0; i < m_nHeight; ++i) {
+    const noise16_axis &ay = m_Rows[i];
+    uint8_t h[8];
+    uint8_t hashed = m_Cols[0].cell;
+    noise16_hash(h, hashed, ay.cell, az.cell);
+    for(uint8_t j = 0; j < m_nWidth; ++j) {
+      const noise16_axis &ax = m_Cols[j];
+      if(ax.cell != hashed) {
+        noise16_hash(h, ax.cell, ay.cell, az.cell);
+        hashed = ax.cell;
+      }
+      *pData++ = noise16_scale3d(noise16_lerp(h, ax, ay, az));
+    }
+  }
+}
+
+void CNoiseField16::fill(uint16_t *pData) const {
+  for(uint8_t i = 0; i < m_nHeight; ++i) {
+    const noise16_axis &ay = m_Rows[i];
+    uint8_t h[4];
+    uint8_t hashed = m_Cols[0].cell;
+    noise16_hash(h, hashed, ay.cell);
+    for(uint8_t j = 0; j < m_nWidth; ++j) {
+      const noise16_axis &ax = m_Cols[j];
+      if(ax.cell != hashed) {
+        noise16_hash(h, ax.cell, ay.cell);
+        hashed = ax.cell;
+      }
+      *pData++ = noise16_scale2d(noise16_lerp(h, ax, ay));
+    }
+  }
+}
+
 void fill_noise8(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
             uint8_t hue_octaves, uint16_t hue_x, int hue_scale,
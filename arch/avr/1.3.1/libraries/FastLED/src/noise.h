@@ -157,6 +157,81 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
 /// @} Raw Fill Functions
 
 
+/// @name Noise Fields
+/// 16-bit noise over a fixed grid, for animations that redraw the same
+/// matrix every frame.
+/// @{
+
+/// Lattice position and fade of one 16.16 noise coordinate
+struct noise16_axis {
+    uint8_t cell;    ///< integer part of the coordinate, the lattice cell
+    int16_t offset;  ///< fractional part, halved, as fed to the gradients
+    uint16_t fade;   ///< fractional part after easing, used to interpolate
+};
+
+/// A grid of inoise16() sample points, spaced evenly along x and y.
+/// The lattice cell and fade of every column and row are worked out once by
+/// setGrid() and kept, and the corner hashes are shared by neighbouring
+/// points in the same cell, so a frame that only moves along the time axis
+/// pays for the gradients and the interpolation and little else.
+/// The results are bit-exact with inoise16().
+///
+/// The column and row terms take five bytes each; CNoiseFieldArray16
+/// provides the storage for a fixed size grid. Octaves are separate grids,
+/// use one field per octave.
+class CNoiseField16 {
+public:
+    /// @param width number of columns
+    /// @param height number of rows
+    /// @param axes storage for width + height column and row entries
+    CNoiseField16(uint8_t width, uint8_t height, noise16_axis *axes)
+        : m_Cols(axes), m_Rows(axes + width), m_nWidth(width), m_nHeight(height) {}
+
+    /// Place the grid on the noise map. Column j of row i samples the point
+    /// (x + j * scalex, y + i * scaley).
+    /// @param x x-axis coordinate of the first column
+    /// @param scalex distance between columns
+    /// @param y y-axis coordinate of the first row
+    /// @param scaley distance between rows
+    void setGrid(uint32_t x, int32_t scalex, uint32_t y, int32_t scaley);
+
+    /// Fill a buffer with 3D noise, pData[i * width + j] gets
+    /// inoise16(x + j * scalex, y + i * scaley, z)
+    /// @param pData width * height values, row by row
+    /// @param z z-axis coordinate, usually the time
+    void fill(uint16_t *pData, uint32_t z) const;
+
+    /// Fill a buffer with 2D noise, pData[i * width + j] gets
+    /// inoise16(x + j * scalex, y + i * scaley)
+    /// @param pData width * height values, row by row
+    void fill(uint16_t *pData) const;
+
+    /// Number of columns
+    uint8_t width() const { return m_nWidth; }
+    /// Number of rows
+    uint8_t height() const { return m_nHeight; }
+
+private:
+    noise16_axis *m_Cols;
+    noise16_axis *m_Rows;
+    uint8_t m_nWidth;
+    uint8_t m_nHeight;
+};
+
+/// CNoiseField16 with its own storage for a WIDTH x HEIGHT grid
+/// @tparam WIDTH number of columns
+/// @tparam HEIGHT number of rows
+template<uint8_t WIDTH, uint8_t HEIGHT>
+class CNoiseFieldArray16 : public CNoiseField16 {
+    noise16_axis m_Axes[WIDTH + HEIGHT];  ///< the column and row terms
+
+public:
+    CNoiseFieldArray16() : CNoiseField16(WIDTH, HEIGHT, m_Axes) {}
+};
+
+/// @} Noise Fields
+
+
 /// @name Fill Functions
 /// Fill an LED array with colors based on noise. 
 /// Colors are calculated using noisemaps, randomly selecting hue and value 
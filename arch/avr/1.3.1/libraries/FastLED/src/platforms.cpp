@@ -39,6 +39,30 @@
 #endif // defined(NRF52_SERIES)
 
 
+#if defined(FASTLED_STUB_IMPL)
+
+    // Arduino timing functions for native host builds
+    #include <chrono>
+    #include <thread>
+    #include "platforms/stub/led_sysdefs_stub.h"
+
+    static const std::chrono::steady_clock::time_point gStubStart = std::chrono::steady_clock::now();
+
+    unsigned long millis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - gStubStart).count();
+    }
+
+    unsigned long micros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gStubStart).count();
+    }
+
+    void delay(unsigned long ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+#endif // defined(FASTLED_STUB_IMPL)
+
+
 
 // FASTLED_NAMESPACE_BEGIN
 // FASTLED_NAMESPACE_END
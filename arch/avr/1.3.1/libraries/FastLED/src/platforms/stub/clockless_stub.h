@@ -0,0 +1,34 @@
+#ifndef __INC_CLOCKLESS_STUB_H
+#define __INC_CLOCKLESS_STUB_H
+
+FASTLED_NAMESPACE_BEGIN
+
+#define FASTLED_HAS_CLOCKLESS 1
+
+/// Clockless controller for host builds. It scales and dithers the pixels
+/// like a real driver would, then drops the bytes.
+template <uint8_t DATA_PIN, int T1, int T2, int T3, EOrder RGB_ORDER = RGB, int XTRA0 = 0, bool FLIP = false, int WAIT_TIME = 50>
+class ClocklessController : public CPixelLEDController<RGB_ORDER> {
+public:
+    virtual void init() { }
+
+    virtual uint16_t getMaxRefreshRate() const { return 400; }
+
+protected:
+    virtual void showPixels(PixelController<RGB_ORDER> & pixels) {
+        uint8_t sum = 0;
+        pixels.preStepFirstByteDithering();
+        while(pixels.has(1)) {
+            pixels.stepDithering();
+            sum += pixels.loadAndScale0();
+            sum += pixels.loadAndScale1();
+            sum += pixels.loadAndScale2();
+            pixels.advanceData();
+        }
+        FastPin<DATA_PIN>::set(sum);
+    }
+};
+
+FASTLED_NAMESPACE_END
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef __INC_FASTLED_STUB_H
+#define __INC_FASTLED_STUB_H
+
+#include "fastpin_stub.h"
+#include "clockless_stub.h"
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __INC_FASTPIN_STUB_H
+#define __INC_FASTPIN_STUB_H
+
+FASTLED_NAMESPACE_BEGIN
+
+/// Pin that only remembers its last written state, for host builds
+template<uint8_t PIN> class _STUBPIN {
+public:
+    typedef volatile uint8_t * port_ptr_t;
+    typedef uint8_t port_t;
+
+    inline static void setOutput() { }
+    inline static void setInput() { }
+
+    inline static void hi() __attribute__ ((always_inline)) { sPort = 1; }
+    inline static void lo() __attribute__ ((always_inline)) { sPort = 0; }
+    inline static void set(FASTLED_REGISTER port_t val) __attribute__ ((always_inline)) { sPort = val; }
+
+    inline static void strobe() __attribute__ ((always_inline)) { toggle(); toggle(); }
+
+    inline static void toggle() __attribute__ ((always_inline)) { sPort ^= 1; }
+
+    inline static void hi(FASTLED_REGISTER port_ptr_t port) __attribute__ ((always_inline)) { *port = 1; }
+    inline static void lo(FASTLED_REGISTER port_ptr_t port) __attribute__ ((always_inline)) { *port = 0; }
+    inline static void fastset(FASTLED_REGISTER port_ptr_t port, FASTLED_REGISTER port_t val) __attribute__ ((always_inline)) { *port = val; }
+
+    inline static port_t hival() __attribute__ ((always_inline)) { return 1; }
+    inline static port_t loval() __attribute__ ((always_inline)) { return 0; }
+    inline static port_ptr_t port() __attribute__ ((always_inline)) { return &sPort; }
+    inline static port_t mask() __attribute__ ((always_inline)) { return 1; }
+
+private:
+    static volatile uint8_t sPort;
+};
+
+template<uint8_t PIN> volatile uint8_t _STUBPIN<PIN>::sPort;
+
+#define _FL_DEFPIN(PIN) template<> class FastPin<PIN> : public _STUBPIN<PIN> {};
+
+_FL_DEFPIN(0); _FL_DEFPIN(1); _FL_DEFPIN(2); _FL_DEFPIN(3); _FL_DEFPIN(4); _FL_DEFPIN(5); _FL_DEFPIN(6); _FL_DEFPIN(7);
+_FL_DEFPIN(8); _FL_DEFPIN(9); _FL_DEFPIN(10); _FL_DEFPIN(11); _FL_DEFPIN(12); _FL_DEFPIN(13); _FL_DEFPIN(14); _FL_DEFPIN(15);
+_FL_DEFPIN(16); _FL_DEFPIN(17); _FL_DEFPIN(18); _FL_DEFPIN(19); _FL_DEFPIN(20); _FL_DEFPIN(21); _FL_DEFPIN(22); _FL_DEFPIN(23);
+_FL_DEFPIN(24); _FL_DEFPIN(25); _FL_DEFPIN(26); _FL_DEFPIN(27); _FL_DEFPIN(28); _FL_DEFPIN(29); _FL_DEFPIN(30); _FL_DEFPIN(31);
+
+#define HAS_HARDWARE_PIN_SUPPORT 1
+
+FASTLED_NAMESPACE_END
+
+#endif
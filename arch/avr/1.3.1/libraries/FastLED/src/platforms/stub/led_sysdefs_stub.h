@@ -0,0 +1,50 @@
+#ifndef __INC_LED_SYSDEFS_STUB_H
+#define __INC_LED_SYSDEFS_STUB_H
+
+/// @file led_sysdefs_stub.h
+/// System definitions for building FastLED natively on a PC, selected with
+/// FASTLED_STUB_IMPL. Nothing is driven; this is for running and timing the
+/// math, color and effect code off target.
+
+#define FASTLED_STUB
+
+#ifndef INTERRUPT_THRESHOLD
+#define INTERRUPT_THRESHOLD 1
+#endif
+
+#ifndef FASTLED_ALLOW_INTERRUPTS
+#define FASTLED_ALLOW_INTERRUPTS 1
+#endif
+
+#if FASTLED_ALLOW_INTERRUPTS == 1
+#define FASTLED_ACCURATE_CLOCK
+#endif
+
+#ifndef F_CPU
+#define F_CPU 1000000000
+#endif
+
+// Default to NOT using PROGMEM
+#ifndef FASTLED_USE_PROGMEM
+#define FASTLED_USE_PROGMEM 0
+#endif
+
+// data type defs
+typedef volatile uint8_t RoReg; /**< Read only 8-bit register (volatile const unsigned int) */
+typedef volatile uint8_t RwReg; /**< Read-Write 8-bit register (volatile unsigned int) */
+
+#define FASTLED_NO_PINMAP
+
+// there are no interrupts to mask
+#define cli()
+#define sei()
+
+#define FASTLED_NEEDS_YIELD
+extern "C" void yield();
+
+// Arduino timing functions, defined in platforms.cpp
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+#endif
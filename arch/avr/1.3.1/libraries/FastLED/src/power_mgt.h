@@ -102,6 +102,72 @@ uint8_t  calculate_max_brightness_for_power_mW( uint8_t target_brightness, uint3
 /// @} PowerInternal
 
 
+/// Keeps running per-channel totals of a CRGB array, so that power limiting
+/// costs O(changed pixels) per frame instead of a pass over the whole array.
+/// Attach it with CLEDController::setPowerTracker().
+///
+/// The totals are only right if every change to the array goes through the
+/// tracker: either write pixels with set() or `tracker[i] = color`, or wrap
+/// direct writes in beginUpdate() / endUpdate() over the same range. After
+/// anything else (fill_solid(), fadeToBlackBy() on the whole strip, ...)
+/// call invalidate() and the next query does one full pass.
+class CPowerTracker {
+public:
+    /// Write-tracking reference to one pixel, returned by operator[]
+    class Pixel {
+    public:
+        Pixel(CPowerTracker &tracker, uint16_t index) : m_Tracker(tracker), m_nIndex(index) {}
+        /// Tracked write of the pixel
+        Pixel &operator=(const CRGB &color) { m_Tracker.set(m_nIndex, color); return *this; }
+        /// Tracked copy from another tracked pixel
+        Pixel &operator=(const Pixel &rhs) { m_Tracker.set(m_nIndex, (CRGB)rhs); return *this; }
+        /// Read the pixel
+        operator CRGB() const { return m_Tracker.m_Leds[m_nIndex]; }
+    private:
+        CPowerTracker &m_Tracker;
+        uint16_t m_nIndex;
+    };
+
+    /// @param leds the LED data to track
+    /// @param numLeds the number of LEDs in the data array
+    CPowerTracker(CRGB *leds, uint16_t numLeds)
+        : m_Leds(leds), m_nLeds(numLeds), m_nRed(0), m_nGreen(0), m_nBlue(0), m_bValid(false) {}
+
+    /// Tracked write of one pixel
+    /// @param index the pixel to change
+    /// @param color its new color
+    void set(uint16_t index, const CRGB &color);
+
+    /// @copydoc set()
+    Pixel operator[](uint16_t index) { return Pixel(*this, index); }
+
+    /// Take a range of pixels out of the totals before changing them directly
+    /// @param first the first pixel that is going to change
+    /// @param count how many pixels are going to change
+    void beginUpdate(uint16_t first, uint16_t count);
+
+    /// Put a range of pixels back into the totals after changing them
+    /// @param first the first pixel that changed, as passed to beginUpdate()
+    /// @param count how many pixels changed, as passed to beginUpdate()
+    void endUpdate(uint16_t first, uint16_t count);
+
+    /// Forget the totals, the next query adds up the whole array again
+    void invalidate() { m_bValid = false; }
+
+    /// Same as calculate_unscaled_power_mW() on the tracked array
+    /// @returns the number of milliwatts the LED data would consume at max brightness
+    uint32_t unscaled_power_mW();
+
+private:
+    void recompute();
+
+    CRGB *m_Leds;
+    uint16_t m_nLeds;
+    uint32_t m_nRed, m_nGreen, m_nBlue;
+    bool m_bValid;
+};
+
+
 /// @} Power
 
 FASTLED_NAMESPACE_END
@@ -30,11 +30,15 @@
 #include "LIS3DHTR.h"
 template <class T>
 
-LIS3DHTR<T>::LIS3DHTR()
+LIS3DHTR<T>::LIS3DHTR() : odrPeriod(0), _irqPending(0), _irqTime(0), _intPin(0), _ring(NULL),
+                            _ringMask(0), _ringHead(0), _ringTail(0), _dropped(0)
 {
     
 }
 
+template <class T>
+LIS3DHTR<T> *LIS3DHTR<T>::_isrInstance = NULL;
+
 template <class T>
 void LIS3DHTR<T>::begin(SPIClass &comm, uint8_t sspin)
 {
@@ -48,7 +52,7 @@ void LIS3DHTR<T>::begin(SPIClass &comm, uint8_t sspin)
     // Data is captured on rising edge of clock (CPHA = 0)
     // Base value of the clock is HIGH (CPOL = 1)
     // MODE3 for 328p operation
-    SPISettings _settings(10000000, MSBFIRST, SPI_MODE3);
+    _settings = SPISettings(10000000, MSBFIRST, SPI_MODE3);
 
     // start the SPI library:
     _spi_com->begin();
@@ -213,6 +217,7 @@ void LIS3DHTR<T>::setFullScaleRange(scale_type_t range)
     default:
         break;
     }
+    mgScale = 65536000UL / accRange;
 }
 
 template <class T>
@@ -227,79 +232,326 @@ void LIS3DHTR<T>::setOutputDataRate(odr_type_t odr)
 
     writeRegister(LIS3DHTR_REG_ACCEL_CTRL_REG1, data);
     delay(LIS3DHTR_CONVERSIONDELAY);
+
+    switch (odr)
+    {
+    case LIS3DHTR_DATARATE_1HZ:
+        odrPeriod = 1000000;
+        break;
+    case LIS3DHTR_DATARATE_10HZ:
+        odrPeriod = 100000;
+        break;
+    case LIS3DHTR_DATARATE_25HZ:
+        odrPeriod = 40000;
+        break;
+    case LIS3DHTR_DATARATE_50HZ:
+        odrPeriod = 20000;
+        break;
+    case LIS3DHTR_DATARATE_100HZ:
+        odrPeriod = 10000;
+        break;
+    case LIS3DHTR_DATARATE_200HZ:
+        odrPeriod = 5000;
+        break;
+    case LIS3DHTR_DATARATE_400HZ:
+        odrPeriod = 2500;
+        break;
+    case LIS3DHTR_DATARATE_1_6KH:
+        odrPeriod = 625;
+        break;
+    case LIS3DHTR_DATARATE_5KHZ:
+        odrPeriod = 800; // 1.25 kHz in normal mode
+        break;
+    default:
+        odrPeriod = 0;
+        break;
+    }
 }
 
 template <class T>
 void LIS3DHTR<T>::getAcceleration(float *x, float *y, float *z)
 {
-    // Read the Accelerometer
-    uint8_t buf[8]={0};
+    int16_t raw[3];
 
-    // Read the Data
-    readRegisterRegion(buf,LIS3DHTR_REG_ACCEL_OUT_X_L,6);
+    getAccelerationRaw(&raw[0], &raw[1], &raw[2]);
 
-    // Conversion of the result
-    // 16-bit signed result for X-Axis Acceleration Data of LIS3DHTR
-    *x = (float)((int16_t*)buf)[0] / accRange;
-    // 16-bit signed result for Y-Axis Acceleration Data of LIS3DHTR
-    *y = (float)((int16_t*)buf)[1] / accRange;
-    // 16-bit signed result for Z-Axis Acceleration Data of LIS3DHTR
-    *z = (float)((int16_t*)buf)[2] / accRange;
+    *x = (float)raw[0] / accRange;
+    *y = (float)raw[1] / accRange;
+    *z = (float)raw[2] / accRange;
 }
 
 template <class T>
 float LIS3DHTR<T>::getAccelerationX(void)
 {
-    // Read the Accelerometer
-    uint8_t xAccelLo, xAccelHi;
-    int16_t x;
+    // 16-bit signed result, low and high byte in one auto-increment read
+    return (float)(int16_t)readRegisterInt16(LIS3DHTR_REG_ACCEL_OUT_X_L) / accRange;
+}
 
-    // Read the Data
-    // Reading the Low X-Axis Acceleration Data Register
-    xAccelLo = readRegister(LIS3DHTR_REG_ACCEL_OUT_X_L);
-    // Reading the High X-Axis Acceleration Data Register
-    xAccelHi = readRegister(LIS3DHTR_REG_ACCEL_OUT_X_H);
-    // Conversion of the result
-    // 16-bit signed result for X-Axis Acceleration Data of LIS3DHTR
-    x = (int16_t)((xAccelHi << 8) | xAccelLo);
+template <class T>
+float LIS3DHTR<T>::getAccelerationY(void)
+{
+    return (float)(int16_t)readRegisterInt16(LIS3DHTR_REG_ACCEL_OUT_Y_L) / accRange;
+}
 
-    return (float)x / accRange;
+template <class T>
+float LIS3DHTR<T>::getAccelerationZ(void)
+{
+    return (float)(int16_t)readRegisterInt16(LIS3DHTR_REG_ACCEL_OUT_Z_L) / accRange;
 }
 
 template <class T>
-float LIS3DHTR<T>::getAccelerationY(void)
+void LIS3DHTR<T>::getAccelerationRaw(int16_t *x, int16_t *y, int16_t *z)
 {
-    // Read the Accelerometer
-    uint8_t yAccelLo, yAccelHi;
-    int16_t y;
+    uint8_t buf[6] = {0};
 
-    // Reading the Low Y-Axis Acceleration Data Register
-    yAccelLo = readRegister(LIS3DHTR_REG_ACCEL_OUT_Y_L);
-    // Reading the High Y-Axis Acceleration Data Register
-    yAccelHi = readRegister(LIS3DHTR_REG_ACCEL_OUT_Y_H);
-    // Conversion of the result
-    // 16-bit signed result for Y-Axis Acceleration Data of LIS3DHTR
-    y = (int16_t)((yAccelHi << 8) | yAccelLo);
+    // OUT_X_L .. OUT_Z_H in a single transfer
+    readRegisterRegion(buf, LIS3DHTR_REG_ACCEL_OUT_X_L, 6);
 
-    return (float)y / accRange;
+    *x = (int16_t)(buf[0] | (buf[1] << 8));
+    *y = (int16_t)(buf[2] | (buf[3] << 8));
+    *z = (int16_t)(buf[4] | (buf[5] << 8));
 }
 
 template <class T>
-float LIS3DHTR<T>::getAccelerationZ(void)
+void LIS3DHTR<T>::getAccelerationMilliG(int16_t *x, int16_t *y, int16_t *z)
+{
+    getAccelerationRaw(x, y, z);
+
+    // rounded 16x16 bit multiply instead of a float division per axis
+    *x = ((int32_t)*x * mgScale + 0x8000) >> 16;
+    *y = ((int32_t)*y * mgScale + 0x8000) >> 16;
+    *z = ((int32_t)*z * mgScale + 0x8000) >> 16;
+}
+
+template <class T>
+void LIS3DHTR<T>::setFifoMode(fifo_mode_t mode, uint8_t watermark)
+{
+    uint8_t data = 0;
+
+    // going through bypass clears the FIFO before a new mode starts collecting
+    writeRegister(LIS3DHTR_REG_ACCEL_FIFO_CTRL, LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_BYPASS);
+
+    data = readRegister(LIS3DHTR_REG_ACCEL_CTRL_REG5);
+    data &= ~LIS3DHTR_REG_ACCEL_CTRL_REG5_FIFO_EN_MASK;
+    if (mode != LIS3DHTR_FIFO_BYPASS)
+    {
+        data |= LIS3DHTR_REG_ACCEL_CTRL_REG5_FIFO_EN_ENABLE;
+    }
+    writeRegister(LIS3DHTR_REG_ACCEL_CTRL_REG5, data);
+
+    if (mode != LIS3DHTR_FIFO_BYPASS)
+    {
+        writeRegister(LIS3DHTR_REG_ACCEL_FIFO_CTRL, mode | (watermark & LIS3DHTR_REG_ACCEL_FIFO_CTRL_FTH_MASK));
+    }
+}
+
+template <class T>
+uint8_t LIS3DHTR<T>::getFifoCount(void)
+{
+    uint8_t src = readRegister(LIS3DHTR_REG_ACCEL_FIFO_SRC);
+
+    if (src & LIS3DHTR_REG_ACCEL_FIFO_SRC_EMPTY_MASK)
+    {
+        return 0;
+    }
+    if (src & LIS3DHTR_REG_ACCEL_FIFO_SRC_OVRN_MASK)
+    {
+        return LIS3DHTR_FIFO_SIZE;
+    }
+    return src & LIS3DHTR_REG_ACCEL_FIFO_SRC_FSS_MASK;
+}
+
+template <class T>
+uint8_t LIS3DHTR<T>::readFifo(int16_t *xyz, uint8_t maxSamples)
+{
+    uint8_t count = getFifoCount();
+    uint8_t done = 0;
+
+    if (count > maxSamples)
+    {
+        count = maxSamples;
+    }
+
+    // reading past OUT_Z_H wraps back to OUT_X_L and pops the next sample,
+    // SPI takes the whole FIFO at once, I2C is bounded by the Wire buffer
+    while (done < count)
+    {
+        uint8_t n = count - done;
+        if (_spi_com == NULL && n > LIS3DHTR_WIRE_BURST_SAMPLES)
+        {
+            n = LIS3DHTR_WIRE_BURST_SAMPLES;
+        }
+        readRegisterRegion((uint8_t *)&xyz[3 * done], LIS3DHTR_REG_ACCEL_OUT_X_L, n * 6);
+        done += n;
+    }
+
+    return count;
+}
+
+template <class T>
+void LIS3DHTR<T>::isr(void)
+{
+    LIS3DHTR<T> *self = _isrInstance;
+
+    // no bus access here, Wire needs interrupts to run
+    if (self != NULL)
+    {
+        self->_irqTime = micros();
+        self->_irqPending = 1;
+    }
+}
+
+template <class T>
+bool LIS3DHTR<T>::beginInterrupt(uint8_t pin, lis3dhtr_sample_t *ring, uint8_t size, uint8_t watermark)
+{
+    uint8_t data = 0;
+    int irq = digitalPinToInterrupt(pin);
+
+    if (ring == NULL || size == 0 || size > 128 || (size & (size - 1)) || irq == NOT_AN_INTERRUPT)
+    {
+        return false;
+    }
+    if (_isrInstance != NULL && _isrInstance != this)
+    {
+        return false; // one driven instance at a time
+    }
+    if (_ring != NULL)
+    {
+        endInterrupt();
+    }
+
+    _ring = ring;
+    _ringMask = size - 1;
+    _ringHead = 0;
+    _ringTail = 0;
+    _dropped = 0;
+    _intPin = pin;
+    // drain once even if INT1 is already high and no edge will come
+    _irqPending = 1;
+    _irqTime = micros();
+    _isrInstance = this;
+
+    setFifoMode(LIS3DHTR_FIFO_STREAM, watermark);
+
+    data = readRegister(LIS3DHTR_REG_ACCEL_CTRL_REG3);
+    data &= ~(LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_ZYXDA | LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_WTM);
+    data |= watermark ? LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_WTM : LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_ZYXDA;
+    writeRegister(LIS3DHTR_REG_ACCEL_CTRL_REG3, data);
+
+    pinMode(pin, INPUT);
+    attachInterrupt(irq, isr, RISING);
+    return true;
+}
+
+template <class T>
+void LIS3DHTR<T>::endInterrupt(void)
+{
+    uint8_t data = 0;
+
+    if (_ring == NULL)
+    {
+        return;
+    }
+    detachInterrupt(digitalPinToInterrupt(_intPin));
+    _isrInstance = NULL;
+    _ring = NULL;
+    _ringHead = 0;
+    _ringTail = 0;
+    _irqPending = 0;
+
+    data = readRegister(LIS3DHTR_REG_ACCEL_CTRL_REG3);
+    data &= ~(LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_ZYXDA | LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_WTM);
+    writeRegister(LIS3DHTR_REG_ACCEL_CTRL_REG3, data);
+    setFifoMode(LIS3DHTR_FIFO_BYPASS);
+}
+
+template <class T>
+uint8_t LIS3DHTR<T>::update(void)
 {
-    // Read the Accelerometer
-    uint8_t zAccelLo, zAccelHi;
-    int16_t z;
+    int16_t xyz[LIS3DHTR_WIRE_BURST_SAMPLES * 3];
+    uint32_t t;
+    uint8_t count, done = 0, added = 0;
+
+    if (_ring == NULL || !_irqPending)
+    {
+        return 0;
+    }
+    noInterrupts();
+    _irqPending = 0;
+    t = _irqTime;
+    interrupts();
+
+    // the newest sample is dated at the interrupt, older ones one data period apart
+    count = getFifoCount();
+    while (done < count)
+    {
+        uint8_t n = count - done;
+        if (n > LIS3DHTR_WIRE_BURST_SAMPLES)
+        {
+            n = LIS3DHTR_WIRE_BURST_SAMPLES;
+        }
+        readRegisterRegion((uint8_t *)xyz, LIS3DHTR_REG_ACCEL_OUT_X_L, n * 6);
+
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if ((uint8_t)(_ringHead - _ringTail) > _ringMask)
+            {
+                _dropped++;
+                continue;
+            }
+            lis3dhtr_sample_t *sample = &_ring[_ringHead & _ringMask];
+            sample->timestamp = t - (uint32_t)(count - 1 - done - i) * odrPeriod;
+            sample->x = xyz[3 * i];
+            sample->y = xyz[3 * i + 1];
+            sample->z = xyz[3 * i + 2];
+            _ringHead++;
+            added++;
+        }
+        done += n;
+    }
 
-    // Reading the Low Z-Axis Acceleration Data Register
-    zAccelLo = readRegister(LIS3DHTR_REG_ACCEL_OUT_Z_L);
-    // Reading the High Z-Axis Acceleration Data Register
-    zAccelHi = readRegister(LIS3DHTR_REG_ACCEL_OUT_Z_H);
-    // Conversion of the result
-    // 16-bit signed result for Z-Axis Acceleration Data of LIS3DHTR
-    z = (int16_t)((zAccelHi << 8) | zAccelLo);
+    // samples that came in during the drain can leave INT1 high, and without
+    // a new rising edge the interrupt would never fire again
+    if (digitalRead(_intPin) == HIGH)
+    {
+        noInterrupts();
+        if (!_irqPending)
+        {
+            _irqPending = 1;
+            _irqTime = micros();
+        }
+        interrupts();
+    }
+    return added;
+}
 
-    return (float)z / accRange;
+template <class T>
+uint8_t LIS3DHTR<T>::samplesAvailable(void)
+{
+    return _ringHead - _ringTail;
+}
+
+template <class T>
+uint8_t LIS3DHTR<T>::readSamples(lis3dhtr_sample_t *out, uint8_t maxSamples)
+{
+    uint8_t n = samplesAvailable();
+
+    if (n > maxSamples)
+    {
+        n = maxSamples;
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        out[i] = _ring[_ringTail & _ringMask];
+        _ringTail++;
+    }
+    return n;
+}
+
+template <class T>
+uint16_t LIS3DHTR<T>::droppedSamples(void)
+{
+    return _dropped;
 }
 
 template <class T>
@@ -129,6 +129,14 @@
 #define LIS3DHTR_REG_ACCEL_CTRL_REG1_AXEN_DISABLE (0x00) // Acceleration X-Axis Disabled
 #define LIS3DHTR_REG_ACCEL_CTRL_REG1_AXEN_ENABLE (0x01)  // Acceleration X-Axis Enabled
 
+/**************************************************************************
+    ACCELEROMETER CONTROL REGISTER 3 DESCRIPTION
+**************************************************************************/
+#define LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_CLICK (0x80)   // Click Interrupt on INT1
+#define LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_ZYXDA (0x10)   // Data Ready Interrupt on INT1
+#define LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_WTM (0x04)     // FIFO Watermark Interrupt on INT1
+#define LIS3DHTR_REG_ACCEL_CTRL_REG3_I1_OVERRUN (0x02) // FIFO Overrun Interrupt on INT1
+
 /**************************************************************************
     ACCELEROMETER CONTROL REGISTER 4 DESCRIPTION
 **************************************************************************/
@@ -159,6 +167,37 @@
 #define LIS3DHTR_REG_ACCEL_CTRL_REG4_SIM_4WIRE (0x00) // 4-Wire Interface
 #define LIS3DHTR_REG_ACCEL_CTRL_REG4_SIM_3WIRE (0x01) // 3-Wire Interface
 
+/**************************************************************************
+    ACCELEROMETER CONTROL REGISTER 5 DESCRIPTION
+**************************************************************************/
+#define LIS3DHTR_REG_ACCEL_CTRL_REG5_FIFO_EN_MASK (0x40)    // FIFO Enable
+#define LIS3DHTR_REG_ACCEL_CTRL_REG5_FIFO_EN_DISABLE (0x00) // FIFO Disabled
+#define LIS3DHTR_REG_ACCEL_CTRL_REG5_FIFO_EN_ENABLE (0x40)  // FIFO Enabled
+
+/**************************************************************************
+    FIFO CONTROL/SOURCE REGISTER DESCRIPTION
+**************************************************************************/
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_MASK (0xC0)         // FIFO Mode Selection
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_BYPASS (0x00)       // Bypass Mode
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_FIFO (0x40)         // FIFO Mode, Stops Collecting When Full
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_STREAM (0x80)       // Stream Mode, Oldest Sample Overwritten
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_STREAM_FIFO (0xC0)  // Stream Mode Until Trigger, Then FIFO
+#define LIS3DHTR_REG_ACCEL_FIFO_CTRL_FTH_MASK (0x1F)        // Watermark Level
+
+#define LIS3DHTR_REG_ACCEL_FIFO_SRC_WTM_MASK (0x80)   // Watermark Reached
+#define LIS3DHTR_REG_ACCEL_FIFO_SRC_OVRN_MASK (0x40)  // FIFO Full, Oldest Sample Overwritten
+#define LIS3DHTR_REG_ACCEL_FIFO_SRC_EMPTY_MASK (0x20) // FIFO Empty
+#define LIS3DHTR_REG_ACCEL_FIFO_SRC_FSS_MASK (0x1F)   // Unread Samples
+
+#define LIS3DHTR_FIFO_SIZE (32) // Samples held by the FIFO
+
+// Samples fetched per I2C burst, the Wire receive buffer limits a single requestFrom()
+#ifdef BUFFER_LENGTH
+#define LIS3DHTR_WIRE_BURST_SAMPLES (BUFFER_LENGTH / 6)
+#else
+#define LIS3DHTR_WIRE_BURST_SAMPLES (5)
+#endif
+
 #define LIS3DHTR_REG_ACCEL_STATUS2_UPDATE_MASK (0x08)   // Has New Data Flag Mask
 
 enum power_type_t // power mode
@@ -175,6 +214,14 @@ enum scale_type_t // measurement rage
     LIS3DHTR_RANGE_16G = LIS3DHTR_REG_ACCEL_CTRL_REG4_FS_16G, //
 };
 
+enum fifo_mode_t // FIFO mode
+{
+    LIS3DHTR_FIFO_BYPASS = LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_BYPASS,
+    LIS3DHTR_FIFO_FIFO = LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_FIFO,
+    LIS3DHTR_FIFO_STREAM = LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_STREAM,
+    LIS3DHTR_FIFO_STREAM_TO_FIFO = LIS3DHTR_REG_ACCEL_FIFO_CTRL_FM_STREAM_FIFO
+};
+
 enum odr_type_t // output data rate
 {
     LIS3DHTR_DATARATE_POWERDOWN = LIS3DHTR_REG_ACCEL_CTRL_REG1_AODR_PD,
@@ -189,6 +236,12 @@ enum odr_type_t // output data rate
     LIS3DHTR_DATARATE_5KHZ = LIS3DHTR_REG_ACCEL_CTRL_REG1_AODR_5K
 };
 
+struct lis3dhtr_sample_t // one sample collected by the INT1 driven mode
+{
+    uint32_t timestamp; // micros() when the sample was taken
+    int16_t x, y, z;    // raw output, as getAccelerationRaw()
+};
+
 template <class T>
 class LIS3DHTR
 {
@@ -211,6 +264,27 @@ public:
     float getAccelerationX(void);
     float getAccelerationY(void);
     float getAccelerationZ(void);
+    // integer outputs, all three axes come from one burst read
+    void getAccelerationRaw(int16_t *x, int16_t *y, int16_t *z);
+    void getAccelerationMilliG(int16_t *x, int16_t *y, int16_t *z);
+
+    // FIFO_STREAM keeps the newest 32 samples, FIFO_FIFO stops when full.
+    // watermark (0-31) sets the level reported by the WTM flag/interrupt.
+    void setFifoMode(fifo_mode_t mode, uint8_t watermark = 0);
+    uint8_t getFifoCount(void);
+    // drains up to maxSamples samples into xyz (3 values per sample), returns the count
+    uint8_t readFifo(int16_t *xyz, uint8_t maxSamples);
+
+    // INT1 driven sampling. The chip collects into its FIFO (stream mode) and
+    // raises INT1 on every new sample (watermark 0) or when `watermark` samples
+    // are queued. The interrupt only records the time, update() then drains the
+    // FIFO into `ring` (size a power of two, at most 128) in burst reads.
+    bool beginInterrupt(uint8_t pin, lis3dhtr_sample_t *ring, uint8_t size, uint8_t watermark = 0);
+    void endInterrupt(void);
+    uint8_t update(void); // call from loop(), returns the samples added
+    uint8_t samplesAvailable(void);
+    uint8_t readSamples(lis3dhtr_sample_t *out, uint8_t maxSamples);
+    uint16_t droppedSamples(void); // samples lost because the ring was full
     void click(uint8_t c, uint8_t click_thresh, uint8_t limit = 10, uint8_t latency = 20, uint8_t window = 255);
 
     void openTemp();
@@ -233,13 +307,26 @@ private:
     void writeRegister(uint8_t reg, uint8_t val);
     uint8_t readRegister(uint8_t reg);
     uint16_t readRegisterInt16(uint8_t reg);
+    static void isr(void);
+    static LIS3DHTR<T> *_isrInstance;
     uint8_t devAddr;
     int16_t accRange;
+    uint16_t mgScale; // 1000 / accRange in 16.16 fixed point
     uint8_t commInterface;
     uint8_t chipSelectPin;
     SPIClass *_spi_com;
     SPISettings _settings;
     TwoWire *_wire_com;
+
+    uint32_t odrPeriod; // us between samples at the current data rate
+    volatile uint8_t _irqPending;
+    volatile uint32_t _irqTime;
+    uint8_t _intPin;
+    lis3dhtr_sample_t *_ring;
+    uint8_t _ringMask;
+    uint8_t _ringHead; // free running, written by update()
+    uint8_t _ringTail; // free running, written by readSamples()
+    uint16_t _dropped;
 };
 
 #endif /*SEEED_LIS3DHTR_H*/
@@ -66,6 +66,8 @@ Keyboard_::Keyboard_(void)
 	static HIDSubDescriptor node(_hidReportDescriptor, sizeof(_hidReportDescriptor));
 	HID().AppendDescriptor(&node);
 	_asciimap = KeyboardLayout_en_US;
+	_packKeys = 1;
+	_reportDelay = 0;
 }
 
 void Keyboard_::begin(const uint8_t *layout)
@@ -97,21 +99,13 @@ size_t Keyboard_::press(uint8_t k)
 		_keyReport.modifiers |= (1<<(k-128));
 		k = 0;
 	} else {				// it's a printing key
-		k = pgm_read_byte(_asciimap + k);
+		uint8_t modifiers;
+		k = asciiToKey(k, &modifiers);
 		if (!k) {
 			setWriteError();
 			return 0;
 		}
-		if ((k & ALT_GR) == ALT_GR) {
-			_keyReport.modifiers |= 0x40;   // AltGr = right Alt
-			k &= 0x3F;
-		} else if ((k & SHIFT) == SHIFT) {
-			_keyReport.modifiers |= 0x02;	// the left shift modifier
-			k &= 0x7F;
-		}
-		if (k == ISO_REPLACEMENT) {
-			k = ISO_KEY;
-		}
+		_keyReport.modifiers |= modifiers;
 	}
 
 	// Add k to the key report only if it's not already present
@@ -147,20 +141,12 @@ size_t Keyboard_::release(uint8_t k)
 		_keyReport.modifiers &= ~(1<<(k-128));
 		k = 0;
 	} else {				// it's a printing key
-		k = pgm_read_byte(_asciimap + k);
+		uint8_t modifiers;
+		k = asciiToKey(k, &modifiers);
 		if (!k) {
 			return 0;
 		}
-		if ((k & ALT_GR) == ALT_GR) {
-			_keyReport.modifiers &= ~(0x40);   // AltGr = right Alt
-			k &= 0x3F;
-		} else if ((k & SHIFT) == SHIFT) {
-			_keyReport.modifiers &= ~(0x02);	// the left shift modifier
-			k &= 0x7F;
-		}
-		if (k == ISO_REPLACEMENT) {
-			k = ISO_KEY;
-		}
+		_keyReport.modifiers &= ~modifiers;
 	}
 
 	// Test the key report to see if k is present.  Clear it if it exists.
@@ -194,7 +180,137 @@ size_t Keyboard_::write(uint8_t c)
 	return p;		// just return the result of press() since release() almost always returns 1
 }
 
+void Keyboard_::setPacking(uint8_t maxKeys, uint8_t reportDelay)
+{
+	if (maxKeys < 1) {
+		maxKeys = 1;
+	} else if (maxKeys > 6) {
+		maxKeys = 6;
+	}
+	_packKeys = maxKeys;
+	_reportDelay = reportDelay;
+}
+
+// Translates a printing character through the layout, returns 0 if the
+// layout has no key for it.
+uint8_t Keyboard_::asciiToKey(uint8_t c, uint8_t *modifiers)
+{
+	uint8_t k = pgm_read_byte(_asciimap + c);
+	*modifiers = 0;
+	if ((k & ALT_GR) == ALT_GR) {
+		*modifiers = 0x40;	// AltGr = right Alt
+		k &= 0x3F;
+	} else if ((k & SHIFT) == SHIFT) {
+		*modifiers = 0x02;	// the left shift modifier
+		k &= 0x7F;
+	}
+	if (k == ISO_REPLACEMENT) {
+		k = ISO_KEY;
+	}
+	return k;
+}
+
+// Returns the first free slot of the report, 6 if it is full or -1 if k is
+// already in it.
+static int8_t keySlot(const KeyReport* keys, uint8_t k)
+{
+	int8_t slot = 6;
+	for (int8_t i = 5; i >= 0; i--) {
+		if (keys->keys[i] == k) {
+			return -1;
+		}
+		if (keys->keys[i] == 0x00) {
+			slot = i;
+		}
+	}
+	return slot;
+}
+
+void Keyboard_::sendPacked(KeyReport* keys)
+{
+	sendReport(keys);
+	if (_reportDelay) {
+		delay(_reportDelay);
+	}
+}
+
+// Types a run of printing characters with several keys going down in the
+// same report. The host processes the new keys of a report in array order,
+// so the text comes out unchanged as long as no key appears twice and all
+// keys share one modifier state; the batch is released before either
+// would happen. Keys held with press() stay down throughout.
+size_t Keyboard_::writePacked(const uint8_t *buffer, size_t size)
+{
+	KeyReport report = _keyReport;
+	uint8_t batchModifiers = 0;
+	uint8_t pending = 0;
+	size_t n = 0;
+
+	for (; size; size--, buffer++) {
+		uint8_t c = *buffer;
+		uint8_t k, modifiers;
+		int8_t slot;
+
+		if (c == '\r') {
+			continue;
+		}
+		if (c >= 128) {
+			// modifiers and non-printing keys go through the single key path
+			if (pending) {
+				sendPacked(&report);
+				sendPacked(&_keyReport);
+				pending = 0;
+			}
+			if (!write(c)) {
+				break;
+			}
+			report = _keyReport;
+			n++;
+			continue;
+		}
+
+		k = asciiToKey(c, &modifiers);
+		if (!k) {
+			setWriteError();
+			break;
+		}
+
+		slot = keySlot(&report, k);
+		if (pending && (slot < 0 || slot == 6 || modifiers != batchModifiers || pending == _packKeys)) {
+			sendPacked(&report);
+			sendPacked(&_keyReport);
+			report = _keyReport;
+			pending = 0;
+			slot = keySlot(&report, k);
+		}
+		if (slot < 0) {
+			// already held with press(), like write() nothing new goes down
+			n++;
+			continue;
+		}
+		if (slot == 6) {
+			setWriteError();
+			break;
+		}
+		if (!pending) {
+			batchModifiers = modifiers;
+			report.modifiers = _keyReport.modifiers | modifiers;
+		}
+		report.keys[slot] = k;
+		pending++;
+		n++;
+	}
+	if (pending) {
+		sendPacked(&report);
+		sendPacked(&_keyReport);
+	}
+	return n;
+}
+
 size_t Keyboard_::write(const uint8_t *buffer, size_t size) {
+	if (_packKeys > 1) {
+		return writePacked(buffer, size);
+	}
 	size_t n = 0;
 	while (size--) {
 		if (*buffer != '\r') {
@@ -132,7 +132,12 @@ class Keyboard_ : public Print
 private:
   KeyReport _keyReport;
   const uint8_t *_asciimap;
+  uint8_t _packKeys;
+  uint8_t _reportDelay;
   void sendReport(KeyReport* keys);
+  uint8_t asciiToKey(uint8_t c, uint8_t *modifiers);
+  void sendPacked(KeyReport* keys);
+  size_t writePacked(const uint8_t *buffer, size_t size);
 public:
   Keyboard_(void);
   void begin(const uint8_t *layout = KeyboardLayout_en_US);
@@ -142,6 +147,10 @@ public:
   size_t press(uint8_t k);
   size_t release(uint8_t k);
   void releaseAll(void);
+  // Let write(buffer, size) (and so print()) put up to maxKeys distinct
+  // characters into one report; 1 types one key per press/release pair.
+  // reportDelay adds a pause in ms after every report for slow hosts.
+  void setPacking(uint8_t maxKeys, uint8_t reportDelay = 0);
 };
 extern Keyboard_ Keyboard;
 
@@ -0,0 +1,177 @@
+// Serial1 against a model of the 32U4's USART1 at 115200 baud: the byte
+// stream and the atomic sections per byte for bulk write() with interrupts
+// on and off, caller supplied rings passed to begin() and the sizes it
+// refuses, and rxOverruns()/rxHighWater() against what the line lost.
+#include "uart_model.h"
+#include "Arduino.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+static UartModel uart;
+
+static uint32_t rng = 1;
+static uint8_t rnd() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 16;
+}
+
+static void drain() {
+  Serial1.flush();
+  while (!uart.idle()) {
+    delayMicroseconds(1);
+  }
+}
+
+// 20 kB in write() calls of 1 to 120 bytes, returns atomic sections a byte
+static double bulk(const char *name, bool interruptsOff) {
+  uart.sent.clear();
+  std::vector<uint8_t> sent;
+  uint8_t buffer[120];
+  long cli0 = hostCliCount;
+  uint32_t t0 = hostMicros;
+  if (interruptsOff) {
+    noInterrupts();
+  }
+  while (sent.size() < 20000) {
+    size_t n = 1 + rnd() % sizeof(buffer);
+    for (size_t i = 0; i < n; i++) {
+      buffer[i] = rnd();
+    }
+    CHECK(Serial1.write(buffer, n) == n);
+    sent.insert(sent.end(), buffer, buffer + n);
+  }
+  Serial1.flush();
+  long sections = hostCliCount - cli0;
+  if (interruptsOff) {
+    interrupts();
+  }
+  drain();
+  CHECK(uart.sent == sent);
+  double perByte = (double)sections / sent.size();
+  printf(
+    "%s: %zu bytes, %.2f atomic sections a byte, line %.0f%% busy\n", name, sent.size(), perByte,
+    100.0 * sent.size() * uart.charTime() / (hostMicros - t0)
+  );
+  return perByte;
+}
+
+// the line sends count bytes, the sketch reads burst of them every period us
+static long receive(int count, uint32_t period, int burst) {
+  std::vector<uint8_t> sent, got;
+  for (int i = 0; i < count; i++) {
+    sent.push_back(rnd());
+    uart.line.push_back(sent.back());
+  }
+  while (!uart.line.empty() || Serial1.available()) {
+    delayMicroseconds(period);
+    for (int i = 0; i < burst && Serial1.available(); i++) {
+      got.push_back(Serial1.read());
+    }
+  }
+  // what arrived came in order
+  size_t j = 0;
+  for (size_t i = 0; i < sent.size() && j < got.size(); i++) {
+    j += sent[i] == got[j];
+  }
+  CHECK(j == got.size());
+  return sent.size() - got.size();
+}
+
+static void test_tx() {
+  Serial1.begin(115200);
+  uart.attach();
+  CHECK(uart.charTime() == 85 && Serial1.availableForWrite() == SERIAL_TX_BUFFER_SIZE - 1);
+
+  double on = bulk("64 byte ring", false);
+  bulk("64 byte ring, interrupts off", true);
+  CHECK(on < 0.2);
+  CHECK(uart.overwrites == 0);
+
+  // short lines into an empty ring
+  uart.sent.clear();
+  std::vector<uint8_t> sent;
+  long cli0 = hostCliCount;
+  char text[48];
+  for (int i = 0; i < 300; i++) {
+    int n = snprintf(text, sizeof(text), "t=%u ax=%d ay=%d\r\n", (unsigned)hostMicros, rnd() - 128, rnd() - 128);
+    Serial1.print(text);
+    sent.insert(sent.end(), text, text + n);
+    delay(4);
+  }
+  drain();
+  CHECK(uart.sent == sent);
+  printf("short lines: %.2f atomic sections a byte\n", (double)(hostCliCount - cli0) / sent.size());
+}
+
+static void test_user_buffers() {
+  static unsigned char rx[256], tx[256], odd[100];
+  Serial1.begin(115200, SERIAL_8N1, rx, sizeof(rx), tx, sizeof(tx));
+  uart.attach();
+  CHECK(Serial1.availableForWrite() == 255);
+  double big = bulk("256 byte user ring", false);
+  CHECK(big < 0.1);
+
+  // the same slow reader as below loses nothing with the bigger ring
+  CHECK(receive(3000, 100 * 85, 256) == 0);
+  CHECK(Serial1.rxOverruns() == 0 && Serial1.rxHighWater() > 63);
+  printf("256 byte user ring: 3000 bytes read every 100 characters, none lost, %d at most waiting\n", Serial1.rxHighWater());
+
+  // not a power of two, too big for the index, or none: the built-in ring
+  Serial1.begin(115200, SERIAL_8N1, odd, sizeof(odd), NULL, 0);
+  uart.attach();
+  CHECK(Serial1.availableForWrite() == SERIAL_TX_BUFFER_SIZE - 1);
+  CHECK(receive(1000, 100 * 85, 64) > 0 && Serial1.rxHighWater() == SERIAL_RX_BUFFER_SIZE - 1);
+  Serial1.begin(115200, SERIAL_8N1, rx, 512, tx, 512);
+  uart.attach();
+  CHECK(Serial1.availableForWrite() == SERIAL_TX_BUFFER_SIZE - 1);
+  Serial1.begin(115200);
+  uart.attach();
+}
+
+static void test_rx_stats() {
+  Serial1.resetRxStats();
+  CHECK(receive(3000, 5 * 85, 64) == 0);
+  CHECK(Serial1.rxOverruns() == 0 && Serial1.rxHighWater() <= 6);
+  Serial1.resetRxStats();
+
+  // a slow reader: the ring fills and every byte it drops is counted
+  long lost = receive(3000, 100 * 85, 64);
+  CHECK(lost > 0 && Serial1.rxOverruns() == lost && uart.lost == 0);
+  CHECK(Serial1.rxHighWater() == SERIAL_RX_BUFFER_SIZE - 1);
+  printf("64 byte ring: 3000 bytes read every 100 characters, %ld lost and counted, %d at most waiting\n", lost, Serial1.rxHighWater());
+  Serial1.resetRxStats();
+  CHECK(Serial1.rxOverruns() == 0 && Serial1.rxHighWater() == 0);
+
+  // interrupts held off for five characters: UDR1 overflows, one per DOR
+  for (int i = 0; i < 10; i++) {
+    uart.line.push_back('a' + i);
+  }
+  noInterrupts();
+  delayMicroseconds(5 * 85 + 40);
+  interrupts();
+  delay(2);
+  int got = 0;
+  while (Serial1.read() >= 0) {
+    got++;
+  }
+  CHECK(uart.lost > 0 && got + uart.lost == 10);
+  CHECK(Serial1.rxOverruns() == 1);
+  printf("interrupts off for 5 characters: %ld lost in UDR1, %u overrun counted\n", uart.lost, Serial1.rxOverruns());
+}
+
+int main() {
+  test_tx();
+  test_user_buffers();
+  test_rx_stats();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
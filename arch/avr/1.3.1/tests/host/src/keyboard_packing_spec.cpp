@@ -0,0 +1,207 @@
+// Keyboard's packed print() against a model of the USB host: each report
+// is decoded the way the host does it, modifiers first and then the keys
+// that were not down in the previous report in array order, back to text
+// through the en_US layout. Text has to come out unchanged at every packing
+// with every key up at the end; the spec prints the reports per character.
+#include "Keyboard.h"
+#include <stdio.h>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+class KeyboardHost {
+public:
+  std::string typed;
+  KeyReport last = {};
+  long reports = 0;
+  // reports with a key twice or more keys than the packing allows
+  long bad = 0;
+  uint8_t maxKeys = 6;
+
+  void attach(HID_ &hid) {
+    hid.onReport = [this](uint8_t id, const void *data, int len) {
+      if (id != 2 || len != sizeof(KeyReport)) {
+        bad++;
+        return;
+      }
+      receive(*(const KeyReport *)data);
+    };
+  }
+
+  bool allUp() {
+    for (int i = 0; i < 6; i++) {
+      if (last.keys[i]) {
+        return false;
+      }
+    }
+    return last.modifiers == 0;
+  }
+
+private:
+  void receive(const KeyReport &report) {
+    reports++;
+    int down = 0;
+    for (int i = 0; i < 6; i++) {
+      uint8_t k = report.keys[i];
+      if (!k) {
+        continue;
+      }
+      down++;
+      bool held = false;
+      for (int j = 0; j < 6; j++) {
+        held = held || last.keys[j] == k;
+        if (j > i && report.keys[j] == k) {
+          bad++;
+        }
+      }
+      if (!held) {
+        typed += decode(k, report.modifiers);
+      }
+    }
+    if (down > maxKeys) {
+      bad++;
+    }
+    last = report;
+  }
+
+  // only shift and AltGr change the character, a held ctrl does not
+  static char decode(uint8_t k, uint8_t modifiers) {
+    uint8_t wanted = modifiers & 0x42;
+    for (int c = 0; c < 128; c++) {
+      uint8_t entry = KeyboardLayout_en_US[c];
+      uint8_t needs = 0;
+      if ((entry & 0xc0) == 0xc0) {
+        needs = 0x40;
+        entry &= 0x3f;
+      } else if (entry & 0x80) {
+        needs = 0x02;
+        entry &= 0x7f;
+      }
+      if (entry && entry == k && needs == wanted) {
+        return c;
+      }
+    }
+    return '?';
+  }
+};
+
+static const char *texts[] = {
+  "Hello, World! The quick brown fox jumps over the lazy dog 0123456789.",
+  "aaaa bbbb AAbbCC !@#$%^&*()_+ ~`{}[]|\\:;\"'<>,.?/",
+  "Mississippi Massachusetts committee bookkeeper",
+  "https://example.com/path?q=Atlas&x=1\n\tnext line",
+};
+
+static void test_print() {
+  KeyboardHost host;
+  host.attach(HID());
+  Keyboard.begin();
+
+  double perChar[7] = {};
+  for (int packing : {1, 2, 4, 6}) {
+    Keyboard.setPacking(packing);
+    host.maxKeys = packing;
+    long chars = 0, reports = 0;
+    for (const char *text : texts) {
+      host.typed.clear();
+      host.reports = 0;
+      CHECK(Keyboard.print(text) == strlen(text));
+      CHECK(host.typed == text && host.allUp());
+      chars += strlen(text);
+      reports += host.reports;
+    }
+    perChar[packing] = (double)reports / chars;
+  }
+  CHECK(host.bad == 0 && Keyboard.getWriteError() == 0);
+  // one press and one release per character unpacked
+  CHECK(perChar[1] == 2.0);
+  CHECK(perChar[6] < perChar[4] && perChar[4] < perChar[2] && perChar[2] < perChar[1]);
+
+  // '\r' is skipped, a character the layout lacks stops the text
+  Keyboard.setPacking(6);
+  host.typed.clear();
+  CHECK(Keyboard.print("a\r\nb") == 3 && host.typed == "a\nb");
+  host.typed.clear();
+  CHECK(Keyboard.print("ab\x01" "cd") == 2 && host.typed == "ab" && host.allUp() && Keyboard.getWriteError());
+  Keyboard.clearWriteError();
+
+  printf("reports per character at packing 1, 2, 4, 6: %.2f %.2f %.2f %.2f\n", perChar[1], perChar[2], perChar[4], perChar[6]);
+}
+
+static void test_held() {
+  KeyboardHost host;
+  host.attach(HID());
+  Keyboard.begin();
+  Keyboard.setPacking(6);
+
+  // ctrl held with press() stays down through a packed print
+  Keyboard.press(KEY_LEFT_CTRL);
+  CHECK(Keyboard.print("abcABC") == 6 && host.typed == "abcABC");
+  CHECK(host.last.modifiers == 0x01);
+  // so does a held letter, which print() does not type again
+  Keyboard.press('x');
+  host.typed.clear();
+  CHECK(Keyboard.print("axb") == 3 && host.typed == "ab");
+  CHECK(host.last.modifiers == 0x01 && host.last.keys[0] == 0x1b);
+  Keyboard.releaseAll();
+  CHECK(host.allUp());
+
+  // a non-printing key between printing ones goes through write()
+  const uint8_t keys[] = {'a', 'b', KEY_LEFT_ARROW, 'c'};
+  host.typed.clear();
+  host.reports = 0;
+  CHECK(Keyboard.write(keys, sizeof(keys)) == 4 && host.typed == "ab?c" && host.allUp());
+  CHECK(host.reports == 6);
+  CHECK(host.bad == 0);
+}
+
+static void test_press_release() {
+  KeyboardHost host;
+  host.attach(HID());
+  Keyboard.begin();
+  Keyboard.setPacking(1);
+
+  // shifted and plain keys share the modifier byte
+  Keyboard.press('A');
+  CHECK(host.last.modifiers == 0x02 && host.last.keys[0] == 0x04);
+  Keyboard.press('b');
+  CHECK(host.last.modifiers == 0x02 && host.last.keys[1] == 0x05);
+  Keyboard.release('A');
+  CHECK(host.last.modifiers == 0 && host.last.keys[0] == 0 && host.last.keys[1] == 0x05);
+  Keyboard.release('b');
+  CHECK(host.allUp());
+  Keyboard.press(KEY_LEFT_CTRL);
+  CHECK(host.last.modifiers == 0x01);
+  Keyboard.release(KEY_LEFT_CTRL);
+  CHECK(host.allUp());
+  CHECK(Keyboard.write('Z') == 1 && host.typed == "ABZ");
+}
+
+static void test_delay() {
+  KeyboardHost host;
+  host.attach(HID());
+  Keyboard.begin();
+  Keyboard.setPacking(4, 3);
+  uint32_t t0 = hostMicros;
+  CHECK(Keyboard.print("abcdefgh") == 8 && host.typed == "abcdefgh");
+  // every report, presses and releases, is followed by the pause
+  CHECK(host.reports == 4 && hostMicros - t0 == 4 * 3000);
+  Keyboard.setPacking(1);
+}
+
+int main() {
+  test_print();
+  test_held();
+  test_press_release();
+  test_delay();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+// Arduino.h for library specs: pin levels live in hostPins, time only
+// moves when a spec or delay() moves it, and external interrupts run when a
+// spec moves their pin with hostSetPin(). Core files build against the
+// core's own Arduino.h on the same avr/ headers.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "host.h"
+
+#define LOW    0x0
+#define HIGH   0x1
+#define INPUT  0x0
+#define OUTPUT 0x1
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define NOT_AN_INTERRUPT -1
+
+// the ATmega32U4 variants
+#define NUM_DIGITAL_PINS 31
+static const uint8_t SS = 17;
+#define digitalPinToInterrupt(p) ((p) == 0 ? 2 : ((p) == 1 ? 3 : ((p) == 2 ? 1 : ((p) == 3 ? 0 : ((p) == 7 ? 4 : NOT_AN_INTERRUPT)))))
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+extern "C" {
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+}
@@ -0,0 +1,37 @@
+#pragma once
+// PluggableHID on the host: reports go to the spec's model of the USB host
+// and are counted
+#include "Arduino.h"
+#include "Print.h"
+#include <functional>
+
+#define _USING_HID
+
+class HIDSubDescriptor {
+public:
+  HIDSubDescriptor(const void *d, const uint16_t l) : data(d), length(l) {}
+
+  const void *data;
+  const uint16_t length;
+};
+
+class HID_ {
+public:
+  std::function<void(uint8_t id, const void *data, int len)> onReport;
+  long reports = 0;
+
+  int SendReport(uint8_t id, const void *data, int len) {
+    reports++;
+    if (onReport) {
+      onReport(id, data, len);
+    }
+    return len;
+  }
+
+  void AppendDescriptor(HIDSubDescriptor *) {}
+};
+
+inline HID_ &HID() {
+  static HID_ hid;
+  return hid;
+}
@@ -0,0 +1,52 @@
+#pragma once
+// the part of the core's Print the libraries under test use
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  int getWriteError() {
+    return _writeError;
+  }
+  void clearWriteError() {
+    setWriteError(0);
+  }
+
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+      if (write(*buffer++)) {
+        n++;
+      } else {
+        break;
+      }
+    }
+    return n;
+  }
+  size_t write(const char *str) {
+    return str ? write((const uint8_t *)str, strlen(str)) : 0;
+  }
+  virtual int availableForWrite() {
+    return 0;
+  }
+  virtual void flush() {}
+
+  size_t print(const char str[]) {
+    return write(str);
+  }
+  size_t print(char c) {
+    return write((uint8_t)c);
+  }
+
+protected:
+  void setWriteError(int err = 1) {
+    _writeError = err;
+  }
+
+private:
+  int _writeError = 0;
+};
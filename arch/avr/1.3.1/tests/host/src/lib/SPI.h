@@ -0,0 +1,49 @@
+#pragma once
+// SPIClass on the host: every byte goes to the spec's device model, each
+// beginTransaction() is counted and its settings kept.
+#include "Arduino.h"
+#include <functional>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+  SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+  uint32_t clock;
+  uint8_t bitOrder;
+  uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+  // one byte each way, first is set for the first byte of a transaction
+  std::function<uint8_t(uint8_t out, bool first)> onTransfer;
+  long transactions = 0;
+  SPISettings settings;
+
+  void begin() {}
+
+  void beginTransaction(SPISettings s) {
+    settings = s;
+    transactions++;
+    _first = true;
+  }
+
+  uint8_t transfer(uint8_t data) {
+    uint8_t in = onTransfer ? onTransfer(data, _first) : 0xff;
+    _first = false;
+    return in;
+  }
+
+  void endTransaction() {}
+
+private:
+  bool _first = false;
+};
+
+extern SPIClass SPI;
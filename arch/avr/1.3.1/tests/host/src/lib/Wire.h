@@ -0,0 +1,75 @@
+#pragma once
+// TwoWire on the host: each transaction goes to the spec's device model and
+// is counted. Reads stop at BUFFER_LENGTH bytes like the AVR library's.
+#include "Arduino.h"
+#include <functional>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+public:
+  // the bytes of one write transaction, and the bytes to return for a read
+  std::function<void(uint8_t address, const uint8_t *data, size_t len)> onWrite;
+  std::function<void(uint8_t address, uint8_t *data, size_t len)> onRead;
+  // endTransmission() and requestFrom() calls
+  long transactions = 0;
+
+  void begin() {}
+
+  void beginTransmission(uint8_t address) {
+    _address = address;
+    _txLength = 0;
+  }
+
+  size_t write(uint8_t data) {
+    if (_txLength >= BUFFER_LENGTH) {
+      return 0;
+    }
+    _tx[_txLength++] = data;
+    return 1;
+  }
+
+  uint8_t endTransmission(uint8_t = true) {
+    transactions++;
+    if (onWrite) {
+      onWrite(_address, _tx, _txLength);
+    }
+    return 0;
+  }
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity) {
+    transactions++;
+    if (quantity > BUFFER_LENGTH) {
+      quantity = BUFFER_LENGTH;
+    }
+    memset(_rx, 0xff, quantity);
+    if (onRead) {
+      onRead(address, _rx, quantity);
+    }
+    _rxIndex = 0;
+    _rxLength = quantity;
+    return quantity;
+  }
+
+  uint8_t requestFrom(int address, int quantity) {
+    return requestFrom((uint8_t)address, (uint8_t)quantity);
+  }
+
+  int available() {
+    return _rxLength - _rxIndex;
+  }
+
+  int read() {
+    return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1;
+  }
+
+private:
+  uint8_t _address = 0;
+  uint8_t _tx[BUFFER_LENGTH];
+  uint8_t _txLength = 0;
+  uint8_t _rx[BUFFER_LENGTH];
+  uint8_t _rxIndex = 0;
+  uint8_t _rxLength = 0;
+};
+
+extern TwoWire Wire;
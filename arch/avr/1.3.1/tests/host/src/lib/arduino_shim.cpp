@@ -0,0 +1,158 @@
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+
+uint8_t hostPins[HOST_NUM_PINS];
+uint32_t hostMicros = 0;
+void (*hostTick)(void) = NULL;
+bool (*hostIrq)(void) = NULL;
+long hostCliCount = 0;
+uint8_t (*hostUsbRead)(uint8_t reg) = NULL;
+void (*hostUsbWrite)(uint8_t reg, uint8_t value) = NULL;
+
+volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+volatile uint8_t PINE, DDRE, PORTE, PINF, DDRF, PORTF;
+volatile uint8_t MCUSR, WDTCSR;
+volatile uint8_t UBRR1H, UBRR1L, UCSR1A, UCSR1B, UCSR1C, UDR1;
+
+TwoWire Wire;
+SPIClass SPI;
+
+// the five external interrupts of the ATmega32U4
+static const uint8_t interruptPins[] = {3, 2, 0, 1, 7};
+static void (*interruptFuncs[5])(void);
+static int interruptModes[5];
+static bool interruptFlags[5];
+static bool interruptsOn = true;
+
+// runs what is pending for as long as interrupts stay on
+static void dispatch() {
+  for (int i = 0; i < 5 && interruptsOn; i++) {
+    if (interruptFlags[i] && interruptFuncs[i]) {
+      interruptFlags[i] = false;
+      hostRunIsr(interruptFuncs[i]);
+    }
+  }
+  while (interruptsOn && hostIrq && hostIrq()) {
+  }
+}
+
+void hostRunIsr(void (*vector)(void)) {
+  interruptsOn = false;
+  vector();
+  // reti
+  interruptsOn = true;
+}
+
+void hostAdvance(uint32_t us) {
+  if (!hostTick) {
+    hostMicros += us;
+    return;
+  }
+  while (us--) {
+    hostMicros++;
+    hostTick();
+    dispatch();
+  }
+}
+
+// a poll in a busy wait
+static void poll() {
+  if (hostTick) {
+    hostAdvance(1);
+  }
+}
+
+void cli(void) {
+  hostCliCount++;
+  interruptsOn = false;
+}
+
+void sei(void) {
+  interruptsOn = true;
+  dispatch();
+}
+
+HostSreg::operator uint8_t() const {
+  poll();
+  return interruptsOn ? _BV(SREG_I) : 0;
+}
+
+HostSreg &HostSreg::operator=(uint8_t value) {
+  if (value & _BV(SREG_I)) {
+    sei();
+  } else {
+    cli();
+  }
+  return *this;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < HOST_NUM_PINS) {
+    hostPins[pin] = val ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HOST_NUM_PINS ? hostPins[pin] : LOW;
+}
+
+unsigned long millis(void) {
+  poll();
+  return hostMicros / 1000;
+}
+
+unsigned long micros(void) {
+  poll();
+  return hostMicros;
+}
+
+void delay(unsigned long ms) {
+  hostAdvance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostAdvance(us);
+}
+
+void _delay_us(double us) {
+  hostAdvance((uint32_t)us);
+}
+
+void _delay_ms(double ms) {
+  hostAdvance((uint32_t)(ms * 1000));
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode) {
+  if (interruptNum < 5) {
+    interruptFuncs[interruptNum] = userFunc;
+    interruptModes[interruptNum] = mode;
+    interruptFlags[interruptNum] = false;
+  }
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+  if (interruptNum < 5) {
+    interruptFuncs[interruptNum] = NULL;
+  }
+}
+
+void hostSetPin(uint8_t pin, uint8_t val) {
+  if (pin >= HOST_NUM_PINS) {
+    return;
+  }
+  uint8_t old = hostPins[pin];
+  hostPins[pin] = val ? HIGH : LOW;
+  for (int i = 0; i < 5; i++) {
+    if (interruptPins[i] != pin || !interruptFuncs[i] || old == hostPins[pin]) {
+      continue;
+    }
+    int mode = interruptModes[i];
+    if (mode == CHANGE || (mode == RISING && hostPins[pin]) || (mode == FALLING && !hostPins[pin])) {
+      interruptFlags[i] = true;
+    }
+  }
+  dispatch();
+}
@@ -0,0 +1,8 @@
+#pragma once
+// the global interrupt flag is the shim's, see host.h
+#include "avr/io.h"
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+void cli(void);
+void sei(void);
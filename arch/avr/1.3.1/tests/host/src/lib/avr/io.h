@@ -0,0 +1,192 @@
+#pragma once
+// The ATmega32U4 as far as the core uses it. The USB controller's registers
+// go to the spec's model (hostUsbRead/hostUsbWrite in host.h), the others
+// are plain bytes a model can watch and set. Registers are also defined as
+// macros of their own name so `#if defined(UBRR1H)` works as on the chip.
+#include "host.h"
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define FLASHEND 0x7FFF
+#define RAMEND 0x0AFF
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_BYTE(sfr) (sfr)
+#define bit_is_set(sfr, bit) ((uint8_t)(sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((uint8_t)(sfr) & _BV(bit)))
+
+// SREG only holds the interrupt flag
+struct HostSreg {
+  operator uint8_t() const;
+  HostSreg &operator=(uint8_t value);
+};
+static HostSreg SREG;
+#define SREG SREG
+#define SREG_I 7
+
+extern volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+extern volatile uint8_t PINE, DDRE, PORTE, PINF, DDRF, PORTF;
+extern volatile uint8_t MCUSR, WDTCSR;
+
+// USART1
+extern volatile uint8_t UBRR1H, UBRR1L, UCSR1A, UCSR1B, UCSR1C, UDR1;
+#define UBRR1H UBRR1H
+#define UBRR1L UBRR1L
+#define UCSR1A UCSR1A
+#define UCSR1B UCSR1B
+#define UCSR1C UCSR1C
+#define UDR1   UDR1
+#define RXC1   7
+#define TXC1   6
+#define UDRE1  5
+#define FE1    4
+#define DOR1   3
+#define UPE1   2
+#define U2X1   1
+#define MPCM1  0
+#define RXCIE1 7
+#define TXCIE1 6
+#define UDRIE1 5
+#define RXEN1  4
+#define TXEN1  3
+#define USART1_RX_vect   USART1_RX_vect
+#define USART1_UDRE_vect USART1_UDRE_vect
+
+// USB controller
+enum {
+  HOST_UHWCON, HOST_USBCON, HOST_USBSTA, HOST_USBINT, HOST_UDCON, HOST_UDINT, HOST_UDIEN, HOST_UDADDR, HOST_UDFNUML, HOST_UDFNUMH,
+  HOST_UDMFN, HOST_UEINTX, HOST_UENUM, HOST_UERST, HOST_UECONX, HOST_UECFG0X, HOST_UECFG1X, HOST_UESTA0X, HOST_UESTA1X, HOST_UEIENX,
+  HOST_UEDATX, HOST_UEBCLX, HOST_UEBCHX, HOST_UEINT, HOST_PLLCSR, HOST_PLLFRQ, HOST_USB_REGISTERS
+};
+
+struct HostUsbRegister {
+  uint8_t reg;
+
+  operator uint8_t() const {
+    return hostUsbRead ? hostUsbRead(reg) : 0;
+  }
+  HostUsbRegister &operator=(uint8_t value) {
+    if (hostUsbWrite) {
+      hostUsbWrite(reg, value);
+    }
+    return *this;
+  }
+  HostUsbRegister &operator|=(uint8_t value) {
+    return *this = *this | value;
+  }
+  HostUsbRegister &operator&=(uint8_t value) {
+    return *this = *this & value;
+  }
+};
+
+#define HOST_USB_REGISTER(name) static HostUsbRegister name = {HOST_##name}
+HOST_USB_REGISTER(UHWCON);
+HOST_USB_REGISTER(USBCON);
+HOST_USB_REGISTER(USBSTA);
+HOST_USB_REGISTER(USBINT);
+HOST_USB_REGISTER(UDCON);
+HOST_USB_REGISTER(UDINT);
+HOST_USB_REGISTER(UDIEN);
+HOST_USB_REGISTER(UDADDR);
+HOST_USB_REGISTER(UDFNUML);
+HOST_USB_REGISTER(UDFNUMH);
+HOST_USB_REGISTER(UDMFN);
+HOST_USB_REGISTER(UEINTX);
+HOST_USB_REGISTER(UENUM);
+HOST_USB_REGISTER(UERST);
+HOST_USB_REGISTER(UECONX);
+HOST_USB_REGISTER(UECFG0X);
+HOST_USB_REGISTER(UECFG1X);
+HOST_USB_REGISTER(UESTA0X);
+HOST_USB_REGISTER(UESTA1X);
+HOST_USB_REGISTER(UEIENX);
+HOST_USB_REGISTER(UEDATX);
+HOST_USB_REGISTER(UEBCLX);
+HOST_USB_REGISTER(UEBCHX);
+HOST_USB_REGISTER(UEINT);
+HOST_USB_REGISTER(PLLCSR);
+HOST_USB_REGISTER(PLLFRQ);
+#define USBCON USBCON
+#define UHWCON UHWCON
+#define USB_COM_vect USB_COM_vect
+#define USB_GEN_vect USB_GEN_vect
+
+// UHWCON, USBCON, USBSTA
+#define UVREGE 0
+#define OTGPADE 4
+#define FRZCLK 5
+#define USBE 7
+#define VBUS 0
+// UDCON, UDINT, UDIEN
+#define DETACH 0
+#define RMWKUP 1
+#define LSM 2
+#define RSTCPU 3
+#define SUSPI 0
+#define SOFI 2
+#define EORSTI 3
+#define WAKEUPI 4
+#define EORSMI 5
+#define UPRSMI 6
+#define SUSPE 0
+#define SOFE 2
+#define EORSTE 3
+#define WAKEUPE 4
+#define EORSME 5
+#define UPRSME 6
+#define ADDEN 7
+// UEINTX, UEIENX
+#define TXINI 0
+#define STALLEDI 1
+#define RXOUTI 2
+#define RXSTPI 3
+#define NAKOUTI 4
+#define RWAL 5
+#define NAKINI 6
+#define FIFOCON 7
+#define TXINE 0
+#define STALLEDE 1
+#define RXOUTE 2
+#define RXSTPE 3
+#define NAKOUTE 4
+#define NAKINE 6
+#define FLERRE 7
+// UECONX, UECFG0X, UECFG1X, UESTA0X, UERST
+#define EPEN 0
+#define RSTDT 3
+#define STALLRQC 4
+#define STALLRQ 5
+#define EPDIR 0
+#define EPTYPE0 6
+#define EPTYPE1 7
+#define ALLOC 1
+#define EPBK0 2
+#define EPBK1 3
+#define EPSIZE0 4
+#define EPSIZE1 5
+#define EPSIZE2 6
+#define NBUSYBK0 0
+#define NBUSYBK1 1
+#define DTSEQ0 2
+#define DTSEQ1 3
+#define UNDERFI 5
+#define OVERFI 6
+#define CFGOK 7
+#define EPRST0 0
+#define EPRST6 6
+// PLLCSR, PLLFRQ
+#define PLOCK 0
+#define PLLE 1
+#define PINDIV 4
+#define PDIV0 0
+#define PDIV1 1
+#define PDIV2 2
+#define PDIV3 3
+#define PLLUSB 6
+#define PINMUX 7
+// WDTCSR
+#define WDE 3
+#define WDCE 4
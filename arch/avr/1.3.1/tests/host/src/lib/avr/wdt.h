@@ -0,0 +1,9 @@
+#pragma once
+// the watchdog never fires on the host
+#define WDTO_15MS  0
+#define WDTO_120MS 3
+#define WDTO_1S    6
+
+#define wdt_enable(timeout) ((void)(timeout))
+#define wdt_disable()
+#define wdt_reset()
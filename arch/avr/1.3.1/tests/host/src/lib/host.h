@@ -0,0 +1,29 @@
+#pragma once
+// What specs and their device models see of the shim: pin levels, the
+// clock, and hooks for devices that run as time passes and raise
+// interrupts, for library and core code alike.
+#include <stdint.h>
+
+#define HOST_NUM_PINS 31
+
+extern uint8_t hostPins[HOST_NUM_PINS];
+extern uint32_t hostMicros;
+
+// drives an input from outside: an attached interrupt runs on its edge, or
+// once interrupts() is called if they are off, as the INTF flag would
+void hostSetPin(uint8_t pin, uint8_t val);
+
+// With hostTick set, time passes one microsecond at a time and each poll of
+// millis(), micros() or SREG takes one, so busy waits see devices move.
+// hostIrq runs whenever interrupts are on and returns whether it ran a vector.
+extern void (*hostTick)(void);
+extern bool (*hostIrq)(void);
+void hostAdvance(uint32_t us);
+// runs vector as the CPU does, with interrupts off until it returns
+void hostRunIsr(void (*vector)(void));
+// cli() calls so far, each the start of an atomic section
+extern long hostCliCount;
+
+// the USB controller's registers, handed to the spec's model
+extern uint8_t (*hostUsbRead)(uint8_t reg);
+extern void (*hostUsbWrite)(uint8_t reg, uint8_t value);
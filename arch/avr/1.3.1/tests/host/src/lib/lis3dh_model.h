@@ -0,0 +1,159 @@
+#pragma once
+// A LIS3DH as the driver sees it over Wire or SPI: the register file, output
+// registers showing the newest sample, and the 32-level FIFO. With the FIFO
+// on, reading past OUT_Z_H pops a sample and wraps back to OUT_X_L. INT1
+// follows the watermark or data ready flag CTRL_REG3 routes to it.
+#include "SPI.h"
+#include "Wire.h"
+#include <deque>
+
+struct Lis3dhSample {
+  int16_t x, y, z;
+};
+
+class Lis3dhModel {
+public:
+  uint8_t reg[0x40];
+  std::deque<Lis3dhSample> fifo;
+  // samples FIFO mode refused once full, and stream mode overwrote
+  long lost = 0;
+  // the pin INT1 is wired to, -1 for none
+  int int1Pin = -1;
+  // runs after each Wire transaction, for samples that arrive mid-drain
+  std::function<void()> onTransaction;
+
+  Lis3dhModel() {
+    memset(reg, 0, sizeof(reg));
+    reg[0x0f] = 0x33;  // WHO_AM_I
+  }
+
+  void attach(TwoWire &wire) {
+    wire.onWrite = [this](uint8_t, const uint8_t *data, size_t len) {
+      if (!len) {
+        return;
+      }
+      _ptr = data[0] & 0x7f;
+      _inc = data[0] & 0x80;
+      for (size_t i = 1; i < len; i++) {
+        writeNext(data[i]);
+      }
+      transactionDone();
+    };
+    wire.onRead = [this](uint8_t, uint8_t *data, size_t len) {
+      for (size_t i = 0; i < len; i++) {
+        data[i] = readNext();
+      }
+      transactionDone();
+    };
+  }
+
+  void attach(SPIClass &spi) {
+    spi.onTransfer = [this](uint8_t out, bool first) -> uint8_t {
+      if (first) {
+        _read = out & 0x80;
+        _inc = out & 0x40;
+        _ptr = out & 0x3f;
+        return 0xff;
+      }
+      uint8_t value = _read ? readNext() : 0xff;
+      if (!_read) {
+        writeNext(out);
+      }
+      updateInt1();
+      return value;
+    };
+  }
+
+  // a new sample at the data rate
+  void push(Lis3dhSample sample) {
+    _current = sample;
+    _dataReady = true;
+    if (fifoEnabled()) {
+      if (fifo.size() < 32) {
+        fifo.push_back(sample);
+      } else {
+        lost++;
+        if ((reg[0x2e] & 0xc0) != 0x40) {
+          fifo.pop_front();
+          fifo.push_back(sample);
+        }
+      }
+    }
+    updateInt1();
+  }
+
+  bool fifoEnabled() {
+    return (reg[0x24] & 0x40) && (reg[0x2e] & 0xc0);
+  }
+
+  // FIFO_SRC_REG: WTM, OVRN_FIFO, EMPTY and the unread count
+  uint8_t fifoSource() {
+    size_t count = fifo.size();
+    uint8_t src = count ? (count >= 32 ? 0x40 | 31 : count) : 0x20;
+    if (count > (size_t)(reg[0x2e] & 0x1f)) {
+      src |= 0x80;
+    }
+    return src;
+  }
+
+  // CTRL_REG3: I1_WTM follows FIFO_SRC's WTM bit, I1_ZYXDA an unread sample
+  bool int1() {
+    return ((reg[0x22] & 0x04) && (fifoSource() & 0x80)) || ((reg[0x22] & 0x10) && _dataReady);
+  }
+
+private:
+  Lis3dhSample _current = {0, 0, 0};
+  bool _dataReady = false;
+  uint8_t _ptr = 0;
+  bool _inc = false;
+  bool _read = false;
+
+  void writeNext(uint8_t value) {
+    reg[_ptr] = value;
+    // bypass mode empties the FIFO
+    if (_ptr == 0x2e && !(value & 0xc0)) {
+      fifo.clear();
+    }
+    if (_inc) {
+      _ptr = (_ptr + 1) & 0x3f;
+    }
+  }
+
+  void updateInt1() {
+    if (int1Pin >= 0) {
+      hostSetPin(int1Pin, int1() ? HIGH : LOW);
+    }
+  }
+
+  void transactionDone() {
+    updateInt1();
+    if (onTransaction) {
+      onTransaction();
+    }
+  }
+
+  uint8_t readNext() {
+    uint8_t r = _ptr;
+    uint8_t value;
+    if (r >= 0x28 && r <= 0x2d) {
+      Lis3dhSample sample = fifoEnabled() && !fifo.empty() ? fifo.front() : _current;
+      int16_t axis = r < 0x2a ? sample.x : r < 0x2c ? sample.y : sample.z;
+      value = r & 1 ? (uint16_t)axis >> 8 : axis & 0xff;
+      if (r == 0x2d) {
+        _dataReady = false;
+        if (fifoEnabled() && !fifo.empty()) {
+          fifo.pop_front();
+          _dataReady = !fifo.empty();
+        }
+      }
+    } else if (r == 0x2f) {
+      value = fifoSource();
+    } else {
+      value = reg[r];
+    }
+    if (_inc) {
+      _ptr = r == 0x2d && fifoEnabled() ? 0x28 : (r + 1) & 0x3f;
+    }
+    return value;
+  }
+};
@@ -0,0 +1,128 @@
+#pragma once
+// The ATmega32U4's USART1 and the line at the other end, as the core's
+// HardwareSerial sees them. The registers are plain bytes, so the model
+// looks at them every microsecond: UCSR1A written with UDRE1 cleared means
+// the code wrote UDR1. begin() writes UCSR1A as well, so attach() the model
+// again after it. Characters take the time UBRR1 and U2X1 give them; UDR1
+// holds one received character, a second one arriving before it is read
+// sets DOR1 and is lost. USART1_RX_vect and USART1_UDRE_vect run while their
+// flag and enable are both set.
+#include "host.h"
+#include <avr/io.h>
+#include <deque>
+#include <stddef.h>
+#include <vector>
+
+extern "C" void USART1_RX_vect(void);
+extern "C" void USART1_UDRE_vect(void);
+
+class UartModel {
+public:
+  // what went out on TX, and what is still to come in on RX
+  std::vector<uint8_t> sent;
+  std::deque<uint8_t> line;
+  // characters lost to a full UDR1, and UDR1 written while it was full
+  long lost = 0, overwrites = 0;
+
+  ~UartModel() {
+    if (_model == this) {
+      _model = NULL;
+      hostTick = NULL;
+      hostIrq = NULL;
+    }
+  }
+
+  void attach() {
+    _model = this;
+    publish();
+    hostTick = []() { _model->tick(); };
+    hostIrq = []() { return _model->irq(); };
+  }
+
+  // microseconds per character, ten bits at the programmed rate
+  uint32_t charTime() {
+    uint32_t cycles = (((UBRR1H << 8) | UBRR1L) + 1) * ((UCSR1A & _BV(U2X1)) ? 8 : 16);
+    return cycles * 10 / (F_CPU / 1000000);
+  }
+
+  // the last character sent has left the shifter
+  bool idle() {
+    return !_hold && !_shifting;
+  }
+
+private:
+  static inline UartModel *_model = NULL;
+  uint8_t _published = 0;
+  bool _hold = false, _shifting = false, _txc = false, _rxc = false, _dor = false;
+  uint8_t _holdByte = 0, _shiftByte = 0;
+  uint32_t _shiftLeft = 0, _rxLeft = 0;
+
+  // what the code wrote to UCSR1A and UDR1 since the last look
+  void sync() {
+    uint8_t written = UCSR1A;
+    if (written != _published) {
+      if (written & _BV(TXC1)) {
+        _txc = false;
+      }
+      if (!(written & _BV(UDRE1))) {
+        if (_hold) {
+          overwrites++;
+        }
+        _hold = true;
+        _holdByte = UDR1;
+      }
+    }
+    publish();
+  }
+
+  void publish() {
+    uint8_t mode = UCSR1A & (_BV(U2X1) | _BV(MPCM1));
+    _published = UCSR1A = mode | (_rxc ? _BV(RXC1) : 0) | (_txc ? _BV(TXC1) : 0) | (_hold ? 0 : _BV(UDRE1)) | (_dor ? _BV(DOR1) : 0);
+  }
+
+  void tick() {
+    sync();
+    uint8_t control = UCSR1B;
+    if (_shifting && --_shiftLeft == 0) {
+      sent.push_back(_shiftByte);
+      _shifting = false;
+      _txc = !_hold;
+    }
+    if (!_shifting && _hold && (control & _BV(TXEN1))) {
+      _shiftByte = _holdByte;
+      _hold = false;
+      _shifting = true;
+      _shiftLeft = charTime();
+    }
+    if (!line.empty() && (control & _BV(RXEN1)) && ++_rxLeft >= charTime()) {
+      _rxLeft = 0;
+      if (_rxc) {
+        _dor = true;
+        lost++;
+      } else {
+        UDR1 = line.front();
+        _rxc = true;
+      }
+      line.pop_front();
+    }
+    publish();
+  }
+
+  bool irq() {
+    sync();
+    uint8_t control = UCSR1B;
+    if (_rxc && (control & _BV(RXCIE1))) {
+      hostRunIsr(USART1_RX_vect);
+      // the vector read UDR1
+      _rxc = _dor = false;
+      publish();
+      return true;
+    }
+    if (!_hold && (control & _BV(UDRIE1))) {
+      hostRunIsr(USART1_UDRE_vect);
+      sync();
+      return true;
+    }
+    return false;
+  }
+};
@@ -0,0 +1,252 @@
+#pragma once
+// The ATmega32U4 USB device controller and the host at the other end, as
+// the core's USBCore.cpp sees them. Endpoint 0 takes setup packets from the
+// spec; IN endpoints have one or two banks that the host empties one packet
+// every hostInterval microseconds while it is reading; a start of frame
+// comes every millisecond. USB_GEN_vect and USB_COM_vect run, level
+// triggered, while their flag and enable are both set.
+#include "host.h"
+#include <avr/io.h>
+#include <deque>
+#include <string.h>
+#include <vector>
+
+extern "C" void USB_GEN_vect(void);
+extern "C" void USB_COM_vect(void);
+
+class UsbModel {
+public:
+  static const int ENDPOINTS = 7;
+
+  // what the host received on each endpoint, and the size of each packet
+  std::vector<uint8_t> received[ENDPOINTS];
+  std::vector<int> packets[ENDPOINTS];
+  bool reading = true;
+  int hostInterval = 60;
+  // bytes written to a bank that was busy or full, which the chip drops
+  long lostWrites = 0;
+  // vector entries, and microseconds in which they kept firing without end
+  long genVectors = 0, comVectors = 0, storms = 0;
+
+  UsbModel() {
+    memset(_reg, 0, sizeof(_reg));
+  }
+
+  ~UsbModel() {
+    if (_model == this) {
+      _model = NULL;
+      hostUsbRead = NULL;
+      hostUsbWrite = NULL;
+      hostTick = NULL;
+      hostIrq = NULL;
+    }
+  }
+
+  void attach() {
+    _model = this;
+    hostUsbRead = [](uint8_t reg) { return _model->read(reg); };
+    hostUsbWrite = [](uint8_t reg, uint8_t value) { _model->write(reg, value); };
+    hostTick = []() { _model->tick(); };
+    hostIrq = []() { return _model->irq(); };
+  }
+
+  // end of a bus reset, handled by USB_GEN_vect when enabled
+  void busReset() {
+    _reg[HOST_UDINT] |= _BV(EORSTI);
+    hostAdvance(1);
+  }
+
+  // a setup packet on endpoint 0, without a data stage
+  void setup(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index = 0) {
+    uint8_t packet[8] = {requestType, request, (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)index, (uint8_t)(index >> 8), 0, 0};
+    _setup.assign(packet, packet + 8);
+    _setupPending = true;
+    hostAdvance(1);
+  }
+
+  // IN banks the host has not taken yet
+  int queued() {
+    return _released.size();
+  }
+
+private:
+  struct Endpoint {
+    uint8_t cfg0 = 0, cfg1 = 0, ienx = 0;
+    bool busy[2] = {false, false};
+    std::vector<uint8_t> bank[2];
+    int cur = 0;
+  };
+
+  static inline UsbModel *_model = NULL;
+  uint8_t _reg[HOST_USB_REGISTERS];
+  Endpoint _ep[ENDPOINTS];
+  std::deque<std::pair<int, int>> _released;  // endpoint and bank, in order
+  std::vector<uint8_t> _setup;
+  bool _setupPending = false;
+  long _now = 0;
+  int _vectorsThisTick = 0;
+
+  Endpoint &current() {
+    return _ep[_reg[HOST_UENUM] % ENDPOINTS];
+  }
+
+  bool isIn(const Endpoint &ep) {
+    return ep.cfg0 & _BV(EPDIR);
+  }
+
+  int banks(const Endpoint &ep) {
+    return (ep.cfg1 & _BV(EPBK0)) ? 2 : 1;
+  }
+
+  bool bankFree(const Endpoint &ep) {
+    return !ep.busy[ep.cur];
+  }
+
+  uint8_t read(uint8_t reg) {
+    Endpoint &ep = current();
+    int num = _reg[HOST_UENUM] % ENDPOINTS;
+    switch (reg) {
+    case HOST_PLLCSR:
+      return _reg[reg] | ((_reg[reg] & _BV(PLLE)) ? _BV(PLOCK) : 0);
+    case HOST_UEINTX:
+      if (num == 0) {
+        return (_setupPending ? _BV(RXSTPI) : 0) | _BV(TXINI);
+      }
+      if (!isIn(ep)) {
+        return 0;
+      }
+      return bankFree(ep) ? _BV(TXINI) | _BV(FIFOCON) | (ep.bank[ep.cur].size() < 64 ? _BV(RWAL) : 0) : 0;
+    case HOST_UEDATX:
+      if (num == 0 && !_setup.empty()) {
+        uint8_t value = _setup.front();
+        _setup.erase(_setup.begin());
+        return value;
+      }
+      return 0;
+    case HOST_UEBCLX:
+      return ep.bank[ep.cur].size();
+    case HOST_UESTA0X:
+      return (ep.busy[0] ? 1 : 0) + (ep.busy[1] ? 1 : 0);
+    case HOST_UEIENX:
+      return ep.ienx;
+    case HOST_UECFG0X:
+      return ep.cfg0;
+    case HOST_UECFG1X:
+      return ep.cfg1;
+    case HOST_UEINT:
+      return pendingEndpoints();
+    }
+    return _reg[reg];
+  }
+
+  void write(uint8_t reg, uint8_t value) {
+    Endpoint &ep = current();
+    int num = _reg[HOST_UENUM] % ENDPOINTS;
+    switch (reg) {
+    case HOST_UDINT:
+      // flags are only cleared by software
+      _reg[reg] &= value;
+      return;
+    case HOST_UEINTX:
+      if (num == 0) {
+        if (!(value & _BV(RXSTPI))) {
+          _setupPending = false;
+        }
+      } else if (isIn(ep) && !(value & _BV(FIFOCON)) && bankFree(ep)) {
+        // an empty bank goes out as a zero length packet
+        ep.busy[ep.cur] = true;
+        _released.push_back({num, ep.cur});
+        ep.cur = (ep.cur + 1) % banks(ep);
+      }
+      return;
+    case HOST_UEDATX:
+      if (num == 0) {
+        return;
+      }
+      if (!isIn(ep) || !bankFree(ep) || ep.bank[ep.cur].size() >= 64) {
+        lostWrites++;
+        return;
+      }
+      ep.bank[ep.cur].push_back(value);
+      return;
+    case HOST_UEIENX:
+      ep.ienx = value;
+      return;
+    case HOST_UECFG0X:
+      ep.cfg0 = value;
+      return;
+    case HOST_UECFG1X:
+      ep.cfg1 = value;
+      return;
+    case HOST_UERST:
+      for (int i = 0; i < ENDPOINTS; i++) {
+        if (value & _BV(i)) {
+          reset(i);
+        }
+      }
+      break;
+    }
+    _reg[reg] = value;
+  }
+
+  void reset(int num) {
+    Endpoint &ep = _ep[num];
+    ep.busy[0] = ep.busy[1] = false;
+    ep.bank[0].clear();
+    ep.bank[1].clear();
+    ep.cur = 0;
+    for (auto it = _released.begin(); it != _released.end();) {
+      it = it->first == num ? _released.erase(it) : it + 1;
+    }
+  }
+
+  uint8_t pendingEndpoints() {
+    uint8_t pending = (_ep[0].ienx & _BV(RXSTPE)) && _setupPending ? 1 : 0;
+    for (int i = 1; i < ENDPOINTS; i++) {
+      if (isIn(_ep[i]) && (_ep[i].ienx & _BV(TXINE)) && bankFree(_ep[i])) {
+        pending |= _BV(i);
+      }
+    }
+    return pending;
+  }
+
+  void tick() {
+    _now++;
+    _vectorsThisTick = 0;
+    if (reading && _now % hostInterval == 0 && !_released.empty()) {
+      auto [num, bank] = _released.front();
+      _released.pop_front();
+      Endpoint &ep = _ep[num];
+      received[num].insert(received[num].end(), ep.bank[bank].begin(), ep.bank[bank].end());
+      packets[num].push_back(ep.bank[bank].size());
+      ep.bank[bank].clear();
+      ep.busy[bank] = false;
+    }
+    if (_now % 1000 == 0) {
+      _reg[HOST_UDINT] |= _BV(SOFI);
+      _reg[HOST_UDFNUML]++;
+    }
+  }
+
+  bool irq() {
+    if (++_vectorsThisTick > 50) {
+      // left for the next microsecond, counted once
+      if (_vectorsThisTick == 51) {
+        storms++;
+      }
+      return false;
+    }
+    if (_reg[HOST_UDINT] & _reg[HOST_UDIEN] & (_BV(SUSPI) | _BV(SOFI) | _BV(EORSTI) | _BV(WAKEUPI))) {
+      genVectors++;
+      hostRunIsr(USB_GEN_vect);
+      return true;
+    }
+    if (pendingEndpoints()) {
+      comVectors++;
+      hostRunIsr(USB_COM_vect);
+      return true;
+    }
+    _vectorsThisTick--;
+    return false;
+  }
+};
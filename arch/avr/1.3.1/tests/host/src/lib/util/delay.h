@@ -0,0 +1,3 @@
+#pragma once
+void _delay_us(double us);
+void _delay_ms(double ms);
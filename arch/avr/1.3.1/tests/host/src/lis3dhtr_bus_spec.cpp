@@ -0,0 +1,169 @@
+// LIS3DHTR against a register model of the sensor on a counting Wire and SPI
+// bus: transactions per sample for the float getters, the single burst read
+// and the FIFO drain, and the milli-g integer path against the float one.
+#include "LIS3DHTR.h"
+#include "lis3dh_model.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+// count samples numbered from first: x = 100 n, y = -x, z = 7 n - 3000
+static void fill(Lis3dhModel &chip, int count, int first = 0) {
+  for (int i = first; i < first + count; i++) {
+    chip.push({(int16_t)(i * 100), (int16_t)(-i * 100), (int16_t)(i * 7 - 3000)});
+  }
+}
+
+static bool inOrder(const int16_t *xyz, int count, int first = 0) {
+  for (int i = 0; i < count; i++) {
+    int n = first + i;
+    if (xyz[3 * i] != n * 100 || xyz[3 * i + 1] != -n * 100 || xyz[3 * i + 2] != n * 7 - 3000) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_wire() {
+  Lis3dhModel chip;
+  chip.attach(Wire);
+  LIS3DHTR<TwoWire> lis;
+  lis.begin(Wire, 0x18);
+  CHECK(lis.isConnection());
+  CHECK((chip.reg[0x23] & 0x30) == LIS3DHTR_RANGE_16G);
+
+  chip.push({-1234, 567, 16000});
+  long t0 = Wire.transactions;
+  float x = lis.getAccelerationX(), y = lis.getAccelerationY(), z = lis.getAccelerationZ();
+  long getters = Wire.transactions - t0;
+  // one address write and one read per axis
+  CHECK(getters == 6);
+  CHECK(x == -1234.0f / 1280 && y == 567.0f / 1280 && z == 16000.0f / 1280);
+
+  t0 = Wire.transactions;
+  float ax, ay, az;
+  lis.getAcceleration(&ax, &ay, &az);
+  long burst = Wire.transactions - t0;
+  CHECK(burst == 2 && ax == x && ay == y && az == z);
+
+  int16_t rx, ry, rz;
+  lis.getAccelerationRaw(&rx, &ry, &rz);
+  CHECK(rx == -1234 && ry == 567 && rz == 16000);
+
+  printf("Wire: X, Y and Z getters %ld transactions, getAcceleration() %ld\n", getters, burst);
+}
+
+static void test_milli_g() {
+  Lis3dhModel chip;
+  chip.attach(Wire);
+  LIS3DHTR<TwoWire> lis;
+  lis.begin(Wire, 0x18);
+  scale_type_t ranges[] = {LIS3DHTR_RANGE_2G, LIS3DHTR_RANGE_4G, LIS3DHTR_RANGE_8G, LIS3DHTR_RANGE_16G};
+  double worst = 0;
+  for (scale_type_t range : ranges) {
+    lis.setFullScaleRange(range);
+    for (long v = -32768; v <= 32767; v += 7) {
+      chip.push({(int16_t)v, (int16_t)-v, (int16_t)(v / 2)});
+      int16_t mx, my, mz;
+      float fx, fy, fz;
+      long t0 = Wire.transactions;
+      lis.getAccelerationMilliG(&mx, &my, &mz);
+      CHECK(Wire.transactions - t0 == 2);
+      lis.getAcceleration(&fx, &fy, &fz);
+      worst = fmax(worst, fmax(fabs(mx - fx * 1000), fmax(fabs(my - fy * 1000), fabs(mz - fz * 1000))));
+      if (failures > 10) {
+        return;
+      }
+    }
+  }
+  CHECK(worst < 1);
+  printf("getAccelerationMilliG() on all four ranges: within %.2f mg of the float path\n", worst);
+}
+
+static void test_fifo_wire() {
+  Lis3dhModel chip;
+  chip.attach(Wire);
+  LIS3DHTR<TwoWire> lis;
+  lis.begin(Wire, 0x18);
+
+  lis.setFifoMode(LIS3DHTR_FIFO_STREAM, 16);
+  CHECK(chip.reg[0x2e] == (LIS3DHTR_FIFO_STREAM | 16) && (chip.reg[0x24] & 0x40));
+  CHECK(lis.getFifoCount() == 0);
+  fill(chip, 20);
+  CHECK(lis.getFifoCount() == 20);
+  // stream mode keeps the newest 32
+  fill(chip, 17, 20);
+  CHECK(lis.getFifoCount() == 32);
+
+  // the whole FIFO, in bursts the 32 byte Wire buffer can hold
+  int16_t xyz[3 * 32];
+  long t0 = Wire.transactions;
+  CHECK(lis.readFifo(xyz, 32) == 32);
+  long drain = Wire.transactions - t0;
+  CHECK(inOrder(xyz, 32, 5) && chip.fifo.empty());
+  CHECK(drain == 2 + 2 * ((32 + LIS3DHTR_WIRE_BURST_SAMPLES - 1) / LIS3DHTR_WIRE_BURST_SAMPLES));
+
+  // fewer than asked for, and fewer asked for than stored
+  fill(chip, 3);
+  CHECK(lis.readFifo(xyz, 32) == 3 && inOrder(xyz, 3));
+  fill(chip, 10);
+  CHECK(lis.readFifo(xyz, 4) == 4 && inOrder(xyz, 4) && chip.fifo.size() == 6);
+  CHECK(lis.readFifo(xyz, 0) == 0 && chip.fifo.size() == 6);
+
+  // bypass clears the FIFO and turns it off
+  lis.setFifoMode(LIS3DHTR_FIFO_BYPASS);
+  CHECK(chip.reg[0x2e] == 0 && !(chip.reg[0x24] & 0x40) && chip.fifo.empty());
+  CHECK(lis.getFifoCount() == 0);
+
+  printf("Wire: 32 FIFO samples in %ld transactions (%.2f per sample)\n", drain, drain / 32.0);
+}
+
+static void test_spi() {
+  Lis3dhModel chip;
+  chip.attach(SPI);
+  LIS3DHTR<SPIClass> lis;
+  lis.begin(SPI, 10);
+  CHECK(lis.isConnection());
+  // begin() used to fill a local SPISettings, leaving the member at the defaults
+  CHECK(SPI.settings.clock == 10000000 && SPI.settings.dataMode == SPI_MODE3 && SPI.settings.bitOrder == MSBFIRST);
+  CHECK(hostPins[10] == HIGH);
+
+  chip.push({100, -200, 300});
+  long t0 = SPI.transactions;
+  int16_t x, y, z;
+  lis.getAccelerationRaw(&x, &y, &z);
+  CHECK(SPI.transactions - t0 == 1 && x == 100 && y == -200 && z == 300);
+  t0 = SPI.transactions;
+  lis.getAccelerationX();
+  lis.getAccelerationY();
+  lis.getAccelerationZ();
+  CHECK(SPI.transactions - t0 == 3);
+
+  lis.setFifoMode(LIS3DHTR_FIFO_FIFO, 31);
+  fill(chip, 40);
+  CHECK(chip.fifo.size() == 32 && chip.lost == 8);
+  int16_t xyz[3 * 32];
+  t0 = SPI.transactions;
+  CHECK(lis.readFifo(xyz, 32) == 32);
+  long drain = SPI.transactions - t0;
+  // FIFO_SRC, then every sample in one transfer
+  CHECK(drain == 2 && inOrder(xyz, 32) && chip.fifo.empty());
+  printf("SPI: getAccelerationRaw() 1 transaction, 32 FIFO samples in %ld\n", drain);
+}
+
+int main() {
+  test_wire();
+  test_milli_g();
+  test_fifo_wire();
+  test_spi();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
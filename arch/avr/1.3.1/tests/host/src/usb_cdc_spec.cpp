@@ -0,0 +1,147 @@
+// Serial on the native USB port against a model of the 32U4's USB
+// controller and a host taking a packet every 60 us: the byte stream for log
+// lines, a bulk dump and bursts, the zero length packet after a transfer
+// that ends on a full packet, no endpoint interrupt firing without end, and
+// write() giving up when the host stops reading.
+#include "usb_model.h"
+#include "USBAPI.h"
+// built in, for the port's line state
+#include "CDC.cpp"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+static UsbModel usb;
+
+static uint32_t rng = 1;
+static uint8_t rnd() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 16;
+}
+
+// enumeration as far as the CDC port needs it, then the terminal opens it;
+// SET_CONTROL_LINE_STATE would touch the bootloader key at a fixed RAM
+// address, so DTR and RTS are set directly
+static void connect() {
+  usb.attach();
+  USBDevice.attach();
+  usb.busReset();
+  usb.setup(REQUEST_HOSTTODEVICE | REQUEST_STANDARD | REQUEST_DEVICE, SET_CONFIGURATION, 1);
+  _usbLineInfo.lineState = 3;
+}
+
+static void settle() {
+  delay(5);
+  usb.received[CDC_TX].clear();
+  usb.packets[CDC_TX].clear();
+}
+
+// write() calls of `size` bytes every `period` us until `total` are sent
+static void stream(const char *name, int total, int minSize, int maxSize, uint32_t period) {
+  settle();
+  std::vector<uint8_t> sent;
+  uint32_t inWrite = 0, start = hostMicros;
+  long calls = 0;
+  uint8_t buffer[300];
+  while ((int)sent.size() < total) {
+    int size = minSize + rnd() % (maxSize - minSize + 1);
+    for (int i = 0; i < size; i++) {
+      buffer[i] = rnd();
+    }
+    uint32_t t0 = hostMicros;
+    size_t n = Serial.write(buffer, size);
+    inWrite += hostMicros - t0;
+    calls++;
+    CHECK(n == (size_t)size);
+    sent.insert(sent.end(), buffer, buffer + n);
+    delayMicroseconds(period);
+  }
+  uint32_t written = hostMicros - start;
+  Serial.flush();
+  delay(5);
+
+  const std::vector<int> &packets = usb.packets[CDC_TX];
+  CHECK(usb.received[CDC_TX] == sent);
+  // every transfer ends on a short packet
+  CHECK(!packets.empty() && packets.back() < USB_EP_SIZE);
+  printf(
+    "%s: %zu bytes in %zu packets, %.2f ms inside write() (%.1f us a call), written in %.1f ms\n", name, sent.size(), packets.size(),
+    inWrite / 1000.0, (double)inWrite / calls, written / 1000.0
+  );
+}
+
+static void test_connect() {
+  connect();
+  CHECK(USBDevice.configured() && Serial);
+  CHECK(Serial.availableForWrite() == CDC_TX_BUFFER_SIZE);
+}
+
+static void test_streams() {
+  stream("log lines every 2 ms", 6000, 20, 59, 2000);
+  stream("32 KB dump", 32768, 1, 200, 5);
+  stream("300 byte bursts every 5 ms", 6000, 300, 300, 5000);
+  CHECK(usb.lostWrites == 0 && usb.storms == 0);
+}
+
+static void test_zlp() {
+  settle();
+  uint8_t buffer[2 * USB_EP_SIZE];
+  memset(buffer, 7, sizeof(buffer));
+  CHECK(Serial.write(buffer, sizeof(buffer)) == sizeof(buffer));
+  delay(3);
+  const std::vector<int> &packets = usb.packets[CDC_TX];
+  CHECK(packets.size() == 3 && packets[0] == USB_EP_SIZE && packets[1] == USB_EP_SIZE && packets[2] == 0);
+  printf("%zu byte write: packets of", sizeof(buffer));
+  for (int size : packets) {
+    printf(" %d", size);
+  }
+  printf(" bytes\n");
+
+  // an idle port gets no further packets, and TXINE stays off
+  long vectors = usb.comVectors;
+  delay(10);
+  CHECK(packets.size() == 3 && usb.comVectors == vectors);
+}
+
+static void test_host_stops() {
+  settle();
+  usb.reading = false;
+  std::vector<uint8_t> big(1000, 'x');
+  uint32_t t0 = hostMicros;
+  size_t n = Serial.write(big.data(), big.size());
+  uint32_t stalled = hostMicros - t0;
+  // two banks and the ring, then 250 ms without progress
+  CHECK(n == 2 * USB_EP_SIZE + CDC_TX_BUFFER_SIZE);
+  CHECK(stalled >= 250000 && stalled < 260000);
+  CHECK(Serial.getWriteError());
+  CHECK(!CDC_TxFlush() && Serial.availableForWrite() == 0);
+  CHECK(usb.storms == 0);
+
+  usb.reading = true;
+  Serial.clearWriteError();
+  delay(5);
+  CHECK(usb.received[CDC_TX].size() == n && Serial.availableForWrite() == CDC_TX_BUFFER_SIZE);
+  printf(
+    "host not reading: %zu of %zu bytes queued, write() gave up after %.0f ms; delivered once it reads again\n", n, big.size(),
+    stalled / 1000.0
+  );
+}
+
+int main() {
+  test_connect();
+  test_streams();
+  test_zlp();
+  test_host_stops();
+  CHECK(usb.lostWrites == 0 && usb.storms == 0);
+  printf("%ld endpoint and %ld general interrupts, %ld storms\n", usb.comVectors, usb.genVectors, usb.storms);
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -226,6 +226,50 @@ size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
   return index;  // return number of characters, not including null terminator
 }
 
+size_t Stream::readLine(char *buffer, size_t capacity, char terminator, bool *truncated) {
+  size_t index = 0;
+  bool overflow = false;
+  if (!buffer || !capacity) {
+    if (truncated) {
+      *truncated = false;
+    }
+    return 0;
+  }
+  size_t room = capacity - 1;
+  while (1) {
+    size_t avail = hasPeekBufferAPI() ? peekAvailable() : 0;
+    if (avail) {
+      // scan what is already buffered in one go
+      const char *data = peekBuffer();
+      const char *end = (const char *)memchr(data, terminator, avail);
+      size_t len = end ? end - data : avail;
+      size_t copy = len < room - index ? len : room - index;
+      memcpy(buffer + index, data, copy);
+      index += copy;
+      overflow |= copy < len;
+      peekConsume(end ? len + 1 : len);
+      if (end) {
+        break;
+      }
+      continue;
+    }
+    int c = timedRead();
+    if (c < 0 || (char)c == terminator) {
+      break;
+    }
+    if (index < room) {
+      buffer[index++] = (char)c;
+    } else {
+      overflow = true;
+    }
+  }
+  buffer[index] = '\0';
+  if (truncated) {
+    *truncated = overflow;
+  }
+  return index;  // return number of characters, not including null terminator
+}
+
 String Stream::readString() {
   String ret;
   int c = timedRead();
@@ -119,10 +119,34 @@ public:
   // terminates if length characters have been read, timeout, or if the terminator character  detected
   // returns the number of characters placed in the buffer (0 means no valid data found)
 
+  size_t readLine(char *buffer, size_t capacity, char terminator = '\n', bool *truncated = nullptr);
+  // reads chars into buffer until the terminator (consumed, not stored), timeout or end of stream
+  // and null terminates them. A line longer than capacity - 1 is cut there, its remainder is skipped
+  // up to the terminator and *truncated is set.
+  // returns the number of characters placed in the buffer
+
   // Arduino String functions to be added here
   virtual String readString();
   String readStringUntil(char terminator);
 
+  // Peek buffer API, for streams that keep received data in RAM and can let
+  // readers scan it in place instead of fetching it one char at a time
+  virtual bool hasPeekBufferAPI() const {
+    return false;
+  }
+  // returns the number of bytes that can be read from peekBuffer() without waiting
+  virtual size_t peekAvailable() {
+    return 0;
+  }
+  // returns a pointer to the next peekAvailable() bytes, valid until the next read
+  virtual const char *peekBuffer() {
+    return nullptr;
+  }
+  // drops consume bytes (at most peekAvailable()) from the front of peekBuffer()
+  virtual void peekConsume(size_t consume) {
+    (void)consume;
+  }
+
 protected:
   long parseInt(char ignore) {
     return parseInt(SKIP_ALL, ignore);
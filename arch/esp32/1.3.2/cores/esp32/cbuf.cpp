@@ -34,13 +34,13 @@
       log_e("failed to create mutex"); \
     }                                  \
   }
-#define CBUF_MUTEX_LOCK()                          \
-  if (_lock != NULL) {                             \
-    xSemaphoreTakeRecursive(_lock, portMAX_DELAY); \
+#define CBUF_MUTEX_LOCK()                 \
+  if (_lock != NULL) {                    \
+    xSemaphoreTake(_lock, portMAX_DELAY); \
   }
-#define CBUF_MUTEX_UNLOCK()         \
-  if (_lock != NULL) {              \
-    xSemaphoreGiveRecursive(_lock); \
+#define CBUF_MUTEX_UNLOCK()  \
+  if (_lock != NULL) {       \
+    xSemaphoreGive(_lock);   \
   }
 #define CBUF_MUTEX_DELETE()      \
   if (_lock != NULL) {           \
@@ -50,20 +50,21 @@
   }
 #endif
 
-cbuf::cbuf(size_t size) : next(NULL), has_peek(false), peek_byte(0), _buf(xRingbufferCreate(size, RINGBUF_TYPE_BYTEBUF)) {
+cbuf::cbuf(size_t size) : next(NULL), has_peek(false), peek_byte(0), _buf((char *)malloc(size)) {
   if (_buf == NULL) {
     log_e("failed to allocate ring buffer");
+  } else {
+    _size = size;
   }
   CBUF_MUTEX_CREATE();
 }
 
 cbuf::~cbuf() {
   CBUF_MUTEX_LOCK();
-  if (_buf != NULL) {
-    RingbufHandle_t b = _buf;
-    _buf = NULL;
-    vRingbufferDelete(b);
-  }
+  free(_buf);
+  _buf = NULL;
+  _size = 0;
+  _fill = 0;
   CBUF_MUTEX_UNLOCK();
   CBUF_MUTEX_DELETE();
 }
@@ -74,90 +75,52 @@ size_t cbuf::resizeAdd(size_t addSize) {
 
 size_t cbuf::resize(size_t newSize) {
   CBUF_MUTEX_LOCK();
-  size_t _size = size();
-  if (newSize == _size) {
-    return _size;
+  size_t oldSize = _size;
+  if (newSize == oldSize) {
+    CBUF_MUTEX_UNLOCK();
+    return oldSize;
   }
 
   // not lose any data
   // if data can be lost use remove or flush before resize
-  size_t bytes_available = available();
-  if (newSize < bytes_available) {
+  if (newSize < _fill) {
     CBUF_MUTEX_UNLOCK();
     log_e("new size is less than the currently available data size");
-    return _size;
+    return oldSize;
   }
 
-  RingbufHandle_t newbuf = xRingbufferCreate(newSize, RINGBUF_TYPE_BYTEBUF);
+  char *newbuf = (char *)malloc(newSize);
   if (newbuf == NULL) {
     CBUF_MUTEX_UNLOCK();
     log_e("failed to allocate new ring buffer");
-    return _size;
-  }
-
-  if (_buf != NULL) {
-    if (bytes_available) {
-      char *old_data = (char *)malloc(bytes_available);
-      if (old_data == NULL) {
-        vRingbufferDelete(newbuf);
-        CBUF_MUTEX_UNLOCK();
-        log_e("failed to allocate temporary buffer");
-        return _size;
-      }
-      bytes_available = read(old_data, bytes_available);
-      if (!bytes_available) {
-        free(old_data);
-        vRingbufferDelete(newbuf);
-        CBUF_MUTEX_UNLOCK();
-        log_e("failed to read previous data");
-        return _size;
-      }
-      if (xRingbufferSend(newbuf, (void *)old_data, bytes_available, 0) != pdTRUE) {
-        write(old_data, bytes_available);
-        free(old_data);
-        vRingbufferDelete(newbuf);
-        CBUF_MUTEX_UNLOCK();
-        log_e("failed to restore previous data");
-        return _size;
-      }
-      free(old_data);
-    }
-
-    RingbufHandle_t b = _buf;
-    _buf = newbuf;
-    vRingbufferDelete(b);
-  } else {
-    _buf = newbuf;
+    return oldSize;
   }
+  size_t fill = _read(newbuf, _fill);
+  free(_buf);
+  _buf = newbuf;
+  _size = newSize;
+  _begin = 0;
+  _fill = fill;
   CBUF_MUTEX_UNLOCK();
   return newSize;
 }
 
 size_t cbuf::available() const {
-  size_t available = 0;
-  if (_buf != NULL) {
-    vRingbufferGetInfo(_buf, NULL, NULL, NULL, NULL, (UBaseType_t *)&available);
-  }
-  if (has_peek) {
-    available++;
-  }
+  CBUF_MUTEX_LOCK();
+  size_t available = _fill;
+  CBUF_MUTEX_UNLOCK();
   return available;
 }
 
 size_t cbuf::size() {
-  size_t _size = 0;
-  if (_buf != NULL) {
-    _size = xRingbufferGetMaxItemSize(_buf);
-  }
   return _size;
 }
 
 size_t cbuf::room() const {
-  size_t _room = 0;
-  if (_buf != NULL) {
-    _room = xRingbufferGetCurFreeSize(_buf);
-  }
-  return _room;
+  CBUF_MUTEX_LOCK();
+  size_t room = _size - _fill;
+  CBUF_MUTEX_UNLOCK();
+  return room;
 }
 
 bool cbuf::empty() const {
@@ -169,22 +132,8 @@ bool cbuf::full() const {
 }
 
 int cbuf::peek() {
-  if (!available()) {
-    return -1;
-  }
-
-  int c;
-
   CBUF_MUTEX_LOCK();
-  if (has_peek) {
-    c = peek_byte;
-  } else {
-    c = read();
-    if (c >= 0) {
-      has_peek = true;
-      peek_byte = c;
-    }
-  }
+  int c = _fill ? (uint8_t)_buf[_begin] : -1;
   CBUF_MUTEX_UNLOCK();
   return c;
 }
@@ -194,62 +143,38 @@ int cbuf::read() {
   if (!read(&result, 1)) {
     return -1;
   }
-  return static_cast<int>(result);
+  return (uint8_t)result;
 }
 
 size_t cbuf::read(char *dst, size_t size) {
   CBUF_MUTEX_LOCK();
-  size_t bytes_available = available();
-  if (!bytes_available || !size) {
-    CBUF_MUTEX_UNLOCK();
+  size_t size_read = _read(dst, size);
+  CBUF_MUTEX_UNLOCK();
+  return size_read;
+}
+
+size_t cbuf::_read(char *dst, size_t size) {
+  if (size > _fill) {
+    size = _fill;
+  }
+  if (!size) {
     return 0;
   }
-
-  if (has_peek) {
-    if (dst != NULL) {
-      *dst++ = peek_byte;
-    }
-    size--;
+  size_t first = _size - _begin;
+  if (first > size) {
+    first = size;
   }
-
-  size_t size_read = 0;
-  if (size) {
-    size_t received_size = 0;
-    size_t size_to_read = (size < bytes_available) ? size : bytes_available;
-    uint8_t *received_buff = (uint8_t *)xRingbufferReceiveUpTo(_buf, &received_size, 0, size_to_read);
-    if (received_buff != NULL) {
-      if (dst != NULL) {
-        memcpy(dst, received_buff, received_size);
-      }
-      vRingbufferReturnItem(_buf, received_buff);
-      size_read = received_size;
-      size_to_read -= received_size;
-      // wrap around data
-      if (size_to_read) {
-        received_size = 0;
-        received_buff = (uint8_t *)xRingbufferReceiveUpTo(_buf, &received_size, 0, size_to_read);
-        if (received_buff != NULL) {
-          if (dst != NULL) {
-            memcpy(dst + size_read, received_buff, received_size);
-          }
-          vRingbufferReturnItem(_buf, received_buff);
-          size_read += received_size;
-        } else {
-          log_e("failed to read wrap around data from ring buffer");
-        }
-      }
-    } else {
-      log_e("failed to read from ring buffer");
-    }
+  if (dst != NULL) {
+    memcpy(dst, _buf + _begin, first);
+    // wrap around data
+    memcpy(dst + first, _buf, size - first);
   }
-
-  if (has_peek) {
-    has_peek = false;
-    size_read++;
+  _begin += size;
+  if (_begin >= _size) {
+    _begin -= _size;
   }
-
-  CBUF_MUTEX_UNLOCK();
-  return size_read;
+  _fill -= size;
+  return size;
 }
 
 size_t cbuf::write(char c) {
@@ -258,32 +183,144 @@ size_t cbuf::write(char c) {
 
 size_t cbuf::write(const char *src, size_t size) {
   CBUF_MUTEX_LOCK();
-  size_t bytes_available = room();
-  if (!bytes_available || !size) {
-    CBUF_MUTEX_UNLOCK();
-    return 0;
+  size_t size_written = _write(src, size);
+  CBUF_MUTEX_UNLOCK();
+  return size_written;
+}
+
+size_t cbuf::_write(const char *src, size_t size) {
+  if (size > _size - _fill) {
+    size = _size - _fill;
   }
-  size_t size_to_write = (size < bytes_available) ? size : bytes_available;
-  if (xRingbufferSend(_buf, (void *)src, size_to_write, 0) != pdTRUE) {
-    CBUF_MUTEX_UNLOCK();
-    log_e("failed to write to ring buffer");
+  if (!size) {
     return 0;
   }
-  CBUF_MUTEX_UNLOCK();
-  return size_to_write;
+  size_t end = _begin + _fill;
+  if (end >= _size) {
+    end -= _size;
+  }
+  size_t first = _size - end;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(_buf + end, src, first);
+  memcpy(_buf, src + first, size - first);
+  _fill += size;
+  return size;
 }
 
 void cbuf::flush() {
-  read(NULL, available());
+  CBUF_MUTEX_LOCK();
+  _begin = 0;
+  _fill = 0;
+  CBUF_MUTEX_UNLOCK();
 }
 
 size_t cbuf::remove(size_t size) {
   CBUF_MUTEX_LOCK();
-  size_t bytes_available = available();
-  if (bytes_available && size) {
-    size_t size_to_remove = (size < bytes_available) ? size : bytes_available;
-    bytes_available -= read(NULL, size_to_remove);
-  }
+  _read(NULL, size);
+  size_t bytes_available = _fill;
   CBUF_MUTEX_UNLOCK();
   return bytes_available;
 }
+
+cbuf_spsc::cbuf_spsc(size_t size) : _buf(NULL), _mask(0), _head(0), _tail(0) {
+  size_t capacity = 1;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  _buf = (char *)malloc(capacity);
+  if (_buf == NULL) {
+    log_e("failed to allocate ring buffer");
+    return;
+  }
+  _mask = capacity - 1;
+}
+
+cbuf_spsc::~cbuf_spsc() {
+  free(_buf);
+}
+
+int cbuf_spsc::peek() {
+  if (!available()) {
+    return -1;
+  }
+  return (uint8_t)_buf[_tail.load(std::memory_order_relaxed) & _mask];
+}
+
+size_t cbuf_spsc::peek(char *dst, size_t size) const {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t count = _head.load(std::memory_order_acquire) - tail;
+  if (size > count) {
+    size = count;
+  }
+  if (!size) {
+    return 0;
+  }
+  size_t offset = tail & _mask;
+  size_t first = _mask + 1 - offset;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(dst, _buf + offset, first);
+  memcpy(dst + first, _buf, size - first);
+  return size;
+}
+
+int cbuf_spsc::read() {
+  int c = peek();
+  if (c >= 0) {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  return c;
+}
+
+size_t cbuf_spsc::read(char *dst, size_t size) {
+  if (dst == NULL) {
+    size_t count = available();
+    if (size > count) {
+      size = count;
+    }
+  } else {
+    size = peek(dst, size);
+  }
+  _tail.store(_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  return size;
+}
+
+size_t cbuf_spsc::write(char c) {
+  return write(&c, 1);
+}
+
+size_t cbuf_spsc::write(const char *src, size_t size) {
+  size_t head = _head.load(std::memory_order_relaxed);
+  size_t space = this->size() - (head - _tail.load(std::memory_order_acquire));
+  if (size > space) {
+    size = space;
+  }
+  if (!size) {
+    return 0;
+  }
+  size_t offset = head & _mask;
+  size_t first = _mask + 1 - offset;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(_buf + offset, src, first);
+  memcpy(_buf, src + first, size - first);
+  _head.store(head + size, std::memory_order_release);
+  return size;
+}
+
+void cbuf_spsc::flush() {
+  _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t cbuf_spsc::remove(size_t size) {
+  size_t count = available();
+  if (size > count) {
+    size = count;
+  }
+  _tail.store(_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  return count - size;
+}
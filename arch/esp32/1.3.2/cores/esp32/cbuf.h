@@ -23,11 +23,14 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <atomic>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
 
+// Circular byte buffer that may be shared by any number of readers and
+// writers, every call takes a mutex. Use cbuf_spsc below when only one task
+// writes and only one task reads.
 class cbuf {
 public:
   cbuf(size_t size);
@@ -54,12 +57,66 @@ public:
   size_t remove(size_t size);
 
   cbuf *next;
+  // kept for compatibility, peek() no longer takes the byte out of the buffer
   bool has_peek;
   uint8_t peek_byte;
 
 protected:
-  RingbufHandle_t _buf = NULL;
+  size_t _read(char *dst, size_t size);
+  size_t _write(const char *src, size_t size);
+
+  char *_buf = NULL;
+  size_t _size = 0;
+  size_t _begin = 0;  // offset of the oldest byte
+  size_t _fill = 0;   // bytes stored
 #if !CONFIG_DISABLE_HAL_LOCKS
   SemaphoreHandle_t _lock = NULL;
 #endif
 };
+
+// Lock-free circular byte buffer for exactly one writing and one reading
+// task (or ISR). The capacity is rounded up to a power of two. The writer
+// may only call room(), full() and write(), everything else is for the reader.
+class cbuf_spsc {
+public:
+  cbuf_spsc(size_t size);
+  ~cbuf_spsc();
+
+  size_t size() const {
+    return _buf ? _mask + 1 : 0;
+  }
+  size_t available() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+  }
+  size_t room() const {
+    return size() - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+  }
+  bool empty() const {
+    return available() == 0;
+  }
+  bool full() const {
+    return room() == 0;
+  }
+
+  int peek();
+  size_t peek(char *dst, size_t size) const;
+
+  int read();
+  size_t read(char *dst, size_t size);
+
+  size_t write(char c);
+  size_t write(const char *src, size_t size);
+
+  void flush();
+  size_t remove(size_t size);
+
+protected:
+  cbuf_spsc(const cbuf_spsc &) = delete;
+  cbuf_spsc &operator=(const cbuf_spsc &) = delete;
+
+  char *_buf;
+  size_t _mask;
+  // free running positions, only the low bits index _buf
+  std::atomic<size_t> _head;  // written by the writer
+  std::atomic<size_t> _tail;  // written by the reader
+};
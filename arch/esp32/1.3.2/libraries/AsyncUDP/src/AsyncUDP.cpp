@@ -1,5 +1,6 @@
 #include "Arduino.h"
 #include "AsyncUDP.h"
+#include <new>
 
 extern "C" {
 #include "lwip/opt.h"
@@ -151,6 +152,63 @@ static err_t _udp_sendto_if(struct udp_pcb *pcb, struct pbuf *pb, const ip_addr_
   return msg.err;
 }
 
+typedef struct {
+  struct tcpip_api_call_data call;
+  udp_pcb *pcb;
+  AsyncUDPBatchItem *items;
+  size_t count;
+  const uint8_t *data;  // shared payload, or NULL to use each item's
+  size_t len;
+  struct netif *netif;
+  size_t sent;
+  err_t err;
+} udp_api_batch_t;
+
+static err_t _udp_sendto_batch_api(struct tcpip_api_call_data *api_call_msg) {
+  udp_api_batch_t *msg = (udp_api_batch_t *)api_call_msg;
+  // The payloads are referenced, not copied: lwIP prepends its headers in a
+  // separate pbuf and copies PBUF_REF data if it has to queue it, so the same
+  // pbuf can be pointed at the next payload once the stack has let go of it.
+  pbuf *pb = NULL;
+  msg->sent = 0;
+  msg->err = ERR_OK;
+  for (size_t i = 0; i < msg->count; i++) {
+    AsyncUDPBatchItem &item = msg->items[i];
+    const uint8_t *data = msg->data ? msg->data : item.data;
+    size_t len = msg->data ? msg->len : item.len;
+    if (len > CONFIG_TCP_MSS) {
+      len = CONFIG_TCP_MSS;
+    }
+    if (pb && pb->ref > 1) {
+      pbuf_free(pb);
+      pb = NULL;
+    }
+    if (!pb) {
+      pb = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
+      if (!pb) {
+        item.err = msg->err = ERR_MEM;
+        continue;
+      }
+    }
+    pb->payload = (void *)data;
+    pb->len = pb->tot_len = len;
+    if (msg->netif) {
+      item.err = udp_sendto_if(msg->pcb, pb, &item.addr, item.port, msg->netif);
+    } else {
+      item.err = udp_sendto(msg->pcb, pb, &item.addr, item.port);
+    }
+    if (item.err == ERR_OK) {
+      msg->sent++;
+    } else {
+      msg->err = item.err;
+    }
+  }
+  if (pb) {
+    pbuf_free(pb);
+  }
+  return msg->err;
+}
+
 typedef struct {
   void *arg;
   udp_pcb *pcb;
@@ -164,15 +222,38 @@ static QueueHandle_t _udp_queue;
 static volatile TaskHandle_t _udp_task_handle = NULL;
 
 static void _udp_task(void *pvParameters) {
-  lwip_event_packet_t *e = NULL;
+  // events are drained in batches and consecutive packets for the same
+  // AsyncUDP are delivered together; the packets live on this task's stack
+  lwip_event_packet_t events[ASYNC_UDP_BATCH_SIZE];
+  AsyncUDPPacket *packets[ASYNC_UDP_BATCH_SIZE];
+  alignas(AsyncUDPPacket) uint8_t storage[ASYNC_UDP_BATCH_SIZE][sizeof(AsyncUDPPacket)];
   for (;;) {
-    if (xQueueReceive(_udp_queue, &e, portMAX_DELAY) == pdTRUE) {
-      if (!e->pb) {
-        free((void *)(e));
+    if (xQueueReceive(_udp_queue, &events[0], portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    size_t count = 1;
+    while (count < ASYNC_UDP_BATCH_SIZE && xQueueReceive(_udp_queue, &events[count], 0) == pdTRUE) {
+      count++;
+    }
+    size_t first = 0;
+    while (first < count) {
+      if (!events[first].pb) {
+        first++;
         continue;
       }
-      AsyncUDP::_s_recv(e->arg, e->pcb, e->pb, e->addr, e->port, e->netif);
-      free((void *)(e));
+      size_t n = 0;
+      void *arg = events[first].arg;
+      for (size_t i = first; i < count && events[i].arg == arg && events[i].pb; i++) {
+        lwip_event_packet_t &e = events[i];
+        packets[n] = new (storage[n]) AsyncUDPPacket(reinterpret_cast<AsyncUDP *>(arg), e.pb, e.addr, e.port, e.netif);
+        n++;
+      }
+      AsyncUDP::_s_recvBatch(arg, packets, n);
+      for (size_t i = 0; i < n; i++) {
+        packets[i]->~AsyncUDPPacket();
+        pbuf_free(events[first + i].pb);
+      }
+      first += n;
     }
   }
   _udp_task_handle = NULL;
@@ -181,14 +262,17 @@ static void _udp_task(void *pvParameters) {
 
 static bool _udp_task_start() {
   if (!_udp_queue) {
-    _udp_queue = xQueueCreate(32, sizeof(lwip_event_packet_t *));
+    // the queue stores the events by value, so its storage is the event pool
+    _udp_queue = xQueueCreate(ASYNC_UDP_QUEUE_LENGTH, sizeof(lwip_event_packet_t));
     if (!_udp_queue) {
       return false;
     }
   }
   if (!_udp_task_handle) {
+    // _udp_task keeps one batch of events and packets on its stack
+    const uint32_t stack = 4096 + ASYNC_UDP_BATCH_SIZE * (sizeof(lwip_event_packet_t) + sizeof(AsyncUDPPacket) + sizeof(AsyncUDPPacket *));
     xTaskCreateUniversal(
-      _udp_task, "async_udp", 4096, NULL, CONFIG_ARDUINO_UDP_TASK_PRIORITY, (TaskHandle_t *)&_udp_task_handle, CONFIG_ARDUINO_UDP_RUNNING_CORE
+      _udp_task, "async_udp", stack, NULL, CONFIG_ARDUINO_UDP_TASK_PRIORITY, (TaskHandle_t *)&_udp_task_handle, CONFIG_ARDUINO_UDP_RUNNING_CORE
     );
     if (!_udp_task_handle) {
       return false;
@@ -201,21 +285,15 @@ static bool _udp_task_post(void *arg, udp_pcb *pcb, pbuf *pb, const ip_addr_t *a
   if (!_udp_task_handle || !_udp_queue) {
     return false;
   }
-  lwip_event_packet_t *e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
-  if (!e) {
-    return false;
-  }
-  e->arg = arg;
-  e->pcb = pcb;
-  e->pb = pb;
-  e->addr = addr;
-  e->port = port;
-  e->netif = netif;
-  if (xQueueSend(_udp_queue, &e, portMAX_DELAY) != pdPASS) {
-    free((void *)(e));
-    return false;
-  }
-  return true;
+  lwip_event_packet_t e;
+  e.arg = arg;
+  e.pcb = pcb;
+  e.pb = pb;
+  e.addr = addr;
+  e.port = port;
+  e.netif = netif;
+  // never block the lwIP thread: when the task falls behind the packet is dropped
+  return xQueueSend(_udp_queue, &e, 0) == pdPASS;
 }
 
 static void _udp_recv(void *arg, udp_pcb *pcb, pbuf *pb, const ip_addr_t *addr, uint16_t port) {
@@ -224,6 +302,7 @@ static void _udp_recv(void *arg, udp_pcb *pcb, pbuf *pb, const ip_addr_t *addr,
     pb = pb->next;
     this_pb->next = NULL;
     if (!_udp_task_post(arg, pcb, this_pb, addr, port, ip_current_input_netif())) {
+      AsyncUDP::_s_dropped(arg);
       pbuf_free(this_pb);
     }
   }
@@ -237,12 +316,11 @@ static bool _udp_task_stop(){
         vTaskDelay(10);
     }
 
-    lwip_event_packet_t * e;
+    lwip_event_packet_t e;
     while (xQueueReceive(_udp_queue, &e, 0) == pdTRUE) {
-        if(e->pb){
-            pbuf_free(e->pb);
+        if(e.pb){
+            pbuf_free(e.pb);
         }
-        free((void*)(e));
     }
     vQueueDelete(_udp_queue);
     _udp_queue = NULL;
@@ -304,6 +382,7 @@ AsyncUDPPacket::AsyncUDPPacket(AsyncUDPPacket &packet) {
   _udp = packet._udp;
   _pb = packet._pb;
   _if = packet._if;
+  _netif = packet._netif;
   _data = packet._data;
   _len = packet._len;
   _index = 0;
@@ -321,6 +400,7 @@ AsyncUDPPacket::AsyncUDPPacket(AsyncUDP *udp, pbuf *pb, const ip_addr_t *raddr,
   _udp = udp;
   _pb = pb;
   _if = TCPIP_ADAPTER_IF_MAX;
+  _netif = ntif;
   _data = (uint8_t *)(pb->payload);
   _len = pb->len;
   _index = 0;
@@ -359,18 +439,6 @@ AsyncUDPPacket::AsyncUDPPacket(AsyncUDP *udp, pbuf *pb, const ip_addr_t *raddr,
   }
 #endif
   memcpy(_remoteMac, eth->src.addr, 6);
-
-  struct netif *netif = NULL;
-  void *nif = NULL;
-  int i;
-  for (i = 0; i < TCPIP_ADAPTER_IF_MAX; i++) {
-    tcpip_adapter_get_netif((tcpip_adapter_if_t)i, &nif);
-    netif = (struct netif *)nif;
-    if (netif && netif == ntif) {
-      _if = (tcpip_adapter_if_t)i;
-      break;
-    }
-  }
 }
 
 AsyncUDPPacket::~AsyncUDPPacket() {
@@ -390,14 +458,12 @@ int AsyncUDPPacket::available() {
 }
 
 size_t AsyncUDPPacket::read(uint8_t *data, size_t len) {
-  size_t i;
   size_t a = _len - _index;
   if (len > a) {
     len = a;
   }
-  for (i = 0; i < len; i++) {
-    data[i] = read();
-  }
+  memcpy(data, _data + _index, len);
+  _index += len;
   return len;
 }
 
@@ -420,6 +486,18 @@ void AsyncUDPPacket::flush() {
 }
 
 tcpip_adapter_if_t AsyncUDPPacket::interface() {
+  // resolved on first use, most handlers never ask
+  if (_netif) {
+    for (int i = 0; i < TCPIP_ADAPTER_IF_MAX; i++) {
+      void *nif = NULL;
+      tcpip_adapter_get_netif((tcpip_adapter_if_t)i, &nif);
+      if (nif && (struct netif *)nif == _netif) {
+        _if = (tcpip_adapter_if_t)i;
+        break;
+      }
+    }
+    _netif = NULL;
+  }
   return _if;
 }
 
@@ -503,7 +581,7 @@ size_t AsyncUDPPacket::write(const uint8_t *data, size_t len) {
   if (!data) {
     return 0;
   }
-  return _udp->writeTo(data, len, &_remoteIp, _remotePort, _if);
+  return _udp->writeTo(data, len, &_remoteIp, _remotePort, interface());
 }
 
 size_t AsyncUDPPacket::write(uint8_t data) {
@@ -534,6 +612,8 @@ AsyncUDP::AsyncUDP() {
   _connected = false;
   _lastErr = ERR_OK;
   _handler = NULL;
+  _batchHandler = NULL;
+  _dropped = 0;
 }
 
 AsyncUDP::~AsyncUDP() {
@@ -739,21 +819,57 @@ size_t AsyncUDP::writeTo(const uint8_t *data, size_t len, const ip_addr_t *addr,
   return 0;
 }
 
-void AsyncUDP::_recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint16_t port, struct netif *netif) {
-  while (pb != NULL) {
-    pbuf *this_pb = pb;
-    pb = pb->next;
-    this_pb->next = NULL;
-    if (_handler) {
-      AsyncUDPPacket packet(this, this_pb, addr, port, netif);
-      _handler(packet);
+size_t AsyncUDP::sendBatch(AsyncUDPBatchItem *items, size_t count, tcpip_adapter_if_t tcpip_if) {
+  return sendBatch(NULL, 0, items, count, tcpip_if);
+}
+
+size_t AsyncUDP::sendBatch(const uint8_t *data, size_t len, AsyncUDPBatchItem *items, size_t count, tcpip_adapter_if_t tcpip_if) {
+  if (!items || !count) {
+    return 0;
+  }
+  if (!_pcb) {
+    UDP_MUTEX_LOCK();
+    _pcb = udp_new();
+    UDP_MUTEX_UNLOCK();
+    if (_pcb == NULL) {
+      return 0;
     }
-    pbuf_free(this_pb);
   }
+  udp_api_batch_t msg;
+  msg.pcb = _pcb;
+  msg.items = items;
+  msg.count = count;
+  msg.data = data;
+  msg.len = len;
+  msg.netif = NULL;
+  if (tcpip_if < TCPIP_ADAPTER_IF_MAX) {
+    void *nif = NULL;
+    tcpip_adapter_get_netif((tcpip_adapter_if_t)tcpip_if, &nif);
+    msg.netif = (struct netif *)nif;
+  }
+  tcpip_api_call(_udp_sendto_batch_api, (struct tcpip_api_call_data *)&msg);
+  _lastErr = msg.err;
+  return msg.sent;
 }
 
-void AsyncUDP::_s_recv(void *arg, udp_pcb *upcb, pbuf *p, const ip_addr_t *addr, uint16_t port, struct netif *netif) {
-  reinterpret_cast<AsyncUDP *>(arg)->_recv(upcb, p, addr, port, netif);
+void AsyncUDP::_recvBatch(AsyncUDPPacket **packets, size_t count) {
+  if (_batchHandler) {
+    _batchHandler(packets, count);
+    return;
+  }
+  if (_handler) {
+    for (size_t i = 0; i < count; i++) {
+      _handler(*packets[i]);
+    }
+  }
+}
+
+void AsyncUDP::_s_recvBatch(void *arg, AsyncUDPPacket **packets, size_t count) {
+  reinterpret_cast<AsyncUDP *>(arg)->_recvBatch(packets, count);
+}
+
+void AsyncUDP::_s_dropped(void *arg) {
+  reinterpret_cast<AsyncUDP *>(arg)->_dropped++;
 }
 
 bool AsyncUDP::listen(uint16_t port) {
@@ -878,10 +994,20 @@ esp_err_t AsyncUDP::lastErr() {
   return _lastErr;
 }
 
+uint32_t AsyncUDP::droppedPackets() {
+  return _dropped;
+}
+
 void AsyncUDP::onPacket(AuPacketHandlerFunctionWithArg cb, void *arg) {
   onPacket(std::bind(cb, arg, std::placeholders::_1));
 }
 
 void AsyncUDP::onPacket(AuPacketHandlerFunction cb) {
   _handler = cb;
+  _batchHandler = NULL;
+}
+
+void AsyncUDP::onPackets(AuPacketBatchHandlerFunction cb) {
+  _batchHandler = cb;
+  _handler = NULL;
 }
@@ -12,6 +12,17 @@ extern "C" {
 #include "freertos/semphr.h"
 }
 
+// Length of the queue between the lwIP thread and the async_udp task. Packets
+// that arrive while it is full are dropped and counted in droppedPackets().
+#ifndef ASYNC_UDP_QUEUE_LENGTH
+#define ASYNC_UDP_QUEUE_LENGTH 32
+#endif
+
+// Most packets the async_udp task takes off the queue and delivers at once
+#ifndef ASYNC_UDP_BATCH_SIZE
+#define ASYNC_UDP_BATCH_SIZE 8
+#endif
+
 // This enum and it's uses are copied and adapted for compatibility from ESP-IDF 4-
 typedef enum {
   TCPIP_ADAPTER_IF_STA = 0, /**< Wi-Fi STA (station) interface */
@@ -28,8 +39,23 @@ struct udp_pcb;
 struct pbuf;
 struct netif;
 
+// One datagram of AsyncUDP::sendBatch(). err is set to the result of sending it.
+struct AsyncUDPBatchItem {
+  const uint8_t *data;
+  size_t len;
+  ip_addr_t addr;
+  uint16_t port;
+  esp_err_t err;
+
+  void to(const IPAddress &ip, uint16_t p) {
+    ip.to_ip_addr_t(&addr);
+    port = p;
+  }
+};
+
 typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
 typedef std::function<void(void *arg, AsyncUDPPacket &packet)> AuPacketHandlerFunctionWithArg;
+typedef std::function<void(AsyncUDPPacket **packets, size_t count)> AuPacketBatchHandlerFunction;
 
 class AsyncUDPMessage : public Print {
 protected:
@@ -56,6 +82,7 @@ protected:
   AsyncUDP *_udp;
   pbuf *_pb;
   tcpip_adapter_if_t _if;
+  struct netif *_netif;  // until interface() has resolved _if
   ip_addr_t _localIp;
   uint16_t _localPort;
   ip_addr_t _remoteIp;
@@ -109,9 +136,11 @@ protected:
   bool _connected;
   esp_err_t _lastErr;
   AuPacketHandlerFunction _handler;
+  AuPacketBatchHandlerFunction _batchHandler;
+  volatile uint32_t _dropped;
 
   bool _init();
-  void _recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint16_t port, struct netif *netif);
+  void _recvBatch(AsyncUDPPacket **packets, size_t count);
 
 public:
   AsyncUDP();
@@ -119,6 +148,8 @@ public:
 
   void onPacket(AuPacketHandlerFunctionWithArg cb, void *arg = NULL);
   void onPacket(AuPacketHandlerFunction cb);
+  // receive up to ASYNC_UDP_BATCH_SIZE queued packets per call, replaces onPacket()
+  void onPackets(AuPacketBatchHandlerFunction cb);
 
   bool listen(const ip_addr_t *addr, uint16_t port);
   bool listen(const IPAddress addr, uint16_t port);
@@ -149,15 +180,24 @@ public:
   size_t broadcastTo(AsyncUDPMessage &message, uint16_t port, tcpip_adapter_if_t tcpip_if = TCPIP_ADAPTER_IF_MAX);
   size_t broadcast(AsyncUDPMessage &message);
 
+  // Send every item in a single call into the lwIP thread, the payloads are
+  // not copied. Returns the number of datagrams sent, see item.err for each.
+  size_t sendBatch(AsyncUDPBatchItem *items, size_t count, tcpip_adapter_if_t tcpip_if = TCPIP_ADAPTER_IF_MAX);
+  // same, with one payload for all destinations (item.data and item.len are ignored)
+  size_t sendBatch(const uint8_t *data, size_t len, AsyncUDPBatchItem *items, size_t count, tcpip_adapter_if_t tcpip_if = TCPIP_ADAPTER_IF_MAX);
+
   IPAddress listenIP();
 #if CONFIG_LWIP_IPV6
   IPAddress listenIPv6();
 #endif
   bool connected();
   esp_err_t lastErr();
+  // packets dropped because the async_udp task could not keep up
+  uint32_t droppedPackets();
   operator bool();
 
-  static void _s_recv(void *arg, udp_pcb *upcb, pbuf *p, const ip_addr_t *addr, uint16_t port, struct netif *netif);
+  static void _s_recvBatch(void *arg, AsyncUDPPacket **packets, size_t count);
+  static void _s_dropped(void *arg);
 };
 
 #endif
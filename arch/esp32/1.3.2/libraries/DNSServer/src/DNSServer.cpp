@@ -12,10 +12,15 @@
 
 #define DNS_MIN_REQ_LEN 17  // minimal size for DNS request asking ROOT = DNS_HEADER_SIZE + 1 null byte for Name + 4 bytes type/class
 
-DNSServer::DNSServer() : _port(DNS_DEFAULT_PORT), _ttl(htonl(DNS_DEFAULT_TTL)), _errorReplyCode(DNSReplyCode::NonExistentDomain) {}
+DNSServer::DNSServer() : _port(DNS_DEFAULT_PORT), _ttl(htonl(DNS_DEFAULT_TTL)), _errorReplyCode(DNSReplyCode::NonExistentDomain), _domainLabelsLength(0) {
+  clearAnswerCache();
+}
 
 DNSServer::DNSServer(const String &domainName)
-  : _port(DNS_DEFAULT_PORT), _ttl(htonl(DNS_DEFAULT_TTL)), _errorReplyCode(DNSReplyCode::NonExistentDomain), _domainName(domainName){};
+  : _port(DNS_DEFAULT_PORT), _ttl(htonl(DNS_DEFAULT_TTL)), _errorReplyCode(DNSReplyCode::NonExistentDomain), _domainName(domainName) {
+  encodeDomainName();
+  clearAnswerCache();
+}
 
 bool DNSServer::start() {
   if (_resolvedIP.operator uint32_t() == 0) {  // no address is set, try to obtain AP interface's IP
@@ -31,6 +36,7 @@ bool DNSServer::start() {
 #endif
   }
 
+  clearAnswerCache();
   _udp.close();
   _udp.onPacket([this](AsyncUDPPacket &pkt) {
     this->_handleUDP(pkt);
@@ -46,8 +52,10 @@ bool DNSServer::start(uint16_t port, const String &domainName, const IPAddress &
   } else {
     _domainName.clear();
   }
+  encodeDomainName();
 
   _resolvedIP = resolvedIP;
+  clearAnswerCache();
   _udp.close();
   _udp.onPacket([this](AsyncUDPPacket &pkt) {
     this->_handleUDP(pkt);
@@ -61,6 +69,7 @@ void DNSServer::setErrorReplyCode(const DNSReplyCode &replyCode) {
 
 void DNSServer::setTTL(const uint32_t &ttl) {
   _ttl = htonl(ttl);
+  clearAnswerCache();
 }
 
 void DNSServer::stop() {
@@ -72,6 +81,73 @@ void DNSServer::downcaseAndRemoveWwwPrefix(String &domainName) {
   domainName.replace("www.", "");
 }
 
+void DNSServer::encodeDomainName() {
+  // "example.com" -> "\x07example\x03com\x00", a name that does not fit never matches
+  _domainLabelsLength = 0;
+  if (_domainName.isEmpty()) {
+    return;
+  }
+  const char *name = _domainName.c_str();
+  size_t pos = 0;
+  while (*name) {
+    const char *dot = strchr(name, '.');
+    size_t len = dot ? dot - name : strlen(name);
+    if (len) {
+      if (len > 63 || pos + 1 + len + 1 > sizeof(_domainLabels)) {
+        return;
+      }
+      _domainLabels[pos++] = len;
+      memcpy(_domainLabels + pos, name, len);
+      pos += len;
+    }
+    name += dot ? len + 1 : len;
+  }
+  _domainLabels[pos++] = 0;
+  _domainLabelsLength = pos;
+}
+
+void DNSServer::clearAnswerCache() {
+  for (size_t i = 0; i < DNS_ANSWER_CACHE_SIZE; i++) {
+    _answers[i].questionLength = 0;
+  }
+  _nextAnswer = 0;
+}
+
+bool DNSServer::matchesDomainName(const uint8_t *labels, size_t len) const {
+  if (len > 4 && labels[0] == 3 && tolower(labels[1]) == 'w' && tolower(labels[2]) == 'w' && tolower(labels[3]) == 'w') {
+    labels += 4;
+    len -= 4;
+  }
+  if (len != _domainLabelsLength) {
+    return false;
+  }
+  // length bytes are at most 63, below 'A', so they pass tolower() unchanged
+  for (size_t i = 0; i < len; i++) {
+    if (tolower(labels[i]) != _domainLabels[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DNSServer::replyFromCache(AsyncUDPPacket &req, const uint8_t *question, size_t len) {
+  for (size_t i = 0; i < DNS_ANSWER_CACHE_SIZE; i++) {
+    CachedAnswer &answer = _answers[i];
+    if (answer.questionLength != len || memcmp(answer.reply + DNS_HEADER_SIZE, question, len) != 0) {
+      continue;
+    }
+    // same question, only the ID and the request flags differ
+    DNSHeader dnsHeader;
+    memcpy(&dnsHeader, answer.reply, DNS_HEADER_SIZE);
+    memcpy(&dnsHeader, req.data(), 4);
+    dnsHeader.QR = DNS_QR_RESPONSE;
+    memcpy(answer.reply, &dnsHeader, DNS_HEADER_SIZE);
+    _udp.writeTo(answer.reply, answer.length, req.remoteIP(), req.remotePort());
+    return true;
+  }
+  return false;
+}
+
 void DNSServer::_handleUDP(AsyncUDPPacket &pkt) {
   if (pkt.length() < DNS_MIN_REQ_LEN) {
     return;  // truncated packet or not a DNS req
@@ -91,28 +167,39 @@ void DNSServer::_handleUDP(AsyncUDPPacket &pkt) {
       // Each label contains a byte to describe its length and the label itself. The list of
       // labels terminates with a zero-valued byte. In "github.com", we have two labels "github" & "com"
 */
-    const char *enoflbls = strchr(reinterpret_cast<const char *>(pkt.data()) + DNS_HEADER_SIZE, 0);  // find end_of_label marker
-    ++enoflbls;                                                                                      // advance after null terminator
-    dnsQuestion.QName = pkt.data() + DNS_HEADER_SIZE;                                                // we can reference labels from the request
-    dnsQuestion.QNameLength = enoflbls - (char *)pkt.data() - DNS_HEADER_SIZE;
-    /*
-        check if we aint going out of pkt bounds
-        proper dns req should have label terminator at least 4 bytes before end of packet
-      */
-    if (dnsQuestion.QNameLength > pkt.length() - DNS_HEADER_SIZE - sizeof(dnsQuestion.QType) - sizeof(dnsQuestion.QClass)) {
+    const uint8_t *labels = pkt.data() + DNS_HEADER_SIZE;
+    // proper dns req should have label terminator at least 4 bytes before end of packet
+    size_t end = pkt.length() - DNS_HEADER_SIZE - sizeof(dnsQuestion.QType) - sizeof(dnsQuestion.QClass);
+    if (end > DNS_MAX_NAME_LENGTH) {
+      end = DNS_MAX_NAME_LENGTH;
+    }
+    size_t pos = 0;
+    while (pos < end && labels[pos] != 0) {
+      if (labels[pos] & 0xC0) {
+        return;  // compression pointers are not expected in a question
+      }
+      pos += labels[pos] + 1;
+    }
+    if (pos >= end) {
       return;  // malformed packet
     }
+    dnsQuestion.QName = labels;  // we can reference labels from the request
+    dnsQuestion.QNameLength = pos + 1;
 
     // Copy the QType and QClass
-    memcpy(&dnsQuestion.QType, enoflbls, sizeof(dnsQuestion.QType));
-    memcpy(&dnsQuestion.QClass, enoflbls + sizeof(dnsQuestion.QType), sizeof(dnsQuestion.QClass));
+    memcpy(&dnsQuestion.QType, labels + dnsQuestion.QNameLength, sizeof(dnsQuestion.QType));
+    memcpy(&dnsQuestion.QClass, labels + dnsQuestion.QNameLength + sizeof(dnsQuestion.QType), sizeof(dnsQuestion.QClass));
   }
 
   // will reply with IP only to "*" or if domain matches without www. subdomain
-  if (dnsHeader.OPCode == DNS_OPCODE_QUERY && requestIncludesOnlyOneQuestion(dnsHeader)
-      && (_domainName.isEmpty() || getDomainNameWithoutWwwPrefix(static_cast<const unsigned char *>(dnsQuestion.QName), dnsQuestion.QNameLength) == _domainName)) {
-    replyWithIP(pkt, dnsHeader, dnsQuestion);
-    return;
+  if (dnsHeader.OPCode == DNS_OPCODE_QUERY && requestIncludesOnlyOneQuestion(dnsHeader)) {
+    if (replyFromCache(pkt, dnsQuestion.QName, dnsQuestion.QNameLength + 4)) {
+      return;
+    }
+    if (_domainName.isEmpty() || matchesDomainName(dnsQuestion.QName, dnsQuestion.QNameLength)) {
+      replyWithIP(pkt, dnsHeader, dnsQuestion);
+      return;
+    }
   }
 
   // otherwise reply with custom code
@@ -138,37 +225,50 @@ String DNSServer::getDomainNameWithoutWwwPrefix(const unsigned char *start, size
 }
 
 void DNSServer::replyWithIP(AsyncUDPPacket &req, DNSHeader &dnsHeader, DNSQuestion &dnsQuestion) {
-  AsyncUDPMessage rpl;
+  uint8_t *rpl = _reply;
 
   // Change the type of message to a response and set the number of answers equal to
   // the number of questions in the header
   dnsHeader.QR = DNS_QR_RESPONSE;
   dnsHeader.ANCount = dnsHeader.QDCount;
-  rpl.write((unsigned char *)&dnsHeader, DNS_HEADER_SIZE);
+  memcpy(rpl, &dnsHeader, DNS_HEADER_SIZE);
+  rpl += DNS_HEADER_SIZE;
 
   // Write the question
-  rpl.write(dnsQuestion.QName, dnsQuestion.QNameLength);
-  rpl.write((uint8_t *)&dnsQuestion.QType, 2);
-  rpl.write((uint8_t *)&dnsQuestion.QClass, 2);
+  memcpy(rpl, dnsQuestion.QName, dnsQuestion.QNameLength);
+  rpl += dnsQuestion.QNameLength;
+  memcpy(rpl, &dnsQuestion.QType, 2);
+  memcpy(rpl + 2, &dnsQuestion.QClass, 2);
+  rpl += 4;
 
   // Write the answer
   // Use DNS name compression : instead of repeating the name in this RNAME occurrence,
   // set the two MSB of the byte corresponding normally to the length to 1. The following
   // 14 bits must be used to specify the offset of the domain name in the message
   // (<255 here so the first byte has the 6 LSB at 0)
-  rpl.write((uint8_t)0xC0);
-  rpl.write((uint8_t)DNS_OFFSET_DOMAIN_NAME);
+  *rpl++ = 0xC0;
+  *rpl++ = DNS_OFFSET_DOMAIN_NAME;
 
   // DNS type A : host address, DNS class IN for INternet, returning an IPv4 address
   uint16_t answerType = htons(DNS_TYPE_A), answerClass = htons(DNS_CLASS_IN), answerIPv4 = htons(DNS_RDLENGTH_IPV4);
-  rpl.write((unsigned char *)&answerType, 2);
-  rpl.write((unsigned char *)&answerClass, 2);
-  rpl.write((unsigned char *)&_ttl, 4);  // DNS Time To Live
-  rpl.write((unsigned char *)&answerIPv4, 2);
+  memcpy(rpl, &answerType, 2);
+  memcpy(rpl + 2, &answerClass, 2);
+  memcpy(rpl + 4, &_ttl, 4);  // DNS Time To Live
+  memcpy(rpl + 8, &answerIPv4, 2);
   uint32_t ip = _resolvedIP;
-  rpl.write(reinterpret_cast<uint8_t *>(&ip), sizeof(uint32_t));  // The IPv4 address to return
+  memcpy(rpl + 10, &ip, sizeof(uint32_t));  // The IPv4 address to return
+  rpl += 14;
+
+  size_t length = rpl - _reply;
+  _udp.writeTo(_reply, length, req.remoteIP(), req.remotePort());
 
-  _udp.sendTo(rpl, req.remoteIP(), req.remotePort());
+  if (dnsQuestion.QNameLength <= DNS_ANSWER_CACHE_NAME_LENGTH) {
+    CachedAnswer &answer = _answers[_nextAnswer];
+    _nextAnswer = (_nextAnswer + 1) % DNS_ANSWER_CACHE_SIZE;
+    answer.questionLength = dnsQuestion.QNameLength + 4;
+    answer.length = length;
+    memcpy(answer.reply, _reply, length);
+  }
 
 #ifdef DEBUG_ESP_DNS
   DEBUG_OUTPUT.printf(
@@ -183,7 +283,5 @@ void DNSServer::replyWithCustomCode(AsyncUDPPacket &req, DNSHeader &dnsHeader) {
   dnsHeader.RCode = static_cast<uint16_t>(_errorReplyCode);
   dnsHeader.QDCount = 0;
 
-  AsyncUDPMessage rpl(sizeof(DNSHeader));
-  rpl.write(reinterpret_cast<const uint8_t *>(&dnsHeader), sizeof(DNSHeader));
-  _udp.sendTo(rpl, req.remoteIP(), req.remotePort());
+  _udp.writeTo(reinterpret_cast<const uint8_t *>(&dnsHeader), sizeof(DNSHeader), req.remoteIP(), req.remotePort());
 }
@@ -8,6 +8,16 @@
 #define DNS_HEADER_SIZE        12
 #define DNS_OFFSET_DOMAIN_NAME DNS_HEADER_SIZE  // Offset in bytes to reach the domain name labels in the DNS message
 #define DNS_DEFAULT_PORT       53
+#define DNS_MAX_NAME_LENGTH    255  // Maximum length of a domain name in wire format, labels and length bytes included
+
+// Number of recent positive answers kept ready to send, and the longest
+// question name they are kept for
+#ifndef DNS_ANSWER_CACHE_SIZE
+#define DNS_ANSWER_CACHE_SIZE 4
+#endif
+#ifndef DNS_ANSWER_CACHE_NAME_LENGTH
+#define DNS_ANSWER_CACHE_NAME_LENGTH 64
+#endif
 
 enum class DNSReplyCode : uint16_t {
   NoError = 0,
@@ -165,7 +175,33 @@ private:
   String _domainName;
   IPAddress _resolvedIP;
 
+  // _domainName encoded as DNS labels, queries are compared against it in place
+  uint8_t _domainLabels[DNS_MAX_NAME_LENGTH];
+  size_t _domainLabelsLength;
+
+  // every reply is assembled here, _handleUDP only runs on the async_udp task
+  uint8_t _reply[DNS_HEADER_SIZE + DNS_MAX_NAME_LENGTH + 4 + 16];
+
+  struct CachedAnswer {
+    uint16_t questionLength;  // QName + QType + QClass, 0 if unused
+    uint16_t length;
+    uint8_t reply[DNS_HEADER_SIZE + DNS_ANSWER_CACHE_NAME_LENGTH + 4 + 16];
+  };
+  CachedAnswer _answers[DNS_ANSWER_CACHE_SIZE];
+  uint8_t _nextAnswer;
+
   void downcaseAndRemoveWwwPrefix(String &domainName);
+  void encodeDomainName();
+  void clearAnswerCache();
+
+  /**
+     * @brief compare the question labels against the served domain name,
+     * ignoring case and a leading www label, without copying them
+     * @param labels a pointer to the start of labels records in DNS packet
+     * @param len labels length, including the terminating 0
+     */
+  bool matchesDomainName(const uint8_t *labels, size_t len) const;
+  bool replyFromCache(AsyncUDPPacket &req, const uint8_t *question, size_t len);
 
   /**
      * @brief Get the Domain Name Without Www Prefix object
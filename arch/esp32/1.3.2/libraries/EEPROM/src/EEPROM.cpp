@@ -28,18 +28,73 @@
 #include <esp_partition.h>
 #include <esp_log.h>
 
-EEPROMClass::EEPROMClass(void) : _handle(0), _data(0), _size(0), _dirty(false), _name("eeprom") {}
+#define EEPROM_PAGE_SIZE_KEY "page_size"
+
+static void pageKey(char *key, size_t page) {
+  snprintf(key, NVS_KEY_NAME_MAX_SIZE, "p%u", (unsigned)page);
+}
+
+EEPROMClass::EEPROMClass(void) : _handle(0), _data(0), _size(0), _dirty(false), _name("eeprom"), _dirtyPages(0), _pages(0) {}
 
 EEPROMClass::EEPROMClass(uint32_t sector)
   // Only for compatiility, no sectors in nvs!
-  : _handle(0), _data(0), _size(0), _dirty(false), _name("eeprom") {}
+  : _handle(0), _data(0), _size(0), _dirty(false), _name("eeprom"), _dirtyPages(0), _pages(0) {}
 
-EEPROMClass::EEPROMClass(const char *name) : _handle(0), _data(0), _size(0), _dirty(false), _name(name) {}
+EEPROMClass::EEPROMClass(const char *name) : _handle(0), _data(0), _size(0), _dirty(false), _name(name), _dirtyPages(0), _pages(0) {}
 
 EEPROMClass::~EEPROMClass() {
   end();
 }
 
+// Read up to len bytes of a blob, a longer blob is truncated. stored is set to
+// its length, or 0 if there is no such key.
+bool EEPROMClass::_readBlob(const char *key, uint8_t *data, size_t len, size_t *stored) {
+  *stored = 0;
+  esp_err_t res = nvs_get_blob(_handle, key, NULL, stored);
+  if (res == ESP_ERR_NVS_NOT_FOUND) {
+    *stored = 0;
+    return true;
+  }
+  if (res != ESP_OK) {
+    log_e("Unable to read NVS key %s: %d", key, res);
+    return false;
+  }
+  size_t read_size = *stored;
+  if (read_size <= len) {
+    return nvs_get_blob(_handle, key, data, &read_size) == ESP_OK;
+  }
+  uint8_t *key_data = (uint8_t *)malloc(read_size);
+  if (!key_data) {
+    log_e("Not enough memory to read NVS key %s", key);
+    return false;
+  }
+  res = nvs_get_blob(_handle, key, key_data, &read_size);
+  memcpy(data, key_data, len);
+  free(key_data);
+  return res == ESP_OK;
+}
+
+// Load the pages written with pageSize, a missing, short or long page is
+// marked dirty
+bool EEPROMClass::_loadPages(size_t pageSize) {
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  for (size_t offset = 0, page = 0; offset < _size; offset += pageSize, page++) {
+    size_t len = _size - offset < pageSize ? _size - offset : pageSize;
+    size_t stored;
+    pageKey(key, page);
+    if (!_readBlob(key, _data + offset, len, &stored)) {
+      return false;
+    }
+    if (stored < len) {
+      _markDirty(offset + stored, len - stored);
+    } else if (stored > len) {
+      // the EEPROM shrank, the last page is stored cut to size
+      _markDirty(offset, len);
+    }
+  }
+  return true;
+}
+
 bool EEPROMClass::begin(size_t size) {
   if (!size) {
     return false;
@@ -51,69 +106,68 @@ bool EEPROMClass::begin(size_t size) {
     return false;
   }
 
-  size_t key_size = 0;
-  res = nvs_get_blob(_handle, _name, NULL, &key_size);
-  if (res != ESP_OK && res != ESP_ERR_NVS_NOT_FOUND) {
-    log_e("Unable to read NVS key: %d", res);
+  free(_data);
+  free(_dirtyPages);
+  _size = 0;
+  _pages = (size + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE;
+  _data = (uint8_t *)malloc(size);
+  _dirtyPages = (uint8_t *)calloc((_pages + 7) / 8, 1);
+  if (!_data || !_dirtyPages) {
+    log_e("Not enough memory for %d bytes in EEPROM", size);
+    free(_data);
+    free(_dirtyPages);
+    _data = 0;
+    _dirtyPages = 0;
+    _pages = 0;
     return false;
   }
-  if (size < key_size) {  // truncate
-    log_w("truncating EEPROM from %d to %d", key_size, size);
-    uint8_t *key_data = (uint8_t *)malloc(key_size);
-    if (!key_data) {
-      log_e("Not enough memory to truncate EEPROM!");
-      return false;
-    }
-    nvs_get_blob(_handle, _name, key_data, &key_size);
-    nvs_set_blob(_handle, _name, key_data, size);
-    nvs_commit(_handle);
-    free(key_data);
-  } else if (size > key_size) {  // expand or new
-    size_t expand_size = size - key_size;
-    uint8_t *expand_key = (uint8_t *)malloc(expand_size);
-    if (!expand_key) {
-      log_e("Not enough memory to expand EEPROM!");
-      return false;
-    }
-    // check for adequate free space
-    if (nvs_set_blob(_handle, "expand", expand_key, expand_size)) {
-      log_e("Not enough space to expand EEPROM from %d to %d", key_size, size);
-      free(expand_key);
-      return false;
-    }
-    free(expand_key);
-    nvs_erase_key(_handle, "expand");
-    uint8_t *key_data = (uint8_t *)malloc(size);
-    if (!key_data) {
-      log_e("Not enough memory to expand EEPROM!");
+  memset(_data, 0xFF, size);
+  _size = size;
+  _dirty = false;
+
+  // older versions kept everything in a single blob named after the namespace
+  size_t legacy_size;
+  if (!_readBlob(_name, _data, _size, &legacy_size)) {
+    return false;
+  }
+  uint32_t page_size = 0;
+  nvs_get_u32(_handle, EEPROM_PAGE_SIZE_KEY, &page_size);
+  if (legacy_size) {
+    log_i("Converting EEPROM of %d bytes to %d byte pages", legacy_size, EEPROM_PAGE_SIZE);
+    _markDirty(0, _size);
+  } else if (page_size) {
+    if (!_loadPages(page_size)) {
       return false;
     }
-    memset(key_data, 0xFF, size);
-    if (key_size) {
-      log_i("Expanding EEPROM from %d to %d", key_size, size);
-      // hold data while key is deleted
-      nvs_get_blob(_handle, _name, key_data, &key_size);
-      nvs_erase_key(_handle, _name);
-    } else {
-      log_i("New EEPROM of %d bytes", size);
+    if (page_size != EEPROM_PAGE_SIZE) {
+      _markDirty(0, _size);
     }
-    nvs_commit(_handle);
-    nvs_set_blob(_handle, _name, key_data, size);
-    free(key_data);
-    nvs_commit(_handle);
-  }
-
-  if (_data) {
-    delete[] _data;
+  } else {
+    log_i("New EEPROM of %d bytes", size);
+    _markDirty(0, _size);
   }
 
-  _data = (uint8_t *)malloc(size);
-  if (!_data) {
-    log_e("Not enough memory for %d bytes in EEPROM", size);
+  // write out new, expanded and re-laid out pages now, so that a lack of
+  // space shows up here and not on the first commit()
+  if (!commit()) {
+    log_e("Not enough space for EEPROM of %d bytes", size);
     return false;
   }
-  _size = size;
-  nvs_get_blob(_handle, _name, _data, &_size);
+  if (page_size != EEPROM_PAGE_SIZE) {
+    nvs_set_u32(_handle, EEPROM_PAGE_SIZE_KEY, EEPROM_PAGE_SIZE);
+  }
+  if (legacy_size) {
+    nvs_erase_key(_handle, _name);
+  }
+  // drop the pages past the end when the EEPROM shrinks
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  for (size_t page = _pages;; page++) {
+    pageKey(key, page);
+    if (nvs_erase_key(_handle, key) != ESP_OK) {
+      break;
+    }
+  }
+  nvs_commit(_handle);
   return true;
 }
 
@@ -123,16 +177,27 @@ void EEPROMClass::end() {
   }
 
   commit();
-  if (_data) {
-    delete[] _data;
-  }
+  free(_data);
+  free(_dirtyPages);
   _data = 0;
+  _dirtyPages = 0;
   _size = 0;
+  _pages = 0;
 
   nvs_close(_handle);
   _handle = 0;
 }
 
+void EEPROMClass::_markDirty(size_t address, size_t len) {
+  if (!len) {
+    return;
+  }
+  for (size_t page = address / EEPROM_PAGE_SIZE; page <= (address + len - 1) / EEPROM_PAGE_SIZE && page < _pages; page++) {
+    _dirtyPages[page >> 3] |= 1 << (page & 7);
+  }
+  _dirty = true;
+}
+
 bool EEPROMClass::isDirty() {
   return _dirty;
 }
@@ -160,7 +225,7 @@ void EEPROMClass::write(int address, uint8_t value) {
   uint8_t *pData = &_data[address];
   if (*pData != value) {
     *pData = value;
-    _dirty = true;
+    _markDirty(address, 1);
   }
 }
 
@@ -176,19 +241,32 @@ bool EEPROMClass::commit() {
     return true;
   }
 
-  esp_err_t err = nvs_set_blob(_handle, _name, _data, _size);
-  if (err != ESP_OK) {
-    log_e("error in write: %s", esp_err_to_name(err));
-  } else {
-    _dirty = false;
-    ret = true;
+  // NVS skips a blob that has not changed, so pages marked dirty by
+  // getDataPtr() without being modified cost a compare, not a write
+  ret = true;
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  for (size_t page = 0; page < _pages; page++) {
+    if (!(_dirtyPages[page >> 3] & (1 << (page & 7)))) {
+      continue;
+    }
+    size_t offset = page * EEPROM_PAGE_SIZE;
+    size_t len = _size - offset < EEPROM_PAGE_SIZE ? _size - offset : EEPROM_PAGE_SIZE;
+    pageKey(key, page);
+    esp_err_t err = nvs_set_blob(_handle, key, _data + offset, len);
+    if (err != ESP_OK) {
+      log_e("error in write: %s", esp_err_to_name(err));
+      ret = false;
+      break;
+    }
+    _dirtyPages[page >> 3] &= ~(1 << (page & 7));
   }
+  _dirty = !ret;
 
   return ret;
 }
 
 uint8_t *EEPROMClass::getDataPtr() {
-  _dirty = true;
+  _markDirty(0, _size);
   return &_data[0];
 }
 
@@ -487,7 +565,7 @@ size_t EEPROMClass::writeString(int address, const char *value) {
   }
 
   memcpy(_data + address, (const uint8_t *)value, len + 1);
-  _dirty = true;
+  _markDirty(address, len + 1);
   return strlen(value);
 }
 
@@ -505,7 +583,7 @@ size_t EEPROMClass::writeBytes(int address, const void *value, size_t len) {
   }
 
   memcpy(_data + address, (const void *)value, len);
-  _dirty = true;
+  _markDirty(address, len);
   return len;
 }
 
@@ -515,7 +593,7 @@ template<class T> T EEPROMClass::writeAll(int address, const T &value) {
   }
 
   memcpy(_data + address, (const uint8_t *)&value, sizeof(T));
-  _dirty = true;
+  _markDirty(address, sizeof(T));
 
   return sizeof(value);
 }
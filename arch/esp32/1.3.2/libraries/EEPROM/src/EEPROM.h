@@ -28,6 +28,12 @@
 #ifndef EEPROM_FLASH_PARTITION_NAME
 #define EEPROM_FLASH_PARTITION_NAME "eeprom"
 #endif
+// The emulated EEPROM is stored as one NVS blob per page of this many bytes,
+// so commit() only rewrites the pages that changed. A power loss during
+// commit() can leave some pages updated and others not.
+#ifndef EEPROM_PAGE_SIZE
+#define EEPROM_PAGE_SIZE 128
+#endif
 #include <Arduino.h>
 
 typedef uint32_t nvs_handle;
@@ -65,7 +71,7 @@ public:
     }
 
     memcpy(_data + address, (const uint8_t *)&t, sizeof(T));
-    _dirty = true;
+    _markDirty(address, sizeof(T));
     return t;
   }
 
@@ -113,6 +119,12 @@ protected:
   size_t _size;
   bool _dirty;
   const char *_name;
+  uint8_t *_dirtyPages;  // one bit per EEPROM_PAGE_SIZE bytes of _data
+  size_t _pages;
+
+  void _markDirty(size_t address, size_t len);
+  bool _readBlob(const char *key, uint8_t *data, size_t len, size_t *stored);
+  bool _loadPages(size_t pageSize);
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EEPROM)
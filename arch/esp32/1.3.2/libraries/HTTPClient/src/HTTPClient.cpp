@@ -34,6 +34,7 @@
 
 /// Cookie jar support
 #include <time.h>
+#include <mutex>
 
 #ifdef HTTPCLIENT_1_1_COMPATIBLE
 class TransportTraits {
@@ -47,6 +48,8 @@ public:
   virtual bool verify(NetworkClient &client, const char *host) {
     return true;
   }
+
+  virtual void key(HTTPConnectionKey &key) {}
 };
 
 #ifndef HTTPCLIENT_NOSECURE
@@ -70,14 +73,115 @@ public:
     return true;
   }
 
+  void key(HTTPConnectionKey &key) override {
+    key.secure = true;
+    key.cacert = _cacert;
+    key.clicert = _clicert;
+    key.clikey = _clikey;
+  }
+
 protected:
   const char *_cacert;
   const char *_clicert;
   const char *_clikey;
 };
 #endif  // HTTPCLIENT_NOSECURE
+
+// Idle keep-alive connections, parked by one HTTPClient and picked up by the
+// next request to the same server. The oldest one is closed when the pool is
+// full, any one idle for longer than the timeout on the next pool access.
+class HTTPConnectionPool {
+public:
+  std::unique_ptr<NetworkClient> acquire(const HTTPConnectionKey &key) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    expire();
+    for (size_t i = 0; i < _idle.size(); i++) {
+      if (!(_idle[i].key == key)) {
+        continue;
+      }
+      std::unique_ptr<NetworkClient> client = std::move(_idle[i].client);
+      _idle.erase(_idle.begin() + i);
+      if (client->connected()) {
+        return client;
+      }
+      client->stop();  // closed by the server while idle
+      i--;
+    }
+    return nullptr;
+  }
+
+  void release(const HTTPConnectionKey &key, std::unique_ptr<NetworkClient> client) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    expire();
+    if (!_maxConnections) {
+      client->stop();
+      return;
+    }
+    if (_idle.size() >= _maxConnections) {
+      _idle.front().client->stop();
+      _idle.erase(_idle.begin());
+    }
+    _idle.push_back({key, std::move(client), millis()});
+  }
+
+  void configure(uint8_t maxConnections, uint32_t idleTimeout) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _maxConnections = maxConnections;
+    _idleTimeout = idleTimeout;
+    while (_idle.size() > _maxConnections) {
+      _idle.front().client->stop();
+      _idle.erase(_idle.begin());
+    }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (Entry &entry : _idle) {
+      entry.client->stop();
+    }
+    _idle.clear();
+  }
+
+private:
+  struct Entry {
+    HTTPConnectionKey key;
+    std::unique_ptr<NetworkClient> client;
+    unsigned long idleSince;
+  };
+
+  // entries are kept oldest first
+  void expire() {
+    unsigned long now = millis();
+    while (!_idle.empty() && (now - _idle.front().idleSince) > _idleTimeout) {
+      log_d("closing idle connection to %s:%u", _idle.front().key.host.c_str(), _idle.front().key.port);
+      _idle.front().client->stop();
+      _idle.erase(_idle.begin());
+    }
+  }
+
+  std::vector<Entry> _idle;
+  uint8_t _maxConnections = HTTPCLIENT_POOL_SIZE;
+  uint32_t _idleTimeout = HTTPCLIENT_POOL_IDLE_TIMEOUT;
+  std::mutex _mtx;
+};
+
+static HTTPConnectionPool connectionPool;
 #endif  // HTTPCLIENT_1_1_COMPATIBLE
 
+// strips leading and trailing whitespace of a line in place, like String::trim()
+static char *trimLine(char *line, size_t &length) {
+  char *end = line + length;
+  while (line < end && isspace((uint8_t)*line)) {
+    line++;
+  }
+  while (end > line && isspace((uint8_t)end[-1])) {
+    end--;
+  }
+  *end = '\0';
+  length = end - line;
+  return line;
+}
+
 /**
  * constructor
  */
@@ -87,6 +191,9 @@ HTTPClient::HTTPClient() {}
  * destructor
  */
 HTTPClient::~HTTPClient() {
+#ifdef HTTPCLIENT_1_1_COMPATIBLE
+  releaseConnection();
+#endif
   if (_client) {
     _client->stop();
   }
@@ -283,7 +390,8 @@ bool HTTPClient::beginInternal(String url, const char *expectedProtocol) {
   } else {
     the_host = host;
   }
-  if (_host != the_host && connected()) {
+  // a connection owned by this instance is parked in the pool by connect() instead
+  if (_host != the_host && connected() && !_tcpDeprecated) {
     log_d("switching host from '%s' to '%s'. disconnecting first", _host.c_str(), the_host.c_str());
     _canReuse = false;
     disconnect(true);
@@ -885,19 +993,18 @@ int HTTPClient::writeToStream(Stream *stream) {
   } else if (_transferEncoding == HTTPC_TE_CHUNKED) {
     int size = 0;
     while (1) {
-      if (!connected()) {
+      if (!connected() && _rxPos == _rxFill) {
         return returnError(HTTPC_ERROR_CONNECTION_LOST);
       }
-      String chunkHeader = _client->readStringUntil('\n');
-
-      if (chunkHeader.length() <= 0) {
+      // chunk size, possibly followed by extensions that are not needed here
+      char *chunkHeader;
+      size_t headerLength;
+      if (!readResponseLine(chunkHeader, headerLength, HTTP_CHUNK_HEADER_SIZE) || headerLength == 0) {
         return returnError(HTTPC_ERROR_READ_TIMEOUT);
       }
 
-      chunkHeader.trim();  // remove \r
-
       // read size of chunk
-      len = (uint32_t)strtol((const char *)chunkHeader.c_str(), NULL, 16);
+      len = (uint32_t)strtol(chunkHeader, NULL, 16);
       size += len;
       log_v(" read chunk len: %d", len);
 
@@ -924,9 +1031,7 @@ int HTTPClient::writeToStream(Stream *stream) {
       }
 
       // read trailing \r\n at the end of the chunk
-      char buf[2];
-      auto trailing_seq_len = _client->readBytes((uint8_t *)buf, 2);
-      if (trailing_seq_len != 2 || buf[0] != '\r' || buf[1] != '\n') {
+      if (!readResponseLine(chunkHeader, headerLength, HTTP_CHUNK_HEADER_SIZE) || headerLength != 0) {
         return returnError(HTTPC_ERROR_READ_TIMEOUT);
       }
 
@@ -1067,6 +1172,17 @@ bool HTTPClient::hasHeader(const char *name) {
  * @return true if connection is ok
  */
 bool HTTPClient::connect(void) {
+#ifdef HTTPCLIENT_1_1_COMPATIBLE
+  HTTPConnectionKey key;
+  if (_transportTraits) {
+    key = connectionKey();
+    if (_tcpDeprecated && !(key == _connectionKey)) {
+      // connected to another server (or with other TLS settings) before
+      releaseConnection();
+    }
+  }
+#endif
+
   if (connected()) {
     if (_reuse) {
       log_d("already connected, reusing connection");
@@ -1081,6 +1197,17 @@ bool HTTPClient::connect(void) {
 
 #ifdef HTTPCLIENT_1_1_COMPATIBLE
   if (_transportTraits && !_client) {
+    _tcpDeprecated = connectionPool.acquire(key);
+    if (_tcpDeprecated) {
+      _client = _tcpDeprecated.get();
+      _connectionKey = key;
+      while (_client->available() > 0) {
+        _client->read();
+      }
+      _client->setTimeout(_tcpTimeout);
+      log_d("reusing pooled connection to %s:%u", _host.c_str(), _port);
+      return true;
+    }
     _tcpDeprecated = _transportTraits->create();
     if (!_tcpDeprecated) {
       log_e("failed to create client");
@@ -1100,6 +1227,9 @@ bool HTTPClient::connect(void) {
     _client->stop();
     return false;
   }
+  if (_tcpDeprecated) {
+    _connectionKey = key;
+  }
 #endif
   if (!_client->connect(_host.c_str(), _port, _connectTimeout)) {
     log_d("failed connect to %s:%u", _host.c_str(), _port);
@@ -1119,6 +1249,54 @@ bool HTTPClient::connect(void) {
   return connected();
 }
 
+#ifdef HTTPCLIENT_1_1_COMPATIBLE
+/**
+ * key of the server the current request goes to
+ * @return HTTPConnectionKey
+ */
+HTTPConnectionKey HTTPClient::connectionKey() {
+  HTTPConnectionKey key;
+  key.host = _host;
+  key.port = _port;
+  _transportTraits->key(key);
+  return key;
+}
+
+/**
+ * give up the connection owned by this instance, it is parked in the
+ * connection pool if it can carry another request and closed otherwise
+ */
+void HTTPClient::releaseConnection() {
+  if (!_tcpDeprecated) {
+    return;
+  }
+  if (_reuse && _canReuse && _tcpDeprecated->connected()) {
+    log_d("parking connection to %s:%u", _connectionKey.host.c_str(), _connectionKey.port);
+    connectionPool.release(_connectionKey, std::move(_tcpDeprecated));
+  } else {
+    _tcpDeprecated->stop();
+    _tcpDeprecated.reset(nullptr);
+  }
+  _client = nullptr;
+}
+
+/**
+ * configure the connection pool shared by all HTTPClient instances
+ * @param maxConnections uint8_t idle connections kept, 0 disables the pool
+ * @param idleTimeout uint32_t ms after which an idle connection is closed
+ */
+void HTTPClient::setConnectionPool(uint8_t maxConnections, uint32_t idleTimeout) {
+  connectionPool.configure(maxConnections, idleTimeout);
+}
+
+/**
+ * close all idle connections of the pool
+ */
+void HTTPClient::clearConnectionPool() {
+  connectionPool.clear();
+}
+#endif  // HTTPCLIENT_1_1_COMPATIBLE
+
 /**
  * sends HTTP request header
  * @param type (GET, POST, ...)
@@ -1190,56 +1368,70 @@ int HTTPClient::handleHeaderResponse() {
   bool firstLine = true;
   String date;
 
+  if (!allocRxBuffer()) {
+    return HTTPC_ERROR_TOO_LESS_RAM;
+  }
+  // header lines are read with Stream::readLine(), which never reads past
+  // the header, so the body is still in _client for getStream() users
+  static_assert(HTTP_MAX_HEADER_LINE <= HTTP_TCP_RX_BUFFER_SIZE, "header lines are read into the response buffer");
+  char *lineBuf = (char *)_rxBuffer.get();
+  _rxPos = 0;
+  _rxFill = 0;
+
   while (connected()) {
     size_t len = _client->available();
     if (len > 0) {
-      String headerLine = _client->readStringUntil('\n');
-      headerLine.trim();  // remove \r
+      bool truncated;
+      size_t lineLength = _client->readLine(lineBuf, HTTP_MAX_HEADER_LINE, '\n', &truncated);
+      char *headerLine = trimLine(lineBuf, lineLength);  // remove \r
 
       lastDataTime = millis();
 
-      log_v("RX: '%s'", headerLine.c_str());
+      log_v("RX: '%s'", headerLine);
 
       if (firstLine) {
         firstLine = false;
-        if (_canReuse && headerLine.startsWith("HTTP/1.")) {
+        if (_canReuse && strncmp(headerLine, "HTTP/1.", sizeof "HTTP/1." - 1) == 0) {
           _canReuse = (headerLine[sizeof "HTTP/1." - 1] != '0');
         }
-        int codePos = headerLine.indexOf(' ') + 1;
-        _returnCode = headerLine.substring(codePos, headerLine.indexOf(' ', codePos)).toInt();
-      } else if (headerLine.indexOf(':')) {
-        String headerName = headerLine.substring(0, headerLine.indexOf(':'));
-        String headerValue = headerLine.substring(headerLine.indexOf(':') + 1);
-        headerValue.trim();
-
-        if (headerName.equalsIgnoreCase("Date")) {
+        const char *codePos = strchr(headerLine, ' ');
+        _returnCode = codePos ? atoi(codePos + 1) : 0;
+      } else if (truncated) {
+        log_w("header longer than %d chars skipped", HTTP_MAX_HEADER_LINE - 1);
+      } else if (char *headerDiv = strchr(headerLine, ':')) {
+        *headerDiv = '\0';
+        const char *headerName = headerLine;
+        size_t valueLength = lineLength - (headerDiv + 1 - headerLine);
+        const char *headerValue = trimLine(headerDiv + 1, valueLength);
+
+        if (strcasecmp(headerName, "Date") == 0) {
           date = headerValue;
         }
 
-        if (headerName.equalsIgnoreCase("Content-Length")) {
-          _size = headerValue.toInt();
+        if (strcasecmp(headerName, "Content-Length") == 0) {
+          _size = atoi(headerValue);
         }
 
-        if (_canReuse && headerName.equalsIgnoreCase("Connection")) {
-          if (headerValue.indexOf("close") >= 0 && headerValue.indexOf("keep-alive") < 0) {
+        if (_canReuse && strcasecmp(headerName, "Connection") == 0) {
+          if (strstr(headerValue, "close") && !strstr(headerValue, "keep-alive")) {
             _canReuse = false;
           }
         }
 
-        if (headerName.equalsIgnoreCase("Transfer-Encoding")) {
+        if (strcasecmp(headerName, "Transfer-Encoding") == 0) {
           transferEncoding = headerValue;
         }
 
-        if (headerName.equalsIgnoreCase("Location")) {
+        if (strcasecmp(headerName, "Location") == 0) {
           _location = headerValue;
         }
 
-        if (headerName.equalsIgnoreCase("Set-Cookie")) {
+        if (strcasecmp(headerName, "Set-Cookie") == 0) {
           setCookie(date, headerValue);
         }
 
         for (size_t i = 0; i < _headerKeysCount; i++) {
-          if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
+          if (strcasecmp(_currentHeaders[i].key.c_str(), headerName) == 0) {
             // Uncomment the following lines if you need to add support for multiple headers with the same key:
             // if (!_currentHeaders[i].value.isEmpty()) {
             //     // Existing value, append this one with a comma
@@ -1253,7 +1445,7 @@ int HTTPClient::handleHeaderResponse() {
         }
       }
 
-      if (headerLine == "") {
+      if (lineLength == 0) {
         log_d("code: %d", _returnCode);
 
         if (_size > 0) {
@@ -1292,120 +1484,200 @@ int HTTPClient::handleHeaderResponse() {
   return HTTPC_ERROR_CONNECTION_LOST;
 }
 
+/**
+ * allocate the response buffer, it is kept for the lifetime of the instance
+ * @return true if the buffer is available
+ */
+bool HTTPClient::allocRxBuffer() {
+  if (!_rxBuffer) {
+    _rxBuffer.reset(new (std::nothrow) uint8_t[HTTP_TCP_RX_BUFFER_SIZE]);
+    if (!_rxBuffer) {
+      log_w("too less ram! need %d", HTTP_TCP_RX_BUFFER_SIZE);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * move the unread part of the response buffer to its start and append
+ * what the server sends, waiting up to the tcp timeout
+ * @return number of bytes added
+ */
+size_t HTTPClient::fillRxBuffer() {
+  uint8_t *buff = _rxBuffer.get();
+  if (_rxPos) {
+    memmove(buff, buff + _rxPos, _rxFill - _rxPos);
+    _rxFill -= _rxPos;
+    _rxPos = 0;
+  }
+  unsigned long start = millis();
+  while (_rxFill < HTTP_TCP_RX_BUFFER_SIZE) {
+    int sizeAvailable = _client->available();
+    if (sizeAvailable > 0) {
+      int bytesRead = _client->read(buff + _rxFill, std::min((size_t)sizeAvailable, HTTP_TCP_RX_BUFFER_SIZE - _rxFill));
+      if (bytesRead > 0) {
+        _rxFill += bytesRead;
+        return bytesRead;
+      }
+    }
+    if (!connected() || (millis() - start) > _tcpTimeout) {
+      break;
+    }
+    delay(1);
+  }
+  return 0;
+}
+
+/**
+ * read one line of the body framing (chunk size or chunk end) in place from
+ * the response buffer, the line is null terminated and without "\r\n"
+ * @param line char *& set to the start of the line
+ * @param length size_t & set to the length of the line
+ * @param maxLength size_t lines of this length or longer are refused
+ * @return false on timeout or if the line is too long
+ */
+bool HTTPClient::readResponseLine(char *&line, size_t &length, size_t maxLength) {
+  if (!allocRxBuffer()) {
+    return false;
+  }
+  while (1) {
+    char *start = (char *)_rxBuffer.get() + _rxPos;
+    size_t pending = std::min(_rxFill - _rxPos, maxLength);
+    char *end = (char *)memchr(start, '\n', pending);
+    if (end) {
+      _rxPos += end - start + 1;
+      length = end - start;
+      if (length && start[length - 1] == '\r') {
+        length--;
+      }
+      start[length] = '\0';
+      line = start;
+      return true;
+    }
+    if (pending == maxLength) {
+      log_w("line longer than %d chars", maxLength - 1);
+      return false;
+    }
+    if (!fillRxBuffer()) {
+      return false;
+    }
+  }
+}
+
 /**
  * write one Data Block to Stream
+ * data left in the response buffer by readResponseLine() is written first,
+ * the rest is read through the same buffer, never past the end of the block
  * @param stream Stream *
  * @param size int
  * @return < 0 = error >= 0 = size written
  */
 int HTTPClient::writeToStreamDataBlock(Stream *stream, int size) {
-  int buff_size = HTTP_TCP_RX_BUFFER_SIZE;
   int len = size;
   int bytesWritten = 0;
 
-  // if possible create smaller buffer then HTTP_TCP_RX_BUFFER_SIZE
-  if ((len > 0) && (len < buff_size)) {
-    buff_size = len;
+  if (!allocRxBuffer()) {
+    return HTTPC_ERROR_TOO_LESS_RAM;
   }
+  uint8_t *buff = _rxBuffer.get();
 
-  // create buffer for read
-  uint8_t *buff = (uint8_t *)malloc(buff_size);
+  // read all data from server
+  while (len > 0 || len == -1) {
 
-  if (buff) {
-    // read all data from server
-    while (connected() && (len > 0 || len == -1)) {
+    if (_rxPos == _rxFill) {
+      if (!connected()) {
+        break;
+      }
+      _rxPos = 0;
+      _rxFill = 0;
 
       // get available data size
-      size_t sizeAvailable = buff_size;
+      size_t sizeAvailable = HTTP_TCP_RX_BUFFER_SIZE;
       if (len < 0) {
         sizeAvailable = _client->available();
       }
 
-      if (sizeAvailable) {
-
-        int readBytes = sizeAvailable;
-
-        // read only the asked bytes
-        if (len > 0 && readBytes > len) {
-          readBytes = len;
-        }
-
-        // not read more the buffer can handle
-        if (readBytes > buff_size) {
-          readBytes = buff_size;
-        }
-
-        // stop if no more reading
-        if (readBytes == 0) {
-          break;
-        }
+      // read only the asked bytes
+      if (len > 0 && sizeAvailable > (size_t)len) {
+        sizeAvailable = len;
+      }
 
-        // read data
-        int bytesRead = _client->readBytes(buff, readBytes);
+      // not read more the buffer can handle
+      if (sizeAvailable > HTTP_TCP_RX_BUFFER_SIZE) {
+        sizeAvailable = HTTP_TCP_RX_BUFFER_SIZE;
+      }
 
-        // write it to Stream
-        int bytesWrite = stream->write(buff, bytesRead);
-        bytesWritten += bytesWrite;
+      if (!sizeAvailable) {
+        delay(1);
+        continue;
+      }
 
-        // are all Bytes a written to stream ?
-        if (bytesWrite != bytesRead) {
-          log_d("short write asked for %d but got %d retry...", bytesRead, bytesWrite);
+      // read data
+      _rxFill = _client->readBytes(buff, sizeAvailable);
+      if (!_rxFill) {
+        continue;
+      }
+    }
 
-          // check for write error
-          if (stream->getWriteError()) {
-            log_d("stream write error %d", stream->getWriteError());
+    int bytesRead = _rxFill - _rxPos;
+    if (len > 0 && bytesRead > len) {
+      bytesRead = len;
+    }
+    uint8_t *data = buff + _rxPos;
+    _rxPos += bytesRead;
 
-            //reset write error for retry
-            stream->clearWriteError();
-          }
+    // write it to Stream
+    int bytesWrite = stream->write(data, bytesRead);
+    bytesWritten += bytesWrite;
 
-          // some time for the stream
-          delay(1);
+    // are all Bytes a written to stream ?
+    if (bytesWrite != bytesRead) {
+      log_d("short write asked for %d but got %d retry...", bytesRead, bytesWrite);
 
-          int leftBytes = (bytesRead - bytesWrite);
+      // check for write error
+      if (stream->getWriteError()) {
+        log_d("stream write error %d", stream->getWriteError());
 
-          // retry to send the missed bytes
-          bytesWrite = stream->write((buff + bytesWrite), leftBytes);
-          bytesWritten += bytesWrite;
+        //reset write error for retry
+        stream->clearWriteError();
+      }
 
-          if (bytesWrite != leftBytes) {
-            // failed again
-            log_w("short write asked for %d but got %d failed.", leftBytes, bytesWrite);
-            free(buff);
-            return HTTPC_ERROR_STREAM_WRITE;
-          }
-        }
+      // some time for the stream
+      delay(1);
 
-        // check for write error
-        if (stream->getWriteError()) {
-          log_w("stream write error %d", stream->getWriteError());
-          free(buff);
-          return HTTPC_ERROR_STREAM_WRITE;
-        }
+      int leftBytes = (bytesRead - bytesWrite);
 
-        // count bytes to read left
-        if (len > 0) {
-          len -= bytesRead;
-        }
+      // retry to send the missed bytes
+      bytesWrite = stream->write((data + bytesWrite), leftBytes);
+      bytesWritten += bytesWrite;
 
-        delay(0);
-      } else {
-        delay(1);
+      if (bytesWrite != leftBytes) {
+        // failed again
+        log_w("short write asked for %d but got %d failed.", leftBytes, bytesWrite);
+        return HTTPC_ERROR_STREAM_WRITE;
       }
     }
 
-    free(buff);
-
-    log_v("connection closed or file end (written: %d).", bytesWritten);
-
-    if ((size > 0) && (size != bytesWritten)) {
-      log_d("bytesWritten %d and size %d mismatch!.", bytesWritten, size);
+    // check for write error
+    if (stream->getWriteError()) {
+      log_w("stream write error %d", stream->getWriteError());
       return HTTPC_ERROR_STREAM_WRITE;
     }
 
-  } else {
-    log_w("too less ram! need %d", buff_size);
-    return HTTPC_ERROR_TOO_LESS_RAM;
+    // count bytes to read left
+    if (len > 0) {
+      len -= bytesRead;
+    }
+
+    delay(0);
+  }
+
+  log_v("connection closed or file end (written: %d).", bytesWritten);
+
+  if ((size > 0) && (size != bytesWritten)) {
+    log_d("bytesWritten %d and size %d mismatch!.", bytesWritten, size);
+    return HTTPC_ERROR_STREAM_WRITE;
   }
 
   return bytesWritten;
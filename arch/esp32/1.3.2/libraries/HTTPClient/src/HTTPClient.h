@@ -43,6 +43,15 @@
 
 #define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
 
+/// idle keep-alive connections kept for later requests of any HTTPClient (0 disables the pool)
+#ifndef HTTPCLIENT_POOL_SIZE
+#define HTTPCLIENT_POOL_SIZE (3)
+#endif
+/// ms an idle pooled connection is kept before it is closed
+#ifndef HTTPCLIENT_POOL_IDLE_TIMEOUT
+#define HTTPCLIENT_POOL_IDLE_TIMEOUT (15000)
+#endif
+
 /// HTTP client errors
 #define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
 #define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
@@ -60,6 +69,15 @@
 #define HTTP_TCP_RX_BUFFER_SIZE (4096)
 #define HTTP_TCP_TX_BUFFER_SIZE (1460)
 
+/// longest response header line kept, longer ones are skipped (at most HTTP_TCP_RX_BUFFER_SIZE)
+#ifndef HTTP_MAX_HEADER_LINE
+#define HTTP_MAX_HEADER_LINE HTTP_TCP_RX_BUFFER_SIZE
+#endif
+/// longest chunk size line of a chunked body, chunk extensions included
+#ifndef HTTP_CHUNK_HEADER_SIZE
+#define HTTP_CHUNK_HEADER_SIZE (32)
+#endif
+
 /// HTTP codes see RFC7231
 typedef enum {
   HTTP_CODE_CONTINUE = 100,
@@ -147,6 +165,21 @@ typedef enum {
 #ifdef HTTPCLIENT_1_1_COMPATIBLE
 class TransportTraits;
 typedef std::unique_ptr<TransportTraits> TransportTraitsPtr;
+
+/// what a connection was opened for, a pooled connection is only reused for the same key
+struct HTTPConnectionKey {
+  String host;
+  uint16_t port = 0;
+  bool secure = false;
+  const char *cacert = nullptr;  // TLS settings, compared by pointer
+  const char *clicert = nullptr;
+  const char *clikey = nullptr;
+
+  bool operator==(const HTTPConnectionKey &other) const {
+    return port == other.port && secure == other.secure && cacert == other.cacert && clicert == other.clicert && clikey == other.clikey
+           && host.equalsIgnoreCase(other.host);
+  }
+};
 #endif
 
 // cookie jar support
@@ -255,6 +288,14 @@ public:
 
   static String errorToString(int error);
 
+#ifdef HTTPCLIENT_1_1_COMPATIBLE
+  /// Connection pool, shared by all instances that were started with begin(url) or begin(host, port, ...).
+  /// Their keep-alive connections are parked there when the instance is destroyed or moves to another
+  /// server, and handed out again to the next request for the same host, port and TLS settings.
+  static void setConnectionPool(uint8_t maxConnections, uint32_t idleTimeout = HTTPCLIENT_POOL_IDLE_TIMEOUT);
+  static void clearConnectionPool();
+#endif
+
   /// Cookie jar support
   void setCookieJar(CookieJar *cookieJar);
   void resetCookieJar();
@@ -274,6 +315,13 @@ protected:
   bool sendHeader(const char *type);
   int handleHeaderResponse();
   int writeToStreamDataBlock(Stream *stream, int len);
+  bool allocRxBuffer();
+  size_t fillRxBuffer();
+  bool readResponseLine(char *&line, size_t &length, size_t maxLength);
+#ifdef HTTPCLIENT_1_1_COMPATIBLE
+  HTTPConnectionKey connectionKey();
+  void releaseConnection();
+#endif
 
   /// Cookie jar support
   void setCookie(String date, String headerValue);
@@ -282,6 +330,7 @@ protected:
 #ifdef HTTPCLIENT_1_1_COMPATIBLE
   TransportTraitsPtr _transportTraits;
   std::unique_ptr<NetworkClient> _tcpDeprecated;
+  HTTPConnectionKey _connectionKey;  // of the connection in _tcpDeprecated
 #endif
 
   NetworkClient *_client = nullptr;
@@ -304,6 +353,9 @@ protected:
   String _acceptEncoding = "identity;q=1,chunked;q=0.1,*;q=0";
 
   /// Response handling
+  std::unique_ptr<uint8_t[]> _rxBuffer;  // header lines, chunk framing and body data
+  size_t _rxPos = 0;                     // next unread byte in _rxBuffer
+  size_t _rxFill = 0;                    // end of the data in _rxBuffer
   RequestArgument *_currentHeaders = nullptr;
   size_t _headerKeysCount = 0;
 
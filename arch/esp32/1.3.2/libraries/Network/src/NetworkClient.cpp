@@ -101,6 +101,20 @@ public:
   }
 
   int read(uint8_t *dst, size_t len) {
+    if (dst && len >= _size && _pos == _fill && _fd >= 0) {
+      // nothing buffered and a read at least as large as the buffer:
+      // receive straight into dst instead of copying through _buffer
+      _pos = _fill = 0;
+      int res = recv(_fd, dst, len, MSG_DONTWAIT);
+      if (res < 0) {
+        if (errno != EWOULDBLOCK) {
+          _failed = true;
+          return -1;
+        }
+        return 0;
+      }
+      return res;
+    }
     if (!dst || !len || (_pos == _fill && !fillBuffer())) {
       return _failed ? -1 : 0;
     }
@@ -146,6 +160,21 @@ public:
     return _fill - _pos + r_available();
   }
 
+  size_t peekAvailable() {
+    if (_pos == _fill && !fillBuffer()) {
+      return 0;
+    }
+    return _fill - _pos;
+  }
+
+  const char *peekBuffer() {
+    return (const char *)_buffer + _pos;
+  }
+
+  void peekConsume(size_t consume) {
+    _pos += (consume < _fill - _pos) ? consume : _fill - _pos;
+  }
+
   void clear() {
     if (r_available()) {
       _pos = _fill;
@@ -541,6 +570,32 @@ int NetworkClient::available() {
   return res;
 }
 
+size_t NetworkClient::peekAvailable() {
+  if (fd() < 0 || !_rxBuffer) {
+    return 0;
+  }
+  size_t res = _rxBuffer->peekAvailable();
+  if (_rxBuffer->failed()) {
+    log_e("fail on fd %d, errno: %d, \"%s\"", fd(), errno, strerror(errno));
+    stop();
+    return 0;
+  }
+  return res;
+}
+
+const char *NetworkClient::peekBuffer() {
+  if (!_rxBuffer) {
+    return nullptr;
+  }
+  return _rxBuffer->peekBuffer();
+}
+
+void NetworkClient::peekConsume(size_t consume) {
+  if (_rxBuffer) {
+    _rxBuffer->peekConsume(consume);
+  }
+}
+
 void NetworkClient::clear() {
   if (_rxBuffer != nullptr) {
     _rxBuffer->clear();
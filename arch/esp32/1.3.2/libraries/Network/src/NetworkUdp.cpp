@@ -149,7 +149,7 @@ void NetworkUDP::stop() {
   }
   tx_buffer_len = 0;
   if (rx_buffer) {
-    cbuf *b = rx_buffer;
+    cbuf_spsc *b = rx_buffer;
     rx_buffer = NULL;
     delete b;
   }
@@ -349,8 +349,10 @@ int NetworkUDP::parsePacket() {
   }
 #endif  // LWIP_IPV6=1
   if (len > 0) {
-    rx_buffer = new (std::nothrow) cbuf(len);
-    rx_buffer->write(buf, len);
+    rx_buffer = new (std::nothrow) cbuf_spsc(len);
+    if (rx_buffer) {
+      rx_buffer->write(buf, len);
+    }
   }
   free(buf);
   return len;
@@ -369,7 +371,7 @@ int NetworkUDP::read() {
   }
   int out = rx_buffer->read();
   if (!rx_buffer->available()) {
-    cbuf *b = rx_buffer;
+    cbuf_spsc *b = rx_buffer;
     rx_buffer = 0;
     delete b;
   }
@@ -386,7 +388,7 @@ int NetworkUDP::read(char *buffer, size_t len) {
   }
   int out = rx_buffer->read(buffer, len);
   if (!rx_buffer->available()) {
-    cbuf *b = rx_buffer;
+    cbuf_spsc *b = rx_buffer;
     rx_buffer = 0;
     delete b;
   }
@@ -404,7 +406,7 @@ void NetworkUDP::clear() {
   if (!rx_buffer) {
     return;
   }
-  cbuf *b = rx_buffer;
+  cbuf_spsc *b = rx_buffer;
   rx_buffer = 0;
   delete b;
 }
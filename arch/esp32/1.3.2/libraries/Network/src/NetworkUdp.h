@@ -48,7 +48,7 @@ private:
   uint16_t remote_port;
   char *tx_buffer;
   size_t tx_buffer_len;
-  cbuf *rx_buffer;
+  cbuf_spsc *rx_buffer;  // filled and drained by the task that calls parsePacket()
 
 public:
   NetworkUDP();
@@ -58,6 +58,18 @@ public:
   int connect(const char *host, uint16_t port, const char *pskIdent, const char *psKey);
   int connect(IPAddress ip, uint16_t port, const char *host, const char *CA_cert, const char *cert, const char *private_key);
   int peek();
+  // the socket buffer of NetworkClient holds the encrypted stream, which must
+  // not leak through the peek buffer API inherited from it
+  bool hasPeekBufferAPI() const override {
+    return false;
+  }
+  size_t peekAvailable() override {
+    return 0;
+  }
+  const char *peekBuffer() override {
+    return nullptr;
+  }
+  void peekConsume(size_t) override {}
   size_t write(uint8_t data);
   size_t write(const uint8_t *buf, size_t size);
   int available();
@@ -21,10 +21,12 @@ const char *nvs_errors[] = {"OTHER",          "NOT_INITIALIZED", "NOT_FOUND",
                             "INVALID_HANDLE", "REMOVE_FAILED",   "KEY_TOO_LONG", "PAGE_FULL",     "INVALID_STATE", "INVALID_LENGTH"};
 #define nvs_error(e) (((e) > ESP_ERR_NVS_BASE) ? nvs_errors[(e) & ~(ESP_ERR_NVS_BASE)] : nvs_errors[0])
 
-Preferences::Preferences() : _handle(0), _started(false), _readOnly(false) {}
+Preferences::Preferences()
+  : _handle(0), _started(false), _readOnly(false), _batchDepth(0), _batchPending(false), _cache(NULL), _cacheClock(0), _cacheHits(0), _cacheMisses(0) {}
 
 Preferences::~Preferences() {
   end();
+  free(_cache);
 }
 
 bool Preferences::begin(const char *name, bool readOnly, const char *partition_label) {
@@ -55,10 +57,165 @@ void Preferences::end() {
   if (!_started) {
     return;
   }
+  if (_batchDepth) {
+    _batchDepth = 1;
+    commitBatch();
+  }
   nvs_close(_handle);
+  _cacheClear();
   _started = false;
 }
 
+/*
+ * Defer nvs_commit() of the following put, remove and clear calls until
+ * the matching commitBatch(). Batches may be nested, only the outermost
+ * commitBatch() commits.
+ * */
+
+bool Preferences::beginBatch() {
+  if (!_started || _readOnly) {
+    return false;
+  }
+  _batchDepth++;
+  return true;
+}
+
+bool Preferences::commitBatch() {
+  if (!_started || !_batchDepth) {
+    return false;
+  }
+  if (--_batchDepth || !_batchPending) {
+    return true;
+  }
+  _batchPending = false;
+  esp_err_t err = nvs_commit(_handle);
+  if (err) {
+    log_e("nvs_commit fail: %s", nvs_error(err));
+    return false;
+  }
+  return true;
+}
+
+esp_err_t Preferences::_commit() {
+  if (_batchDepth) {
+    _batchPending = true;
+    return ESP_OK;
+  }
+  return nvs_commit(_handle);
+}
+
+/*
+ * Read-through cache of recently read values. Entries are keyed by name and
+ * type, and remember missing keys too. put, remove and clear on this object
+ * invalidate them; writes through another Preferences object are not seen.
+ * */
+
+bool Preferences::enableCache(bool enable) {
+  if (!enable) {
+    free(_cache);
+    _cache = NULL;
+    return true;
+  }
+  if (!_cache) {
+    _cache = (CacheEntry *)calloc(PREFERENCES_CACHE_SIZE, sizeof(CacheEntry));
+    if (!_cache) {
+      log_e("Not enough memory for the Preferences cache");
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t Preferences::cacheHits() {
+  return _cacheHits;
+}
+
+uint32_t Preferences::cacheMisses() {
+  return _cacheMisses;
+}
+
+static uint32_t cacheKeyHash(const char *key) {
+  // FNV-1a
+  uint32_t hash = 2166136261UL;
+  while (*key) {
+    hash ^= (uint8_t)*key++;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+Preferences::CacheEntry *Preferences::_cacheFind(const char *key, PreferenceType type) {
+  if (!_cache || !_started || !key) {
+    return NULL;
+  }
+  uint32_t hash = cacheKeyHash(key);
+  for (size_t i = 0; i < PREFERENCES_CACHE_SIZE; i++) {
+    CacheEntry &entry = _cache[i];
+    if (entry.stamp && entry.hash == hash && entry.type == type && strcmp(entry.key, key) == 0) {
+      entry.stamp = ++_cacheClock;
+      _cacheHits++;
+      return &entry;
+    }
+  }
+  _cacheMisses++;
+  return NULL;
+}
+
+bool Preferences::_cacheGet(const char *key, PreferenceType type, void *value, size_t len) {
+  CacheEntry *entry = _cacheFind(key, type);
+  if (!entry) {
+    return false;
+  }
+  if (entry->len) {
+    memcpy(value, entry->value, len);
+  }
+  return true;
+}
+
+void Preferences::_cachePut(const char *key, PreferenceType type, esp_err_t err, const void *value, size_t len) {
+  if (!_cache || !_started || !key || strlen(key) >= sizeof(_cache->key) || len > sizeof(_cache->value)) {
+    return;
+  }
+  if (err == ESP_ERR_NVS_NOT_FOUND || err == ESP_ERR_NVS_TYPE_MISMATCH) {
+    len = 0;  // remember that there is no such value
+  } else if (err != ESP_OK) {
+    return;
+  }
+  // replace the least recently used entry
+  CacheEntry *entry = &_cache[0];
+  for (size_t i = 1; i < PREFERENCES_CACHE_SIZE && entry->stamp; i++) {
+    if (_cache[i].stamp < entry->stamp) {
+      entry = &_cache[i];
+    }
+  }
+  strcpy(entry->key, key);
+  entry->hash = cacheKeyHash(key);
+  entry->type = type;
+  entry->len = len;
+  if (len) {
+    memcpy(entry->value, value, len);
+  }
+  entry->stamp = ++_cacheClock;
+}
+
+void Preferences::_cacheRemove(const char *key) {
+  if (!_cache) {
+    return;
+  }
+  uint32_t hash = cacheKeyHash(key);
+  for (size_t i = 0; i < PREFERENCES_CACHE_SIZE; i++) {
+    if (_cache[i].stamp && _cache[i].hash == hash && strcmp(_cache[i].key, key) == 0) {
+      _cache[i].stamp = 0;
+    }
+  }
+}
+
+void Preferences::_cacheClear() {
+  if (_cache) {
+    memset(_cache, 0, PREFERENCES_CACHE_SIZE * sizeof(CacheEntry));
+  }
+}
+
 /*
  * Clear all keys in opened preferences
  * */
@@ -67,12 +224,13 @@ bool Preferences::clear() {
   if (!_started || _readOnly) {
     return false;
   }
+  _cacheClear();
   esp_err_t err = nvs_erase_all(_handle);
   if (err) {
     log_e("nvs_erase_all fail: %s", nvs_error(err));
     return false;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s", nvs_error(err));
     return false;
@@ -88,12 +246,13 @@ bool Preferences::remove(const char *key) {
   if (!_started || !key || _readOnly) {
     return false;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_erase_key(_handle, key);
   if (err) {
     log_e("nvs_erase_key fail: %s %s", key, nvs_error(err));
     return false;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return false;
@@ -109,12 +268,13 @@ size_t Preferences::putChar(const char *key, int8_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_i8(_handle, key, value);
   if (err) {
     log_e("nvs_set_i8 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -126,12 +286,13 @@ size_t Preferences::putUChar(const char *key, uint8_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_u8(_handle, key, value);
   if (err) {
     log_e("nvs_set_u8 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -143,12 +304,13 @@ size_t Preferences::putShort(const char *key, int16_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_i16(_handle, key, value);
   if (err) {
     log_e("nvs_set_i16 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -160,12 +322,13 @@ size_t Preferences::putUShort(const char *key, uint16_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_u16(_handle, key, value);
   if (err) {
     log_e("nvs_set_u16 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -177,12 +340,13 @@ size_t Preferences::putInt(const char *key, int32_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_i32(_handle, key, value);
   if (err) {
     log_e("nvs_set_i32 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -194,12 +358,13 @@ size_t Preferences::putUInt(const char *key, uint32_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_u32(_handle, key, value);
   if (err) {
     log_e("nvs_set_u32 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -219,12 +384,13 @@ size_t Preferences::putLong64(const char *key, int64_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_i64(_handle, key, value);
   if (err) {
     log_e("nvs_set_i64 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -236,12 +402,13 @@ size_t Preferences::putULong64(const char *key, uint64_t value) {
   if (!_started || !key || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_u64(_handle, key, value);
   if (err) {
     log_e("nvs_set_u64 fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -265,12 +432,13 @@ size_t Preferences::putString(const char *key, const char *value) {
   if (!_started || !key || !value || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_str(_handle, key, value);
   if (err) {
     log_e("nvs_set_str fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -286,12 +454,13 @@ size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
   if (!_started || !key || !value || !len || _readOnly) {
     return 0;
   }
+  _cacheRemove(key);
   esp_err_t err = nvs_set_blob(_handle, key, value, len);
   if (err) {
     log_e("nvs_set_blob fail: %s %s", key, nvs_error(err));
     return 0;
   }
-  err = nvs_commit(_handle);
+  err = _commit();
   if (err) {
     log_e("nvs_commit fail: %s %s", key, nvs_error(err));
     return 0;
@@ -358,10 +527,14 @@ int8_t Preferences::getChar(const char *key, const int8_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_I8, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_i8(_handle, key, &value);
   if (err) {
     log_v("nvs_get_i8 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_I8, err, &value, sizeof(value));
   return value;
 }
 
@@ -370,10 +543,14 @@ uint8_t Preferences::getUChar(const char *key, const uint8_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_U8, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_u8(_handle, key, &value);
   if (err) {
     log_v("nvs_get_u8 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_U8, err, &value, sizeof(value));
   return value;
 }
 
@@ -382,10 +559,14 @@ int16_t Preferences::getShort(const char *key, const int16_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_I16, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_i16(_handle, key, &value);
   if (err) {
     log_v("nvs_get_i16 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_I16, err, &value, sizeof(value));
   return value;
 }
 
@@ -394,10 +575,14 @@ uint16_t Preferences::getUShort(const char *key, const uint16_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_U16, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_u16(_handle, key, &value);
   if (err) {
     log_v("nvs_get_u16 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_U16, err, &value, sizeof(value));
   return value;
 }
 
@@ -406,10 +591,14 @@ int32_t Preferences::getInt(const char *key, const int32_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_I32, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_i32(_handle, key, &value);
   if (err) {
     log_v("nvs_get_i32 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_I32, err, &value, sizeof(value));
   return value;
 }
 
@@ -418,10 +607,14 @@ uint32_t Preferences::getUInt(const char *key, const uint32_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_U32, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_u32(_handle, key, &value);
   if (err) {
     log_v("nvs_get_u32 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_U32, err, &value, sizeof(value));
   return value;
 }
 
@@ -438,10 +631,14 @@ int64_t Preferences::getLong64(const char *key, const int64_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_I64, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_i64(_handle, key, &value);
   if (err) {
     log_v("nvs_get_i64 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_I64, err, &value, sizeof(value));
   return value;
 }
 
@@ -450,10 +647,14 @@ uint64_t Preferences::getULong64(const char *key, const uint64_t defaultValue) {
   if (!_started || !key) {
     return value;
   }
+  if (_cacheGet(key, PT_U64, &value, sizeof(value))) {
+    return value;
+  }
   esp_err_t err = nvs_get_u64(_handle, key, &value);
   if (err) {
     log_v("nvs_get_u64 fail: %s %s", key, nvs_error(err));
   }
+  _cachePut(key, PT_U64, err, &value, sizeof(value));
   return value;
 }
 
@@ -530,7 +731,22 @@ size_t Preferences::getBytesLength(const char *key) {
 }
 
 size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  CacheEntry *entry = _cacheFind(key, PT_BLOB);
+  if (entry) {
+    if (!entry->len || !buf || !maxLen) {
+      return entry->len;
+    }
+    if (entry->len > maxLen) {
+      log_e("not enough space in buffer: %u < %u", maxLen, entry->len);
+      return 0;
+    }
+    memcpy(buf, entry->value, entry->len);
+    return entry->len;
+  }
   size_t len = getBytesLength(key);
+  if (!len) {
+    _cachePut(key, PT_BLOB, ESP_ERR_NVS_NOT_FOUND, NULL, 0);
+  }
   if (!len || !buf || !maxLen) {
     return len;
   }
@@ -543,6 +759,7 @@ size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
     log_e("nvs_get_blob fail: %s %s", key, nvs_error(err));
     return 0;
   }
+  _cachePut(key, PT_BLOB, err, buf, len);
   return len;
 }
 
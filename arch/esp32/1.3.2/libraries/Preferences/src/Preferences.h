@@ -15,6 +15,12 @@
 #define _PREFERENCES_H_
 
 #include "Arduino.h"
+#include <type_traits>
+
+// Entries of the optional read cache, see Preferences::enableCache()
+#ifndef PREFERENCES_CACHE_SIZE
+#define PREFERENCES_CACHE_SIZE 8
+#endif
 
 typedef enum {
   PT_I8,
@@ -35,17 +41,52 @@ protected:
   uint32_t _handle;
   bool _started;
   bool _readOnly;
+  uint8_t _batchDepth;
+  bool _batchPending;
+
+  struct CacheEntry {
+    char key[16];  // NVS_KEY_NAME_MAX_SIZE
+    uint32_t hash;
+    uint32_t stamp;  // last use, 0 if free
+    uint8_t type;    // PreferenceType
+    uint8_t len;     // 0 if the key is missing
+    uint8_t value[8];
+  };
+  CacheEntry *_cache;
+  uint32_t _cacheClock;
+  uint32_t _cacheHits;
+  uint32_t _cacheMisses;
+
+  esp_err_t _commit();
+  CacheEntry *_cacheFind(const char *key, PreferenceType type);
+  bool _cacheGet(const char *key, PreferenceType type, void *value, size_t len);
+  void _cachePut(const char *key, PreferenceType type, esp_err_t err, const void *value, size_t len);
+  void _cacheRemove(const char *key);
+  void _cacheClear();
 
 public:
   Preferences();
   ~Preferences();
 
+  // owns the cache table and an open NVS handle
+  Preferences(const Preferences &) = delete;
+  Preferences &operator=(const Preferences &) = delete;
+
   bool begin(const char *name, bool readOnly = false, const char *partition_label = NULL);
   void end();
 
   bool clear();
   bool remove(const char *key);
 
+  bool beginBatch();
+  bool commitBatch();
+
+  // Keep the last PREFERENCES_CACHE_SIZE integers, bools and blobs of up to
+  // 8 bytes (floats, doubles) read from this namespace in RAM
+  bool enableCache(bool enable = true);
+  uint32_t cacheHits();
+  uint32_t cacheMisses();
+
   size_t putChar(const char *key, int8_t value);
   size_t putUChar(const char *key, uint8_t value);
   size_t putShort(const char *key, int16_t value);
@@ -63,6 +104,12 @@ public:
   size_t putString(const char *key, String value);
   size_t putBytes(const char *key, const void *value, size_t len);
 
+  // Store a plain struct as a single blob, one NVS entry instead of one per field
+  template<typename T> size_t putStruct(const char *key, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "putStruct() needs a trivially copyable type");
+    return putBytes(key, &value, sizeof(T));
+  }
+
   bool isKey(const char *key);
   PreferenceType getType(const char *key);
   int8_t getChar(const char *key, int8_t defaultValue = 0);
@@ -82,7 +129,36 @@ public:
   String getString(const char *key, String defaultValue = String());
   size_t getBytesLength(const char *key);
   size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+  // Load a struct stored with putStruct(), value is left untouched if the
+  // key is missing or was written with a different size
+  template<typename T> bool getStruct(const char *key, T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "getStruct() needs a trivially copyable type");
+    if (getBytesLength(key) != sizeof(T)) {
+      return false;
+    }
+    return getBytes(key, &value, sizeof(T)) == sizeof(T);
+  }
+
   size_t freeEntries();
 };
 
+// Batch scope: commits once when it goes out of scope
+//   { PreferencesBatch batch(prefs); prefs.putInt("a", 1); prefs.putInt("b", 2); }
+class PreferencesBatch {
+public:
+  PreferencesBatch(Preferences &prefs) : _prefs(prefs) {
+    _prefs.beginBatch();
+  }
+  ~PreferencesBatch() {
+    _prefs.commitBatch();
+  }
+
+  PreferencesBatch(const PreferencesBatch &) = delete;
+  PreferencesBatch &operator=(const PreferencesBatch &) = delete;
+
+private:
+  Preferences &_prefs;
+};
+
 #endif
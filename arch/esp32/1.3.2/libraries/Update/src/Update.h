@@ -46,6 +46,10 @@
 #define SPI_SECTORS_PER_BLOCK 16  // usually large erase block is 32k/64k
 #define SPI_FLASH_BLOCK_SIZE  (SPI_SECTORS_PER_BLOCK * SPI_FLASH_SEC_SIZE)
 
+#ifndef UPDATE_FLASH_TASK_STACK
+#define UPDATE_FLASH_TASK_STACK 4096  // task that writes one sector while writeStream() reads the next
+#endif
+
 class UpdateClass {
 public:
   typedef std::function<void(size_t, size_t)> THandlerFunction_Progress;
@@ -251,6 +255,8 @@ private:
   bool _decryptBuffer();
 #endif /* UPDATE_NOCRYPT */
   bool _writeBuffer();
+  bool _writeStreamPipelined(Stream &data, size_t &written);
+  static void _flashTask(void *arg);
   bool _verifyHeader(uint8_t data);
   bool _verifyEnd();
   bool _enablePartition(const esp_partition_t *partition);
@@ -580,6 +580,10 @@ size_t UpdateClass::writeStream(Stream &data) {
     pinMode(_ledPin, OUTPUT);
   }
 
+  if (!_bufferLen && remaining() > SPI_FLASH_SEC_SIZE && _writeStreamPipelined(data, written)) {
+    return written;
+  }
+
   while (remaining()) {
     if (_ledPin != -1) {
       digitalWrite(_ledPin, _ledOn);  // Switch LED on
@@ -623,6 +627,137 @@ size_t UpdateClass::writeStream(Stream &data) {
   return written;
 }
 
+struct UpdateFlashJob {
+  UpdateClass *update;
+  SemaphoreHandle_t start;  // a sector is in _buffer
+  SemaphoreHandle_t done;   // _writeBuffer() returned, or the task is about to exit
+  bool stop;
+  bool ok;
+};
+
+void UpdateClass::_flashTask(void *arg) {
+  UpdateFlashJob *job = (UpdateFlashJob *)arg;
+  while (1) {
+    xSemaphoreTake(job->start, portMAX_DELAY);
+    if (job->stop) {
+      break;
+    }
+    job->ok = job->update->_writeBuffer();
+    xSemaphoreGive(job->done);
+  }
+  xSemaphoreGive(job->done);
+  vTaskDelete(NULL);
+}
+
+/*
+    Double buffered writeStream(): the stream is read straight into one sector
+    buffer while a second task decrypts, hashes, erases and writes the sector
+    read before it from the other one. Returns false, before reading anything,
+    if the second buffer or the task cannot be set up.
+  */
+bool UpdateClass::_writeStreamPipelined(Stream &data, size_t &written) {
+  uint8_t *fill = new (std::nothrow) uint8_t[SPI_FLASH_SEC_SIZE];
+  UpdateFlashJob job = {this, xSemaphoreCreateBinary(), xSemaphoreCreateBinary(), false, true};
+  TaskHandle_t task = NULL;
+  if (!fill || !job.start || !job.done
+      || xTaskCreate(_flashTask, "update_flash", UPDATE_FLASH_TASK_STACK, &job, uxTaskPriorityGet(NULL), &task) != pdPASS) {
+    log_w("no resources for pipelined update, writing sector by sector");
+    delete[] fill;
+    if (job.start) {
+      vSemaphoreDelete(job.start);
+    }
+    if (job.done) {
+      vSemaphoreDelete(job.done);
+    }
+    return false;
+  }
+
+  // progress is reported from this task, not from the one running _writeBuffer()
+  THandlerFunction_Progress progress_callback = _progress_callback;
+  _progress_callback = NULL;
+  if (progress_callback && !_progress) {
+    progress_callback(0, _size);
+  }
+
+  size_t left = remaining();  // not yet read from the stream
+  size_t inFlight = 0;        // bytes handed to the flash task
+  int timeout_failures = 0;
+  bool streamError = false;
+  while (left) {
+    size_t sector = left < SPI_FLASH_SEC_SIZE ? left : SPI_FLASH_SEC_SIZE;
+    size_t fillLen = 0;
+    while (fillLen < sector) {
+      if (_ledPin != -1) {
+        digitalWrite(_ledPin, _ledOn);  // Switch LED on
+      }
+      size_t toRead = data.readBytes(fill + fillLen, sector - fillLen);
+      if (_ledPin != -1) {
+        digitalWrite(_ledPin, !_ledOn);  // Switch LED off
+      }
+      if (toRead == 0) {
+        // same budget as writeStream(): 300 failed reads 100ms apart
+        if (++timeout_failures >= 300) {
+          streamError = true;
+          break;
+        }
+        delay(100);
+        continue;
+      }
+      timeout_failures = 0;
+      fillLen += toRead;
+    }
+    if (streamError) {
+      break;
+    }
+
+    // wait for the previous sector, then hand this one over
+    if (inFlight) {
+      xSemaphoreTake(job.done, portMAX_DELAY);
+      if (!job.ok) {
+        inFlight = 0;
+        break;
+      }
+      written += inFlight;
+      if (progress_callback) {
+        progress_callback(_progress, _size);
+      }
+    }
+    uint8_t *flushed = _buffer;
+    _buffer = fill;
+    fill = flushed;
+    _bufferLen = sector;
+    inFlight = sector;
+    left -= sector;
+    xSemaphoreGive(job.start);
+
+#if CONFIG_FREERTOS_UNICORE
+    delay(1);  // Fix solo WDT
+#endif
+  }
+
+  if (inFlight) {
+    xSemaphoreTake(job.done, portMAX_DELAY);
+    if (job.ok) {
+      written += inFlight;
+      if (progress_callback) {
+        progress_callback(_progress, _size);
+      }
+    }
+  }
+  job.stop = true;
+  xSemaphoreGive(job.start);
+  xSemaphoreTake(job.done, portMAX_DELAY);
+  vSemaphoreDelete(job.start);
+  vSemaphoreDelete(job.done);
+  delete[] fill;
+  _progress_callback = progress_callback;
+
+  if (streamError) {
+    _abort(UPDATE_ERROR_STREAM);
+  }
+  return true;
+}
+
 void UpdateClass::printError(Print &out) {
   out.println(_err2str(_error));
 }
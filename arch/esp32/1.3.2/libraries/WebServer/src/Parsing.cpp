@@ -73,10 +73,47 @@ static char *readBytesWithTimeout(NetworkClient &client, size_t maxLength, size_
   return buf;
 }
 
+// Copies the next line of the request head to the line buffer, without its
+// line ending. Lines of WEBSERVER_MAX_LINE_LENGTH or more are cut short and
+// reported as truncated.
+char *WebServer::_readLine(size_t &length, bool &truncated) {
+  if (!_lineBuf) {
+    _lineBuf.reset(new (std::nothrow) char[WEBSERVER_MAX_LINE_LENGTH]);
+    if (!_lineBuf) {
+      log_e("Not enough memory for the request line buffer");
+      return nullptr;
+    }
+  }
+  char *line = _lineBuf.get();
+  const char *start = _currentHead.c_str() + _headPos;
+  size_t avail = _currentHead.length() - _headPos;
+  const char *end = (const char *)memchr(start, '\n', avail);
+  length = end ? end - start : avail;
+  _headPos += end ? length + 1 : length;
+  if (length && start[length - 1] == '\r') {
+    length--;
+  }
+  truncated = length >= WEBSERVER_MAX_LINE_LENGTH;
+  if (truncated) {
+    length = WEBSERVER_MAX_LINE_LENGTH - 1;
+  }
+  memcpy(line, start, length);
+  line[length] = '\0';
+  return line;
+}
+
 bool WebServer::_parseRequest(NetworkClient &client) {
   // Read the first line of HTTP request
-  String req = client.readStringUntil('\r');
-  client.readStringUntil('\n');
+  size_t length;
+  bool truncated;
+  char *req = _readLine(length, truncated);
+  if (!req) {
+    return false;
+  }
+  if (truncated) {
+    log_e("Request line longer than %d chars", WEBSERVER_MAX_LINE_LENGTH - 1);
+    return false;
+  }
   //reset header value
   if (_collectAllHeaders) {
     // clear previous headers
@@ -90,22 +127,23 @@ bool WebServer::_parseRequest(NetworkClient &client) {
 
   // First line of HTTP request looks like "GET /path HTTP/1.1"
   // Retrieve the "/path" part by finding the spaces
-  int addr_start = req.indexOf(' ');
-  int addr_end = req.indexOf(' ', addr_start + 1);
-  if (addr_start == -1 || addr_end == -1) {
-    log_e("Invalid request: %s", req.c_str());
+  char *addr_start = strchr(req, ' ');
+  char *addr_end = addr_start ? strchr(addr_start + 1, ' ') : nullptr;
+  if (!addr_start || !addr_end) {
+    log_e("Invalid request: %s", req);
     return false;
   }
 
-  String methodStr = req.substring(0, addr_start);
-  String url = req.substring(addr_start + 1, addr_end);
-  String versionEnd = req.substring(addr_end + 8);
-  _currentVersion = atoi(versionEnd.c_str());
+  *addr_start = '\0';
+  *addr_end = '\0';
+  const char *methodStr = req;
+  char *url = addr_start + 1;
+  _currentVersion = (addr_end + 8 <= req + length) ? atoi(addr_end + 8) : 0;
   String searchStr = "";
-  int hasSearch = url.indexOf('?');
-  if (hasSearch != -1) {
-    searchStr = url.substring(hasSearch + 1);
-    url = url.substring(0, hasSearch);
+  char *hasSearch = strchr(url, '?');
+  if (hasSearch) {
+    *hasSearch = '\0';
+    searchStr = hasSearch + 1;
   }
   _currentUri = url;
   _chunked = false;
@@ -114,67 +152,56 @@ bool WebServer::_parseRequest(NetworkClient &client) {
   HTTPMethod method = HTTP_ANY;
   size_t num_methods = sizeof(_http_method_str) / sizeof(const char *);
   for (size_t i = 0; i < num_methods; i++) {
-    if (methodStr == _http_method_str[i]) {
+    if (strcmp(methodStr, _http_method_str[i]) == 0) {
       method = (HTTPMethod)i;
       break;
     }
   }
   if (method == HTTP_ANY) {
-    log_e("Unknown HTTP Method: %s", methodStr.c_str());
+    log_e("Unknown HTTP Method: %s", methodStr);
     return false;
   }
   _currentMethod = method;
 
-  log_v("method: %s url: %s search: %s", methodStr.c_str(), url.c_str(), searchStr.c_str());
+  log_v("method: %s url: %s search: %s", methodStr, url, searchStr.c_str());
 
   //attach handler
-  RequestHandler *handler;
-  for (handler = _firstHandler; handler; handler = handler->next()) {
-    if (handler->canHandle(*this, _currentMethod, _currentUri)) {
-      break;
-    }
-  }
-  _currentHandler = handler;
+  _currentHandler = _findRequestHandler();
 
   String formData;
   // below is needed only when POST type request
   if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE) {
     String boundaryStr;
-    String headerName;
-    String headerValue;
     bool isForm = false;
     bool isEncoded = false;
     //parse headers
     while (1) {
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req == "") {
+      const char *headerName;
+      const char *headerValue;
+      if (!_readHeader(headerName, headerValue)) {
         break;  //no moar headers
       }
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1) {
-        break;
+      if (!headerName) {
+        continue;
       }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 1);
-      headerValue.trim();
-      _collectHeader(headerName.c_str(), headerValue.c_str());
+      _collectHeader(headerName, headerValue);
 
-      if (headerName.equalsIgnoreCase(FPSTR(Content_Type))) {
+      if (strcasecmp_P(headerName, Content_Type) == 0) {
         using namespace mime;
-        if (headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))) {
+        if (strncmp_P(headerValue, mimeTable[txt].mimeType, strlen_P(mimeTable[txt].mimeType)) == 0) {
           isForm = false;
-        } else if (headerValue.startsWith(F("application/x-www-form-urlencoded"))) {
+        } else if (strncmp(headerValue, "application/x-www-form-urlencoded", 33) == 0) {
           isForm = false;
           isEncoded = true;
-        } else if (headerValue.startsWith(F("multipart/"))) {
-          boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
+        } else if (strncmp(headerValue, "multipart/", 10) == 0) {
+          const char *eq = strchr(headerValue, '=');
+          boundaryStr = eq ? eq + 1 : headerValue;
           boundaryStr.replace("\"", "");
           isForm = true;
         }
-      } else if (headerName.equalsIgnoreCase(F("Content-Length"))) {
-        _clientContentLength = headerValue.toInt();
-      } else if (headerName.equalsIgnoreCase(F("Host"))) {
+      } else if (strcasecmp(headerName, "Content-Length") == 0) {
+        _clientContentLength = atol(headerValue);
+      } else if (strcasecmp(headerName, "Host") == 0) {
         _hostHeader = headerValue;
       }
     }
@@ -240,24 +267,19 @@ bool WebServer::_parseRequest(NetworkClient &client) {
       }
     }
   } else {
-    String headerName;
-    String headerValue;
     //parse headers
     while (1) {
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req == "") {
+      const char *headerName;
+      const char *headerValue;
+      if (!_readHeader(headerName, headerValue)) {
         break;  //no moar headers
       }
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1) {
-        break;
+      if (!headerName) {
+        continue;
       }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 2);
-      _collectHeader(headerName.c_str(), headerValue.c_str());
+      _collectHeader(headerName, headerValue);
 
-      if (headerName.equalsIgnoreCase("Host")) {
+      if (strcasecmp(headerName, "Host") == 0) {
         _hostHeader = headerValue;
       }
     }
@@ -265,12 +287,46 @@ bool WebServer::_parseRequest(NetworkClient &client) {
   }
   client.clear();
 
-  log_v("Request: %s", url.c_str());
+  log_v("Request: %s", _currentUri.c_str());
   log_v(" Arguments: %s", searchStr.c_str());
 
   return true;
 }
 
+// Reads the next header line and splits it in place into name and trimmed
+// value. Returns false at the end of the headers; an over-long line is
+// skipped by returning true with headerName set to nullptr.
+bool WebServer::_readHeader(const char *&headerName, const char *&headerValue) {
+  size_t length;
+  bool truncated;
+  char *line = _readLine(length, truncated);
+  if (!line || !length) {
+    return false;
+  }
+  char *div = strchr(line, ':');
+  if (!div) {
+    return false;
+  }
+  headerName = nullptr;
+  if (truncated) {
+    *div = '\0';
+    log_w("Header %s longer than %d chars, skipped", line, WEBSERVER_MAX_LINE_LENGTH - 1);
+    return true;
+  }
+  *div = '\0';
+  char *value = div + 1;
+  char *end = line + length;
+  while (value < end && isspace((uint8_t)*value)) {
+    value++;
+  }
+  while (end > value && isspace((uint8_t)end[-1])) {
+    *--end = '\0';
+  }
+  headerName = line;
+  headerValue = value;
+  return true;
+}
+
 bool WebServer::_collectHeader(const char *headerName, const char *headerValue) {
   RequestArgument *last = nullptr;
   for (RequestArgument *header = _currentHeaders; header; header = header->next) {
@@ -350,72 +406,176 @@ void WebServer::_parseArguments(const String &data) {
   log_v("args count: %d", _currentArgCount);
 }
 
-void WebServer::_uploadWriteByte(uint8_t b) {
-  if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
-    if (_currentHandler && _currentHandler->canUpload(*this, _currentUri)) {
-      _currentHandler->upload(*this, _currentUri, *_currentUpload);
+void WebServer::_uploadWriteBytes(const uint8_t *data, size_t length) {
+  while (length) {
+    if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
+      if (_currentHandler && _currentHandler->canUpload(*this, _currentUri)) {
+        _currentHandler->upload(*this, _currentUri, *_currentUpload);
+      }
+      _currentUpload->totalSize += _currentUpload->currentSize;
+      _currentUpload->currentSize = 0;
     }
-    _currentUpload->totalSize += _currentUpload->currentSize;
-    _currentUpload->currentSize = 0;
+    size_t chunk = std::min(length, (size_t)(HTTP_UPLOAD_BUFLEN - _currentUpload->currentSize));
+    memcpy(_currentUpload->buf + _currentUpload->currentSize, data, chunk);
+    _currentUpload->currentSize += chunk;
+    data += chunk;
+    length -= chunk;
   }
-  _currentUpload->buf[_currentUpload->currentSize++] = b;
 }
 
-int WebServer::_uploadReadByte(NetworkClient &client) {
-  int res = client.read();
+// Buffered reader over a multipart/form-data body. The body is pulled from the
+// client in bulk reads and the part delimiter ("\r\n--boundary") is located with
+// a Boyer-Moore-Horspool search, so file data is handed on in whole spans
+// instead of one client.read() per byte.
+class MultipartReader {
+public:
+  MultipartReader(NetworkClient &client, uint32_t contentLength, const String &boundary)
+    : _client(client), _remaining(contentLength ? contentLength : UINT32_MAX) {
+    _delimiter = "\r\n--";
+    _delimiter += boundary;
+    size_t dlen = _delimiter.length();
+    // shifts are clamped to the table width, a shorter shift is always safe
+    for (size_t i = 0; i < 256; i++) {
+      _skip[i] = std::min(dlen, (size_t)UINT8_MAX);
+    }
+    for (size_t i = 0; i + 1 < dlen; i++) {
+      _skip[(uint8_t)_delimiter[i]] = std::min(dlen - 1 - i, (size_t)UINT8_MAX);
+    }
+    _size = HTTP_UPLOAD_BUFLEN + dlen;
+    _buf = (uint8_t *)malloc(_size);
+  }
+
+  ~MultipartReader() {
+    free(_buf);
+  }
 
-  if (res < 0) {
-    // keep trying until you either read a valid byte or timeout
-    const unsigned long startMillis = millis();
-    const long timeoutIntervalMillis = client.getTimeout();
-    bool timedOut = false;
-    for (;;) {
-      if (!client.connected()) {
-        return -1;
+  operator bool() const {
+    return _buf != nullptr;
+  }
+
+  // read up to '\r' and skip the following '\n', like readStringUntil('\r') + readStringUntil('\n')
+  bool readLine(String &line) {
+    line = "";
+    while (true) {
+      if (_pos == _fill && !_refill()) {
+        return false;
+      }
+      const uint8_t *start = _buf + _pos;
+      size_t n = _fill - _pos;
+      const uint8_t *cr = (const uint8_t *)memchr(start, '\r', n);
+      if (!cr) {
+        line.concat((const char *)start, n);
+        _pos = _fill;
+        continue;
       }
-      // loosely modeled after blinkWithoutDelay pattern
-      while (!timedOut && !client.available() && client.connected()) {
-        delay(2);
-        timedOut = (millis() - startMillis) >= timeoutIntervalMillis;
+      line.concat((const char *)start, cr - start);
+      _pos += cr - start + 1;
+      while (true) {
+        if (_pos == _fill && !_refill()) {
+          return true;
+        }
+        if (_buf[_pos++] == '\n') {
+          return true;
+        }
       }
+    }
+  }
 
-      res = client.read();
-      if (res >= 0) {
-        return res;  // exit on a valid read
+  // pass everything up to the next delimiter to sink and consume the delimiter
+  template<typename Sink> bool readPart(Sink sink) {
+    const size_t dlen = _delimiter.length();
+    while (true) {
+      size_t avail = _fill - _pos;
+      int found = _search(_buf + _pos, avail);
+      if (found >= 0) {
+        if (found) {
+          sink(_buf + _pos, (size_t)found);
+        }
+        _pos += found + dlen;
+        return true;
       }
-      // NOTE: it is possible to get here and have all of the following
-      //       assertions hold true
-      //
-      //       -- client.available() > 0
-      //       -- client.connected == true
-      //       -- res == -1
-      //
-      //       a simple retry strategy overcomes this which is to say the
-      //       assertion is not permanent, but the reason that this works
-      //       is elusive, and possibly indicative of a more subtle underlying
-      //       issue
-
-      timedOut = (millis() - startMillis) >= timeoutIntervalMillis;
-      if (timedOut) {
-        return res;  // exit on a timeout
+      // the last dlen - 1 bytes may be the start of a delimiter, keep them
+      if (avail >= dlen) {
+        size_t safe = avail - (dlen - 1);
+        sink(_buf + _pos, safe);
+        _pos += safe;
+      }
+      if (!_refill()) {
+        return false;
       }
     }
   }
 
-  return res;
-}
+private:
+  int _search(const uint8_t *data, size_t length) const {
+    const size_t dlen = _delimiter.length();
+    const uint8_t *d = (const uint8_t *)_delimiter.c_str();
+    size_t i = 0;
+    while (i + dlen <= length) {
+      uint8_t last = data[i + dlen - 1];
+      if (last == d[dlen - 1] && memcmp(data + i, d, dlen - 1) == 0) {
+        return (int)i;
+      }
+      i += _skip[last];
+    }
+    return -1;
+  }
+
+  // move unread bytes to the front and append whatever the client has, waiting up to its timeout
+  bool _refill() {
+    if (_pos) {
+      memmove(_buf, _buf + _pos, _fill - _pos);
+      _fill -= _pos;
+      _pos = 0;
+    }
+    if (_fill == _size || !_remaining) {
+      return false;
+    }
+    const unsigned long startMillis = millis();
+    while (true) {
+      int avail = _client.available();
+      if (avail > 0) {
+        size_t toRead = std::min((size_t)avail, std::min(_size - _fill, (size_t)_remaining));
+        int res = _client.read(_buf + _fill, toRead);
+        if (res > 0) {
+          _fill += res;
+          _remaining -= res;
+          return true;
+        }
+      } else if (!_client.connected()) {
+        return false;
+      }
+      if (millis() - startMillis >= _client.getTimeout()) {
+        return false;
+      }
+      delay(1);
+    }
+  }
+
+  NetworkClient &_client;
+  uint32_t _remaining;
+  String _delimiter;
+  uint8_t *_buf = nullptr;
+  size_t _size = 0;
+  size_t _pos = 0;
+  size_t _fill = 0;
+  uint8_t _skip[256];
+};
 
 bool WebServer::_parseForm(NetworkClient &client, const String &boundary, uint32_t len) {
-  (void)len;
   log_v("Parse Form: Boundary: %s Length: %d", boundary.c_str(), len);
+  MultipartReader reader(client, len, boundary);
+  if (!reader) {
+    log_e("Not enough memory to parse form");
+    return false;
+  }
   String line;
   int retry = 0;
   do {
-    line = client.readStringUntil('\r');
+    reader.readLine(line);
     ++retry;
   } while (line.length() == 0 && retry < 3);
 
-  client.readStringUntil('\n');
   //start reading the form
   if (line == ("--" + boundary)) {
     if (_postArgs) {
@@ -430,8 +590,10 @@ bool WebServer::_parseForm(NetworkClient &client, const String &boundary, uint32
       String argFilename;
       bool argIsFile = false;
 
-      line = client.readStringUntil('\r');
-      client.readStringUntil('\n');
+      if (!reader.readLine(line)) {
+        log_e("Error: form data ended before the closing boundary");
+        return false;
+      }
       if (line.length() > 19 && line.substring(0, 19).equalsIgnoreCase(F("Content-Disposition"))) {
         int nameStart = line.indexOf('=');
         if (nameStart != -1) {
@@ -452,21 +614,23 @@ bool WebServer::_parseForm(NetworkClient &client, const String &boundary, uint32
           log_v("PostArg Name: %s", argName.c_str());
           using namespace mime;
           argType = FPSTR(mimeTable[txt].mimeType);
-          line = client.readStringUntil('\r');
-          client.readStringUntil('\n');
+          reader.readLine(line);
           while (line.length() > 0) {
             if (line.length() > 12 && line.substring(0, 12).equalsIgnoreCase(FPSTR(Content_Type))) {
               argType = line.substring(line.indexOf(':') + 2);
             }
             //skip over any other headers
-            line = client.readStringUntil('\r');
-            client.readStringUntil('\n');
+            if (!reader.readLine(line)) {
+              break;
+            }
           }
           log_v("PostArg Type: %s", argType.c_str());
           if (!argIsFile) {
             while (1) {
-              line = client.readStringUntil('\r');
-              client.readStringUntil('\n');
+              if (!reader.readLine(line)) {
+                log_e("Error: form data ended inside PostArg %s", argName.c_str());
+                return false;
+              }
               if (line.startsWith("--" + boundary)) {
                 break;
               }
@@ -502,38 +666,12 @@ bool WebServer::_parseForm(NetworkClient &client, const String &boundary, uint32
             }
             _currentUpload->status = UPLOAD_FILE_WRITE;
 
-            int fastBoundaryLen = 4 /* \r\n-- */ + boundary.length() + 1 /* \0 */;
-            char fastBoundary[fastBoundaryLen];
-            snprintf(fastBoundary, fastBoundaryLen, "\r\n--%s", boundary.c_str());
-            int boundaryPtr = 0;
-            while (true) {
-              int ret = _uploadReadByte(client);
-              if (ret < 0) {
-                // Unexpected, we should have had data available per above
-                return _parseFormUploadAborted();
-              }
-              char in = (char)ret;
-              if (in == fastBoundary[boundaryPtr]) {
-                // The input matched the current expected character, advance and possibly exit this file
-                boundaryPtr++;
-                if (boundaryPtr == fastBoundaryLen - 1) {
-                  // We read the whole boundary line, we're done here!
-                  break;
-                }
-              } else {
-                // The char doesn't match what we want, so dump whatever matches we had, the read in char, and reset ptr to start
-                for (int i = 0; i < boundaryPtr; i++) {
-                  _uploadWriteByte(fastBoundary[i]);
-                }
-                if (in == fastBoundary[0]) {
-                  // This could be the start of the real end, mark it so and don't emit/skip it
-                  boundaryPtr = 1;
-                } else {
-                  // Not the 1st char of our pattern, so emit and ignore
-                  _uploadWriteByte(in);
-                  boundaryPtr = 0;
-                }
-              }
+            bool complete = reader.readPart([this](const uint8_t *data, size_t length) {
+              _uploadWriteBytes(data, length);
+            });
+            if (!complete) {
+              // Unexpected, the client went away or stalled before the closing boundary
+              return _parseFormUploadAborted();
             }
             // Found the boundary string, finish processing this file upload
             if (_currentHandler && _currentHandler->canUpload(*this, _currentUri)) {
@@ -545,11 +683,7 @@ bool WebServer::_parseForm(NetworkClient &client, const String &boundary, uint32
               _currentHandler->upload(*this, _currentUri, *_currentUpload);
             }
             log_v("End File: %s Type: %s Size: %d", _currentUpload->filename.c_str(), _currentUpload->type.c_str(), (int)_currentUpload->totalSize);
-            if (!client.connected()) {
-              return _parseFormUploadAborted();
-            }
-            line = client.readStringUntil('\r');
-            client.readStringUntil('\n');
+            reader.readLine(line);
             if (line == "--") {  // extra two dashes mean we reached the end of all form fields
               log_v("Done Parsing POST");
               break;
@@ -10,14 +10,30 @@ protected:
   const String _uri;
 
 public:
+  // How the pattern matches, used by WebServer to index routes. The default
+  // ROUTE_OTHER keeps the route out of the index, so a subclass with its own
+  // canHandle() keeps working whether or not it overrides routeType().
+  enum RouteType {
+    ROUTE_EXACT,
+    ROUTE_BRACES,
+    ROUTE_GLOB,
+    ROUTE_OTHER
+  };
+
   Uri(const char *uri) : _uri(uri) {}
   Uri(const String &uri) : _uri(uri) {}
   Uri(const __FlashStringHelper *uri) : _uri((const char *)uri) {}
   virtual ~Uri() {}
 
-  virtual Uri *clone() const {
-    return new Uri(_uri);
-  };
+  virtual Uri *clone() const;
+
+  virtual RouteType routeType() const {
+    return ROUTE_OTHER;
+  }
+
+  const String &pattern() const {
+    return _uri;
+  }
 
   virtual void initPathArgs(__attribute__((unused)) std::vector<String> &pathArgs) {}
 
@@ -26,4 +42,25 @@ public:
   }
 };
 
+// What a plain Uri turns into when a handler stores it, e.g. the "/path" of
+// server.on("/path", ...). A class that does not override clone() matches
+// with Uri::canHandle(), an exact string compare, so it can be indexed as one.
+class UriExact final : public Uri {
+
+public:
+  explicit UriExact(const String &uri) : Uri(uri) {}
+
+  Uri *clone() const override {
+    return new UriExact(_uri);
+  }
+
+  RouteType routeType() const override {
+    return ROUTE_EXACT;
+  }
+};
+
+inline Uri *Uri::clone() const {
+  return new UriExact(_uri);
+}
+
 #endif
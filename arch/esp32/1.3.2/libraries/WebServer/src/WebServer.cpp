@@ -1,6 +1,6 @@
 /*
   WebServer.cpp - Dead simple web-server.
-  Supports only one simultaneous client, knows how to handle GET and POST.
+  Serves up to WEBSERVER_MAX_CLIENTS simultaneous clients, knows how to handle GET and POST.
 
   Copyright (c) 2014 Ivan Grokhotkov. All rights reserved.
 
@@ -40,6 +40,7 @@ static const char qop_auth_quoted[] PROGMEM = "qop=\"auth\"";
 static const char WWW_Authenticate[] = "WWW-Authenticate";
 static const char Content_Length[] = "Content-Length";
 static const char ETAG_HEADER[] = "If-None-Match";
+static const char ACCEPT_ENCODING_HEADER[] = "Accept-Encoding";
 
 WebServer::WebServer(IPAddress addr, int port) : _server(addr, port) {
   log_v("WebServer::Webserver(addr=%s, port=%d)", addr.toString().c_str(), port);
@@ -371,6 +372,7 @@ void WebServer::_addRequestHandler(RequestHandler *handler) {
     _lastHandler->next(handler);
     _lastHandler = handler;
   }
+  _routeIndex.add(handler);
 }
 
 bool WebServer::_removeRequestHandler(RequestHandler *handler) {
@@ -391,6 +393,7 @@ bool WebServer::_removeRequestHandler(RequestHandler *handler) {
 
       // Delete 'matching' handler
       delete current;
+      _rebuildRouteIndex();
       return true;
     }
     previous = current;
@@ -399,37 +402,89 @@ bool WebServer::_removeRequestHandler(RequestHandler *handler) {
   return false;
 }
 
+void WebServer::_rebuildRouteIndex() {
+  _routeIndex.clear();
+  for (RequestHandler *handler = _firstHandler; handler; handler = handler->next()) {
+    _routeIndex.add(handler);
+  }
+}
+
+RequestHandler *WebServer::_findRequestHandler() {
+  _routeIndex.lookup(_currentMethod, _currentUri, _routeCandidates);
+  for (RequestHandler *handler : _routeCandidates) {
+    if (handler->canHandle(*this, _currentMethod, _currentUri)) {
+      return handler;
+    }
+  }
+  return nullptr;
+}
+
 void WebServer::serveStatic(const char *uri, FS &fs, const char *path, const char *cache_header) {
   _addRequestHandler(new StaticRequestHandler(fs, path, uri, cache_header));
 }
 
 void WebServer::handleClient() {
-  if (_currentStatus == HC_NONE) {
-    _currentClient = _server.accept();
-    if (!_currentClient) {
-      if (_nullDelay) {
-        delay(1);
-      }
-      return;
+  // Accept at most one new connection per pass, and only into a free slot, so
+  // that pending connections stay queued in the listen backlog when the table is full
+  for (uint8_t i = 0; i < _maxClients; i++) {
+    ClientConnection &conn = _clients[i];
+    if (conn.status != HC_NONE) {
+      continue;
+    }
+    conn.client = _server.accept();
+    if (conn.client) {
+      log_v("New client: slot=%u client.localIP()=%s", i, conn.client.localIP().toString().c_str());
+      conn.status = HC_WAIT_READ;
+      conn.statusChange = millis();
+    }
+    break;
+  }
+
+  bool anyClient = false;
+  bool callYield = false;
+
+  // Service every open connection once, rotating the starting slot so that a
+  // busy client (or a long-lived SSE stream) cannot starve the others
+  for (uint8_t n = 0; n < _maxClients; n++) {
+    ClientConnection &conn = _clients[(_nextClient + n) % _maxClients];
+    if (conn.status == HC_NONE) {
+      continue;
+    }
+    anyClient = true;
+    if (_handleConnection(conn)) {
+      callYield = true;
     }
+  }
+  _nextClient = (_nextClient + 1) % _maxClients;
 
-    log_v("New client: client.localIP()=%s", _currentClient.localIP().toString().c_str());
+  if (!anyClient) {
+    if (_nullDelay) {
+      delay(1);
+    }
+    return;
+  }
 
-    _currentStatus = HC_WAIT_READ;
-    _statusChange = millis();
+  if (callYield) {
+    yield();
   }
+}
 
-  bool keepCurrentClient = false;
+bool WebServer::_handleConnection(ClientConnection &conn) {
+  bool keepClient = false;
   bool callYield = false;
 
-  if (_currentClient.connected()) {
-    switch (_currentStatus) {
+  if (conn.client.connected()) {
+    switch (conn.status) {
       case HC_NONE:
         // No-op to avoid C++ compiler warning
         break;
       case HC_WAIT_READ:
-        // Wait for data from client to become available
-        if (_currentClient.available()) {
+        // Collect the request head as it arrives, a client that stops halfway
+        // through only holds its own slot until HTTP_MAX_DATA_WAIT runs out
+        if (_readHead(conn)) {
+          _currentHead = std::move(conn.head);
+          _headPos = 0;
+          _currentClient = conn.client;
           _currentClient.setTimeout(HTTP_MAX_SEND_WAIT); /* / 1000 removed, WifiClient setTimeout changed to ms */
           if (_parseRequest(_currentClient)) {
             _contentLength = CONTENT_LENGTH_NOT_SET;
@@ -446,52 +501,115 @@ void WebServer::handleClient() {
             }
 
             if (_currentClient.isSSE()) {
-              _currentStatus = HC_WAIT_CLOSE;
-              _statusChange = millis();
-              keepCurrentClient = true;
+              conn.status = HC_WAIT_CLOSE;
+              conn.statusChange = millis();
+              keepClient = true;
             }
             // Fix for issue with Chrome based browsers: https://github.com/espressif/arduino-esp32/issues/3652
             //           if (_currentClient.connected()) {
-            //             _currentStatus = HC_WAIT_CLOSE;
-            //             _statusChange = millis();
-            //             keepCurrentClient = true;
+            //             conn.status = HC_WAIT_CLOSE;
+            //             conn.statusChange = millis();
+            //             keepClient = true;
             //           }
           }
-        } else {  // !_currentClient.available()
-          if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT) {
-            keepCurrentClient = true;
+          // the handler may have flagged the client as SSE, keep that on the slot
+          conn.client = _currentClient;
+          _currentClient = NetworkClient();
+          _currentHead = String();
+          _currentUpload.reset();
+          _currentRaw.reset();
+        } else if (conn.head.length() > HTTP_MAX_HEAD_LEN) {
+          log_e("Request head longer than %d bytes", HTTP_MAX_HEAD_LEN);
+        } else {  // head not complete yet
+          if (millis() - conn.statusChange <= HTTP_MAX_DATA_WAIT) {
+            keepClient = true;
           }
           callYield = true;
         }
         break;
       case HC_WAIT_CLOSE:
-        if (_currentClient.isSSE()) {
+        if (conn.client.isSSE()) {
           // Never close connection
-          _statusChange = millis();
+          conn.statusChange = millis();
         }
         // Wait for client to close the connection
-        if (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT) {
-          keepCurrentClient = true;
+        if (millis() - conn.statusChange <= HTTP_MAX_CLOSE_WAIT) {
+          keepClient = true;
           callYield = true;
         }
     }
   }
 
-  if (!keepCurrentClient) {
-    _currentClient = NetworkClient();
-    _currentStatus = HC_NONE;
-    _currentUpload.reset();
-    _currentRaw.reset();
+  if (!keepClient) {
+    _dropConnection(conn);
   }
 
-  if (callYield) {
-    yield();
+  return callYield;
+}
+
+// Moves what has arrived of the request head into the slot without waiting
+// for more. Returns true once the empty line ending the head has been read;
+// the body, if any, is left in the client for _parseRequest().
+bool WebServer::_readHead(ClientConnection &conn) {
+  int avail = conn.client.available();
+  if (avail <= 0) {
+    return false;
   }
+  conn.statusChange = millis();
+  conn.head.reserve(std::min(conn.head.length() + (unsigned int)avail, (unsigned int)HTTP_MAX_HEAD_LEN + 1));
+  while (avail > 0 && conn.head.length() <= HTTP_MAX_HEAD_LEN) {
+    // with a peek buffer, take a line (or what has arrived of it) at a time
+    size_t buffered = conn.client.hasPeekBufferAPI() ? conn.client.peekAvailable() : 0;
+    int c;
+    if (buffered) {
+      const char *data = conn.client.peekBuffer();
+      const char *nl = (const char *)memchr(data, '\n', buffered);
+      size_t take = nl ? nl - data + 1 : buffered;
+      conn.head.concat(data, take);
+      conn.client.peekConsume(take);
+      avail -= take;
+      c = nl ? '\n' : 0;
+    } else {
+      c = conn.client.read();
+      if (c < 0) {
+        break;
+      }
+      conn.head += (char)c;
+      avail--;
+    }
+    if (c == '\n' && (conn.head.endsWith("\r\n\r\n") || conn.head.endsWith("\n\n"))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WebServer::_dropConnection(ClientConnection &conn) {
+  conn.client = NetworkClient();
+  conn.status = HC_NONE;
+  conn.head = String();
+}
+
+void WebServer::setMaxClients(uint8_t maxClients) {
+  if (maxClients < 1) {
+    maxClients = 1;
+  } else if (maxClients > WEBSERVER_MAX_CLIENTS) {
+    log_w("Max clients limited to %d", WEBSERVER_MAX_CLIENTS);
+    maxClients = WEBSERVER_MAX_CLIENTS;
+  }
+  for (uint8_t i = maxClients; i < _maxClients; i++) {
+    _dropConnection(_clients[i]);
+  }
+  _maxClients = maxClients;
+  _nextClient = 0;
 }
 
 void WebServer::close() {
   _server.close();
-  _currentStatus = HC_NONE;
+  for (uint8_t i = 0; i < WEBSERVER_MAX_CLIENTS; i++) {
+    _dropConnection(_clients[i]);
+  }
+  _currentClient = NetworkClient();
   if (!_headerKeysCount) {
     collectHeaders(0, 0);
   }
@@ -539,6 +657,7 @@ void WebServer::enableCrossOrigin(boolean value) {
 void WebServer::enableETag(bool enable, ETagFunction fn) {
   _eTagEnabled = enable;
   _eTagFunction = fn;
+  _eTagGeneration++;
 }
 
 void WebServer::_prepareHeader(String &response, int code, const char *content_type, size_t contentLength) {
@@ -692,6 +811,33 @@ void WebServer::_streamFileCore(const size_t fileSize, const String &fileName, c
   send(code, contentType, "");
 }
 
+size_t WebServer::_streamContent(Stream &stream, size_t length) {
+  size_t bufLen = std::min(length, (size_t)HTTP_STREAM_BUFLEN);
+  if (!bufLen) {
+    return 0;
+  }
+  char *buf = (char *)malloc(bufLen);
+  if (!buf) {
+    log_e("Not enough memory to stream %u bytes", length);
+    return 0;
+  }
+  size_t written = 0;
+  while (written < length) {
+    size_t toRead = std::min(length - written, bufLen);
+    size_t got = stream.readBytes(buf, toRead);
+    if (!got) {
+      break;
+    }
+    size_t sent = _currentClientWrite(buf, got);
+    written += sent;
+    if (sent != got) {
+      break;
+    }
+  }
+  free(buf);
+  return written;
+}
+
 String WebServer::pathArg(unsigned int i) const {
   if (_currentHandler != nullptr) {
     return _currentHandler->pathArg(i);
@@ -760,11 +906,14 @@ void WebServer::collectHeaders(const char *headerKeys[], const size_t headerKeys
 
   _headerKeysCount += headerKeysCount;
 
-  RequestArgument *last = _currentHeaders->next;
+  RequestArgument *last = _currentHeaders;
+  while (last->next) {
+    last = last->next;
+  }
 
-  for (int i = 2; i < _headerKeysCount; i++) {
+  for (size_t i = 0; i < headerKeysCount; i++) {
     last->next = new RequestArgument();
-    last->next->key = headerKeys[i - 2];
+    last->next->key = headerKeys[i];
     last = last->next;
   }
 }
@@ -915,7 +1064,10 @@ void WebServer::collectAllHeaders() {
   _currentHeaders->next = new RequestArgument();
   _currentHeaders->next->key = FPSTR(ETAG_HEADER);
 
-  _headerKeysCount = 2;
+  _currentHeaders->next->next = new RequestArgument();
+  _currentHeaders->next->next->key = FPSTR(ACCEPT_ENCODING_HEADER);
+
+  _headerKeysCount = 3;
   _collectAllHeaders = true;
 }
 
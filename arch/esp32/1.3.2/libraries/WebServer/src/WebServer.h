@@ -1,6 +1,6 @@
 /*
   WebServer.h - Dead simple web-server.
-  Supports only one simultaneous client, knows how to handle GET and POST.
+  Serves up to WEBSERVER_MAX_CLIENTS simultaneous clients, knows how to handle GET and POST.
 
   Copyright (c) 2014 Ivan Grokhotkov. All rights reserved.
 
@@ -63,12 +63,37 @@ enum HTTPAuthMethod {
 #define HTTP_RAW_BUFLEN 1436
 #endif
 
+// chunk size used by streamFile(), one full TCP send window per write
+#ifndef HTTP_STREAM_BUFLEN
+#ifdef CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+#define HTTP_STREAM_BUFLEN CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+#else
+#define HTTP_STREAM_BUFLEN (4 * HTTP_DOWNLOAD_UNIT_SIZE)
+#endif
+#endif
+
+#ifndef WEBSERVER_ETAG_CACHE_SIZE
+#define WEBSERVER_ETAG_CACHE_SIZE 16  // files per serveStatic() handler whose ETag is kept
+#endif
+
+#ifndef WEBSERVER_MAX_LINE_LENGTH
+#define WEBSERVER_MAX_LINE_LENGTH 2048  // longest request or header line, including the null terminator
+#endif
+
 #define HTTP_MAX_DATA_WAIT      5000  //ms to wait for the client to send the request
 #define HTTP_MAX_POST_WAIT      5000  //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT      5000  //ms to wait for data chunk to be ACKed
 #define HTTP_MAX_CLOSE_WAIT     5000  //ms to wait for the client to close the connection
 #define HTTP_MAX_BASIC_AUTH_LEN 256   // maximum length of a basic Auth base64 encoded username:password string
 
+#ifndef WEBSERVER_MAX_CLIENTS
+#define WEBSERVER_MAX_CLIENTS 4  // size of the connection table serviced by handleClient()
+#endif
+
+#ifndef HTTP_MAX_HEAD_LEN
+#define HTTP_MAX_HEAD_LEN 8192  // max size of the request line plus headers collected per connection
+#endif
+
 #define CONTENT_LENGTH_UNKNOWN ((size_t) - 1)
 #define CONTENT_LENGTH_NOT_SET ((size_t) - 2)
 
@@ -94,6 +119,7 @@ typedef struct {
 
 #include "middleware/Middleware.h"
 #include "detail/RequestHandler.h"
+#include "detail/RouteIndex.h"
 
 namespace fs {
 class FS;
@@ -112,6 +138,11 @@ public:
   virtual void close();
   void stop();
 
+  void setMaxClients(uint8_t maxClients);  // limit concurrent connections, 1..WEBSERVER_MAX_CLIENTS
+  uint8_t maxClients() const {
+    return _maxClients;
+  }
+
   const String AuthTypeDigest = F("Digest");
   const String AuthTypeBasic = F("Basic");
 
@@ -233,11 +264,12 @@ public:
 
   template<typename T> size_t streamFile(T &file, const String &contentType, const int code = 200) {
     _streamFileCore(file.size(), file.name(), contentType, code);
-    return _currentClient.write(file);
+    return _streamContent(file, file.size());
   }
 
   bool _eTagEnabled = false;
   ETagFunction _eTagFunction = nullptr;
+  uint32_t _eTagGeneration = 0;  // bumped by enableETag(), drops cached ETags
 
   static String responseCodeToString(int code);
 
@@ -248,20 +280,34 @@ protected:
   virtual size_t _currentClientWrite_P(PGM_P b, size_t l) {
     return _currentClient.write_P(b, l);
   }
+  struct ClientConnection {
+    NetworkClient client;
+    HTTPClientStatus status = HC_NONE;
+    unsigned long statusChange = 0;
+    String head;  // request line and headers received so far
+  };
+
   void _addRequestHandler(RequestHandler *handler);
   bool _removeRequestHandler(RequestHandler *handler);
+  void _rebuildRouteIndex();
+  RequestHandler *_findRequestHandler();
+  bool _handleConnection(ClientConnection &conn);
+  bool _readHead(ClientConnection &conn);
+  void _dropConnection(ClientConnection &conn);
   bool _handleRequest();
   void _finalizeResponse();
+  char *_readLine(size_t &length, bool &truncated);
+  bool _readHeader(const char *&headerName, const char *&headerValue);
   bool _parseRequest(NetworkClient &client);
   void _parseArguments(const String &data);
   bool _parseForm(NetworkClient &client, const String &boundary, uint32_t len);
   bool _parseFormUploadAborted();
-  void _uploadWriteByte(uint8_t b);
-  int _uploadReadByte(NetworkClient &client);
+  void _uploadWriteBytes(const uint8_t *data, size_t length);
   void _prepareHeader(String &response, int code, const char *content_type, size_t contentLength);
   bool _collectHeader(const char *headerName, const char *headerValue);
 
   void _streamFileCore(const size_t fileSize, const String &fileName, const String &contentType, const int code = 200);
+  size_t _streamContent(Stream &stream, size_t length);
 
   String _getRandomHexString();
   // for extracting Auth parameters
@@ -283,13 +329,19 @@ protected:
   HTTPMethod _currentMethod = HTTP_ANY;
   String _currentUri;
   uint8_t _currentVersion = 0;
-  HTTPClientStatus _currentStatus = HC_NONE;
-  unsigned long _statusChange = 0;
   boolean _nullDelay = true;
 
+  ClientConnection _clients[WEBSERVER_MAX_CLIENTS];
+  uint8_t _maxClients = WEBSERVER_MAX_CLIENTS;
+  uint8_t _nextClient = 0;  // slot serviced first on the next handleClient() pass
+  String _currentHead;       // complete head of the request being parsed
+  unsigned int _headPos = 0;
+
   RequestHandler *_currentHandler = nullptr;
   RequestHandler *_firstHandler = nullptr;
   RequestHandler *_lastHandler = nullptr;
+  RouteIndex _routeIndex;
+  std::vector<RequestHandler *> _routeCandidates;
   THandlerFunction _notFoundHandler = nullptr;
   THandlerFunction _fileUploadHandler = nullptr;
 
@@ -300,6 +352,7 @@ protected:
 
   std::unique_ptr<HTTPUpload> _currentUpload;
   std::unique_ptr<HTTPRaw> _currentRaw;
+  std::unique_ptr<char[]> _lineBuf;  // request and header lines, allocated on first use
 
   int _headerKeysCount = 0;
   RequestArgument *_currentHeaders = nullptr;
@@ -65,6 +65,18 @@ public:
     (void)raw;
   }
 
+  /*
+    note: route hints for WebServer's route index, handlers without a
+    routeUri() are asked canHandle() for every request
+  */
+
+  virtual const Uri *routeUri() const {
+    return nullptr;
+  }
+  virtual HTTPMethod routeMethod() const {
+    return HTTP_ANY;
+  }
+
   virtual RequestHandler &setFilter(std::function<bool(WebServer &)> filter) {
     (void)filter;
     return *this;
@@ -125,6 +125,14 @@ public:
     }
   }
 
+  const Uri *routeUri() const override {
+    return _uri;
+  }
+
+  HTTPMethod routeMethod() const override {
+    return _method;
+  }
+
   FunctionRequestHandler &setFilter(WebServer::FilterFunction filter) {
     _filter = filter;
     return *this;
@@ -204,10 +212,15 @@ public:
 
     // look for gz file, only if the original specified path is not a gz.  So part only works to send gzip via content encoding when a non compressed is asked for
     // if you point the the path to gzip you will serve the gzip as content type "application/x-gzip", not text or javascript etc...
-    if (!path.endsWith(FPSTR(mimeTable[gz].endsWith)) && !_fs.exists(path)) {
+    // A precompressed sibling is preferred over the original whenever the client accepts gzip.
+    bool hasGz = false;
+    if (!path.endsWith(FPSTR(mimeTable[gz].endsWith))) {
       String pathWithGz = path + FPSTR(mimeTable[gz].endsWith);
       if (_fs.exists(pathWithGz)) {
-        path += FPSTR(mimeTable[gz].endsWith);
+        hasGz = true;
+        if (acceptsGzip(server.header("Accept-Encoding")) || !_fs.exists(path)) {
+          path = pathWithGz;
+        }
       }
     }
 
@@ -216,14 +229,16 @@ public:
       return false;
     }
 
+    // the response depends on Accept-Encoding whenever there is a choice, so
+    // caches must not hand the plain file to a client that asked for gzip
+    if (hasGz) {
+      server.sendHeader("Vary", "Accept-Encoding");
+    }
+
     String eTagCode;
 
     if (server._eTagEnabled) {
-      if (server._eTagFunction) {
-        eTagCode = (server._eTagFunction)(_fs, path);
-      } else {
-        eTagCode = calcETag(_fs, path);
-      }
+      eTagCode = _cachedETag(server, f, path);
 
       if (server.header("If-None-Match") == eTagCode) {
         server.send(304);
@@ -258,6 +273,43 @@ public:
     return String(buff);
   }
 
+  // true when an Accept-Encoding value allows gzip: "gzip" (or "*") listed
+  // without "q=0", so "gzip, deflate" does and "gzip;q=0, deflate" does not
+  static bool acceptsGzip(const String &acceptEncoding) {
+    int wildcard = -1;
+    int start = 0;
+    int length = acceptEncoding.length();
+    while (start < length) {
+      int end = acceptEncoding.indexOf(',', start);
+      if (end < 0) {
+        end = length;
+      }
+      String coding = acceptEncoding.substring(start, end);
+      start = end + 1;
+
+      bool accepted = true;
+      int params = coding.indexOf(';');
+      if (params >= 0) {
+        String q = coding.substring(params + 1);
+        coding.remove(params);
+        q.trim();
+        q.toLowerCase();
+        if (q.startsWith("q=")) {
+          accepted = q.substring(2).toFloat() > 0;
+        }
+      }
+      coding.trim();
+
+      if (coding.equalsIgnoreCase("gzip") || coding.equalsIgnoreCase("x-gzip")) {
+        return accepted;
+      }
+      if (coding == "*") {
+        wildcard = accepted;
+      }
+    }
+    return wildcard == 1;
+  }
+
   // calculate an ETag for a file in filesystem based on md5 checksum
   // that can be used in the http headers - include quotes.
   static String calcETag(FS &fs, const String &path) {
@@ -283,6 +335,68 @@ public:
   }
 
 protected:
+  // ETags are computed once per file and reused until its size or modification
+  // time changes. Files without a modification time (SPIFFS reports 0) are
+  // never cached, as a rewrite of the same size would keep a stale ETag.
+  struct ETagCacheEntry {
+    String path;
+    size_t size;
+    time_t lastWrite;
+    String eTag;
+  };
+
+  String _cachedETag(WebServer &server, File &f, const String &path) {
+    size_t size = f.size();
+    time_t lastWrite = f.getLastWrite();
+
+    if (lastWrite == 0) {
+      return _computeETag(server, path);
+    }
+    if (_eTagGeneration != server._eTagGeneration) {
+      // enableETag() installed another function, drop what the old one made
+      _eTagCache.clear();
+      _eTagCacheNext = 0;
+      _eTagGeneration = server._eTagGeneration;
+    }
+
+    ETagCacheEntry *entry = nullptr;
+    for (ETagCacheEntry &e : _eTagCache) {
+      if (e.path == path) {
+        if (e.size == size && e.lastWrite == lastWrite) {
+          return e.eTag;
+        }
+        entry = &e;
+        break;
+      }
+    }
+    if (!entry) {
+      if (_eTagCache.size() < WEBSERVER_ETAG_CACHE_SIZE) {
+        _eTagCache.push_back(ETagCacheEntry());
+        entry = &_eTagCache.back();
+      } else {
+        entry = &_eTagCache[_eTagCacheNext];
+        _eTagCacheNext = (_eTagCacheNext + 1) % WEBSERVER_ETAG_CACHE_SIZE;
+      }
+      entry->path = path;
+    }
+
+    entry->size = size;
+    entry->lastWrite = lastWrite;
+    entry->eTag = _computeETag(server, path);
+    return entry->eTag;
+  }
+
+  String _computeETag(WebServer &server, const String &path) {
+    if (server._eTagFunction) {
+      return (server._eTagFunction)(_fs, path);
+    }
+    return calcETag(_fs, path);
+  }
+
+  std::vector<ETagCacheEntry> _eTagCache;
+  size_t _eTagCacheNext = 0;
+  uint32_t _eTagGeneration = 0;
+
   // _filter should return 'true' when the request should be handled
   // and 'false' when the request should be ignored
   WebServer::FilterFunction _filter;
@@ -0,0 +1,205 @@
+#include <Arduino.h>
+#include <algorithm>
+#include "WebServer.h"
+#include "RouteIndex.h"
+
+// FNV-1a, only used to order and find the static children of a node
+static uint32_t segmentHash(const char *segment, size_t length) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)segment[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+static size_t segmentLength(const char *segment, const char *end) {
+  const char *slash = (const char *)memchr(segment, '/', end - segment);
+  return slash ? slash - segment : end - segment;
+}
+
+static bool hasGlobChars(const char *segment, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    char c = segment[i];
+    if (c == '*' || c == '?' || c == '[' || c == '\\') {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool hasBraces(const char *segment, size_t length) {
+  return memchr(segment, '{', length) != nullptr;
+}
+
+// UriBraces can only be indexed when every "{}" captures a whole segment tail,
+// i.e. it is followed by '/' or ends the pattern. Otherwise the capture may
+// span several segments and the route has to go to the fallback list.
+static bool bracesAreSegmentAligned(const String &pattern) {
+  const char *p = pattern.c_str();
+  for (size_t i = 0; i < pattern.length(); i++) {
+    if (p[i] != '{') {
+      continue;
+    }
+    if (p[i + 1] != '}' || (p[i + 2] != '/' && p[i + 2] != '\0')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RouteIndex::Node::~Node() {
+  for (Edge &edge : children) {
+    delete edge.node;
+  }
+  delete wildcard;
+}
+
+RouteIndex::~RouteIndex() {
+  clear();
+}
+
+void RouteIndex::clear() {
+  for (Root *root : _roots) {
+    delete root;
+  }
+  _roots.clear();
+  _fallback.clear();
+  _matches.clear();
+  _seq = 0;
+}
+
+RouteIndex::Node *RouteIndex::_root(HTTPMethod method, bool create) {
+  for (Root *root : _roots) {
+    if (root->method == method) {
+      return &root->node;
+    }
+  }
+  if (!create) {
+    return nullptr;
+  }
+  Root *root = new Root();
+  root->method = method;
+  _roots.push_back(root);
+  return &root->node;
+}
+
+RouteIndex::Node *RouteIndex::_child(Node *node, const char *segment, size_t length) {
+  uint32_t hash = segmentHash(segment, length);
+  auto it = std::lower_bound(node->children.begin(), node->children.end(), hash, [](const Edge &edge, uint32_t h) {
+    return edge.hash < h;
+  });
+  for (; it != node->children.end() && it->hash == hash; ++it) {
+    if (it->segment.length() == length && memcmp(it->segment.c_str(), segment, length) == 0) {
+      return it->node;
+    }
+  }
+  Edge edge;
+  edge.hash = hash;
+  edge.segment.concat(segment, length);
+  edge.node = new Node();
+  node->children.insert(it, edge);
+  return edge.node;
+}
+
+const RouteIndex::Node *RouteIndex::_findChild(const Node *node, const char *segment, size_t length) const {
+  if (node->children.empty()) {
+    return nullptr;
+  }
+  uint32_t hash = segmentHash(segment, length);
+  auto it = std::lower_bound(node->children.begin(), node->children.end(), hash, [](const Edge &edge, uint32_t h) {
+    return edge.hash < h;
+  });
+  for (; it != node->children.end() && it->hash == hash; ++it) {
+    if (it->segment.length() == length && memcmp(it->segment.c_str(), segment, length) == 0) {
+      return it->node;
+    }
+  }
+  return nullptr;
+}
+
+void RouteIndex::add(RequestHandler *handler) {
+  Entry entry = {_seq++, handler};
+
+  const Uri *uri = handler->routeUri();
+  Uri::RouteType type = uri ? uri->routeType() : Uri::ROUTE_OTHER;
+  if (type == Uri::ROUTE_BRACES && !bracesAreSegmentAligned(uri->pattern())) {
+    type = Uri::ROUTE_OTHER;
+  }
+  if (type == Uri::ROUTE_OTHER) {
+    _fallback.push_back(entry);
+    return;
+  }
+
+  const String &pattern = uri->pattern();
+  const char *p = pattern.c_str();
+  const char *end = p + pattern.length();
+  Node *node = _root(handler->routeMethod(), true);
+  while (true) {
+    size_t length = segmentLength(p, end);
+    if (type == Uri::ROUTE_GLOB && hasGlobChars(p, length)) {
+      // fnmatch() lets '*' cross '/', so the rest of the pattern is checked by canHandle()
+      node->globs.push_back(entry);
+      return;
+    }
+    if (type == Uri::ROUTE_BRACES && hasBraces(p, length)) {
+      if (!node->wildcard) {
+        node->wildcard = new Node();
+      }
+      node = node->wildcard;
+    } else {
+      node = _child(node, p, length);
+    }
+    p += length;
+    if (p >= end) {
+      break;
+    }
+    p++;  // skip '/'
+  }
+  node->routes.push_back(entry);
+}
+
+void RouteIndex::_collect(const Node *node, const String &uri, size_t pos) {
+  _matches.insert(_matches.end(), node->globs.begin(), node->globs.end());
+  if (pos > uri.length()) {
+    // every segment consumed
+    _matches.insert(_matches.end(), node->routes.begin(), node->routes.end());
+    return;
+  }
+
+  const char *segment = uri.c_str() + pos;
+  size_t length = segmentLength(segment, uri.c_str() + uri.length());
+  size_t next = pos + length + 1;
+
+  const Node *child = _findChild(node, segment, length);
+  if (child) {
+    _collect(child, uri, next);
+  }
+  if (node->wildcard) {
+    _collect(node->wildcard, uri, next);
+  }
+}
+
+void RouteIndex::lookup(HTTPMethod method, const String &uri, std::vector<RequestHandler *> &candidates) {
+  _matches.clear();
+  candidates.clear();
+
+  const Node *root = _root(method, false);
+  if (root) {
+    _collect(root, uri, 0);
+  }
+  if (method != HTTP_ANY) {
+    root = _root(HTTP_ANY, false);
+    if (root) {
+      _collect(root, uri, 0);
+    }
+  }
+  _matches.insert(_matches.end(), _fallback.begin(), _fallback.end());
+
+  std::sort(_matches.begin(), _matches.end(), [](const Entry &a, const Entry &b) {
+    return a.seq < b.seq;
+  });
+  for (const Entry &entry : _matches) {
+    candidates.push_back(entry.handler);
+  }
+}
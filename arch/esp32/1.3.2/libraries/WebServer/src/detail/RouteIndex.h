@@ -0,0 +1,69 @@
+#ifndef ROUTEINDEX_H
+#define ROUTEINDEX_H
+
+#include <vector>
+#include "WString.h"
+#include "HTTP_Method.h"
+
+class RequestHandler;
+
+// Narrows down the handlers WebServer has to ask canHandle() for a request.
+// Routes are compiled at registration into a trie of path segments per HTTP
+// method: static segments are looked up by hash, "{}" segments of UriBraces
+// become wildcard edges, UriGlob routes hang off the node of their literal
+// prefix and everything else (UriRegex, static file and custom handlers) is
+// kept in a fallback list. Candidates are returned in registration order, so
+// the first handler that accepts the request still wins.
+class RouteIndex {
+public:
+  RouteIndex() {}
+  ~RouteIndex();
+
+  void add(RequestHandler *handler);
+  void clear();
+
+  // fill candidates with the handlers that may accept method + uri
+  void lookup(HTTPMethod method, const String &uri, std::vector<RequestHandler *> &candidates);
+
+private:
+  RouteIndex(const RouteIndex &) = delete;
+  RouteIndex &operator=(const RouteIndex &) = delete;
+
+  struct Entry {
+    uint32_t seq;
+    RequestHandler *handler;
+  };
+
+  struct Node;
+
+  struct Edge {
+    uint32_t hash;
+    String segment;
+    Node *node;
+  };
+
+  struct Node {
+    std::vector<Edge> children;  // static segments, sorted by hash
+    Node *wildcard = nullptr;    // "{}" segment
+    std::vector<Entry> routes;   // routes ending at this node
+    std::vector<Entry> globs;    // UriGlob routes whose literal prefix ends here
+    ~Node();
+  };
+
+  struct Root {
+    HTTPMethod method;
+    Node node;
+  };
+
+  Node *_root(HTTPMethod method, bool create);
+  Node *_child(Node *node, const char *segment, size_t length);
+  const Node *_findChild(const Node *node, const char *segment, size_t length) const;
+  void _collect(const Node *node, const String &uri, size_t pos);
+
+  std::vector<Root *> _roots;
+  std::vector<Entry> _fallback;
+  std::vector<Entry> _matches;  // scratch buffer reused by lookup()
+  uint32_t _seq = 0;
+};
+
+#endif  //ROUTEINDEX_H
@@ -13,6 +13,10 @@ public:
     return new UriBraces(_uri);
   };
 
+  RouteType routeType() const override final {
+    return ROUTE_BRACES;
+  }
+
   void initPathArgs(std::vector<String> &pathArgs) override final {
     int numParams = 0, start = 0;
     do {
@@ -14,6 +14,10 @@ public:
     return new UriGlob(_uri);
   };
 
+  RouteType routeType() const override final {
+    return ROUTE_GLOB;
+  }
+
   bool canHandle(const String &requestUri, __attribute__((unused)) std::vector<String> &pathArgs) override final {
     return fnmatch(_uri.c_str(), requestUri.c_str(), 0) == 0;
   }
@@ -3,6 +3,7 @@
 
 #include "Uri.h"
 #include <regex>
+#include <memory>
 
 class UriRegex : public Uri {
 
@@ -14,6 +15,10 @@ public:
     return new UriRegex(_uri);
   };
 
+  RouteType routeType() const override final {
+    return ROUTE_OTHER;
+  }
+
   void initPathArgs(std::vector<String> &pathArgs) override final {
     std::regex rgx((_uri + "|").c_str());
     std::smatch matches;
@@ -27,11 +32,15 @@ public:
       return true;
     }
 
+    // compile once, the pattern never changes after construction
+    if (!_rgx) {
+      _rgx.reset(new std::regex(_uri.c_str()));
+    }
+
     unsigned int pathArgIndex = 0;
-    std::regex rgx(_uri.c_str());
     std::smatch matches;
     std::string s(requestUri.c_str());
-    if (std::regex_search(s, matches, rgx)) {
+    if (std::regex_search(s, matches, *_rgx)) {
       for (size_t i = 1; i < matches.size(); ++i) {  // skip first
         pathArgs[pathArgIndex] = String(matches[i].str().c_str());
         pathArgIndex++;
@@ -40,6 +49,9 @@ public:
     }
     return false;
   }
+
+private:
+  std::unique_ptr<std::regex> _rgx;
 };
 
 #endif
@@ -0,0 +1,193 @@
+// AsyncUDP::sendBatch() against a loopback stand-in for lwIP's output: what
+// each destination receives, per-item errors, a pbuf the stack keeps a
+// reference to, then datagrams/s and pbuf allocations against a writeTo()
+// loop, both through a tcpip thread.
+#include <Arduino.h>
+#include "AsyncUDP.h"
+#include "host_lwip.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+using namespace std::chrono;
+
+// loopback: every datagram that left, as the destination got it
+struct Datagram {
+  std::string data;
+  uint32_t addr;
+  uint16_t port;
+};
+static std::vector<Datagram> sent;
+static bool record = true;
+static long sentCount = 0;
+static uint32_t checksum = 0;
+
+// the pbufs the "stack" still holds, with the payload each carried when sent
+static std::vector<std::pair<pbuf *, const void *>> held;
+
+static err_t output(udp_pcb *, pbuf *p, const ip_addr_t *dst, u16_t port) {
+  const uint8_t *data = (const uint8_t *)p->payload;
+  sentCount++;
+  checksum = checksum * 31 + data[p->len - 1] + dst->addr + port;
+  if (record) {
+    sent.push_back({std::string((const char *)data, p->len), dst->addr, port});
+  }
+  return ERR_OK;
+}
+
+static std::vector<AsyncUDPBatchItem> destinations(int count, const uint8_t *data = NULL, size_t len = 0) {
+  std::vector<AsyncUDPBatchItem> items(count);
+  for (int i = 0; i < count; i++) {
+    items[i].to(IPAddress(10, 0, 0, i + 1), 4000 + i);
+    items[i].data = data;
+    items[i].len = len;
+    items[i].err = ERR_VAL;
+  }
+  return items;
+}
+
+static void test_send() {
+  AsyncUDP udp;
+  const char *payloads[] = {"first", "second datagram", "3"};
+  std::vector<AsyncUDPBatchItem> items = destinations(3);
+  for (int i = 0; i < 3; i++) {
+    items[i].data = (const uint8_t *)payloads[i];
+    items[i].len = strlen(payloads[i]);
+  }
+  sent.clear();
+  long allocs = hostPbufAllocs;
+  CHECK(udp.sendBatch(items.data(), items.size()) == 3);
+  CHECK(sent.size() == 3 && udp.lastErr() == ERR_OK);
+  for (int i = 0; i < 3 && i < (int)sent.size(); i++) {
+    CHECK(sent[i].data == payloads[i] && IPAddress(sent[i].addr) == IPAddress(10, 0, 0, i + 1) && sent[i].port == 4000 + i);
+    CHECK(items[i].err == ERR_OK);
+  }
+  // one pbuf re-pointed at each payload
+  CHECK(hostPbufAllocs - allocs == 1);
+
+  // one payload for every destination, longer than a segment
+  std::vector<uint8_t> big(CONFIG_TCP_MSS + 100, 'x');
+  items = destinations(4);
+  sent.clear();
+  CHECK(udp.sendBatch(big.data(), big.size(), items.data(), items.size()) == 4);
+  CHECK(sent.size() == 4);
+  for (Datagram &d : sent) {
+    CHECK(d.data == std::string(CONFIG_TCP_MSS, 'x'));
+  }
+  CHECK(udp.sendBatch(items.data(), 0) == 0 && udp.sendBatch(NULL, 4) == 0);
+  CHECK(hostPbufsAlive == 0);
+}
+
+static void test_errors() {
+  AsyncUDP udp;
+  uint8_t data[] = "payload";
+  std::vector<AsyncUDPBatchItem> items = destinations(5, data, sizeof(data));
+  // the route to 10.0.0.3 fails, the rest still go out
+  hostUdpOutput = [](udp_pcb *pcb, pbuf *p, const ip_addr_t *dst, u16_t port) {
+    return IPAddress(dst->addr) == IPAddress(10, 0, 0, 3) ? (err_t)ERR_VAL : output(pcb, p, dst, port);
+  };
+  sent.clear();
+  CHECK(udp.sendBatch(items.data(), items.size()) == 4);
+  CHECK(sent.size() == 4 && udp.lastErr() == ERR_VAL);
+  for (int i = 0; i < 5; i++) {
+    CHECK(items[i].err == (i == 2 ? ERR_VAL : ERR_OK));
+  }
+  hostUdpOutput = output;
+  CHECK(hostPbufsAlive == 0);
+}
+
+static void test_held_pbuf() {
+  // the stack keeps the 2nd and 3rd datagrams' pbufs (say, queued for ARP):
+  // they must not be re-pointed at a later payload
+  AsyncUDP udp;
+  const char *payloads[] = {"aaaa", "bbbb", "cccc", "dddd", "eeee"};
+  std::vector<AsyncUDPBatchItem> items = destinations(5);
+  for (int i = 0; i < 5; i++) {
+    items[i].data = (const uint8_t *)payloads[i];
+    items[i].len = 4;
+  }
+  hostUdpOutput = [](udp_pcb *pcb, pbuf *p, const ip_addr_t *dst, u16_t port) {
+    if (port == 4001 || port == 4002) {
+      pbuf_ref(p);
+      held.push_back({p, p->payload});
+    }
+    return output(pcb, p, dst, port);
+  };
+  long allocs = hostPbufAllocs;
+  CHECK(udp.sendBatch(items.data(), items.size()) == 5);
+  CHECK(held.size() == 2 && hostPbufAllocs - allocs == 3);
+  for (auto &h : held) {
+    CHECK(h.first->payload == h.second && h.first->len == 4);
+  }
+  CHECK(held.size() == 2 && held[0].first != held[1].first);
+  for (auto &h : held) {
+    pbuf_free(h.first);
+  }
+  held.clear();
+  hostUdpOutput = output;
+  CHECK(hostPbufsAlive == 0);
+}
+
+static void test_throughput() {
+  const int peers = 64, rounds = 2000;
+  uint8_t payload[200];
+  for (int i = 0; i < 200; i++) {
+    payload[i] = i;
+  }
+  std::vector<AsyncUDPBatchItem> items = destinations(peers, payload, sizeof(payload));
+  AsyncUDP udp;
+  record = false;
+
+  sentCount = checksum = 0;
+  long allocs = hostPbufAllocs;
+  auto t0 = steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (AsyncUDPBatchItem &item : items) {
+      udp.writeTo(payload, sizeof(payload), &item.addr, item.port);
+    }
+  }
+  double loopRate = sentCount / duration<double>(steady_clock::now() - t0).count();
+  long loopAllocs = hostPbufAllocs - allocs;
+  uint32_t loopChecksum = checksum;
+  CHECK(sentCount == peers * rounds);
+
+  sentCount = checksum = 0;
+  allocs = hostPbufAllocs;
+  t0 = steady_clock::now();
+  size_t returned = 0;
+  for (int r = 0; r < rounds; r++) {
+    returned += r & 1 ? udp.sendBatch(items.data(), peers) : udp.sendBatch(payload, sizeof(payload), items.data(), peers);
+  }
+  double batchRate = sentCount / duration<double>(steady_clock::now() - t0).count();
+  long batchAllocs = hostPbufAllocs - allocs;
+  CHECK(sentCount == peers * rounds && returned == (size_t)sentCount);
+  CHECK(checksum == loopChecksum);
+  CHECK(loopAllocs == peers * rounds && batchAllocs == rounds);
+  CHECK(batchRate > loopRate * 2);
+  CHECK(hostPbufsAlive == 0);
+  record = true;
+  printf(
+    "%d peers x %d rounds of 200 bytes: writeTo loop %.0fk datagrams/s, %ld pbufs; sendBatch %.0fk datagrams/s, %ld pbufs\n", peers, rounds,
+    loopRate / 1000, loopAllocs, batchRate / 1000, batchAllocs
+  );
+}
+
+int main() {
+  hostUdpOutput = output;
+  test_send();
+  test_errors();
+  test_held_pbuf();
+  test_throughput();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+// The queue between the lwIP thread and the async_udp task: what a packet
+// looks like once delivered, then bursts into slow handlers, where the lwIP
+// side must drop and count instead of waiting, and the task must hand the
+// backlog over in batches of at most ASYNC_UDP_BATCH_SIZE.
+#include <Arduino.h>
+#include "AsyncUDP.h"
+#include "host_lwip.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+using namespace std::chrono;
+
+static ip_addr_t address(const char *ip) {
+  ip_addr_t addr;
+  IPAddress(ip).to_ip_addr_t(&addr);
+  return addr;
+}
+
+// waits up to a second for `done`
+template<class F> static bool eventually(F done) {
+  for (int i = 0; i < 1000 && !done(); i++) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  return done();
+}
+
+static void test_delivery() {
+  AsyncUDP udp;
+  CHECK(udp.listen(4210));
+  udp_pcb *pcb = hostUdpFind(4210);
+  CHECK(pcb != NULL);
+
+  std::atomic<int> received{0};
+  udp.onPacket([&](AsyncUDPPacket &packet) {
+    int i = received;
+    char expected[16];
+    snprintf(expected, sizeof(expected), "packet %d", i);
+    CHECK(packet.length() == strlen(expected) && memcmp(packet.data(), expected, packet.length()) == 0);
+    CHECK(packet.remoteIP() == IPAddress(192, 168, 4, 2 + i % 2) && packet.remotePort() == 5000 + i);
+    CHECK(packet.localPort() == 4210 && !packet.isBroadcast() && !packet.isMulticast());
+    uint8_t mac[6];
+    packet.remoteMac(mac);
+    CHECK(mac[0] == 0x02 && mac[5] == 0x02);
+    received++;
+  });
+
+  ip_addr_t src[] = {address("192.168.4.2"), address("192.168.4.3")};
+  for (int i = 0; i < 20; i++) {
+    char data[16];
+    snprintf(data, sizeof(data), "packet %d", i);
+    hostUdpInput(pcb, data, strlen(data), &src[i % 2], 5000 + i);
+    // one at a time, so nothing is dropped
+    CHECK(eventually([&] {
+      return received == i + 1;
+    }));
+  }
+  CHECK(udp.droppedPackets() == 0);
+  CHECK(eventually([] {
+    return hostPbufsAlive == 0;
+  }));
+}
+
+// `count` datagrams from a thread standing in for lwIP, as fast as it can
+// post them, returns the longest a single post took in us
+static double burst(udp_pcb *pcb, int count, int first = 0, udp_pcb *other = NULL) {
+  double worst = 0;
+  std::thread lwip([&] {
+    ip_addr_t src = address("10.0.0.7");
+    for (int i = first; i < first + count; i++) {
+      auto t0 = steady_clock::now();
+      hostUdpInput(other && i % 2 ? other : pcb, &i, sizeof(i), &src, 6000);
+      worst = std::max(worst, duration<double, std::micro>(steady_clock::now() - t0).count());
+    }
+  });
+  lwip.join();
+  return worst;
+}
+
+static void test_slow_handler() {
+  AsyncUDP udp;
+  CHECK(udp.listen(4211));
+  udp_pcb *pcb = hostUdpFind(4211);
+
+  // 20 ms per batch: far slower than the packets arrive
+  std::vector<int> sequence;
+  std::vector<size_t> batches;
+  std::atomic<int> received{0};
+  udp.onPackets([&](AsyncUDPPacket **packets, size_t count) {
+    batches.push_back(count);
+    for (size_t i = 0; i < count; i++) {
+      int n;
+      CHECK(packets[i]->read((uint8_t *)&n, sizeof(n)) == sizeof(n));
+      sequence.push_back(n);
+    }
+    std::this_thread::sleep_for(milliseconds(20));
+    received += count;
+  });
+
+  const int sent = 2000;
+  double worst = burst(pcb, sent);
+  CHECK(eventually([&] {
+    return received + udp.droppedPackets() == sent;
+  }));
+  CHECK(udp.droppedPackets() > 0);
+  // the lwIP thread never waited for the handler
+  CHECK(worst < 10000);
+
+  size_t largest = 0;
+  for (size_t n : batches) {
+    largest = std::max(largest, n);
+  }
+  double average = (double)received / batches.size();
+  CHECK(largest <= ASYNC_UDP_BATCH_SIZE);
+  CHECK(average > 1);
+  // whatever got through kept its order
+  CHECK(std::is_sorted(sequence.begin(), sequence.end()) && std::adjacent_find(sequence.begin(), sequence.end()) == sequence.end());
+  CHECK(eventually([] {
+    return hostPbufsAlive == 0;
+  }));
+  printf(
+    "%d packets into a 20 ms/batch handler: %d delivered in batches of %.1f (max %zu), %u dropped, slowest post %.0f us\n", sent, received.load(), average,
+    largest, udp.droppedPackets(), worst
+  );
+
+  // once the backlog is gone the same socket takes packets again without loss
+  uint32_t dropped = udp.droppedPackets();
+  received = 0;
+  sequence.clear();
+  int i = 100000;
+  ip_addr_t src = address("10.0.0.7");
+  hostUdpInput(pcb, &i, sizeof(i), &src, 6000);
+  CHECK(eventually([&] {
+    return received == 1;
+  }));
+  CHECK(udp.droppedPackets() == dropped && sequence.size() == 1 && sequence[0] == 100000);
+}
+
+static void test_two_sockets() {
+  // packets for two sockets interleaved on the queue: each batch belongs to
+  // one socket, each socket counts its own drops
+  AsyncUDP a, b;
+  CHECK(a.listen(4212) && b.listen(4213));
+  std::atomic<int> receivedA{0}, receivedB{0};
+  auto handler = [](std::atomic<int> &received, uint16_t port) {
+    return [&received, port](AsyncUDPPacket **packets, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        CHECK(packets[i]->localPort() == port);
+      }
+      std::this_thread::sleep_for(milliseconds(1));
+      received += count;
+    };
+  };
+  a.onPackets(handler(receivedA, 4212));
+  b.onPackets(handler(receivedB, 4213));
+
+  const int sent = 1000;
+  burst(hostUdpFind(4212), sent, 0, hostUdpFind(4213));
+  CHECK(eventually([&] {
+    return receivedA + a.droppedPackets() == sent / 2 && receivedB + b.droppedPackets() == sent / 2;
+  }));
+  CHECK(a.droppedPackets() + b.droppedPackets() > 0);
+  CHECK(eventually([] {
+    return hostPbufsAlive == 0;
+  }));
+}
+
+int main() {
+  test_delivery();
+  test_slow_handler();
+  test_two_sockets();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
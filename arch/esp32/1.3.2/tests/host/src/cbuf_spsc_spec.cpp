@@ -0,0 +1,138 @@
+// cbuf and cbuf_spsc: the byte-level API, then a writer and a reader thread
+// pushing a known sequence through each buffer with uneven block sizes, then
+// the NetworkUdp pattern of filling one datagram and reading it bytewise.
+// Build with `make tsan` to run the same threads under ThreadSanitizer.
+#include "cbuf.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+static void test_cbuf() {
+  cbuf b(10);
+  CHECK(b.write("\xff\x80hello", 7) == 7);
+  CHECK(b.peek() == 0xff);
+  CHECK(b.read() == 0xff);
+  CHECK(b.read() == 0x80);
+  CHECK(b.write("0123", 4) == 4);
+  CHECK(b.available() == 9);
+  CHECK(b.resize(20) == 20);
+  char out[16] = {0};
+  CHECK(b.read(out, sizeof(out)) == 9 && memcmp(out, "hello0123", 9) == 0);
+  CHECK(b.read() == -1);
+  b.write("abcdef", 6);
+  CHECK(b.remove(2) == 4);
+  CHECK(b.read() == 'c');
+}
+
+static void test_cbuf_spsc() {
+  cbuf_spsc b(100);
+  CHECK(b.size() == 128);
+  CHECK(b.write("\xfe", 1) == 1);
+  CHECK(b.peek() == 0xfe);
+  CHECK(b.read() == 0xfe);
+  // wraps around the end of the storage many times
+  for (int i = 0; i < 1000; i++) {
+    char block[50];
+    memset(block, i, sizeof(block));
+    CHECK(b.write(block, sizeof(block)) == sizeof(block));
+    CHECK(b.read(block, sizeof(block)) == sizeof(block) && block[49] == (char)i);
+  }
+  char big[200] = {0};
+  CHECK(b.write(big, sizeof(big)) == 128 && b.full());
+  CHECK(b.remove(28) == 100);
+  CHECK(b.read(NULL, 500) == 100 && b.empty());
+}
+
+// byte n of the stream is (char)(n * 7), written and read in varying blocks
+template<class Buffer> static void stress(const char *name, size_t total) {
+  Buffer b(1024);
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread writer([&] {
+    char block[300];
+    size_t n = 0;
+    while (n < total) {
+      size_t k = std::min<size_t>(1 + n % 287, total - n);
+      for (size_t i = 0; i < k; i++) {
+        block[i] = (char)((n + i) * 7);
+      }
+      size_t written = 0;
+      while (written < k) {
+        size_t w = b.write(block + written, k - written);
+        if (!w) {
+          std::this_thread::yield();  // full
+        }
+        written += w;
+      }
+      n += k;
+    }
+  });
+
+  bool ok = true;
+  size_t n = 0;
+  char block[200];
+  while (n < total) {
+    if (n % 5 == 0) {
+      int c = b.read();
+      if (c < 0) {
+        std::this_thread::yield();  // empty
+        continue;
+      }
+      ok &= c == (uint8_t)(n * 7);
+      n++;
+      continue;
+    }
+    size_t r = b.read(block, 1 + n % 199);
+    if (!r) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < r; i++) {
+      ok &= block[i] == (char)((n + i) * 7);
+    }
+    n += r;
+  }
+  writer.join();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  CHECK(ok);
+  printf("%-10s two threads: %s, %.1f MB/s\n", name, ok ? "in order" : "CORRUPT", total / s / 1e6);
+}
+
+template<class Buffer> static void bench_datagram(const char *name) {
+  const int rounds = 20000;
+  char datagram[1460] = {1};
+  unsigned sum = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    Buffer *b = new Buffer(sizeof(datagram));
+    b->write(datagram, sizeof(datagram));
+    int c;
+    while ((c = b->read()) >= 0) {
+      sum += c;
+    }
+    delete b;
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  CHECK(sum == rounds);
+  printf("%-10s datagram read bytewise: %.1f ns/byte\n", name, ns / (rounds * sizeof(datagram)));
+}
+
+int main() {
+  test_cbuf();
+  test_cbuf_spsc();
+  stress<cbuf>("cbuf", 20000000);
+  stress<cbuf_spsc>("cbuf_spsc", 20000000);
+  bench_datagram<cbuf>("cbuf");
+  bench_datagram<cbuf_spsc>("cbuf_spsc");
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
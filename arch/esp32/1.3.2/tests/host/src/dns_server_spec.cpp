@@ -0,0 +1,280 @@
+// DNSServer answering recorded queries through AsyncUDP and the lwIP
+// stand-in: which names match the served domain (case, a leading www label),
+// malformed questions that get no answer, replies served from the answer
+// cache, then queries/s for a stream of captive portal probes.
+#include <Arduino.h>
+#include "DNSServer.h"
+#include "host_lwip.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+using namespace std::chrono;
+typedef std::string Bytes;
+
+#define HEADER(id, flags, qdcount) id "\x01" flags "\x00" qdcount "\x00\x00\x00\x00\x00\x00"
+#define TYPE_A_CLASS_IN            "\x00\x01\x00\x01"
+#define BYTES(literal)             Bytes(literal, sizeof(literal) - 1)
+
+// queries as phones and dig sent them to a portal, EDNS off
+static const Bytes android = BYTES(HEADER("\x3c\x4d", "\x00", "\x01") "\x11" "connectivitycheck" "\x07" "gstatic" "\x03" "com" "\x00" TYPE_A_CLASS_IN);
+static const Bytes apple = BYTES(HEADER("\x5e\x4d", "\x00", "\x01") "\x07" "captive" "\x05" "apple" "\x03" "com" "\x00" TYPE_A_CLASS_IN);
+static const Bytes mixedCase = BYTES(HEADER("\x21\x4d", "\x20", "\x01") "\x06" "Portal" "\x05" "LOCAL" "\x00" TYPE_A_CLASS_IN);
+static const Bytes www = BYTES(HEADER("\x22\x4d", "\x20", "\x01") "\x03" "www" "\x06" "portal" "\x05" "local" "\x00" TYPE_A_CLASS_IN);
+static const Bytes wwwMixedCase = BYTES(HEADER("\x23\x4d", "\x20", "\x01") "\x03" "WwW" "\x06" "pORTAL" "\x05" "local" "\x00" TYPE_A_CLASS_IN);
+static const Bytes subdomain = BYTES(HEADER("\x24\x4d", "\x20", "\x01") "\x04" "mail" "\x06" "portal" "\x05" "local" "\x00" TYPE_A_CLASS_IN);
+static const Bytes wwwTwice = BYTES(HEADER("\x25\x4d", "\x20", "\x01") "\x03" "www" "\x03" "www" "\x06" "portal" "\x05" "local" "\x00" TYPE_A_CLASS_IN);
+static const Bytes suffix = BYTES(HEADER("\x26\x4d", "\x20", "\x01") "\x06" "portal" "\x05" "local" "\x04" "evil" "\x00" TYPE_A_CLASS_IN);
+// cut off inside the name, and a label length running past the packet
+static const Bytes truncated = BYTES(HEADER("\x27\x4d", "\x20", "\x01") "\x06" "portal" "\x05" "loc");
+static const Bytes overrun = BYTES(HEADER("\x28\x4d", "\x20", "\x01") "\x06" "portal" "\x3f" "local" "\x00" TYPE_A_CLASS_IN);
+// "portal" followed by a pointer back to the question, not valid in a question
+static const Bytes pointer = BYTES(HEADER("\x29\x4d", "\x20", "\x01") "\x06" "portal" "\xc0\x0c" TYPE_A_CLASS_IN);
+static const Bytes twoQuestions = BYTES(HEADER("\x2a\x4d", "\x20", "\x02") "\x06" "portal" "\x05" "local" "\x00" TYPE_A_CLASS_IN "\x06" "portal" "\x05" "local" "\x00" TYPE_A_CLASS_IN);
+
+static const uint16_t port = 5300;
+
+// replies as they leave the stack
+static std::mutex repliesLock;
+static std::vector<Bytes> replies;
+static std::atomic<long> replyCount{0};
+static bool record = true;
+static std::atomic<bool> holding{false};
+
+static err_t output(udp_pcb *, pbuf *p, const ip_addr_t *dst, u16_t dstPort) {
+  CHECK(IPAddress(dst->addr) == IPAddress(192, 168, 4, 2) && dstPort == 50000);
+  replyCount++;
+  while (holding) {
+    std::this_thread::yield();
+  }
+  if (record) {
+    std::lock_guard<std::mutex> lock(repliesLock);
+    replies.push_back(Bytes((const char *)p->payload, p->len));
+  }
+  return ERR_OK;
+}
+
+static void send(const Bytes &query) {
+  ip_addr_t src;
+  IPAddress(192, 168, 4, 2).to_ip_addr_t(&src);
+  hostUdpInput(hostUdpFind(port), query.data(), query.size(), &src, 50000);
+}
+
+static bool awaitReplies(long count) {
+  auto deadline = steady_clock::now() + seconds(1);
+  while (replyCount < count && steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  return replyCount == count;
+}
+
+// the replies to `query`: it is followed by `sentinel`, a query that is
+// always answered, once that answer is in so is any other
+static std::vector<Bytes> ask(const Bytes &query, const Bytes &sentinel) {
+  Bytes mark = sentinel;
+  mark[0] = mark[1] = 0xff;
+  std::unique_lock<std::mutex> lock(repliesLock);
+  replies.clear();
+  lock.unlock();
+  send(query);
+  send(mark);
+  for (int i = 0; i < 1000; i++) {
+    lock.lock();
+    if (!replies.empty() && replies.back().compare(0, 2, mark, 0, 2) == 0) {
+      return std::vector<Bytes>(replies.begin(), replies.end() - 1);
+    }
+    lock.unlock();
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  CHECK(!"no answer to the sentinel");
+  return {};
+}
+
+static Bytes answer(const Bytes &query, uint32_t ttl = 60) {
+  Bytes reply = query;
+  reply[2] |= 0x80;  // QR
+  reply[7] = 1;      // ANCount
+  reply += BYTES("\xc0\x0c" TYPE_A_CLASS_IN);
+  reply += {char(ttl >> 24), char(ttl >> 16), char(ttl >> 8), char(ttl)};
+  reply += BYTES("\x00\x04\xc0\xa8\x04\x01");
+  return reply;
+}
+
+static Bytes nxdomain(const Bytes &query) {
+  Bytes reply = query.substr(0, 12);
+  reply[2] |= 0x80;
+  reply[3] = (reply[3] & 0xf0) | 3;
+  reply[5] = 0;  // QDCount
+  return reply;
+}
+
+static void test_domain() {
+  DNSServer dns;
+  CHECK(dns.start(port, "www.Portal.local", IPAddress(192, 168, 4, 1)));
+  const Bytes &sentinel = mixedCase;
+
+  CHECK(ask(mixedCase, sentinel) == std::vector<Bytes>{answer(mixedCase)});
+  CHECK(ask(www, sentinel) == std::vector<Bytes>{answer(www)});
+  CHECK(ask(wwwMixedCase, sentinel) == std::vector<Bytes>{answer(wwwMixedCase)});
+  CHECK(ask(subdomain, sentinel) == std::vector<Bytes>{nxdomain(subdomain)});
+  // only one leading www label is ignored
+  CHECK(ask(wwwTwice, sentinel) == std::vector<Bytes>{nxdomain(wwwTwice)});
+  CHECK(ask(suffix, sentinel) == std::vector<Bytes>{nxdomain(suffix)});
+  CHECK(ask(android, sentinel) == std::vector<Bytes>{nxdomain(android)});
+  CHECK(ask(twoQuestions, sentinel) == std::vector<Bytes>{nxdomain(twoQuestions)});
+
+  // malformed questions, and a response, get nothing back
+  CHECK(ask(truncated, sentinel).empty());
+  CHECK(ask(overrun, sentinel).empty());
+  CHECK(ask(pointer, sentinel).empty());
+  CHECK(ask(truncated.substr(0, 16), sentinel).empty());
+  Bytes response = answer(mixedCase);
+  CHECK(ask(response, sentinel).empty());
+
+  dns.setErrorReplyCode(DNSReplyCode::Refused);
+  Bytes refused = nxdomain(subdomain);
+  refused[3] = (refused[3] & 0xf0) | 5;
+  CHECK(ask(subdomain, sentinel) == std::vector<Bytes>{refused});
+  CHECK(hostPbufsAlive == 0);
+}
+
+static void test_captive() {
+  DNSServer dns;
+  CHECK(dns.start(port, "*", IPAddress(192, 168, 4, 1)));
+  const Bytes &sentinel = apple;
+  for (const Bytes *query : {&android, &apple, &mixedCase, &www, &subdomain, &wwwTwice, &suffix}) {
+    CHECK(ask(*query, sentinel) == std::vector<Bytes>{answer(*query)});
+  }
+  CHECK(ask(twoQuestions, sentinel) == std::vector<Bytes>{nxdomain(twoQuestions)});
+  CHECK(ask(pointer, sentinel).empty());
+  CHECK(ask(truncated, sentinel).empty());
+}
+
+static void test_answer_cache() {
+  DNSServer dns;
+  CHECK(dns.start(port, "*", IPAddress(192, 168, 4, 1)));
+  const Bytes &sentinel = apple;
+
+  // a repeated question answered from the cache carries the new ID and flags
+  Bytes again = android;
+  again[0] = 0x77;
+  again[2] = 0x00;  // no recursion desired
+  CHECK(ask(android, sentinel) == std::vector<Bytes>{answer(android)});
+  CHECK(ask(again, sentinel) == std::vector<Bytes>{answer(again)});
+  CHECK(ask(android, sentinel) == std::vector<Bytes>{answer(android)});
+
+  // the same name in other case is another question, echoed as asked
+  Bytes upper = android;
+  upper[13] = 'C';
+  CHECK(ask(upper, sentinel) == std::vector<Bytes>{answer(upper)});
+
+  // a new TTL is not served from old answers
+  dns.setTTL(300);
+  CHECK(ask(android, sentinel) == std::vector<Bytes>{answer(android, 300)});
+
+  // more names than the cache holds, and one too long for it, twice around
+  std::vector<Bytes> queries;
+  for (int i = 0; i < DNS_ANSWER_CACHE_SIZE + 3; i++) {
+    queries.push_back(android);
+    queries.back()[1] = i;
+    queries.back()[14] = 'a' + i;
+  }
+  Bytes label(35, 'x');
+  queries.push_back(BYTES(HEADER("\x40\x4d", "\x00", "\x01")) + char(label.size()) + label + char(label.size()) + label + BYTES("\x00" TYPE_A_CLASS_IN));
+  for (int round = 0; round < 2; round++) {
+    for (const Bytes &query : queries) {
+      CHECK(ask(query, sentinel) == std::vector<Bytes>{answer(query, 300)});
+    }
+  }
+
+  // restarting in domain mode drops the captive answers
+  CHECK(dns.start(port, "portal.local", IPAddress(192, 168, 4, 1)));
+  CHECK(ask(android, mixedCase) == std::vector<Bytes>{nxdomain(android)});
+}
+
+static Bytes probe(const char *name, uint16_t id) {
+  Bytes query = BYTES(HEADER("\x00\x00", "\x00", "\x01"));
+  query[0] = id >> 8;
+  query[1] = id;
+  while (*name) {
+    const char *dot = strchr(name, '.');
+    size_t len = dot ? dot - name : strlen(name);
+    query += char(len);
+    query.append(name, len);
+    name += dot ? len + 1 : len;
+  }
+  return query + BYTES("\x00" TYPE_A_CLASS_IN);
+}
+
+// queries/s the async_udp task answers: each round the task is held in the
+// reply to a first query until all of `queries` are queued behind it
+static double throughput(const std::vector<Bytes> &queries, const Bytes &first, int rounds) {
+  record = false;
+  replyCount = 0;
+  double s = 0;
+  for (int r = 0; r < rounds; r++) {
+    long before = replyCount;
+    holding = true;
+    send(first);
+    for (const Bytes &query : queries) {
+      send(query);
+    }
+    CHECK(awaitReplies(before + 1));
+    auto t0 = steady_clock::now();
+    holding = false;
+    CHECK(awaitReplies(before + 1 + queries.size()));
+    s += duration<double>(steady_clock::now() - t0).count();
+  }
+  record = true;
+  return queries.size() * rounds / s;
+}
+
+static void test_throughput() {
+  // what phones probe behind a captive portal, mostly the same few names,
+  // plus the portal's own name
+  const char *names[] = {
+    "connectivitycheck.gstatic.com", "www.google.com", "clients3.google.com", "captive.apple.com", "www.apple.com", "www.msftconnecttest.com",
+    "dns.msftncsi.com", "detectportal.firefox.com", "mtalk.google.com", "Portal.Local", "www.portal.local", "play.googleapis.com",
+    "graph.facebook.com", "android.clients.google.com", "time.android.com", "i.instagram.com"
+  };
+  const int count = sizeof(names) / sizeof(names[0]);
+  std::vector<Bytes> queries;
+  std::mt19937 rng(1);
+  for (int i = 0; i < 1000; i++) {
+    queries.push_back(probe(names[rng() % 7 == 0 ? rng() % count : rng() % 4], rng()));
+  }
+
+  DNSServer dns;
+  CHECK(dns.start(port, "*", IPAddress(192, 168, 4, 1)));
+  Bytes first = probe("portal.local", 0);
+  double captive = throughput(queries, first, 50);
+  CHECK(dns.start(port, "portal.local", IPAddress(192, 168, 4, 1)));
+  double domain = throughput(queries, first, 50);
+  printf("1000 portal probes x 50: captive %.0fk queries/s, domain portal.local %.0fk queries/s\n", captive / 1000, domain / 1000);
+  CHECK(hostPbufsAlive == 0);
+}
+
+int main() {
+  hostUdpOutput = output;
+  hostTcpipCoreLocking = true;
+  test_domain();
+  test_captive();
+  test_answer_cache();
+  test_throughput();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
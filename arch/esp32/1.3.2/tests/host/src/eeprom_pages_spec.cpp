@@ -0,0 +1,199 @@
+// EEPROM on the in-memory NVS: what a commit() writes when one value
+// changes, that pages survive end()/begin() and a change of size, and that
+// the single blob older versions stored, or convert() copies out of the
+// eeprom partition, becomes pages on begin().
+#include "EEPROM.h"
+#include "esp_partition.h"
+#include "host_nvs.h"
+#include "nvs.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+// what NVS stores for one page: its index, data header and the data
+static const size_t PAGE_BYTES = (2 + (EEPROM_PAGE_SIZE + 31) / 32) * 32;
+
+// the eeprom partition of the 1.0 core, for convert()
+static uint8_t partitionData[1024];
+static esp_partition_t partition = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0x3f0000, sizeof(partitionData), "eeprom", false};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *label) {
+  return strcmp(label, partition.label) == 0 ? &partition : NULL;
+}
+
+int esp_partition_read(const esp_partition_t *, size_t src_offset, void *dst, size_t size) {
+  memcpy(dst, partitionData + src_offset, size);
+  return ESP_OK;
+}
+
+int esp_partition_erase_range(const esp_partition_t *, size_t offset, size_t size) {
+  memset(partitionData + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+static void test_commit() {
+  const size_t size = 4096;
+  EEPROMClass eeprom("pages");
+  size_t before = hostNvsBytesWritten;
+  CHECK(eeprom.begin(size));
+  // every page written up front, so a full partition fails in begin()
+  size_t pages = (size + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE;
+  CHECK(hostNvsBytesWritten - before >= pages * PAGE_BYTES);
+  bool blank = true;
+  for (size_t i = 0; i < size; i++) {
+    blank = blank && eeprom.read(i) == 0xFF;
+  }
+  CHECK(blank && !eeprom.isDirty());
+
+  eeprom.writeString(100, "hello world");
+  eeprom.writeUInt(2000, 0xdeadbeef);
+  CHECK(eeprom.isDirty());
+  before = hostNvsBytesWritten;
+  size_t writes = hostNvsWrites;
+  CHECK(eeprom.commit());
+  CHECK(hostNvsWrites - writes == 2 && hostNvsBytesWritten - before == 2 * PAGE_BYTES && !eeprom.isDirty());
+
+  // a counter written once a minute for a day
+  const int minutes = 1440;
+  before = hostNvsBytesWritten;
+  writes = hostNvsWrites;
+  for (int minute = 0; minute < minutes; minute++) {
+    eeprom.writeUInt(8, minute);
+    CHECK(eeprom.commit());
+  }
+  size_t perCommit = (hostNvsBytesWritten - before) / minutes;
+  CHECK(perCommit == PAGE_BYTES && hostNvsWrites - writes == (size_t)minutes);
+
+  // a value straddling two pages writes both
+  before = hostNvsBytesWritten;
+  eeprom.writeUInt(EEPROM_PAGE_SIZE - 2, 0x01020304);
+  CHECK(eeprom.commit());
+  CHECK(hostNvsBytesWritten - before == 2 * PAGE_BYTES);
+
+  // unchanged bytes cost nothing, even with every page marked dirty
+  before = hostNvsBytesWritten;
+  eeprom.write(8, eeprom.read(8));
+  CHECK(!eeprom.isDirty());
+  eeprom.getDataPtr();
+  CHECK(eeprom.isDirty() && eeprom.commit());
+  CHECK(hostNvsBytesWritten == before);
+  // and a commit with nothing dirty does not touch NVS
+  size_t reads = hostNvsReads;
+  CHECK(eeprom.commit() && hostNvsReads == reads);
+  eeprom.end();
+
+  // the whole 4 KB blob each time, as a single blob was stored before
+  size_t singleBlob = (2 + (size + 31) / 32) * 32;
+  printf(
+    "%zu byte EEPROM, a counter committed once a minute: %zu bytes written per commit (%zu as one blob), %zu KB a day\n", size, perCommit, singleBlob,
+    perCommit * minutes / 1024
+  );
+}
+
+static void test_reopen() {
+  EEPROMClass eeprom("pages");
+  CHECK(eeprom.begin(4096));
+  CHECK(eeprom.readString(100) == "hello world");
+  CHECK(eeprom.readUInt(2000) == 0xdeadbeef && eeprom.readUInt(8) == 1439);
+  CHECK(eeprom.readUInt(EEPROM_PAGE_SIZE - 2) == 0x01020304);
+  eeprom.end();
+
+  // grow: the old bytes stay, the new ones are blank
+  CHECK(eeprom.begin(4096 + 100));
+  CHECK(eeprom.readUInt(2000) == 0xdeadbeef && eeprom.read(4096 + 50) == 0xFF);
+  eeprom.write(1010, 0x55);
+  eeprom.end();
+
+  // shrink: the pages past the end are dropped from NVS
+  CHECK(eeprom.begin(1000));
+  CHECK(eeprom.readString(100) == "hello world" && eeprom.length() == 1000);
+  eeprom.end();
+  nvs_handle_t handle;
+  nvs_open("pages", NVS_READWRITE, &handle);
+  size_t len;
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  snprintf(key, sizeof(key), "p%u", (unsigned)((1000 + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE));
+  CHECK(nvs_get_blob(handle, key, NULL, &len) == ESP_ERR_NVS_NOT_FOUND);
+  snprintf(key, sizeof(key), "p%u", (unsigned)(1000 / EEPROM_PAGE_SIZE));
+  CHECK(nvs_get_blob(handle, key, NULL, &len) == ESP_OK && len == 1000 % EEPROM_PAGE_SIZE);
+  nvs_close(handle);
+
+  // and growing again does not bring them back
+  CHECK(eeprom.begin(4096));
+  CHECK(eeprom.readString(100) == "hello world" && eeprom.read(1010) == 0xFF && eeprom.read(2000) == 0xFF);
+  eeprom.end();
+}
+
+static void test_legacy_blob() {
+  // a single blob named after the namespace, as older versions stored it
+  nvs_handle_t handle;
+  nvs_open("legacy", NVS_READWRITE, &handle);
+  uint8_t blob[512];
+  for (int i = 0; i < 512; i++) {
+    blob[i] = i;
+  }
+  nvs_set_blob(handle, "legacy", blob, sizeof(blob));
+
+  EEPROMClass eeprom("legacy");
+  CHECK(eeprom.begin(600));
+  bool same = true;
+  for (int i = 0; i < 512; i++) {
+    same = same && eeprom.read(i) == (uint8_t)i;
+  }
+  CHECK(same && eeprom.read(550) == 0xFF && !eeprom.isDirty());
+  size_t len;
+  CHECK(nvs_get_blob(handle, "legacy", NULL, &len) == ESP_ERR_NVS_NOT_FOUND);
+  uint32_t pageSize;
+  CHECK(nvs_get_u32(handle, "page_size", &pageSize) == ESP_OK && pageSize == EEPROM_PAGE_SIZE);
+  eeprom.write(300, 7);
+  eeprom.end();
+
+  // the converted pages are what the next begin() reads
+  size_t before = hostNvsBytesWritten;
+  CHECK(eeprom.begin(600));
+  CHECK(eeprom.read(300) == 7 && eeprom.read(301) == (uint8_t)301);
+  CHECK(hostNvsBytesWritten == before);
+  eeprom.end();
+
+  // a legacy blob longer than the EEPROM is cut to its size
+  nvs_open("long", NVS_READWRITE, &handle);
+  nvs_set_blob(handle, "long", blob, sizeof(blob));
+  EEPROMClass shorter("long");
+  CHECK(shorter.begin(200));
+  CHECK(shorter.read(199) == 199 && shorter.length() == 200);
+  shorter.end();
+  nvs_close(handle);
+}
+
+static void test_convert() {
+  // convert() copies the partition into a legacy blob, begin() makes pages of it
+  memset(partitionData, 0xFF, sizeof(partitionData));
+  CHECK(EEPROMClass().convert(false, "eeprom", "converted") == 0);
+  for (size_t i = 0; i < 100; i++) {
+    partitionData[i] = i * 3;
+  }
+  CHECK(EEPROMClass().convert(true, "eeprom", "converted") == sizeof(partitionData));
+  CHECK(partitionData[10] == 0xFF);
+  CHECK(EEPROMClass().convert(true, "missing", "converted") == 0);
+
+  EEPROMClass eeprom("converted");
+  CHECK(eeprom.begin(sizeof(partitionData)));
+  CHECK(eeprom.read(10) == 30 && eeprom.read(99) == (uint8_t)(99 * 3) && eeprom.read(100) == 0xFF);
+  eeprom.end();
+}
+
+int main() {
+  test_commit();
+  test_reopen();
+  test_legacy_blob();
+  test_convert();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+// HTTPClient response parsing from its one response buffer: header lines,
+// chunked, Content-Length and read-until-close bodies at TCP segment sizes
+// from 7 bytes up, chunk size lines over HTTP_CHUNK_HEADER_SIZE, and the
+// speed and allocation count of writeToStream() on a chunked body.
+#include <Arduino.h>
+#include "HTTPClient.h"
+#include <chrono>
+#include <new>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+// every heap allocation of the test, malloc and realloc are wrapped by the linker
+static long allocations = 0;
+
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_realloc(void *ptr, size_t size);
+
+extern "C" void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+extern "C" void *__wrap_realloc(void *ptr, size_t size) {
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+
+void *operator new(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *operator new[](size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+// the server: answers each request head with `response`, in segments of at most `maxChunk`
+static std::string response;
+static size_t maxChunk = 1436;
+static bool closeAfterResponse = false;
+
+static std::shared_ptr<NetworkClient::Socket> dial(const char *, uint16_t) {
+  auto socket = std::make_shared<NetworkClient::Socket>();
+  socket->maxChunk = maxChunk;
+  socket->peer = [](NetworkClient::Socket &s) {
+    if (s.out.size() >= 4 && s.out.compare(s.out.size() - 4, 4, "\r\n\r\n") == 0) {
+      s.out.clear();
+      s.in += response;
+      s.open = !closeAfterResponse;
+    }
+  };
+  return socket;
+}
+
+// counts and checksums what writeToStream() hands it
+struct Sink : Stream {
+  size_t size = 0;
+  uint32_t sum = 0;
+  int available() override {
+    return 0;
+  }
+  int read() override {
+    return -1;
+  }
+  int peek() override {
+    return -1;
+  }
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t *buf, size_t len) override {
+    for (size_t i = 0; i < len; i++) {
+      sum = sum * 31 + buf[i];
+    }
+    size += len;
+    return len;
+  }
+};
+
+static std::string chunked(const std::string &body, size_t chunkSize, const char *extension = "") {
+  std::string r = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n";
+  for (size_t pos = 0; pos < body.size(); pos += chunkSize) {
+    size_t n = std::min(chunkSize, body.size() - pos);
+    char header[64];
+    snprintf(header, sizeof(header), "%zX%s\r\n", n, extension);
+    r += header + body.substr(pos, n) + "\r\n";
+  }
+  return r + "0\r\n\r\n";
+}
+
+static std::string get(int *code = nullptr) {
+  HTTPClient http;
+  http.begin("http://example.com/file");
+  int c = http.GET();
+  if (code) {
+    *code = c;
+  }
+  String s = http.getString();
+  http.end();
+  return std::string(s.c_str(), s.length());
+}
+
+static void test_headers() {
+  response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nX-Test:   spaced value  \r\nX-Huge: " + std::string(3000, 'h') + "\r\nContent-Length: 5\r\n\r\nhello";
+  HTTPClient http;
+  const char *keys[] = {"X-Test", "Content-Type", "X-Huge"};
+  http.begin("http://example.com/");
+  http.collectHeaders(keys, 3);
+  CHECK(http.GET() == 200);
+  CHECK(http.header("X-Test") == "spaced value");
+  CHECK(http.header("Content-Type") == "text/plain");
+  CHECK(http.header("X-Huge").length() == 3000);
+  CHECK(http.getSize() == 5 && http.getString() == "hello");
+  http.end();
+}
+
+static void test_bodies() {
+  std::string body;
+  for (int i = 0; i < 50000; i++) {
+    body += char('A' + (i * 7919) % 53);
+  }
+  int bad = 0;
+  for (size_t segment : {7, 100, 1436, 100000}) {
+    maxChunk = segment;
+    // chunk sizes that keep changing, so chunk lines land everywhere in the buffer
+    response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (size_t pos = 0, k = 1; pos < body.size(); k++) {
+      size_t n = std::min(body.size() - pos, k * 37 % 5000 + 1);
+      char header[32];
+      snprintf(header, sizeof(header), "%zx;name=value\r\n", n);
+      response += header + body.substr(pos, n) + "\r\n";
+      pos += n;
+    }
+    response += "0\r\n\r\n";
+    bad += get() != body;
+
+    response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    bad += get() != body;
+
+    closeAfterResponse = true;
+    response = "HTTP/1.0 200 OK\r\n\r\n" + body;
+    bad += get() != body;
+    closeAfterResponse = false;
+  }
+  maxChunk = 1436;
+  CHECK(bad == 0);
+
+  // a chunk size line the client will not buffer
+  std::string extension = ";" + std::string(HTTP_CHUNK_HEADER_SIZE, 'x');
+  response = chunked("abc", 3, extension.c_str());
+  CHECK(get().empty());
+  extension = ";" + std::string(HTTP_CHUNK_HEADER_SIZE - 6, 'x');
+  response = chunked("abc", 3, extension.c_str());
+  CHECK(get() == "abc");
+}
+
+// allocations made by writeToStream() for a chunked body of `chunks` chunks
+static long streamAllocations(int chunks, double *mbps) {
+  std::string body(chunks * 1024, 'a');
+  for (size_t i = 0; i < body.size(); i++) {
+    body[i] = 'a' + i % 26;
+  }
+  response = chunked(body, 1024);
+  HTTPClient http;
+  http.begin("http://example.com/big");
+  http.GET();
+  Sink sink;
+  long before = allocations;
+  auto t0 = std::chrono::steady_clock::now();
+  int written = http.writeToStream(&sink);
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+  long count = allocations - before;
+  http.end();
+  CHECK(written == (int)body.size() && sink.size == body.size());
+  if (mbps) {
+    *mbps = body.size() / us;
+  }
+  return count;
+}
+
+int main() {
+  NetworkClient::dial = dial;
+  test_headers();
+  test_bodies();
+
+  streamAllocations(20, nullptr);
+  long few = streamAllocations(20, nullptr);
+  double mbps;
+  long many = streamAllocations(20000, &mbps);
+  printf("chunked body, 1 KB chunks: %.1f MB/s, %ld allocations for 20 chunks, %ld for 20000\n", mbps, few, many);
+  CHECK(many == few);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
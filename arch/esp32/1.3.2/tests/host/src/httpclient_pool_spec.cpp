@@ -0,0 +1,176 @@
+// Keep-alive connections shared between HTTPClient instances: how many
+// connections a local server accepts for N requests with and without the
+// pool, and when the pool closes a parked connection (idle timeout, pool
+// full, closed by the server, cleared).
+#include <Arduino.h>
+#include "HTTPClient.h"
+#include <map>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+typedef std::shared_ptr<NetworkClient::Socket> Socket;
+
+// the local server: every accepted connection, by "host:port"
+static std::map<std::string, std::vector<Socket>> accepted;
+static bool serverCloses = false;
+
+static Socket dial(const char *host, uint16_t port) {
+  Socket socket = std::make_shared<NetworkClient::Socket>();
+  // answers every complete request head with its path
+  socket->peer = [](NetworkClient::Socket &s) {
+    size_t end;
+    while ((end = s.out.find("\r\n\r\n")) != std::string::npos) {
+      std::string head = s.out.substr(0, end);
+      s.out.erase(0, end + 4);
+      std::string body = "hello from " + head.substr(4, head.find(' ', 4) - 4);
+      s.in += "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + (serverCloses ? "\r\nConnection: close" : "\r\nConnection: keep-alive")
+              + "\r\n\r\n" + body;
+      s.open = !serverCloses;
+    }
+  };
+  accepted[std::string(host) + ":" + std::to_string(port)].push_back(socket);
+  return socket;
+}
+
+static int accepts() {
+  int count = 0;
+  for (auto &server : accepted) {
+    count += server.second.size();
+  }
+  return count;
+}
+
+// the i-th connection accepted by `server`
+static Socket connection(const std::string &server, size_t i) {
+  std::vector<Socket> &sockets = accepted[server];
+  CHECK(i < sockets.size());
+  return i < sockets.size() ? sockets[i] : std::make_shared<NetworkClient::Socket>();
+}
+
+static bool fetch(const char *url) {
+  HTTPClient http;
+  http.begin(url);
+  bool ok = http.GET() == 200 && http.getString().startsWith("hello from /");
+  http.end();
+  return ok;
+}
+
+static const char *urls[] = {"http://api.one.local/a", "http://api.two.local:8080/b", "http://api.three.local/c"};
+
+// `requests` requests round robin over the three servers, each from a new HTTPClient
+static bool roundRobin(int requests) {
+  accepted.clear();
+  bool ok = true;
+  for (int i = 0; i < requests; i++) {
+    ok &= fetch(urls[i % 3]);
+  }
+  return ok;
+}
+
+static void test_reuse() {
+  HTTPClient::setConnectionPool(3);
+  CHECK(roundRobin(30));
+  CHECK(accepts() == 3 && accepted["api.one.local:80"].size() == 1 && accepted["api.two.local:8080"].size() == 1);
+  printf("30 requests to 3 servers: pool of 3 %d connections, ", accepts());
+
+  HTTPClient::setConnectionPool(0);
+  CHECK(roundRobin(30));
+  CHECK(accepts() == 30);
+  printf("no pool %d connections\n", accepts());
+
+  // one long-lived object moving between servers parks each connection too
+  HTTPClient::setConnectionPool(3);
+  HTTPClient::clearConnectionPool();
+  accepted.clear();
+  {
+    HTTPClient http;
+    for (int i = 0; i < 30; i++) {
+      http.begin(urls[i % 3]);
+      CHECK(http.GET() == 200 && http.getString().length() > 0);
+      http.end();
+    }
+  }
+  CHECK(accepts() == 3);
+
+  // connections the server closes are not parked
+  HTTPClient::clearConnectionPool();
+  serverCloses = true;
+  CHECK(roundRobin(6));
+  CHECK(accepts() == 6);
+  serverCloses = false;
+  HTTPClient::clearConnectionPool();
+}
+
+static void test_idle_timeout() {
+  HTTPClient::setConnectionPool(3, 50);
+  accepted.clear();
+  CHECK(fetch(urls[0]));
+  Socket first = connection("api.one.local:80", 0);
+  delay(10);
+  CHECK(fetch(urls[0]));
+  CHECK(accepts() == 1 && first->open);
+
+  // idle for longer than the timeout: closed on the next pool access
+  delay(70);
+  CHECK(fetch(urls[1]));
+  CHECK(!first->open);
+  CHECK(fetch(urls[0]));
+  CHECK(accepted["api.one.local:80"].size() == 2);
+
+  // closed by the server while parked
+  Socket second = connection("api.one.local:80", 1);
+  second->open = false;
+  CHECK(fetch(urls[0]));
+  CHECK(accepted["api.one.local:80"].size() == 3);
+  HTTPClient::clearConnectionPool();
+  CHECK(!connection("api.one.local:80", 2)->open && !connection("api.two.local:8080", 0)->open);
+}
+
+static void test_max_connections() {
+  HTTPClient::setConnectionPool(2);
+  accepted.clear();
+  CHECK(fetch(urls[0]) && fetch(urls[1]));
+  Socket one = connection("api.one.local:80", 0);
+  Socket two = connection("api.two.local:8080", 0);
+  CHECK(one->open && two->open);
+
+  // a third parked connection closes the oldest one
+  CHECK(fetch(urls[2]));
+  CHECK(!one->open && two->open);
+  CHECK(fetch(urls[1]) && fetch(urls[2]));
+  CHECK(accepts() == 3);
+  CHECK(fetch(urls[0]));
+  CHECK(accepted["api.one.local:80"].size() == 2);
+
+  // three servers round robin on a pool of two: every connection is evicted before reuse
+  HTTPClient::clearConnectionPool();
+  CHECK(roundRobin(30));
+  CHECK(accepts() == 30);
+
+  // shrinking the pool closes the oldest parked connections
+  HTTPClient::clearConnectionPool();
+  HTTPClient::setConnectionPool(3);
+  CHECK(roundRobin(3));
+  HTTPClient::setConnectionPool(1);
+  CHECK(!connection("api.one.local:80", 0)->open && !connection("api.two.local:8080", 0)->open && connection("api.three.local:80", 0)->open);
+  HTTPClient::clearConnectionPool();
+}
+
+int main() {
+  NetworkClient::dial = dial;
+  test_reuse();
+  test_idle_timeout();
+  test_max_connections();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
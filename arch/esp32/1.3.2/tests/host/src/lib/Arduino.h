@@ -0,0 +1,42 @@
+#pragma once
+// Arduino.h for the host tests: the real core String/Stream/Print on top of
+// the C++ standard library, time functions from arduino_shim.cpp
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <pgmspace.h>
+#include "stdlib_noniso.h"
+#include "esp_err.h"
+#include "esp32-hal-log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t);
+void yield();
+// delay() returns at once and only moves millis() and micros() on, for
+// specs that run into retry loops
+extern bool hostSkipDelays;
+#define LOW    0x0
+#define HIGH   0x1
+#define OUTPUT 0x03
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+using std::min;
+using std::max;
+#include "WString.h"
+#include "Stream.h"
+#include "Print.h"
+#include "IPAddress.h"
+#include "Client.h"
+#include "Server.h"
+#include "Esp.h"
@@ -0,0 +1,13 @@
+#pragma once
+// The flash access of EspClass; a spec that flashes defines these, so it can
+// back the partition with memory or a file
+#include "esp_partition.h"
+
+class EspClass {
+public:
+  bool partitionEraseRange(const esp_partition_t *partition, uint32_t offset, size_t size);
+  bool partitionWrite(const esp_partition_t *partition, uint32_t offset, uint32_t *data, size_t size);
+  bool partitionRead(const esp_partition_t *partition, uint32_t offset, uint32_t *data, size_t size);
+};
+
+extern EspClass ESP;
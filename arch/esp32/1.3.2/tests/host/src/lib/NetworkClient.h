@@ -0,0 +1,125 @@
+#pragma once
+// In-memory NetworkClient. Copies share one Socket, like copies of the real
+// client share its socket: reads come from `in`, writes are appended to `out`.
+// available() and the peek buffer hand out at most maxChunk bytes at a time,
+// like a TCP segment.
+// The peer stays connected until `open` is cleared, so a test can keep adding
+// to `in` between handleClient() calls.
+// For client side code, connect() gets its Socket from `dial`, and the
+// Socket's `peer` sees every write, so it can answer a request.
+#include "Arduino.h"
+#include "Client.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+class NetworkClient : public Client {
+public:
+  struct Socket {
+    std::string in, out;
+    size_t pos = 0;
+    size_t maxChunk = 1436;
+    bool peekApi = true;
+    bool open = true;
+    std::function<void(Socket &)> peer;
+  };
+  static inline std::function<std::shared_ptr<Socket>(const char *host, uint16_t port)> dial;
+  std::shared_ptr<Socket> socket;
+  bool sse = false;
+
+  NetworkClient() {}
+  explicit NetworkClient(std::shared_ptr<Socket> s) : socket(s) {}
+  int connect(IPAddress, uint16_t) override {
+    return 0;
+  }
+  int connect(const char *, uint16_t) override {
+    return 0;
+  }
+  int connect(IPAddress, uint16_t, int32_t) {
+    return 0;
+  }
+  int connect(const char *host, uint16_t port, int32_t) {
+    socket = dial ? dial(host, port) : nullptr;
+    return socket ? 1 : 0;
+  }
+  int setNoDelay(bool) {
+    return 0;
+  }
+  void setConnectionTimeout(uint32_t) {}
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t *buf, size_t size) override {
+    if (!socket) {
+      return 0;
+    }
+    socket->out.append((const char *)buf, size);
+    if (socket->peer) {
+      socket->peer(*socket);
+    }
+    return size;
+  }
+  size_t write(const char *buf, size_t size) {
+    return write((const uint8_t *)buf, size);
+  }
+  size_t write_P(const char *buf, size_t size) {
+    return write((const uint8_t *)buf, size);
+  }
+  int available() override {
+    return socket ? (int)std::min(socket->in.size() - socket->pos, socket->maxChunk) : 0;
+  }
+  int read() override {
+    return (socket && socket->pos < socket->in.size()) ? (uint8_t)socket->in[socket->pos++] : -1;
+  }
+  int read(uint8_t *buf, size_t size) override {
+    if (!socket) {
+      return -1;
+    }
+    size = std::min(size, socket->in.size() - socket->pos);
+    memcpy(buf, socket->in.data() + socket->pos, size);
+    socket->pos += size;
+    return size;
+  }
+  int peek() override {
+    return (socket && socket->pos < socket->in.size()) ? (uint8_t)socket->in[socket->pos] : -1;
+  }
+  bool hasPeekBufferAPI() const override {
+    return socket && socket->peekApi;
+  }
+  size_t peekAvailable() override {
+    return available();
+  }
+  const char *peekBuffer() override {
+    return socket->in.data() + socket->pos;
+  }
+  void peekConsume(size_t consume) override {
+    socket->pos += std::min(consume, socket->in.size() - socket->pos);
+  }
+  void flush() override {}
+  void clear() {
+    if (socket) {
+      socket->pos = socket->in.size();
+    }
+  }
+  void stop() override {
+    if (socket) {
+      socket->open = false;
+    }
+  }
+  uint8_t connected() override {
+    return socket && (socket->open || socket->pos < socket->in.size());
+  }
+  operator bool() override {
+    return (bool)socket;
+  }
+  void setSSE(bool set) {
+    sse = set;
+  }
+  bool isSSE() {
+    return sse;
+  }
+  IPAddress localIP() const {
+    return IPAddress();
+  }
+  using Print::write;
+};
@@ -0,0 +1,12 @@
+#pragma once
+// TLS client of the host tests: the plain in-memory client with the
+// certificate setters HTTPClient calls
+#include "NetworkClient.h"
+
+class NetworkClientSecure : public NetworkClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char *) {}
+  void setCertificate(const char *) {}
+  void setPrivateKey(const char *) {}
+};
@@ -0,0 +1,24 @@
+#pragma once
+// Listening socket of the host tests: accept() hands out the clients a test
+// queued in `pending`, one per call.
+#include "NetworkClient.h"
+#include <deque>
+
+class NetworkServer {
+public:
+  std::deque<NetworkClient> pending;
+
+  NetworkServer(int = 80) {}
+  NetworkServer(IPAddress, int = 80) {}
+  NetworkClient accept() {
+    if (pending.empty()) {
+      return NetworkClient();
+    }
+    NetworkClient client = pending.front();
+    pending.pop_front();
+    return client;
+  }
+  void begin(uint16_t = 0) {}
+  void close() {}
+  void setNoDelay(bool) {}
+};
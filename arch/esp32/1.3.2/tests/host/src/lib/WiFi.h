@@ -0,0 +1,3 @@
+#pragma once
+// no radio on the host: SOC_WIFI_SUPPORTED is not set
+#include "Arduino.h"
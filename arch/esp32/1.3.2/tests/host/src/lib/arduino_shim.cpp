@@ -0,0 +1,71 @@
+// Host implementations of the core functions the tests link against. Network,
+// GPIO and crypto entry points are inert: no test exercises them.
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "base64.h"
+#include "esp_random.h"
+#include "esp_rom_md5.h"
+#include "libb64/cdecode.h"
+
+bool hostSkipDelays = false;
+static std::atomic<unsigned long> skippedUs{0};
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+unsigned long micros() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() + skippedUs;
+}
+
+void delay(uint32_t ms) {
+  if (hostSkipDelays) {
+    skippedUs += ms * 1000UL;
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t, uint8_t) {}
+
+extern "C" char *itoa(int value, char *result, int base) {
+  return ltoa(value, result, base);
+}
+
+extern "C" char *utoa(unsigned value, char *result, int base) {
+  return ultoa(value, result, base);
+}
+
+const char *pathToFileName(const char *path) {
+  const char *s = strrchr(path, '/');
+  return s ? s + 1 : path;
+}
+
+String base64::encode(const uint8_t *, size_t) {
+  return String();
+}
+
+String base64::encode(const String &) {
+  return String();
+}
+
+int base64_decode_chars(const char *, int, char *) {
+  return 0;
+}
+
+extern "C" uint32_t esp_random() {
+  return 4;
+}
+
+extern "C" void esp_rom_md5_init(md5_context_t *) {}
+extern "C" void esp_rom_md5_update(md5_context_t *, const void *, uint32_t) {}
+extern "C" void esp_rom_md5_final(uint8_t *digest, md5_context_t *) {
+  memset(digest, 0, 16);
+}
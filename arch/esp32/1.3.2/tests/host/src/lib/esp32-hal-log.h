@@ -0,0 +1,8 @@
+#pragma once
+#define log_v(...) do{}while(0)
+#define log_d(...) do{}while(0)
+#define log_i(...) do{}while(0)
+#define log_w(...) do{}while(0)
+#define log_e(...) do{}while(0)
+#define ESP_LOG_LEVEL(...) do{}while(0)
+const char *pathToFileName(const char *path);
@@ -0,0 +1,14 @@
+#pragma once
+#include "esp_err.h"
+#include "esp_netif_ip_addr.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key);
+int esp_netif_get_netif_impl_index(esp_netif_t *esp_netif);
+#ifdef __cplusplus
+}
+#endif
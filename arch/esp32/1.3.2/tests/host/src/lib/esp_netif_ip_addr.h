@@ -0,0 +1,2 @@
+#pragma once
+typedef int esp_ip6_addr_type_t;
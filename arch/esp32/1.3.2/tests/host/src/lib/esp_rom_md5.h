@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+typedef struct { uint32_t s[24]; } md5_context_t;
+#define ESP_ROM_MD5_DIGEST_LEN 16
+extern "C" { void esp_rom_md5_init(md5_context_t*); void esp_rom_md5_update(md5_context_t*, const void*, uint32_t); void esp_rom_md5_final(uint8_t*, md5_context_t*); }
@@ -0,0 +1,14 @@
+#pragma once
+// FreeRTOS semaphores and tasks on top of std::thread, for core and library
+// code that hands work between tasks
+#include <stdint.h>
+
+#define portMAX_DELAY 0xffffffffu
+#define pdTRUE        1
+#define pdFALSE       0
+#define pdPASS        pdTRUE
+#define pdMS_TO_TICKS(ms) (ms)
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
@@ -0,0 +1,17 @@
+#pragma once
+// FreeRTOS queues: items are copied in and out, like on the target
+#include "FreeRTOS.h"
+
+typedef struct HostQueue *QueueHandle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+#ifdef __cplusplus
+}
+#endif
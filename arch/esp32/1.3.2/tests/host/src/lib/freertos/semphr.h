@@ -0,0 +1,54 @@
+#pragma once
+// Binary semaphores and mutexes as a count of at most one, guarded by a
+// std::mutex; give and take may come from different threads.
+#include "FreeRTOS.h"
+
+// AsyncUDP.h includes this inside extern "C"
+extern "C++" {
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+struct HostSemaphore {
+  std::mutex lock;
+  std::condition_variable cv;
+  bool given;
+};
+typedef HostSemaphore *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new HostSemaphore{{}, {}, false};
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new HostSemaphore{{}, {}, true};
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->lock);
+  auto given = [sem] {
+    return sem->given;
+  };
+  if (ticks == portMAX_DELAY) {
+    sem->cv.wait(lock, given);
+  } else if (!sem->cv.wait_for(lock, std::chrono::milliseconds(ticks), given)) {
+    return pdFALSE;
+  }
+  sem->given = false;
+  return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  std::lock_guard<std::mutex> lock(sem->lock);
+  if (sem->given) {
+    return pdFALSE;
+  }
+  sem->given = true;
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem) {
+  delete sem;
+}
+}
@@ -0,0 +1,36 @@
+#pragma once
+// Tasks as detached std::threads. A test sets hostTaskCreateFails to see how
+// the code copes without the memory for another task.
+#include "FreeRTOS.h"
+
+// AsyncUDP.h includes this inside extern "C"
+extern "C++" {
+#include <thread>
+
+typedef void *TaskHandle_t;
+
+inline bool hostTaskCreateFails = false;
+
+static inline BaseType_t xTaskCreate(void (*task)(void *), const char *, uint32_t, void *arg, UBaseType_t, TaskHandle_t *handle) {
+  if (hostTaskCreateFails) {
+    return pdFALSE;
+  }
+  std::thread(task, arg).detach();
+  if (handle) {
+    *handle = (TaskHandle_t)1;
+  }
+  return pdPASS;
+}
+
+static inline BaseType_t
+  xTaskCreateUniversal(void (*task)(void *), const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle, BaseType_t) {
+  return xTaskCreate(task, name, stack, arg, priority, handle);
+}
+
+// only a task deleting itself is supported, its thread then returns
+static inline void vTaskDelete(TaskHandle_t) {}
+
+static inline UBaseType_t uxTaskPriorityGet(TaskHandle_t) {
+  return 1;
+}
+}
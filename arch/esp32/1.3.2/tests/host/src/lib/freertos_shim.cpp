@@ -0,0 +1,63 @@
+// FreeRTOS queues on a std::deque guarded by a std::mutex
+#include "freertos/queue.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+struct HostQueue {
+  std::mutex lock;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+// waits `ticks` ms for `ready`, forever for portMAX_DELAY
+template<class F> static bool waitFor(HostQueue *queue, std::unique_lock<std::mutex> &lock, TickType_t ticks, F ready) {
+  if (ticks == portMAX_DELAY) {
+    queue->cv.wait(lock, ready);
+    return true;
+  }
+  return queue->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  return new HostQueue{{}, {}, {}, length, itemSize};
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!waitFor(queue, lock, ticks, [queue] {
+        return queue->items.size() < queue->length;
+      })) {
+    return pdFALSE;
+  }
+  queue->items.emplace_back((const uint8_t *)item, (const uint8_t *)item + queue->itemSize);
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!waitFor(queue, lock, ticks, [queue] {
+        return !queue->items.empty();
+      })) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->lock);
+  return queue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
@@ -0,0 +1,26 @@
+#pragma once
+// Controls of the lwIP stand-in in lwip_shim.cpp: the spec plays the lwIP
+// thread by feeding datagrams to a bound pcb, and sees what is sent.
+#include "lwip/udp.h"
+#include <atomic>
+#include <functional>
+
+// pbufs allocated and not yet freed, and allocated in all
+extern std::atomic<long> hostPbufsAlive;
+extern std::atomic<long> hostPbufAllocs;
+
+// called for every udp_sendto()/udp_sendto_if() on the tcpip thread, the
+// datagram is sent (ERR_OK) when unset. It must pbuf_ref() what it keeps.
+extern std::function<err_t(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst, u16_t port)> hostUdpOutput;
+
+// tcpip_api_call() runs its function on the caller's thread under the core
+// lock, as with CONFIG_LWIP_TCPIP_CORE_LOCKING, rather than on the tcpip thread
+extern bool hostTcpipCoreLocking;
+
+// the pcb bound to `port`, or NULL
+struct udp_pcb *hostUdpFind(u16_t port);
+
+// a received datagram, with Ethernet, IP and UDP headers in front of the
+// payload like lwIP leaves them, passed to the pcb's recv callback. The
+// destination is the pcb's address, 192.168.4.1 when bound to any.
+void hostUdpInput(struct udp_pcb *pcb, const void *data, u16_t len, const ip_addr_t *src, u16_t srcPort);
@@ -0,0 +1,13 @@
+#pragma once
+// Counters of the in-memory NVS in nvs_shim.cpp. Flash use is counted the
+// way NVS lays entries out: 32 bytes for an integer, a string takes one more
+// entry per 32 bytes of data, a blob two more (its index and data header).
+#include <stddef.h>
+
+extern size_t hostNvsBytesWritten;
+extern size_t hostNvsWrites;
+extern size_t hostNvsReads;
+extern size_t hostNvsCommits;
+
+// forget every namespace, as after erasing the partition
+void hostNvsErase();
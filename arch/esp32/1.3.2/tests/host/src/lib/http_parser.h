@@ -0,0 +1,10 @@
+#pragma once
+#define HTTP_METHOD_MAP(XX) \
+  XX(0, DELETE, DELETE) XX(1, GET, GET) XX(2, HEAD, HEAD) XX(3, POST, POST) XX(4, PUT, PUT) \
+  XX(5, CONNECT, CONNECT) XX(6, OPTIONS, OPTIONS) XX(7, TRACE, TRACE) XX(28, PATCH, PATCH)
+enum http_method {
+#define XX(num, name, string) HTTP_##name = num,
+  HTTP_METHOD_MAP(XX)
+#undef XX
+};
+const char *http_method_str(int);
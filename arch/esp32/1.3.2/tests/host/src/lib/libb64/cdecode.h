@@ -0,0 +1,2 @@
+#pragma once
+int base64_decode_chars(const char*, int, char*);
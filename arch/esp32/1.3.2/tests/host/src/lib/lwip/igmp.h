@@ -0,0 +1,13 @@
+#pragma once
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+err_t igmp_joingroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr);
+err_t igmp_joingroup_netif(struct netif *netif, const ip4_addr_t *groupaddr);
+err_t igmp_leavegroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr);
+err_t igmp_leavegroup_netif(struct netif *netif, const ip4_addr_t *groupaddr);
+#ifdef __cplusplus
+}
+#endif
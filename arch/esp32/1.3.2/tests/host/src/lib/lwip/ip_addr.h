@@ -0,0 +1,35 @@
+#pragma once
+// lwIP addresses as built without IPv6 (CONFIG_LWIP_IPV6 is not set)
+#include <stdint.h>
+
+typedef uint32_t u32_t;
+typedef uint16_t u16_t;
+typedef uint8_t u8_t;
+typedef int8_t err_t;
+
+typedef struct ip4_addr {
+  u32_t addr;
+} ip4_addr_t;
+typedef ip4_addr_t ip_addr_t;
+
+#define IPADDR_TYPE_V4  0U
+#define IPADDR_TYPE_V6  6U
+#define IPADDR_TYPE_ANY 46U
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern const ip_addr_t ip_addr_any;
+extern const ip_addr_t ip_addr_broadcast;
+#ifdef __cplusplus
+}
+#endif
+
+#define IP_ADDR_ANY       (&ip_addr_any)
+#define IP4_ADDR_ANY      (&ip_addr_any)
+#define IP_ANY_TYPE       (&ip_addr_any)
+#define IP_ADDR_BROADCAST (&ip_addr_broadcast)
+
+#define IP_SET_TYPE_VAL(ipaddr, iptype)
+#define ip_addr_copy(dest, src)   ((dest) = (src))
+#define ip_addr_ismulticast(ipaddr) ((((const uint8_t *)&(ipaddr)->addr)[0] & 0xf0) == 0xe0)
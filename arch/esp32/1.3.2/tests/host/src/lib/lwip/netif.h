@@ -0,0 +1,19 @@
+#pragma once
+#include "lwip/ip_addr.h"
+
+struct netif {
+  struct netif *next;
+  char name[2];
+  u8_t num;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern struct netif *netif_list;
+extern struct netif *netif_default;
+struct netif *netif_get_by_index(u8_t idx);
+struct netif *ip_current_input_netif(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+#include "lwip/ip_addr.h"
+
+#define ERR_OK  0
+#define ERR_MEM -1
+#define ERR_VAL -6
@@ -0,0 +1,32 @@
+#pragma once
+#include "lwip/opt.h"
+
+typedef enum {
+  PBUF_TRANSPORT = 74,
+} pbuf_layer;
+
+typedef enum {
+  PBUF_RAM = 0x0280,
+  PBUF_REF = 0x0041,
+} pbuf_type;
+
+struct pbuf {
+  struct pbuf *next;
+  void *payload;
+  u16_t tot_len;
+  u16_t len;
+  u8_t type_internal;
+  u8_t flags;
+  u8_t ref;
+  u8_t if_idx;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type);
+void pbuf_ref(struct pbuf *p);
+u8_t pbuf_free(struct pbuf *p);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+#include "lwip/opt.h"
+
+struct tcpip_api_call_data {
+  err_t err;
+};
+typedef err_t (*tcpip_api_call_fn)(struct tcpip_api_call_data *call);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data *call);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include "lwip/ip_addr.h"
+
+#define SIZEOF_ETH_HDR 14
+#define IP_HLEN        20
+
+struct eth_addr {
+  u8_t addr[6];
+};
+
+struct eth_hdr {
+  struct eth_addr dest;
+  struct eth_addr src;
+  u16_t type;
+};
+
+struct ip_hdr {
+  u8_t _v_hl;
+  u8_t _tos;
+  u16_t _len;
+  u16_t _id;
+  u16_t _offset;
+  u8_t _ttl;
+  u8_t _proto;
+  u16_t _chksum;
+  ip4_addr_t src;
+  ip4_addr_t dest;
+};
@@ -0,0 +1,213 @@
+// lwIP and esp_netif stand-ins: pbufs on the heap with the header room lwIP
+// keeps in front of a payload, pcbs in a list, and a tcpip thread that
+// tcpip_api_call() hands its function to and waits for, like the target does
+// without core locking. With hostTcpipCoreLocking it runs the function in
+// place under a lock instead.
+#include "host_lwip.h"
+#include "lwip/igmp.h"
+#include "lwip/inet.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "esp_netif.h"
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#define HOST_PBUF_HEADROOM (SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + 2)
+
+const ip_addr_t ip_addr_any = {0};
+const ip_addr_t ip_addr_broadcast = {0xffffffffUL};
+
+// the address datagrams for a pcb bound to any address were sent to
+static const ip_addr_t hostNetifIp = {0x0104a8c0UL};  // 192.168.4.1
+
+static struct netif hostNetif = {NULL, {'s', 't'}, 1};
+struct netif *netif_list = &hostNetif;
+struct netif *netif_default = &hostNetif;
+
+std::atomic<long> hostPbufsAlive{0};
+std::atomic<long> hostPbufAllocs{0};
+std::function<err_t(struct udp_pcb *, struct pbuf *, const ip_addr_t *, u16_t)> hostUdpOutput;
+static std::list<udp_pcb> pcbs;
+static std::mutex pcbsLock;
+
+struct netif *netif_get_by_index(u8_t) {
+  return &hostNetif;
+}
+
+struct netif *ip_current_input_netif(void) {
+  return &hostNetif;
+}
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *) {
+  return NULL;
+}
+
+int esp_netif_get_netif_impl_index(esp_netif_t *) {
+  return -1;
+}
+
+// never destroyed: the thread is still waiting on it when the spec exits
+struct TcpipThread {
+  std::mutex lock;
+  std::condition_variable called;
+  std::mutex callers;
+  tcpip_api_call_fn fn = NULL;
+  struct tcpip_api_call_data *call = NULL;
+  err_t err = ERR_OK;
+
+  void run() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+      called.wait(guard, [this] {
+        return fn != NULL;
+      });
+      err = fn(call);
+      fn = NULL;
+      called.notify_all();
+    }
+  }
+};
+
+bool hostTcpipCoreLocking = false;
+
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data *call) {
+  if (hostTcpipCoreLocking) {
+    static std::recursive_mutex core;
+    std::lock_guard<std::recursive_mutex> lock(core);
+    return fn(call);
+  }
+  static TcpipThread *tcpip = [] {
+    TcpipThread *t = new TcpipThread;
+    std::thread(&TcpipThread::run, t).detach();
+    return t;
+  }();
+  std::lock_guard<std::mutex> one(tcpip->callers);
+  std::unique_lock<std::mutex> guard(tcpip->lock);
+  tcpip->fn = fn;
+  tcpip->call = call;
+  tcpip->called.notify_all();
+  tcpip->called.wait(guard, [] {
+    return tcpip->fn == NULL;
+  });
+  return tcpip->err;
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer, u16_t length, pbuf_type type) {
+  // PBUF_REF points at the caller's data, the others carry their own
+  size_t room = type == PBUF_REF ? 0 : HOST_PBUF_HEADROOM + length;
+  uint8_t *mem = (uint8_t *)malloc(sizeof(pbuf) + room);
+  if (!mem) {
+    return NULL;
+  }
+  pbuf *p = (pbuf *)mem;
+  memset(p, 0, sizeof(pbuf));
+  p->payload = type == PBUF_REF ? NULL : mem + sizeof(pbuf) + HOST_PBUF_HEADROOM;
+  p->tot_len = p->len = length;
+  p->ref = 1;
+  hostPbufsAlive++;
+  hostPbufAllocs++;
+  return p;
+}
+
+void pbuf_ref(struct pbuf *p) {
+  __atomic_add_fetch(&p->ref, 1, __ATOMIC_SEQ_CST);
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+  if (__atomic_sub_fetch(&p->ref, 1, __ATOMIC_SEQ_CST)) {
+    return 0;
+  }
+  free(p);
+  hostPbufsAlive--;
+  return 1;
+}
+
+struct udp_pcb *udp_new(void) {
+  std::lock_guard<std::mutex> lock(pcbsLock);
+  pcbs.emplace_back();
+  udp_pcb *pcb = &pcbs.back();
+  memset(pcb, 0, sizeof(udp_pcb));
+  return pcb;
+}
+
+void udp_remove(struct udp_pcb *pcb) {
+  std::lock_guard<std::mutex> lock(pcbsLock);
+  pcbs.remove_if([pcb](const udp_pcb &p) {
+    return &p == pcb;
+  });
+}
+
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+  pcb->local_ip = *ipaddr;
+  pcb->local_port = port;
+  return ERR_OK;
+}
+
+err_t udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+  pcb->remote_ip = *ipaddr;
+  pcb->remote_port = port;
+  return ERR_OK;
+}
+
+void udp_disconnect(struct udp_pcb *pcb) {
+  pcb->remote_ip = ip_addr_any;
+  pcb->remote_port = 0;
+}
+
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {
+  pcb->recv = recv;
+  pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port) {
+  return hostUdpOutput ? hostUdpOutput(pcb, p, dst_ip, dst_port) : ERR_OK;
+}
+
+err_t udp_sendto_if(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port, struct netif *) {
+  return udp_sendto(pcb, p, dst_ip, dst_port);
+}
+
+err_t igmp_joingroup(const ip4_addr_t *, const ip4_addr_t *) {
+  return ERR_OK;
+}
+
+err_t igmp_joingroup_netif(struct netif *, const ip4_addr_t *) {
+  return ERR_OK;
+}
+
+err_t igmp_leavegroup(const ip4_addr_t *, const ip4_addr_t *) {
+  return ERR_OK;
+}
+
+err_t igmp_leavegroup_netif(struct netif *, const ip4_addr_t *) {
+  return ERR_OK;
+}
+
+struct udp_pcb *hostUdpFind(u16_t port) {
+  std::lock_guard<std::mutex> lock(pcbsLock);
+  for (udp_pcb &pcb : pcbs) {
+    if (pcb.local_port == port) {
+      return &pcb;
+    }
+  }
+  return NULL;
+}
+
+void hostUdpInput(struct udp_pcb *pcb, const void *data, u16_t len, const ip_addr_t *src, u16_t srcPort) {
+  pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+  memcpy(p->payload, data, len);
+  udp_hdr *udphdr = (udp_hdr *)((uint8_t *)p->payload - UDP_HLEN);
+  udphdr->src = htons(srcPort);
+  udphdr->dest = htons(pcb->local_port);
+  udphdr->len = htons(UDP_HLEN + len);
+  ip_hdr *iphdr = (ip_hdr *)((uint8_t *)udphdr - IP_HLEN);
+  iphdr->src = *src;
+  iphdr->dest = pcb->local_ip.addr ? pcb->local_ip : hostNetifIp;
+  eth_hdr *eth = (eth_hdr *)((uint8_t *)iphdr - SIZEOF_ETH_HDR);
+  memset(eth, 0x02, sizeof(eth_hdr));
+  pcb->recv(pcb->recv_arg, pcb, p, src, srcPort);
+}
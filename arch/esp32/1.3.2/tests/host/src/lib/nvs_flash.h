@@ -0,0 +1,12 @@
+#pragma once
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t nvs_flash_init_partition(const char *partition_label);
+
+#ifdef __cplusplus
+}
+#endif
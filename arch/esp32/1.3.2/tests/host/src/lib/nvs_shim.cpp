@@ -0,0 +1,172 @@
+// NVS in memory: namespaces of typed keys, with every write counted in the
+// flash it would take. Like NVS, a value identical to the stored one is not
+// written again.
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "host_nvs.h"
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+struct NvsItem {
+  nvs_type_t type;
+  std::vector<uint8_t> data;
+};
+
+static std::map<std::string, std::map<std::string, NvsItem>> store;
+static std::vector<std::string> handles(1);
+
+size_t hostNvsBytesWritten = 0;
+size_t hostNvsWrites = 0;
+size_t hostNvsReads = 0;
+size_t hostNvsCommits = 0;
+
+void hostNvsErase() {
+  store.clear();
+}
+
+static size_t entries(const NvsItem &item) {
+  size_t data = (item.data.size() + 31) / 32;
+  if (item.type == NVS_TYPE_STR) {
+    return 1 + data;
+  }
+  if (item.type == NVS_TYPE_BLOB) {
+    return 2 + data;
+  }
+  return 1;
+}
+
+static std::map<std::string, NvsItem> &keys(nvs_handle_t handle) {
+  return store[handles.at(handle)];
+}
+
+static esp_err_t put(nvs_handle_t handle, const char *key, nvs_type_t type, const void *value, size_t len) {
+  hostNvsReads++;
+  NvsItem item = {type, std::vector<uint8_t>((const uint8_t *)value, (const uint8_t *)value + len)};
+  std::map<std::string, NvsItem> &ns = keys(handle);
+  auto it = ns.find(key);
+  if (it != ns.end() && it->second.type == type && it->second.data == item.data) {
+    return ESP_OK;
+  }
+  hostNvsWrites++;
+  hostNvsBytesWritten += entries(item) * 32;
+  ns[key] = item;
+  return ESP_OK;
+}
+
+// integers must match in size, strings and blobs fit in *len
+static esp_err_t get(nvs_handle_t handle, const char *key, nvs_type_t type, void *out, size_t *len, bool exact) {
+  hostNvsReads++;
+  std::map<std::string, NvsItem> &ns = keys(handle);
+  auto it = ns.find(key);
+  if (it == ns.end()) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (it->second.type != type) {
+    return ESP_ERR_NVS_TYPE_MISMATCH;
+  }
+  size_t stored = it->second.data.size();
+  if (!out) {
+    *len = stored;
+    return ESP_OK;
+  }
+  if (exact ? *len != stored : *len < stored) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out, it->second.data.data(), stored);
+  *len = stored;
+  return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t, nvs_handle_t *out_handle) {
+  handles.push_back(name);
+  *out_handle = handles.size() - 1;
+  return ESP_OK;
+}
+
+esp_err_t nvs_open_from_partition(const char *, const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+  return nvs_open(name, open_mode, out_handle);
+}
+
+esp_err_t nvs_flash_init_partition(const char *) {
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t) {}
+
+esp_err_t nvs_commit(nvs_handle_t) {
+  hostNvsCommits++;
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  hostNvsReads++;
+  if (!keys(handle).erase(key)) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  // the entry is marked erased in place
+  hostNvsWrites++;
+  hostNvsBytesWritten += 32;
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+  hostNvsWrites++;
+  keys(handle).clear();
+  return ESP_OK;
+}
+
+#define NVS_INTEGER(name, T, type)                                      \
+  esp_err_t nvs_set_##name(nvs_handle_t handle, const char *key, T value) { \
+    return put(handle, key, type, &value, sizeof(value));               \
+  }                                                                     \
+  esp_err_t nvs_get_##name(nvs_handle_t handle, const char *key, T *out) {  \
+    size_t len = sizeof(T);                                             \
+    return get(handle, key, type, out, &len, true);                     \
+  }
+
+NVS_INTEGER(u8, uint8_t, NVS_TYPE_U8)
+NVS_INTEGER(i8, int8_t, NVS_TYPE_I8)
+NVS_INTEGER(u16, uint16_t, NVS_TYPE_U16)
+NVS_INTEGER(i16, int16_t, NVS_TYPE_I16)
+NVS_INTEGER(u32, uint32_t, NVS_TYPE_U32)
+NVS_INTEGER(i32, int32_t, NVS_TYPE_I32)
+NVS_INTEGER(u64, uint64_t, NVS_TYPE_U64)
+NVS_INTEGER(i64, int64_t, NVS_TYPE_I64)
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+  return put(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+  return get(handle, key, NVS_TYPE_STR, out_value, length, false);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+  return put(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+  return get(handle, key, NVS_TYPE_BLOB, out_value, length, false);
+}
+
+// the default 20 KB partition: 5 pages of 126 entries, one kept free
+esp_err_t nvs_get_stats(const char *, nvs_stats_t *nvs_stats) {
+  memset(nvs_stats, 0, sizeof(*nvs_stats));
+  nvs_stats->total_entries = 4 * 126;
+  for (auto &ns : store) {
+    nvs_stats->namespace_count++;
+    nvs_stats->used_entries++;
+    for (auto &key : ns.second) {
+      nvs_stats->used_entries += entries(key.second);
+    }
+  }
+  nvs_stats->free_entries = nvs_stats->total_entries - std::min(nvs_stats->used_entries, nvs_stats->total_entries);
+  return ESP_OK;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+  return code == ESP_OK ? "ESP_OK" : code == ESP_ERR_NVS_NOT_FOUND ? "ESP_ERR_NVS_NOT_FOUND" : "ESP_FAIL";
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string.h>
+#define PROGMEM
+#define PGM_P const char *
+#define PGM_VOID_P const void *
+#define PSTR(s) (s)
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define memccpy_P memccpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strstr_P strstr
+#define pgm_read_byte(a) (*(const unsigned char *)(a))
+#define pgm_read_word(a) (*(const unsigned short *)(a))
+#define pgm_read_dword(a) (*(const unsigned long *)(a))
+#define sprintf_P sprintf
+#define snprintf_P snprintf
@@ -0,0 +1,4 @@
+#pragma once
+#define CONFIG_TCP_MSS                   1436
+#define CONFIG_ARDUINO_UDP_TASK_PRIORITY 3
+#define CONFIG_ARDUINO_UDP_RUNNING_CORE  -1
@@ -0,0 +1,2 @@
+#pragma once
+#define SPI_FLASH_SEC_SIZE 4096
@@ -0,0 +1,144 @@
+// Preferences on the in-memory NVS: the commits a batch saves, nesting,
+// end() with a batch still open, and the flash a struct blob takes against
+// one key per field.
+#include "Preferences.h"
+#include "host_nvs.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+static const int FIELDS = 20;
+
+struct Config {
+  int32_t field[FIELDS];
+};
+
+static const char *key(int i) {
+  static char keys[FIELDS][8];
+  snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+  return keys[i];
+}
+
+static void test_batch() {
+  Preferences prefs;
+  CHECK(prefs.begin("batch"));
+
+  size_t commits = hostNvsCommits, bytes = hostNvsBytesWritten;
+  for (int i = 0; i < FIELDS; i++) {
+    CHECK(prefs.putInt(key(i), i) == 4);
+  }
+  size_t plainCommits = hostNvsCommits - commits, plainBytes = hostNvsBytesWritten - bytes;
+  CHECK(plainCommits == FIELDS);
+
+  commits = hostNvsCommits;
+  bytes = hostNvsBytesWritten;
+  {
+    PreferencesBatch batch(prefs);
+    for (int i = 0; i < FIELDS; i++) {
+      CHECK(prefs.putInt(key(i), i + 100) == 4);
+    }
+    CHECK(prefs.remove("k0") && prefs.putString("name", "batched") == 7);
+    CHECK(hostNvsCommits == commits);
+    // reads inside the batch see the writes
+    CHECK(prefs.getInt("k5") == 105 && !prefs.isKey("k0"));
+  }
+  size_t batchCommits = hostNvsCommits - commits;
+  CHECK(batchCommits == 1);
+  CHECK(prefs.getInt("k19") == 119 && prefs.getString("name") == "batched");
+
+  // a batch with nothing written does not commit
+  commits = hostNvsCommits;
+  CHECK(prefs.beginBatch() && prefs.commitBatch());
+  CHECK(hostNvsCommits == commits);
+
+  // clear() is deferred like a put
+  {
+    PreferencesBatch batch(prefs);
+    CHECK(prefs.clear() && prefs.putInt("after", 1) == 4);
+    CHECK(hostNvsCommits == commits);
+  }
+  CHECK(hostNvsCommits == commits + 1 && prefs.getInt("after") == 1 && !prefs.isKey("k1"));
+  CHECK(!prefs.commitBatch());
+  prefs.end();
+
+  printf("%d int puts: %zu commits, %zu bytes written; in a batch %zu commit\n", FIELDS, plainCommits, plainBytes, batchCommits);
+}
+
+static void test_nested() {
+  Preferences prefs;
+  CHECK(prefs.begin("nested"));
+  size_t commits = hostNvsCommits;
+  CHECK(prefs.beginBatch());
+  prefs.putInt("outer", 1);
+  {
+    // a helper with its own batch inside the caller's
+    PreferencesBatch batch(prefs);
+    prefs.putInt("inner", 2);
+  }
+  CHECK(hostNvsCommits == commits);
+  prefs.putInt("outer", 3);
+  CHECK(prefs.commitBatch());
+  CHECK(hostNvsCommits == commits + 1);
+  CHECK(prefs.getInt("outer") == 3 && prefs.getInt("inner") == 2);
+
+  // end() commits a batch left open, however deep
+  commits = hostNvsCommits;
+  CHECK(prefs.beginBatch() && prefs.beginBatch());
+  prefs.putInt("open", 5);
+  prefs.end();
+  CHECK(hostNvsCommits == commits + 1);
+  CHECK(!prefs.beginBatch() && !prefs.commitBatch());
+  CHECK(prefs.begin("nested") && prefs.getInt("open") == 5);
+  // and the next begin() starts outside any batch
+  commits = hostNvsCommits;
+  prefs.putInt("open", 6);
+  CHECK(hostNvsCommits == commits + 1 && !prefs.commitBatch());
+  prefs.end();
+
+  // nothing to batch when read-only
+  CHECK(prefs.begin("nested", true));
+  CHECK(!prefs.beginBatch() && !prefs.commitBatch());
+  prefs.end();
+}
+
+static void test_struct() {
+  Preferences prefs;
+  CHECK(prefs.begin("struct"));
+  Config config;
+  for (int i = 0; i < FIELDS; i++) {
+    config.field[i] = i * 3;
+  }
+  size_t commits = hostNvsCommits, bytes = hostNvsBytesWritten;
+  CHECK(prefs.putStruct("config", config) == sizeof(config));
+  size_t structBytes = hostNvsBytesWritten - bytes;
+  CHECK(hostNvsCommits - commits == 1);
+  // one 32 byte entry per field against the blob's index, header and data
+  CHECK(structBytes == (2 + (sizeof(config) + 31) / 32) * 32 && structBytes < FIELDS * 32);
+
+  Config back = {};
+  CHECK(prefs.getStruct("config", back) && memcmp(&back, &config, sizeof(config)) == 0);
+  // a struct whose layout changed keeps its defaults
+  struct Other {
+    int32_t a;
+  } other = {7};
+  CHECK(!prefs.getStruct("config", other) && other.a == 7);
+  CHECK(!prefs.getStruct("missing", back));
+  prefs.end();
+
+  printf("%d int fields: %d bytes written as keys, %zu as one struct\n", FIELDS, FIELDS * 32, structBytes);
+}
+
+int main() {
+  test_batch();
+  test_nested();
+  test_struct();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// The Preferences read cache on the in-memory NVS: a control loop reading
+// its tuning values with and without it, then that every write through the
+// object is seen and that more keys than entries still read back right.
+#include "Preferences.h"
+#include "host_nvs.h"
+#include <chrono>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+using namespace std::chrono;
+
+static const char *key(int i) {
+  static char keys[30][8];
+  snprintf(keys[i], sizeof(keys[i]), "o%d", i);
+  return keys[i];
+}
+
+// six reads per round, one of a key that was never stored
+static double control(Preferences &prefs, int rounds, float &sum) {
+  auto t0 = steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    sum += prefs.getFloat("kp") + prefs.getFloat("ki") + prefs.getInt("limit") + prefs.getUInt("period") + (prefs.getBool("invert") ? 1 : 0)
+           + prefs.getInt("absent", 3);
+  }
+  return duration<double, std::nano>(steady_clock::now() - t0).count() / (rounds * 6);
+}
+
+static void test_hits() {
+  Preferences prefs;
+  CHECK(prefs.begin("tuning"));
+  prefs.putFloat("kp", 1.5f);
+  prefs.putFloat("ki", 0.25f);
+  prefs.putInt("limit", -40);
+  prefs.putUInt("period", 20);
+  prefs.putBool("invert", true);
+  // other keys in the namespace
+  for (int i = 0; i < 30; i++) {
+    prefs.putInt(key(i), i);
+  }
+
+  const int rounds = 200000;
+  float plainSum = 0, cachedSum = 0;
+  size_t reads = hostNvsReads;
+  double plain = control(prefs, rounds, plainSum);
+  size_t plainReads = hostNvsReads - reads;
+  CHECK(prefs.cacheHits() == 0 && prefs.cacheMisses() == 0);
+
+  CHECK(prefs.enableCache());
+  reads = hostNvsReads;
+  double cached = control(prefs, rounds, cachedSum);
+  size_t cachedReads = hostNvsReads - reads;
+  CHECK(cachedSum == plainSum);
+  // the first round misses each value once, the missing key included
+  CHECK(prefs.cacheMisses() == 6 && prefs.cacheHits() == rounds * 6 - 6);
+  CHECK(cachedReads < 6 * 2 && plainReads >= (size_t)rounds * 6);
+  CHECK(cached < plain);
+  prefs.end();
+
+  printf(
+    "%d rounds of 6 gets: %.0f ns/get and %zu NVS lookups uncached, %.0f ns/get and %zu lookups cached (%u hits, %u misses)\n", rounds, plain,
+    plainReads, cached, cachedReads, prefs.cacheHits(), prefs.cacheMisses()
+  );
+}
+
+static void test_invalidate() {
+  Preferences prefs;
+  CHECK(prefs.begin("tuning") && prefs.enableCache());
+  CHECK(prefs.getInt("limit") == -40);
+  prefs.putInt("limit", 7);
+  CHECK(prefs.getInt("limit") == 7);
+
+  // a missing key is cached until it is written
+  CHECK(prefs.getInt("absent", 3) == 3);
+  prefs.putInt("absent", 9);
+  CHECK(prefs.getInt("absent", 3) == 9);
+  // another type of the same key is not the int
+  CHECK(prefs.getUInt("absent", 5) == 5);
+  CHECK(prefs.remove("absent"));
+  CHECK(prefs.getInt("absent", 4) == 4);
+
+  CHECK(prefs.getFloat("kp") == 1.5f);
+  prefs.putFloat("kp", 2.5f);
+  CHECK(prefs.getFloat("kp") == 2.5f);
+  // in a batch too, before the commit
+  {
+    PreferencesBatch batch(prefs);
+    prefs.putFloat("kp", 3.5f);
+    CHECK(prefs.getFloat("kp") == 3.5f);
+  }
+  CHECK(prefs.clear());
+  CHECK(prefs.getFloat("kp", 0.5f) == 0.5f && prefs.getInt("limit") == 0);
+
+  // more keys than entries
+  for (int i = 0; i < 30; i++) {
+    prefs.putInt(key(i), i * 2);
+  }
+  bool right = true;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 30; i++) {
+      right = right && prefs.getInt(key(i)) == i * 2;
+    }
+  }
+  CHECK(right);
+
+  // end() empties the cache, what it held was stored
+  prefs.end();
+  uint32_t hits = prefs.cacheHits(), misses = prefs.cacheMisses();
+  CHECK(prefs.begin("tuning") && prefs.getInt(key(3)) == 6);
+  CHECK(prefs.cacheHits() == hits && prefs.cacheMisses() == misses + 1);
+  // and once turned off the cache is not looked at
+  CHECK(prefs.enableCache(false) && prefs.getInt(key(3)) == 6);
+  CHECK(prefs.cacheHits() == hits && prefs.cacheMisses() == misses + 1);
+  prefs.end();
+}
+
+int main() {
+  test_hits();
+  test_invalidate();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
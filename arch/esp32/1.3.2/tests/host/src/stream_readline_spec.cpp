@@ -0,0 +1,173 @@
+// Stream::readLine() on a memory-backed Stream, with and without the peek
+// buffer API: same lines as readStringUntil(), truncation reported and the
+// rest of a long line skipped, then both timed against readStringUntil().
+// Last, how WebServer treats lines of WEBSERVER_MAX_LINE_LENGTH and more.
+#include <Arduino.h>
+#include "WebServer.h"
+#include <chrono>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+// reads `data`, the peek buffer shows at most `chunk` bytes at a time
+class MemoryStream : public Stream {
+public:
+  std::string data;
+  size_t pos = 0;
+  size_t chunk = 1436;
+  bool peekApi;
+
+  MemoryStream(const std::string &d, bool peek) : data(d), peekApi(peek) {
+    setTimeout(0);
+  }
+  int available() override {
+    return data.size() - pos;
+  }
+  int read() override {
+    return pos < data.size() ? (uint8_t)data[pos++] : -1;
+  }
+  int peek() override {
+    return pos < data.size() ? (uint8_t)data[pos] : -1;
+  }
+  size_t write(uint8_t) override {
+    return 0;
+  }
+  bool hasPeekBufferAPI() const override {
+    return peekApi;
+  }
+  size_t peekAvailable() override {
+    return std::min(chunk, data.size() - pos);
+  }
+  const char *peekBuffer() override {
+    return data.data() + pos;
+  }
+  void peekConsume(size_t consume) override {
+    pos += consume;
+  }
+};
+
+static void test_lines(bool peek) {
+  MemoryStream s("GET / HTTP/1.1\r\n\r\nno terminator", peek);
+  char buf[32];
+  bool truncated = true;
+  CHECK(s.readLine(buf, sizeof(buf), '\n', &truncated) == 15 && strcmp(buf, "GET / HTTP/1.1\r") == 0 && !truncated);
+  CHECK(s.readLine(buf, sizeof(buf)) == 1 && strcmp(buf, "\r") == 0);
+  CHECK(s.readLine(buf, sizeof(buf)) == 13 && strcmp(buf, "no terminator") == 0);
+  CHECK(s.readLine(buf, sizeof(buf), '\n', &truncated) == 0 && buf[0] == 0 && !truncated);
+
+  // a line that exactly fits, one that is a char too long, and the line after it
+  std::string fits(sizeof(buf) - 1, 'a');
+  std::string over(sizeof(buf), 'b');
+  MemoryStream l(fits + "\n" + over + "\nnext\n", peek);
+  l.chunk = 5;
+  CHECK(l.readLine(buf, sizeof(buf), '\n', &truncated) == fits.size() && buf == fits && !truncated);
+  CHECK(l.readLine(buf, sizeof(buf), '\n', &truncated) == sizeof(buf) - 1 && truncated);
+  CHECK(l.readLine(buf, sizeof(buf), '\n', &truncated) == 4 && strcmp(buf, "next") == 0 && !truncated);
+
+  MemoryStream t("abc", peek);
+  CHECK(t.readLine(buf, 1, '\n', &truncated) == 0 && buf[0] == 0 && truncated);
+  CHECK(t.readLine(nullptr, 0) == 0 && t.available() == 0);
+}
+
+// a response head worth of header lines, repeated
+static std::string headerLines(size_t count) {
+  std::string text;
+  const char *lines[] = {"Content-Type: text/html; charset=utf-8", "Content-Length: 12345", "Connection: keep-alive", "Cache-Control: no-cache",
+                         "Set-Cookie: session=0123456789abcdef0123456789abcdef; Path=/; HttpOnly", "X-Request-Id: 9f2c1e7a-55b1-4a3e-9d0e-3c6f1a2b7d48"};
+  for (size_t i = 0; i < count; i++) {
+    text += lines[i % 6];
+    text += "\r\n";
+  }
+  return text;
+}
+
+template<class F> static double time_us(F f) {
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void bench() {
+  const size_t count = 200000;
+  std::string text = headerLines(count);
+  size_t linesA = 0, linesB = 0, linesC = 0;
+  MemoryStream a(text, false), b(text, false), c(text, true);
+  char buf[256];
+  double untilUs = time_us([&] {
+    while (a.available()) {
+      String line = a.readStringUntil('\n');
+      linesA++;
+    }
+  });
+  double readUs = time_us([&] {
+    while (b.available()) {
+      b.readLine(buf, sizeof(buf));
+      linesB++;
+    }
+  });
+  double peekUs = time_us([&] {
+    while (c.available()) {
+      c.readLine(buf, sizeof(buf));
+      linesC++;
+    }
+  });
+  CHECK(linesA == count && linesB == count && linesC == count);
+  double mb = text.size() / 1e6;
+  printf(
+    "header lines: readStringUntil %.0f MB/s, readLine %.0f MB/s, readLine with peek buffer %.0f MB/s\n", mb / untilUs * 1e6, mb / readUs * 1e6,
+    mb / peekUs * 1e6
+  );
+}
+
+struct TestServer : WebServer {
+  using WebServer::WebServer;
+
+  std::string run(const std::string &request) {
+    auto socket = std::make_shared<NetworkClient::Socket>();
+    socket->in = request;
+    _server.pending.push_back(NetworkClient(socket));
+    for (int i = 0; i < 10 && socket->out.empty(); i++) {
+      handleClient();
+    }
+    return socket->out;
+  }
+};
+
+static void test_webserver_limits() {
+  static TestServer server(80);
+  server.on("/", [] {
+    server.send(200, "text/plain", server.header("X-Fits") + "|" + server.header("X-Long") + "|" + server.header("X-After"));
+  });
+  const char *headers[] = {"X-Fits", "X-Long", "X-After"};
+  server.collectHeaders(headers, 3);
+  server.begin();
+
+  // "X-Fits: " plus the value is one char short of the limit
+  std::string fits(WEBSERVER_MAX_LINE_LENGTH - 1 - 8, 'f');
+  std::string r = server.run("GET / HTTP/1.1\r\nX-Fits: " + fits + "\r\nX-Long: " + std::string(WEBSERVER_MAX_LINE_LENGTH, 'l') + "\r\nX-After: yes\r\n\r\n");
+  CHECK(r.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+  CHECK(r.size() > fits.size() && r.compare(r.size() - fits.size() - 5, std::string::npos, fits + "||yes") == 0);
+
+  // a request line that does not fit is refused
+  r = server.run("GET /" + std::string(WEBSERVER_MAX_LINE_LENGTH, 'u') + " HTTP/1.1\r\n\r\n");
+  CHECK(r.compare(0, 12, "HTTP/1.1 200") != 0 && r.compare(0, 12, "HTTP/1.1 404") != 0);
+  r = server.run("GET /?q=" + std::string(WEBSERVER_MAX_LINE_LENGTH - 30, 'u') + " HTTP/1.1\r\n\r\n");
+  CHECK(r.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+}
+
+int main() {
+  test_lines(false);
+  test_lines(true);
+  bench();
+  test_webserver_limits();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+// Update.writeStream() into a file-backed flash partition from a network
+// stream stand-in, both with the time flash and network take. The pipelined
+// path against the sector by sector one it falls back to when the flash task
+// cannot be created, then a short stream, a stalling stream and a flash write
+// failing while the next sector is being read.
+#include <Arduino.h>
+#include "Update.h"
+#include "esp_image_format.h"
+#include "spi_flash_mmap.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+using namespace std::chrono;
+
+// flash: a temp file, erasing and writing each take 1 ms per sector
+static esp_partition_t partition = {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_DATA_FAT, 0x10000, 1 << 20, "app1", false};
+static FILE *flash;
+static std::atomic<size_t> failWritesFrom{SIZE_MAX};  // partition offset of the first failing write
+static std::atomic<int> writesAfterFailure{0};
+static bool slowFlash = true;
+
+EspClass ESP;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *) {
+  return &partition;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *) {
+  return &partition;
+}
+
+int esp_ota_set_boot_partition(const esp_partition_t *) {
+  return 0;
+}
+
+static void busy(size_t size, int usPerSector) {
+  if (slowFlash) {
+    std::this_thread::sleep_for(microseconds(size / SPI_FLASH_SEC_SIZE * usPerSector));
+  }
+}
+
+bool EspClass::partitionEraseRange(const esp_partition_t *, uint32_t offset, size_t size) {
+  std::vector<uint8_t> erased(size, 0xff);
+  busy(size, 1000);
+  return pwrite(fileno(flash), erased.data(), size, offset) == (ssize_t)size;
+}
+
+bool EspClass::partitionWrite(const esp_partition_t *, uint32_t offset, uint32_t *data, size_t size) {
+  if (offset + size > failWritesFrom) {
+    writesAfterFailure += offset >= failWritesFrom + SPI_FLASH_SEC_SIZE;
+    return false;
+  }
+  busy(size, 1000);
+  return pwrite(fileno(flash), data, size, offset) == (ssize_t)size;
+}
+
+bool EspClass::partitionRead(const esp_partition_t *, uint32_t offset, uint32_t *data, size_t size) {
+  return pread(fileno(flash), data, size, offset) == (ssize_t)size;
+}
+
+static std::vector<uint8_t> flashContents(size_t size) {
+  std::vector<uint8_t> data(size);
+  CHECK(pread(fileno(flash), data.data(), size, 0) == (ssize_t)size);
+  return data;
+}
+
+// TCP stand-in: data arrives at `bytesPerUs` in 1436 byte segments, the sender
+// stalls once a receive window is unread. `stallAt` makes it go quiet once,
+// for `stallReads` reads, `end` cuts the stream short.
+struct NetStream : Stream {
+  const std::vector<uint8_t> &image;
+  size_t pos = 0;
+  size_t end;
+  size_t stallAt = SIZE_MAX;
+  int stallReads = 0;
+  double bytesPerUs = 2;
+  double arrived = 0;
+  steady_clock::time_point last = steady_clock::now();
+  static const size_t window = 5744;
+
+  NetStream(const std::vector<uint8_t> &i) : image(i), end(i.size()) {}
+  int available() override {
+    return end - pos;
+  }
+  int read() override {
+    return pos < end ? image[pos++] : -1;
+  }
+  int peek() override {
+    return pos < end ? image[pos] : -1;
+  }
+  size_t write(uint8_t) override {
+    return 0;
+  }
+  size_t readBytes(char *buffer, size_t length) override {
+    if (pos >= end) {
+      return 0;
+    }
+    if (pos >= stallAt && stallReads > 0) {
+      stallReads--;
+      return 0;
+    }
+    while (true) {
+      auto now = steady_clock::now();
+      arrived = std::min({(double)end, (double)(pos + window), arrived + duration<double, std::micro>(now - last).count() * bytesPerUs});
+      last = now;
+      if ((size_t)arrived > pos) {
+        length = std::min({length, (size_t)arrived - pos, (size_t)1436, stallAt > pos ? stallAt - pos : SIZE_MAX});
+        memcpy(buffer, image.data() + pos, length);
+        pos += length;
+        return length;
+      }
+      std::this_thread::sleep_for(microseconds(100));
+    }
+  }
+};
+
+static std::vector<uint8_t> makeImage(size_t size) {
+  std::vector<uint8_t> image(size);
+  std::mt19937 rng(1);
+  for (uint8_t &b : image) {
+    b = rng();
+  }
+  image[0] = ESP_IMAGE_HEADER_MAGIC;
+  return image;
+}
+
+// a whole update, returns MB/s
+static double update(const std::vector<uint8_t> &image) {
+  UpdateClass u;
+  size_t progress = 0;
+  int callbacks = 0;
+  u.onProgress([&](size_t done, size_t total) {
+    CHECK(done >= progress && total == image.size());
+    progress = done;
+    callbacks++;
+  });
+  CHECK(u.begin(image.size()));
+  NetStream stream(image);
+  auto t0 = steady_clock::now();
+  CHECK(u.writeStream(stream) == image.size());
+  CHECK(u.end());
+  double s = duration<double>(steady_clock::now() - t0).count();
+  CHECK(flashContents(image.size()) == image);
+  CHECK(progress == image.size() && callbacks > 1);
+  return image.size() / s / 1e6;
+}
+
+static bool sameStart(const std::vector<uint8_t> &image, size_t size) {
+  std::vector<uint8_t> data = flashContents(size);
+  // the first 16 bytes are only written by end(), once the image is complete
+  return std::equal(data.begin() + ENCRYPTED_BLOCK_SIZE, data.end(), image.begin() + ENCRYPTED_BLOCK_SIZE);
+}
+
+static void test_stream_errors(const std::vector<uint8_t> &image) {
+  slowFlash = false;
+  hostSkipDelays = true;
+
+  // the stream ends mid-sector, 30 s of retries later the update is aborted
+  {
+    UpdateClass u;
+    CHECK(u.begin(image.size()));
+    NetStream stream(image);
+    stream.end = 10 * SPI_FLASH_SEC_SIZE + 100;
+    CHECK(u.writeStream(stream) == 10 * SPI_FLASH_SEC_SIZE);
+    CHECK(u.getError() == UPDATE_ERROR_STREAM && !u.isRunning());
+    CHECK(sameStart(image, 10 * SPI_FLASH_SEC_SIZE));
+  }
+
+  // a stall shorter than the retry budget is sat out
+  {
+    UpdateClass u;
+    CHECK(u.begin(image.size()));
+    NetStream stream(image);
+    stream.stallAt = 5 * SPI_FLASH_SEC_SIZE + 700;
+    stream.stallReads = 250;
+    CHECK(u.writeStream(stream) == image.size() && u.end());
+    CHECK(flashContents(image.size()) == image);
+  }
+
+  // one as long as the budget aborts, with the sectors before it flashed
+  {
+    UpdateClass u;
+    CHECK(u.begin(image.size()));
+    NetStream stream(image);
+    stream.stallAt = 5 * SPI_FLASH_SEC_SIZE + 700;
+    stream.stallReads = 300;
+    CHECK(u.writeStream(stream) == 5 * SPI_FLASH_SEC_SIZE);
+    CHECK(u.getError() == UPDATE_ERROR_STREAM);
+    CHECK(sameStart(image, 5 * SPI_FLASH_SEC_SIZE));
+  }
+
+  hostSkipDelays = false;
+  slowFlash = true;
+}
+
+static void test_write_failure(const std::vector<uint8_t> &image) {
+  // the flash task fails sector 20 while sector 21 is read
+  UpdateClass u;
+  CHECK(u.begin(image.size()));
+  NetStream stream(image);
+  failWritesFrom = 20 * SPI_FLASH_SEC_SIZE;
+  CHECK(u.writeStream(stream) == 20 * SPI_FLASH_SEC_SIZE);
+  CHECK(u.getError() == UPDATE_ERROR_WRITE);
+  CHECK(stream.pos <= 22 * SPI_FLASH_SEC_SIZE);
+  CHECK(writesAfterFailure == 0);
+  CHECK(sameStart(image, 20 * SPI_FLASH_SEC_SIZE));
+  failWritesFrom = SIZE_MAX;
+}
+
+int main() {
+  flash = tmpfile();
+  CHECK(ftruncate(fileno(flash), partition.size) == 0);
+  std::vector<uint8_t> image = makeImage(512 * 1024 + 1000);
+
+  double pipelined = update(image);
+  hostTaskCreateFails = true;
+  double sequential = update(image);
+  hostTaskCreateFails = false;
+  printf("512 KB at 2 MB/s into 2 ms/sector flash: pipelined %.2f MB/s, sector by sector %.2f MB/s\n", pipelined, sequential);
+  // the TCP window already hides most of each sector write from the old loop
+  CHECK(pipelined > sequential * 0.9);
+
+  test_stream_errors(image);
+  test_write_failure(image);
+
+  fclose(flash);
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
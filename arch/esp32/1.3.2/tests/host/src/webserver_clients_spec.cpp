@@ -0,0 +1,132 @@
+// Several clients on one WebServer: a client that stops in the middle of its
+// request head and an open SSE stream must not hold up the others. Every
+// handleClient() pass has to return without waiting for any of them.
+#include <Arduino.h>
+#include "WebServer.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+typedef std::shared_ptr<NetworkClient::Socket> Socket;
+
+struct TestServer : WebServer {
+  using WebServer::WebServer;
+
+  // a new connection in the listen backlog that has sent `data` so far
+  Socket connect(const std::string &data) {
+    Socket socket = std::make_shared<NetworkClient::Socket>();
+    socket->in = data;
+    _server.pending.push_back(NetworkClient(socket));
+    return socket;
+  }
+};
+
+static TestServer server(80);
+static NetworkClient events;
+static double slowestPass = 0;
+
+// one handleClient() pass, keeping track of the longest one
+static void pass() {
+  auto t0 = std::chrono::steady_clock::now();
+  server.handleClient();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  slowestPass = std::max(slowestPass, ms);
+}
+
+static bool answered(const Socket &socket, const char *body) {
+  return socket->out.compare(0, 15, "HTTP/1.1 200 OK") == 0 && socket->out.find(body) != std::string::npos;
+}
+
+// the server dropped its copies of the client
+static bool released(const Socket &socket) {
+  return socket.use_count() == 1;
+}
+
+int main() {
+  server.on("/data", [] {
+    server.send(200, "text/plain", "data");
+  });
+  server.on("/echo", HTTP_POST, [] {
+    server.send(200, "text/plain", server.arg("plain"));
+  });
+  server.on("/events", [] {
+    server.client().setSSE(true);
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/event-stream", "");
+    events = server.client();
+  });
+  server.begin();
+
+  // stops after the first header, and a dashboard keeping its stream open
+  Socket slow = server.connect("GET /data HTTP/1.1\r\nHost: test\r\n");
+  Socket sse = server.connect("GET /events HTTP/1.1\r\nHost: test\r\n\r\n");
+  for (int i = 0; i < 5; i++) {
+    pass();
+  }
+  CHECK(sse->out.find("text/event-stream") != std::string::npos);
+  CHECK(slow->out.empty() && !released(slow));
+
+  // the remaining two slots serve everybody else
+  std::vector<Socket> fetchers;
+  for (int i = 0; i < 20; i++) {
+    fetchers.push_back(server.connect("GET /data HTTP/1.1\r\nHost: test\r\n\r\n"));
+  }
+  Socket post = server.connect("POST /echo HTTP/1.1\r\nHost: test\r\nContent-Length: 11\r\n\r\nhello world");
+  int passes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  while (passes < 200 && !(answered(post, "hello world") && answered(fetchers.back(), "data"))) {
+    pass();
+    passes++;
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  for (const Socket &f : fetchers) {
+    CHECK(answered(f, "data") && released(f));
+  }
+  CHECK(answered(post, "hello world"));
+  printf("21 requests next to a stalled client and an SSE stream: %d passes, %.2f ms\n", passes, ms);
+
+  // the stream is still open and the stalled client can finish its request
+  events.print("data: tick\n\n");
+  CHECK(sse->out.find("data: tick") != std::string::npos && !released(sse));
+  CHECK(slow->out.empty());
+  slow->in += "Accept: */*\r\n\r\n";
+  pass();
+  pass();
+  CHECK(answered(slow, "data"));
+
+  // a request head arriving a few bytes per pass
+  std::string request = "GET /data HTTP/1.1\r\nHost: test\r\nUser-Agent: drip\r\n\r\n";
+  Socket drip = server.connect("");
+  for (size_t i = 0; i < request.size(); i += 3) {
+    drip->in += request.substr(i, 3);
+    pass();
+    pass();
+    CHECK(i + 3 >= request.size() || drip->out.empty());
+  }
+  CHECK(answered(drip, "data"));
+
+  // a head that never ends is cut off at HTTP_MAX_HEAD_LEN
+  Socket flood = server.connect("GET /data HTTP/1.1\r\n");
+  for (int i = 0; i < 400; i++) {
+    flood->in += "X-Padding: 0123456789abcdef\r\n";
+  }
+  for (int i = 0; i < 20; i++) {
+    pass();
+  }
+  CHECK(flood->out.empty() && released(flood));
+
+  printf("slowest handleClient() pass: %.2f ms\n", slowestPass);
+  CHECK(slowestPass < 100);
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+// RouteIndex against the plain linear scan WebServer used to do: for random
+// route tables and requests the first handler accepting the request must be
+// the same either way. Also times both on a table of a few hundred routes.
+#include <Arduino.h>
+#include "WebServer.h"
+#include "uri/UriBraces.h"
+#include "uri/UriGlob.h"
+#include "uri/UriRegex.h"
+#include <chrono>
+#include <random>
+
+// matches like FunctionRequestHandler: stores uri.clone(), checks the method
+struct TestHandler : RequestHandler {
+  Uri *uri;
+  HTTPMethod method;
+
+  TestHandler(const Uri &u, HTTPMethod m) : uri(u.clone()), method(m) {
+    uri->initPathArgs(pathArgs);
+  }
+  ~TestHandler() {
+    delete uri;
+  }
+  bool canHandle(HTTPMethod m, const String &requestUri) override {
+    if (method != HTTP_ANY && method != m) {
+      return false;
+    }
+    return uri->canHandle(requestUri, pathArgs);
+  }
+  const Uri *routeUri() const override {
+    return uri;
+  }
+  HTTPMethod routeMethod() const override {
+    return method;
+  }
+};
+
+// a user Uri that only overrides clone() and canHandle()
+class UriPrefix : public Uri {
+public:
+  explicit UriPrefix(const String &uri) : Uri(uri) {}
+  Uri *clone() const override {
+    return new UriPrefix(_uri);
+  }
+  bool canHandle(const String &requestUri, std::vector<String> &) override {
+    return requestUri.startsWith(_uri);
+  }
+};
+
+static int failures = 0;
+
+#define CHECK(cond)                                        \
+  do {                                                     \
+    if (!(cond)) {                                         \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                          \
+    }                                                      \
+  } while (0)
+
+static RequestHandler *linearFind(std::vector<RequestHandler *> &handlers, HTTPMethod method, const String &uri) {
+  for (auto h : handlers) {
+    if (h->canHandle(method, uri)) {
+      return h;
+    }
+  }
+  return nullptr;
+}
+
+static RequestHandler *indexFind(RouteIndex &index, std::vector<RequestHandler *> &candidates, HTTPMethod method, const String &uri) {
+  index.lookup(method, uri, candidates);
+  return linearFind(candidates, method, uri);
+}
+
+static void test_route_types() {
+  Uri plain("/a");
+  Uri *exact = plain.clone();
+  Uri *prefix = UriPrefix("/a").clone();
+  CHECK(plain.routeType() == Uri::ROUTE_OTHER);
+  CHECK(exact->routeType() == Uri::ROUTE_EXACT);
+  CHECK(prefix->routeType() == Uri::ROUTE_OTHER);
+  CHECK(UriBraces("/a/{}").routeType() == Uri::ROUTE_BRACES);
+  CHECK(UriGlob("/a/*").routeType() == Uri::ROUTE_GLOB);
+  delete exact;
+  delete prefix;
+}
+
+static void test_custom_uri() {
+  std::vector<RequestHandler *> handlers;
+  std::vector<RequestHandler *> candidates;
+  RouteIndex index;
+  handlers.push_back(new TestHandler(Uri("/files"), HTTP_GET));
+  handlers.push_back(new TestHandler(UriPrefix("/files/"), HTTP_GET));
+  for (auto h : handlers) {
+    index.add(h);
+  }
+  CHECK(indexFind(index, candidates, HTTP_GET, "/files") == handlers[0]);
+  CHECK(indexFind(index, candidates, HTTP_GET, "/files/a/b.txt") == handlers[1]);
+  CHECK(indexFind(index, candidates, HTTP_POST, "/files/a/b.txt") == nullptr);
+  for (auto h : handlers) {
+    delete h;
+  }
+}
+
+static void test_random_tables() {
+  std::mt19937 rng(1);
+  const char *words[] = {"", "a", "b", "api", "v1", "users", "x.json", "{}", "{}.json", "*", "*.txt", "f?o", "index.html"};
+  const char *reqWords[] = {"", "a", "b", "api", "v1", "users", "x.json", "q.json", "t.txt", "foo", "index.html", "zz", "{}", "*"};
+  std::vector<RequestHandler *> handlers;
+  std::vector<RequestHandler *> candidates;
+  RouteIndex index;
+
+  for (int i = 0; i < 400; i++) {
+    String path;
+    int segments = 1 + rng() % 4;
+    int kind = rng() % 11;
+    for (int j = 0; j < segments; j++) {
+      path += "/";
+      path += words[rng() % 13];
+    }
+    if (rng() % 7 == 0) {
+      path += "/";
+    }
+    HTTPMethod method = (rng() % 3 == 0) ? HTTP_ANY : (rng() % 2 ? HTTP_GET : HTTP_POST);
+    RequestHandler *h;
+    if (kind < 4) {
+      h = new TestHandler(Uri(path), method);
+    } else if (kind < 7) {
+      h = new TestHandler(UriBraces(path), method);
+    } else if (kind < 9) {
+      h = new TestHandler(UriGlob(path), method);
+    } else if (kind < 10) {
+      h = new TestHandler(UriPrefix(path), method);
+    } else {
+      h = new TestHandler(UriRegex("^/api/v1/(users)$"), method);
+    }
+    handlers.push_back(h);
+    index.add(h);
+  }
+
+  int mismatches = 0;
+  long candidateTotal = 0;
+  const int requests = 20000;
+  for (int i = 0; i < requests; i++) {
+    String uri;
+    int segments = 1 + rng() % 5;
+    for (int j = 0; j < segments; j++) {
+      uri += "/";
+      uri += reqWords[rng() % 14];
+    }
+    if (rng() % 9 == 0) {
+      uri = "";
+    }
+    HTTPMethod method = rng() % 2 ? HTTP_GET : HTTP_POST;
+    RequestHandler *expected = linearFind(handlers, method, uri);
+    if (indexFind(index, candidates, method, uri) != expected) {
+      if (mismatches++ < 5) {
+        printf("mismatch: %s\n", uri.c_str());
+      }
+    }
+    candidateTotal += candidates.size();
+  }
+  CHECK(mismatches == 0);
+  printf("random tables: %d mismatches, %.1f candidates of %zu routes\n", mismatches, (double)candidateTotal / requests, handlers.size());
+  for (auto h : handlers) {
+    delete h;
+  }
+}
+
+static void bench_routes() {
+  std::vector<RequestHandler *> handlers;
+  std::vector<RequestHandler *> candidates;
+  std::vector<String> requests;
+  RouteIndex index;
+
+  // 150 exact GET routes and 150 UriBraces POST routes, requests hit each once
+  for (int i = 0; i < 150; i++) {
+    RequestHandler *get = new TestHandler(Uri(String("/api/v1/res") + i), HTTP_GET);
+    RequestHandler *post = new TestHandler(UriBraces(String("/api/v1/res") + i + "/{}"), HTTP_POST);
+    handlers.push_back(get);
+    handlers.push_back(post);
+    index.add(get);
+    index.add(post);
+    requests.push_back(String("/api/v1/res") + i);
+    requests.push_back(String("/api/v1/res") + i + "/42");
+  }
+
+  const int rounds = 50;
+  int linearHits = 0, indexHits = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < requests.size(); i++) {
+      linearHits += linearFind(handlers, i & 1 ? HTTP_POST : HTTP_GET, requests[i]) != nullptr;
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < requests.size(); i++) {
+      indexHits += indexFind(index, candidates, i & 1 ? HTTP_POST : HTTP_GET, requests[i]) != nullptr;
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  double n = rounds * requests.size();
+  CHECK(linearHits == n && indexHits == n);
+  printf(
+    "%zu routes: linear %.3f us/req, index %.3f us/req\n", handlers.size(), std::chrono::duration<double, std::micro>(t1 - t0).count() / n,
+    std::chrono::duration<double, std::micro>(t2 - t1).count() / n
+  );
+  for (auto h : handlers) {
+    delete h;
+  }
+}
+
+int main() {
+  test_route_types();
+  test_custom_uri();
+  test_random_tables();
+  bench_routes();
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
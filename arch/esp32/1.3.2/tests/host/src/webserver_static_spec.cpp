@@ -0,0 +1,133 @@
+// serveStatic() against a directory on the host: gzip negotiation from
+// Accept-Encoding, Vary on every response that had a .gz sibling to choose
+// from, and when ETags are taken from the cache or computed again.
+#include <Arduino.h>
+#include "WebServer.h"
+#include "vfs_api.h"
+#include <stdlib.h>
+#include <string>
+#include <utime.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+struct TestServer : WebServer {
+  using WebServer::WebServer;
+
+  // runs one request through a new connection, returns what was sent
+  std::string run(const std::string &request) {
+    auto socket = std::make_shared<NetworkClient::Socket>();
+    socket->in = request;
+    _server.pending.push_back(NetworkClient(socket));
+    for (int i = 0; i < 10 && socket->out.empty(); i++) {
+      handleClient();
+    }
+    return socket->out;
+  }
+
+  std::string get(const char *uri, const char *headers = "") {
+    return run(std::string("GET ") + uri + " HTTP/1.1\r\nHost: test\r\n" + headers + "\r\n");
+  }
+};
+
+static std::string head(const std::string &response) {
+  return response.substr(0, response.find("\r\n\r\n") + 2);
+}
+
+static bool hasHeader(const std::string &response, const char *header) {
+  return head(response).find(std::string("\r\n") + header + "\r\n") != std::string::npos;
+}
+
+static void writeFile(const std::string &path, const char *content) {
+  FILE *f = fopen(path.c_str(), "w");
+  fputs(content, f);
+  fclose(f);
+}
+
+static int eTagCalls = 0;
+
+static String eTagA(FS &, const String &) {
+  eTagCalls++;
+  return "\"a\"";
+}
+
+static String eTagB(FS &, const String &) {
+  eTagCalls++;
+  return "\"b\"";
+}
+
+int main() {
+  char root[] = "/tmp/webserver_static_XXXXXX";
+  if (!mkdtemp(root)) {
+    return 1;
+  }
+  std::string dir(root);
+  writeFile(dir + "/app.js", "plain");
+  writeFile(dir + "/app.js.gz", "compressed");
+  writeFile(dir + "/notes.txt", "notes");
+
+  fs::FSImplPtr impl(new VFSImpl());
+  impl->mountpoint(root);
+  fs::FS fs(impl);
+  TestServer server(80);
+  server.begin();
+  server.serveStatic("/", fs, "/");
+
+  // gzip sibling served only when accepted, Vary either way
+  std::string r = server.get("/app.js", "Accept-Encoding: gzip, deflate\r\n");
+  CHECK(hasHeader(r, "Content-Encoding: gzip") && hasHeader(r, "Vary: Accept-Encoding"));
+  CHECK(r.substr(r.size() - 10) == "compressed");
+  r = server.get("/app.js", "Accept-Encoding: gzip;q=0, deflate\r\n");
+  CHECK(!hasHeader(r, "Content-Encoding: gzip") && hasHeader(r, "Vary: Accept-Encoding"));
+  CHECK(r.substr(r.size() - 5) == "plain");
+  r = server.get("/app.js");
+  CHECK(!hasHeader(r, "Content-Encoding: gzip") && hasHeader(r, "Vary: Accept-Encoding"));
+
+  const char *accepted[] = {"deflate,GZIP", "x-gzip", "br;q=1.0, gzip;q=0.8", "gzip ; q=0.001", "*"};
+  const char *refused[] = {"identity", "gzipped", "deflate, gzip;Q=0.000", "gzip;q=0, *", "*;q=0"};
+  for (const char *value : accepted) {
+    r = server.get("/app.js", (std::string("Accept-Encoding: ") + value + "\r\n").c_str());
+    CHECK(hasHeader(r, "Content-Encoding: gzip"));
+  }
+  for (const char *value : refused) {
+    r = server.get("/app.js", (std::string("Accept-Encoding: ") + value + "\r\n").c_str());
+    CHECK(!hasHeader(r, "Content-Encoding: gzip"));
+  }
+  r = server.get("/notes.txt", "Accept-Encoding: gzip\r\n");
+  CHECK(!hasHeader(r, "Content-Encoding: gzip") && !hasHeader(r, "Vary: Accept-Encoding"));
+
+  // ETag computed once per file, Vary on the 304 too
+  server.enableETag(true, eTagA);
+  r = server.get("/app.js", "Accept-Encoding: gzip\r\n");
+  CHECK(hasHeader(r, "ETag: \"a\"") && eTagCalls == 1);
+  r = server.get("/app.js", "Accept-Encoding: gzip\r\nIf-None-Match: \"a\"\r\n");
+  CHECK(r.compare(0, 12, "HTTP/1.1 304") == 0 && hasHeader(r, "Vary: Accept-Encoding"));
+  CHECK(eTagCalls == 1);
+
+  // a new ETag function drops the cached values
+  server.enableETag(true, eTagB);
+  r = server.get("/app.js", "Accept-Encoding: gzip\r\n");
+  CHECK(hasHeader(r, "ETag: \"b\"") && eTagCalls == 2);
+
+  // no modification time (SPIFFS): computed on every request
+  struct utimbuf epoch = {0, 0};
+  utime((dir + "/app.js.gz").c_str(), &epoch);
+  server.get("/app.js", "Accept-Encoding: gzip\r\n");
+  server.get("/app.js", "Accept-Encoding: gzip\r\n");
+  CHECK(eTagCalls == 4);
+
+  unlink((dir + "/app.js").c_str());
+  unlink((dir + "/app.js.gz").c_str());
+  unlink((dir + "/notes.txt").c_str());
+  rmdir(root);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// Multipart uploads through WebServer: file contents full of delimiter-like
+// bytes must come out unchanged whatever the TCP segment size, with the
+// closing delimiter landing on every offset of the reader's buffer. Also an
+// aborted upload and the upload speed from an in-memory client.
+#include <Arduino.h>
+#include "WebServer.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                            \
+    }                                                        \
+  } while (0)
+
+typedef std::shared_ptr<NetworkClient::Socket> Socket;
+
+struct TestServer : WebServer {
+  using WebServer::WebServer;
+
+  Socket connect(const std::string &data, size_t maxChunk) {
+    Socket socket = std::make_shared<NetworkClient::Socket>();
+    socket->in = data;
+    socket->maxChunk = maxChunk;
+    _server.pending.push_back(NetworkClient(socket));
+    return socket;
+  }
+};
+
+static TestServer server(80);
+static const std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+static std::string received;
+static size_t totalSize;
+static HTTPUploadStatus lastStatus;
+
+static std::string request(const std::string &file) {
+  std::string body = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"note\"\r\n\r\nfirst\r\nsecond\r\n--" + boundary
+                     + "\r\nContent-Disposition: form-data; name=\"update\"; filename=\"fw.bin\"\r\nContent-Type: application/octet-stream\r\n\r\n" + file
+                     + "\r\n--" + boundary + "--\r\n";
+  return "POST /upload HTTP/1.1\r\nHost: test\r\nContent-Type: multipart/form-data; boundary=" + boundary + "\r\nContent-Length: " + std::to_string(body.size())
+         + "\r\n\r\n" + body;
+}
+
+// bytes that keep the delimiter search busy: CR, LF, dashes and the start of the boundary
+static std::string awkwardFile(size_t size, std::mt19937 &rng) {
+  std::string file;
+  std::string partial = "\r\n--" + boundary;
+  while (file.size() < size) {
+    if (rng() % 50 == 0) {
+      file += partial.substr(0, 1 + rng() % (partial.size() - 1));
+    } else {
+      file += "\r\n-a"[rng() % 4];
+    }
+  }
+  file.resize(size);
+  return file;
+}
+
+static bool upload(const std::string &file, size_t maxChunk) {
+  received.clear();
+  totalSize = 0;
+  Socket client = server.connect(request(file), maxChunk);
+  // the head arrives one segment per pass, the body is then read in one go
+  for (int i = 0; i < 1000 && client->out.empty(); i++) {
+    server.handleClient();
+  }
+  return client->out.compare(0, 15, "HTTP/1.1 200 OK") == 0 && received == file && totalSize == file.size() && lastStatus == UPLOAD_FILE_END;
+}
+
+int main() {
+  server.on(
+    "/upload", HTTP_POST,
+    [] {
+      server.send(200, "text/plain", server.arg("note"));
+    },
+    [] {
+      HTTPUpload &u = server.upload();
+      lastStatus = u.status;
+      if (u.status == UPLOAD_FILE_WRITE) {
+        received.append((const char *)u.buf, u.currentSize);
+      } else if (u.status == UPLOAD_FILE_END) {
+        totalSize = u.totalSize;
+      }
+    }
+  );
+  server.begin();
+  std::mt19937 rng(7);
+
+  // TCP segments from one byte up, so delimiters straddle the reader's refills
+  std::string file = awkwardFile(20000, rng);
+  for (size_t maxChunk : {1, 2, 7, 37, 1000, 1436, 100000}) {
+    CHECK(upload(file, maxChunk));
+  }
+  CHECK(server.arg("note") == "first\nsecond");
+
+  // file sizes around HTTP_UPLOAD_BUFLEN put the closing delimiter at every buffer offset
+  int sizeFailures = 0;
+  for (size_t size = 0; size < 3 * HTTP_UPLOAD_BUFLEN + 100; size += (size < 100 || size % HTTP_UPLOAD_BUFLEN > HTTP_UPLOAD_BUFLEN - 100) ? 1 : 50) {
+    std::string small = awkwardFile(size, rng);
+    sizeFailures += !upload(small, 1436);
+    sizeFailures += !upload(small, 500);
+  }
+  CHECK(sizeFailures == 0);
+
+  // the client goes away before the closing delimiter
+  std::string req = request(file);
+  received.clear();
+  Socket aborted = server.connect(req.substr(0, req.size() - boundary.size() - 10), 1436);
+  aborted->open = false;
+  server.handleClient();
+  CHECK(lastStatus == UPLOAD_FILE_ABORTED && aborted->out.compare(0, 12, "HTTP/1.1 200") != 0);
+
+  // upload speed from memory, which only leaves the parser's own cost
+  std::string big = awkwardFile(8 * 1024 * 1024, rng);
+  auto t0 = std::chrono::steady_clock::now();
+  CHECK(upload(big, 1436));
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("multipart upload, 1436 byte segments: %.1f MB/s\n", big.size() / s / 1e6);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}